@@ -1,5 +1,9 @@
+#pragma once
+
 #include "pillar/framework/types/anchor.h"
 #include "pillar/framework/types/dim.h"
+#include "pillar/framework/types/matrix.h"
+#include "pillar/framework/types/packed_rtree.h"
 #include "pillar/framework/types/point2.h"
 #include "pillar/framework/types/rectangle.h"
 
@@ -13,4 +17,13 @@ using Point2 = deps::Point2<T>;
 
 template <class T>
 using Rectangle = deps::Rectangle<T>;
+
+template <class T>
+using PackedRTree = deps::PackedRTree<T>;
+
+template <class T>
+using Matrix2x3 = deps::Matrix2x3<T>;
+
+template <class T>
+using Matrix3x3 = deps::Matrix3x3<T>;
 } // namespace yuzu
\ No newline at end of file
@@ -2,6 +2,7 @@
 // reference: https://github.com/google/mediapipe/blob/master/mediapipe/framework/deps/aligned_malloc_and_free.h
 
 #include <cstddef>
+#include <new>
 #include <stdlib.h>
 
 #if defined(__ANDROID__) || defined(_WIN32)
@@ -60,36 +61,55 @@ inline void alignedFree(void* alignedMemory)
 #endif // _WIN32
 }
 
-template <class T>
+// Allocator for standard containers whose storage starts on an `Alignment`
+// byte boundary, a cache line by default so SIMD loads never split one.
+template <class T, size_t Alignment = (alignof(T) > 64 ? alignof(T) : 64)>
 class AlignedAllocator
 {
     // Strict restriction.
-    static_assert(!(alignof(T) & (alignof(T) - 1)), "alignof(T) must be a power of two");
+    static_assert(!(Alignment & (Alignment - 1)), "Alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "Alignment must be at least alignof(T)");
 
 public:
+    using value_type = T;
+
+    // The alignment is not a type parameter, so allocator_traits cannot
+    // rebind on its own.
+    template <class U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
     inline AlignedAllocator() noexcept = default;
-    template <typename U>
-    inline explicit AlignedAllocator(const AlignedAllocator<U>&) noexcept
+    template <class U>
+    inline AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
     {
     }
 
-    inline T* allocate(size_t n) noexcept { return (T*)alignedMalloc(n * sizeof(T), alignof(T)); }
+    inline T* allocate(size_t n)
+    {
+        void* p = alignedMalloc(n * sizeof(T), static_cast<int>(Alignment));
+        if (p == nullptr && n != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
 
-    inline void deallocate(T* p) { alignedFree(p); }
+    inline void deallocate(T* p, size_t) noexcept { alignedFree(p); }
 
     // Stateless allocators.
-    template <typename U>
-    bool operator==(const AlignedAllocator<U>& rhs) const noexcept
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
     {
         return true;
     }
 
-    template <typename U>
-    bool operator!=(const AlignedAllocator<U>& rhs) const noexcept
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
     {
         return false;
     }
 
     inline ~AlignedAllocator() noexcept = default;
 };
-} // namespace yuzu
\ No newline at end of file
+} // namespace yuzu
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/status/status_code.h"
+#include "pillar/thread_pool/threadsafe_queue.h"
+
+namespace yuzu
+{
+// Raw frame dump: a file of uncompressed frames meant to be recorded in
+// production and replayed bit-exactly, in native byte order.
+//
+//   [file header, 64 bytes]
+//   for each frame:
+//     [zero padding][frame header, 64 bytes][pixel rows]
+//   [index: offset and timestamp of each frame]
+//
+// The frame header sits right before the pixel data, and the pixel data of
+// every frame starts on a 4 KiB boundary, so a mapped file can hand out
+// frames in place with the alignment of a freshly allocated ImageFrame. The
+// index is written by `close()`; a file without one (the recorder died) is
+// still readable by walking the frame headers.
+namespace frame_dump
+{
+constexpr uint32_t kDataAlignment = 4096;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dataAlignment;
+    uint64_t frameCount;
+    // 0 until the index has been written.
+    uint64_t indexOffset;
+    uint8_t reserved[32];
+};
+
+struct FrameHeader
+{
+    uint32_t magic;
+    uint32_t format;
+    int32_t width;
+    int32_t height;
+    int32_t step;
+    uint32_t reserved0;
+    int64_t timestamp;
+    uint64_t dataSize;
+    uint8_t reserved1[24];
+};
+
+struct IndexEntry
+{
+    // File offset of the pixel data, the frame header is right before it.
+    uint64_t dataOffset;
+    int64_t timestamp;
+};
+
+static_assert(sizeof(FileHeader) == 64, "unexpected file header size");
+static_assert(sizeof(FrameHeader) == 64, "unexpected frame header size");
+} // namespace frame_dump
+
+/**
+ * @brief Appends frames to a dump file from a background thread.
+ *
+ * `write` only stages the frame and returns, the file I/O happens on the
+ * writer's own thread. If more than `maxPendingBytes` are waiting to be
+ * written, the frame is dropped and `write` returns kResourceExhausted rather
+ * than blocking the capture thread.
+ */
+class FrameDumpWriter
+{
+public:
+    struct Stats
+    {
+        size_t framesWritten;
+        size_t framesDropped;
+        size_t bytesWritten;
+    };
+
+    explicit FrameDumpWriter(size_t maxPendingBytes = size_t(256) << 20);
+    ~FrameDumpWriter();
+    FrameDumpWriter(const FrameDumpWriter&) = delete;
+    FrameDumpWriter& operator=(const FrameDumpWriter&) = delete;
+
+    // Creates or truncates `path`.
+    Status open(const std::string& path);
+
+    // Copies the pixels of `frame` into a staging buffer.
+    Status write(const ConstImageFrameView& frame, int64_t timestamp = 0);
+    // Takes the frame over and writes its buffer as is, with no copy on the
+    // calling thread. A pooled frame goes back to its pool once written.
+    Status write(ImageFrame&& frame, int64_t timestamp = 0);
+
+    // Waits until every staged frame is on disk (in the page cache).
+    Status flush();
+    // Flushes, writes the index and closes the file. Also done on destruction.
+    Status close();
+
+    bool isOpen() const { return mFd >= 0; }
+    Stats stats() const;
+
+private:
+    struct Record;
+
+    // Counts `bytes` as pending unless that would exceed the cap.
+    bool reservePending(size_t bytes);
+    // Queues a record whose bytes have been reserved, or releases them.
+    Status enqueue(std::unique_ptr<Record> record);
+    void run();
+    bool writeRecord(const Record& record);
+    void fail(Status status);
+
+private:
+    const size_t mMaxPendingBytes;
+    int mFd;
+    std::thread mThread;
+    ThreadsafeQueue<std::unique_ptr<Record>> mQueue;
+
+    // Touched by the writer thread only, until it has been joined.
+    uint64_t mFileEnd;
+    std::vector<frame_dump::IndexEntry> mIndex;
+
+    std::atomic<size_t> mPendingBytes;
+    std::atomic<size_t> mFramesWritten;
+    std::atomic<size_t> mFramesDropped;
+    std::atomic<size_t> mBytesWritten;
+
+    mutable std::mutex mMut;
+    std::condition_variable mDrained;
+    size_t mPendingRecords;
+    // Set once close() has queued the stop record.
+    bool mClosing;
+    Status mStatus;
+    std::vector<std::vector<uint8_t>> mSpareBuffers;
+};
+
+/**
+ * @brief Maps a dump file and serves its frames in place.
+ *
+ * The file is mapped copy-on-write: frames are plain ImageFrames over the
+ * mapping (with `PixelDataDeleter::kNone`), writing to one touches a private
+ * copy of the page and never the file. Frames are valid until the reader is
+ * closed or destroyed.
+ */
+class FrameDumpReader
+{
+public:
+    FrameDumpReader();
+    ~FrameDumpReader();
+    FrameDumpReader(const FrameDumpReader&) = delete;
+    FrameDumpReader& operator=(const FrameDumpReader&) = delete;
+
+    Status open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return mData != nullptr; }
+    size_t size() const { return mIndex.size(); }
+    int64_t timestamp(size_t index) const { return mIndex[index].timestamp; }
+
+    // Wraps frame `index` without copying.
+    Status frame(size_t index, ImageFrame& frame) const;
+    ConstImageFrameView view(size_t index) const;
+
+private:
+    const frame_dump::FrameHeader& header(size_t index) const;
+    Status scanFrames();
+
+private:
+    uint8_t* mData;
+    size_t mSize;
+    std::vector<frame_dump::IndexEntry> mIndex;
+};
+} // namespace yuzu
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+// Pixel format conversion between the interleaved ImageFormats. Supported:
+//
+//   SRGB  <-> SBGRA, SRGB <-> SRGBA, SRGBA <-> SBGRA
+//   SRGB / SRGBA / SBGRA -> GRAY8 (BT.601 luma, 8-bit fixed point)
+//   GRAY8 -> SRGB / SRGBA / SBGRA
+//   GRAY8 <-> GRAY16, SRGB <-> SRGB48, SRGBA <-> SRGBA64 (v * 257 and v >> 8)
+//   GRAY8 / GRAY16 -> VEC32F1 (scaled to [0, 1]), VEC32F1 -> GRAY8
+//
+// Every pair has a scalar kernel; SSE4.1 and AVX2 kernels are picked at
+// runtime according to `cpu::simdLevel()`. All kernels of a pair produce
+// bit-identical results. Alpha is set to 255 where the source has none.
+
+// Returns true if `convertFormat` supports converting `from` into `to`.
+bool isConversionSupported(ImageFormat::Format from, ImageFormat::Format to);
+
+// Converts `src` to `format` and stores the result in `dst`. Unless `dst`
+// already has the right format and dimensions, it is reset with rows aligned
+// to `ImageFrame::kDefaultAlignmentBoundary`. `src` and `dst` must not be the
+// same frame.
+Status convertFormat(const ImageFrame& src, ImageFormat::Format format, ImageFrame& dst);
+
+// Converts between two views of the same dimensions, the target format is the
+// format of `dst`.
+Status convertFormat(const ConstImageFrameView& src, const ImageFrameView& dst);
+
+// Same as above, but uses kernels no wider than `maxLevel`. Mostly useful for
+// testing and benchmarking the kernels against each other.
+Status convertFormat(const ConstImageFrameView& src, const ImageFrameView& dst, cpu::SimdLevel maxLevel);
+} // namespace yuzu
@@ -7,6 +7,8 @@
 #include <memory>
 #include <utility>
 
+#include "pillar/status/status_code.h"
+
 // reference: https://github.com/google/mediapipe/blob/master/mediapipe/framework/formats/image_frame.h
 
 namespace yuzu
@@ -67,6 +69,10 @@ public:
     };
 };
 
+template <class PixelType>
+class BasicImageFrameView;
+using ConstImageFrameView = BasicImageFrameView<const uint8_t>;
+
 class ImageFrame
 {
 public:
@@ -130,14 +136,16 @@ public:
     bool isAligned(uint32_t alignmentBoundary) const;
 
     void copyFrom(const ImageFrame& imageFrame, uint32_t alignmentBoundary);
+    // Copies the pixels seen through `view`, e.g. to materialize a crop.
+    void copyFrom(const ConstImageFrameView& view, uint32_t alignmentBoundary);
     void copyPixelData(ImageFormat::Format format, int width, int height, const uint8_t* pixelData,
                        uint32_t alignmentBoundary);
     void copyPixelData(ImageFormat::Format format, int width, int height, int withStep, const uint8_t* pixelData,
                        uint32_t alignmentBoundary);
 
-    void copyToBuffer(uint8_t* buffer, int bufferSize) const;
-    void copyToBuffer(uint16_t* buffer, int bufferSize) const;
-    void copyToBuffer(float* buffer, int bufferSize) const;
+    Status copyToBuffer(uint8_t* buffer, int bufferSize) const;
+    Status copyToBuffer(uint16_t* buffer, int bufferSize) const;
+    Status copyToBuffer(float* buffer, int bufferSize) const;
 
     static int numberOfChannelsForFormat(ImageFormat::Format format);
     static int channelSizeForFormat(ImageFormat::Format format);
@@ -145,7 +153,6 @@ public:
 
 private:
     void internalCopyFrom(int width, int height, int widthStep, int channelSize, const uint8_t* pixelData);
-    void internalCopyToBuffer(int widthStep, char* buffer) const;
 
 public:
     bool isEmpty() const { return mPixelData == nullptr; }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "pillar/framework/formats/image_frame.h"
+
+namespace yuzu
+{
+namespace internal
+{
+struct ImageFramePoolState;
+} // namespace internal
+
+// A pool of pixel buffers for ImageFrame. Frames are handed out per
+// (format, width, height, alignment) and carry a Deleter that returns the
+// buffer to the pool instead of freeing it, so a steady-state pipeline stops
+// hitting the allocator (and the page faults of first touch) on every frame.
+//
+// The pool is thread-safe. Frames may outlive the pool: once the pool is
+// destroyed, releasing a frame simply frees its buffer.
+class ImageFramePool
+{
+public:
+    struct Stats
+    {
+        // Number of acquisitions served from a retained buffer.
+        size_t hits = 0;
+        // Number of acquisitions which had to allocate a new buffer.
+        size_t misses = 0;
+        // Bytes currently sitting in the pool waiting to be reused.
+        size_t bytesRetained = 0;
+        // Peak of bytes owned by the pool, both handed out and retained.
+        size_t highWaterMark = 0;
+    };
+
+    // Source of frames for code that allocates on its own schedule, e.g. the
+    // copy-on-write of SharedImageFrame. Same arguments as `acquire`.
+    using Allocator = std::function<ImageFrame(ImageFormat::Format format, int width, int height,
+                                               uint32_t alignmentBoundary)>;
+
+    // `maxBytesRetained` caps the memory kept for reuse; buffers released
+    // beyond the cap are freed. Zero means unlimited.
+    explicit ImageFramePool(size_t maxBytesRetained = 0);
+    ~ImageFramePool();
+    ImageFramePool(const ImageFramePool&) = delete;
+    ImageFramePool& operator=(const ImageFramePool&) = delete;
+
+    // Hands out a frame with the same layout `ImageFrame::reset` would create.
+    // The pixel data is not zeroed out.
+    ImageFrame acquire(ImageFormat::Format format, int width, int height,
+                       uint32_t alignmentBoundary = ImageFrame::kDefaultAlignmentBoundary);
+    // Same as `acquire`, then copies the pixels of `imageFrame` into the frame.
+    ImageFrame acquireCopy(const ImageFrame& imageFrame,
+                           uint32_t alignmentBoundary = ImageFrame::kDefaultAlignmentBoundary);
+
+    // Allocates `count` buffers up front and touches every page, so the first
+    // frames of a stream are served without faulting.
+    void reserve(ImageFormat::Format format, int width, int height, uint32_t alignmentBoundary, size_t count);
+    // Frees every retained buffer. Frames handed out are not affected.
+    void clear();
+
+    Stats stats() const;
+
+    // An allocator drawing from this pool. It may outlive the pool, it then
+    // allocates plain frames.
+    Allocator allocator() const;
+
+private:
+    std::shared_ptr<internal::ImageFramePoolState> mState;
+};
+} // namespace yuzu
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/framework/formats/image_frame.h"
+#include "pillar/status/status_code.h"
+
+namespace yuzu
+{
+// A non-owning window into pixel data laid out like an ImageFrame. A view is
+// a pointer, a format, the dimensions and the row step, so cropping a region
+// of interest is pointer arithmetic and never copies. The caller must keep
+// the underlying frame alive while views into it are used.
+//
+// `PixelType` is `uint8_t` for a mutable view and `const uint8_t` for a
+// read-only one, see ImageFrameView and ConstImageFrameView.
+template <class PixelType>
+class BasicImageFrameView
+{
+    static_assert(std::is_same<typename std::remove_const<PixelType>::type, uint8_t>::value,
+                  "PixelType must be uint8_t or const uint8_t");
+
+    using FrameType = typename std::conditional<std::is_const<PixelType>::value, const ImageFrame, ImageFrame>::type;
+
+public:
+    // Creates an empty view.
+    BasicImageFrameView() : mFormat(ImageFormat::UNKNOWN), mWidth(0), mHeight(0), mWidthStep(0), mPixelData(nullptr)
+    {
+    }
+    BasicImageFrameView(ImageFormat::Format format, int width, int height, int widthStep, PixelType* pixelData)
+        : mFormat(format), mWidth(width), mHeight(height), mWidthStep(widthStep), mPixelData(pixelData)
+    {
+    }
+    // Views the whole frame.
+    BasicImageFrameView(FrameType& imageFrame)
+        : BasicImageFrameView(imageFrame.format(), imageFrame.width(), imageFrame.height(), imageFrame.step(),
+                              imageFrame.pixelData())
+    {
+    }
+    // Views the part of the frame covered by `roi`, where `xmax()` and `ymax()`
+    // are exclusive. The region is clipped to the frame.
+    BasicImageFrameView(FrameType& imageFrame, const Rectangle<int>& roi)
+        : BasicImageFrameView(BasicImageFrameView(imageFrame).crop(roi))
+    {
+    }
+    // A mutable view converts implicitly to a read-only one.
+    template <class U, class = typename std::enable_if<std::is_const<PixelType>::value &&
+                                                       !std::is_const<U>::value>::type>
+    BasicImageFrameView(const BasicImageFrameView<U>& other)
+        : BasicImageFrameView(other.format(), other.width(), other.height(), other.step(), other.pixelData())
+    {
+    }
+
+    // Returns the sub-view covered by `roi`, clipped to this view.
+    BasicImageFrameView crop(const Rectangle<int>& roi) const
+    {
+        const int xmin = std::max(roi.xmin(), 0);
+        const int ymin = std::max(roi.ymin(), 0);
+        const int xmax = std::min(roi.xmax(), mWidth);
+        const int ymax = std::min(roi.ymax(), mHeight);
+        if (isEmpty() || roi.isEmpty() || xmin >= xmax || ymin >= ymax)
+        {
+            return BasicImageFrameView(mFormat, 0, 0, mWidthStep, nullptr);
+        }
+
+        PixelType* origin = mPixelData + ymin * mWidthStep + xmin * pixelBytes();
+        return BasicImageFrameView(mFormat, xmax - xmin, ymax - ymin, mWidthStep, origin);
+    }
+
+    // Set the pixels covered by the view to zero. Row padding outside of the
+    // view is left untouched.
+    template <class U = PixelType, class = typename std::enable_if<!std::is_const<U>::value>::type>
+    void setToZero() const
+    {
+        if (isEmpty())
+        {
+            return;
+        }
+
+        if (isContiguous())
+        {
+            std::fill_n(mPixelData, rowBytes() * mHeight, 0);
+            return;
+        }
+
+        PixelType* row = mPixelData;
+        for (int i = mHeight; i > 0; --i, row += mWidthStep)
+        {
+            std::fill_n(row, rowBytes(), 0);
+        }
+    }
+
+    // Returns true if the rows follow each other without any gap.
+    bool isContiguous() const
+    {
+        if (isEmpty())
+        {
+            return false;
+        }
+        return mWidthStep == rowBytes();
+    }
+
+    bool isAligned(uint32_t alignmentBoundary) const
+    {
+        if (isEmpty())
+        {
+            return false;
+        }
+        return (reinterpret_cast<uintptr_t>(mPixelData) % alignmentBoundary) == 0 &&
+               (mWidthStep % alignmentBoundary) == 0;
+    }
+
+    // Packs the pixels into `buffer`, dropping the row step. `bufferSize`
+    // counts elements of the buffer; kInvalidArgument if they cannot hold
+    // every row.
+    Status copyToBuffer(uint8_t* buffer, int bufferSize) const { return internalCopyToBuffer(buffer, bufferSize); }
+    Status copyToBuffer(uint16_t* buffer, int bufferSize) const { return internalCopyToBuffer(buffer, bufferSize); }
+    Status copyToBuffer(float* buffer, int bufferSize) const { return internalCopyToBuffer(buffer, bufferSize); }
+
+public:
+    bool isEmpty() const { return mPixelData == nullptr; }
+
+    ImageFormat::Format format() const { return mFormat; }
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+    int channels() const { return ImageFrame::numberOfChannelsForFormat(mFormat); }
+    int channelSize() const { return ImageFrame::channelSizeForFormat(mFormat); }
+    int byteDepth() const { return ImageFrame::byteDepthForFormat(mFormat); }
+    int step() const { return mWidthStep; }
+
+    PixelType* pixelData() const { return mPixelData; }
+    PixelType* row(int y) const { return mPixelData + y * mWidthStep; }
+
+private:
+    int pixelBytes() const { return channels() * byteDepth(); }
+    int rowBytes() const { return mWidth * pixelBytes(); }
+
+    template <class T>
+    Status internalCopyToBuffer(T* buffer, int bufferSize) const
+    {
+        if (isEmpty())
+        {
+            return okStatus();
+        }
+
+        const int bytes = rowBytes();
+        if (bufferSize < 0 || size_t(bufferSize) * sizeof(T) < size_t(bytes) * mHeight)
+        {
+            return Status(StatusCode::kInvalidArgument, "buffer is smaller than the pixel data");
+        }
+
+        uint8_t* dst = reinterpret_cast<uint8_t*>(buffer);
+        if (isContiguous())
+        {
+            std::copy_n(mPixelData, bytes * mHeight, dst);
+            return okStatus();
+        }
+
+        const uint8_t* src = mPixelData;
+        for (int i = mHeight; i > 0; --i)
+        {
+            std::copy_n(src, bytes, dst);
+            src += mWidthStep;
+            dst += bytes;
+        }
+        return okStatus();
+    }
+
+private:
+    ImageFormat::Format mFormat;
+    int mWidth;
+    int mHeight;
+    int mWidthStep;
+    PixelType* mPixelData;
+};
+
+using ImageFrameView = BasicImageFrameView<uint8_t>;
+using ConstImageFrameView = BasicImageFrameView<const uint8_t>;
+} // namespace yuzu
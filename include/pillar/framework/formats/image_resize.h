@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/status/status_code.h"
+
+namespace yuzu
+{
+enum class InterpolationMode : int32_t
+{
+    // Bilinear with pixel centers at +0.5, the edge pixels are replicated.
+    kBilinear = 0,
+    // Box filter, every destination pixel averages the source area it covers.
+    kArea = 1,
+};
+
+// Resampling for 8-bit, 16-bit and float formats of any channel count.
+//
+// The filter is separable: each source row is filtered horizontally once and
+// kept in a small ring of rows, then destination rows are blended vertically.
+// Filter coefficients are cached per (source size, destination size), and
+// bands of destination rows are processed in parallel.
+
+// Resizes `src` to the dimensions of `dst`, both must have the same format.
+Status resize(const ConstImageFrameView& src, const ImageFrameView& dst,
+              InterpolationMode mode = InterpolationMode::kBilinear);
+
+// Resizes `src` to `width` x `height`. `dst` is reset with
+// `ImageFrame::kDefaultAlignmentBoundary` unless it already has the right
+// format and dimensions.
+Status resize(const ImageFrame& src, int width, int height, ImageFrame& dst,
+              InterpolationMode mode = InterpolationMode::kBilinear);
+
+// Produces source row `y` as `width * channels` floats, with the channel
+// count of the destination.
+using RowFetcher = std::function<void(int y, float* row)>;
+
+// Resizes a `width` x `height` source whose rows are produced on demand, so a
+// producer such as a colour conversion can feed the resampler without
+// materializing the full-size source. Only the rows the filter needs are
+// fetched, possibly from several threads at once.
+Status resize(const RowFetcher& fetchRow, int width, int height, const ImageFrameView& dst,
+              InterpolationMode mode = InterpolationMode::kBilinear);
+
+/**
+ * @brief Resizes `src` into `dst` keeping the aspect ratio, centers it and
+ * pads the borders with `padValue` (in units of the channel type, e.g. 114 for
+ * 8-bit or 0.5 for float frames).
+ *
+ * @param mapping set to the source area covered by the whole of `dst`, in
+ * source pixels and including the padding, so its origin may be negative.
+ * A point (u, v) of `dst` in normalized [0, 1] coordinates maps back to the
+ * source point (xmin + u * width, ymin + v * height).
+ */
+Status letterbox(const ConstImageFrameView& src, const ImageFrameView& dst, Rectangle<float>& mapping,
+                 InterpolationMode mode = InterpolationMode::kBilinear, float padValue = 0.0f);
+} // namespace yuzu
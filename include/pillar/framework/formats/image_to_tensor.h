@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/framework/types/data_type.h"
+#include "pillar/status/status_code.h"
+
+namespace yuzu
+{
+enum class TensorLayout : int32_t
+{
+    kNCHW = 0,
+    kNHWC = 1,
+};
+
+enum class ChannelOrder : int32_t
+{
+    kRGB = 0,
+    kBGR = 1,
+};
+
+struct TensorConversionOptions
+{
+    TensorLayout layout = TensorLayout::kNCHW;
+    // Channel order of the tensor, ignored for GRAY8 frames.
+    ChannelOrder channelOrder = ChannelOrder::kRGB;
+    // Per tensor channel, in tensor channel order:
+    // tensor = (pixel - mean[c]) * scale[c], with pixel in [0, 255].
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+    // DataType::kFLOAT, or DataType::kHALF for IEEE half precision.
+    DataType dataType = DataType::kFLOAT;
+    // Index in the batch dimension the frame is written to.
+    int batchIndex = 0;
+};
+
+/**
+ * @brief Writes an SRGB, SBGRA or GRAY8 frame into a float or half tensor in
+ * a single pass: channel reordering, alpha dropping, normalization and the
+ * HWC to CHW transposition all happen while the pixels are in registers.
+ *
+ * `dims` describes the whole tensor, either {N, C, H, W} / {N, H, W, C} or,
+ * without batch dimension, {C, H, W} / {H, W, C}. C must be 3 for colour
+ * frames and 1 for GRAY8, H and W must match the frame.
+ *
+ * @param src the frame, possibly a cropped view
+ * @param options layout, normalization and element type
+ * @param buffer the caller-provided tensor memory
+ * @param dims the tensor dimensions
+ * @return Status kInvalidArgument if the frame and tensor do not match
+ */
+Status toTensor(const ConstImageFrameView& src, const TensorConversionOptions& options, void* buffer,
+                const Dims& dims);
+} // namespace yuzu
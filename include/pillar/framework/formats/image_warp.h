@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+/**
+ * @brief Warps `src` into `dst` by the affine `transform`, which maps source
+ * coordinates to destination coordinates: destination pixel (x, y) is the
+ * bilinear sample of `src` at the inverse transform of (x, y). Pixel centres
+ * sit at integer coordinates, as in OpenCV's warpAffine.
+ *
+ * Taps falling outside `src` take `borderValue`, in units of the channel type,
+ * so edges blend into it. 8-bit, 16-bit and float formats of any channel
+ * count are supported; tiles of the destination are processed in parallel and
+ * pixels of up to four channels with one SIMD blend each.
+ *
+ * @return Status kInvalidArgument for empty frames, different formats or a
+ * singular transform
+ */
+Status warpAffine(const ConstImageFrameView& src, const ImageFrameView& dst, const Matrix2x3<float>& transform,
+                  float borderValue = 0.0f);
+
+// Same, with a kernel no wider than `maxLevel`.
+Status warpAffine(const ConstImageFrameView& src, const ImageFrameView& dst, const Matrix2x3<float>& transform,
+                  float borderValue, cpu::SimdLevel maxLevel);
+} // namespace yuzu
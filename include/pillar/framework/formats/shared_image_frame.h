@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+
+#include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_pool.h"
+#include "pillar/framework/formats/image_frame_view.h"
+
+namespace yuzu
+{
+/**
+ * @brief A copyable handle sharing one ImageFrame between several consumers,
+ * e.g. a detector, a tracker and a recorder fed by the same camera frame.
+ *
+ * Copies share the pixel buffer through an atomic reference count, the frame
+ * is released (and a pooled buffer returned to its pool) with the last handle.
+ * The mutating accessors copy the frame first if it is shared, so a consumer
+ * writing into its handle never affects the others. Read through the const
+ * accessors, `frame()` or `view()` to avoid unintended copies.
+ *
+ * Like std::shared_ptr, handles sharing a frame may be used from different
+ * threads, but a single handle must not be written concurrently.
+ */
+class SharedImageFrame
+{
+public:
+    SharedImageFrame() = default;
+    // Takes `frame` over. Copies made on write are obtained from `allocator`
+    // when given (see `ImageFramePool::allocator()`), else allocated.
+    explicit SharedImageFrame(ImageFrame&& frame, ImageFramePool::Allocator allocator = nullptr);
+
+    SharedImageFrame(const SharedImageFrame&) = default;
+    SharedImageFrame& operator=(const SharedImageFrame&) = default;
+    SharedImageFrame(SharedImageFrame&&) = default;
+    SharedImageFrame& operator=(SharedImageFrame&&) = default;
+
+    // Read-only access, never copies.
+    const ImageFrame& frame() const;
+    ConstImageFrameView view() const { return ConstImageFrameView(frame()); }
+    const uint8_t* pixelData() const { return frame().pixelData(); }
+
+    // Write access, copies the frame first if it is shared.
+    uint8_t* pixelData() { return mutableFrame().pixelData(); }
+    ImageFrameView mutableView() { return ImageFrameView(mutableFrame()); }
+    void setToZero() { mutableFrame().setToZero(); }
+    ImageFrame& mutableFrame();
+
+    // Hands the frame out and leaves the handle empty. The frame is moved
+    // out if this was the only handle, copied otherwise.
+    ImageFrame release();
+    void reset() { mFrame.reset(); }
+
+    bool isEmpty() const { return mFrame == nullptr || mFrame->isEmpty(); }
+    // True if no other handle shares the frame.
+    bool isUnique() const;
+    long useCount() const { return mFrame.use_count(); }
+
+    ImageFormat::Format format() const { return frame().format(); }
+    int width() const { return frame().width(); }
+    int height() const { return frame().height(); }
+    int channels() const { return frame().channels(); }
+    int byteDepth() const { return frame().byteDepth(); }
+    int step() const { return frame().step(); }
+
+private:
+    ImageFrame copyFrame() const;
+
+private:
+    std::shared_ptr<ImageFrame> mFrame;
+    ImageFramePool::Allocator mAllocator;
+};
+} // namespace yuzu
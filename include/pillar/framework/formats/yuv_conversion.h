@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/framework/formats/image_resize.h"
+#include "pillar/framework/formats/yuv_image.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+// YUV 4:2:0 (kI420 or kNV12 layout) to SRGB or SBGRA conversion.
+//
+// The colour matrix and range are taken from the YUVImage. Samples are
+// converted with 13-bit fixed-point coefficients, chroma is replicated over
+// each 2x2 block. The AVX2 kernel is bit-identical to the scalar one; 10-bit
+// images go through the scalar kernel with samples reduced to 8 bits.
+
+// Converts `src` into `dst`, which must be SRGB or SBGRA. When the dimensions
+// differ, the image is resampled with `mode` on the fly: source rows are
+// converted as the resampler asks for them, without a full-size RGB frame.
+Status convertYUVToRGB(const YUVImage& src, const ImageFrameView& dst,
+                       InterpolationMode mode = InterpolationMode::kBilinear);
+
+// Converts `src` to a `width` x `height` frame of `format`. Unless `dst`
+// already has the right format and dimensions, it is reset with rows aligned
+// to `ImageFrame::kDefaultAlignmentBoundary`.
+Status convertYUVToRGB(const YUVImage& src, ImageFormat::Format format, int width, int height, ImageFrame& dst,
+                       InterpolationMode mode = InterpolationMode::kBilinear);
+
+// Same as the first overload without resampling, using kernels no wider than
+// `maxLevel`. Mostly useful for testing and benchmarking.
+Status convertYUVToRGB(const YUVImage& src, const ImageFrameView& dst, cpu::SimdLevel maxLevel);
+} // namespace yuzu
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "pillar/framework/formats/image_frame.h"
+
+// reference: https://github.com/google/mediapipe/blob/master/mediapipe/framework/formats/yuv_image.h
+
+namespace yuzu
+{
+// A 4:2:0 YCbCr image as produced by video decoders. The luma plane has full
+// resolution, the chroma planes are subsampled by two in both directions
+// (rounded up for odd sizes). Every plane has its own stride.
+class YUVImage
+{
+public:
+    enum class Layout : int32_t
+    {
+        // Three planes: Y, then U (Cb), then V (Cr). Also known as I420.
+        kI420 = 0,
+        // Two planes: Y, then U and V interleaved as UVUV...
+        kNV12 = 1,
+    };
+
+    enum class ColorMatrix : int32_t
+    {
+        kBT601 = 0,
+        kBT709 = 1,
+    };
+
+public:
+    // Creates an empty YUVImage. It will need to be initialized by some other means.
+    YUVImage();
+    YUVImage(YUVImage&& moveFrom);
+    YUVImage& operator=(YUVImage&& moveFrom);
+    YUVImage(const YUVImage&) = delete;
+    YUVImage& operator=(const YUVImage&) = delete;
+
+    // Allocates the planes in a single buffer, does not zero it out. Each row
+    // of each plane is aligned to `alignmentBoundary`, which must be a power
+    // of 2. `format` is YCBCR420P for 8-bit samples or YCBCR420P10 for 10-bit
+    // samples stored in the lower bits of a uint16.
+    YUVImage(Layout layout, int width, int height, uint32_t alignmentBoundary = ImageFrame::kDefaultAlignmentBoundary,
+             ImageFormat::Format format = ImageFormat::YCBCR420P);
+
+    void reset(Layout layout, int width, int height, uint32_t alignmentBoundary,
+               ImageFormat::Format format = ImageFormat::YCBCR420P);
+
+    // Wraps planes owned by someone else, typically a decoder. For kNV12, `u`
+    // is the interleaved chroma plane and `v` is ignored. When the image lets
+    // go of the data, `deleter` is called once with `y`; pass
+    // `ImageFrame::PixelDataDeleter::kNone` to keep ownership with the caller.
+    void adoptPlanes(Layout layout, int width, int height, uint8_t* y, int yStride, uint8_t* u, int uStride,
+                     uint8_t* v, int vStride, ImageFrame::Deleter deleter,
+                     ImageFormat::Format format = ImageFormat::YCBCR420P);
+
+    // Relinquishes ownership of the buffer that would be passed to the deleter
+    // and leaves the image empty.
+    std::unique_ptr<uint8_t[], ImageFrame::Deleter> release();
+
+    // Range and matrix used to interpret the samples. Defaults to limited
+    // range (Y in [16, 235]) BT.601, which is what most decoders output for
+    // SD content.
+    void setColorMatrix(ColorMatrix matrix) { mColorMatrix = matrix; }
+    void setFullRange(bool fullRange) { mFullRange = fullRange; }
+
+public:
+    bool isEmpty() const { return mPlanes[0] == nullptr; }
+
+    ImageFormat::Format format() const { return mFormat; }
+    Layout layout() const { return mLayout; }
+    ColorMatrix colorMatrix() const { return mColorMatrix; }
+    bool fullRange() const { return mFullRange; }
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+    int chromaWidth() const { return (mWidth + 1) / 2; }
+    int chromaHeight() const { return (mHeight + 1) / 2; }
+    int bitDepth() const { return mFormat == ImageFormat::YCBCR420P10 ? 10 : 8; }
+    int byteDepth() const { return mFormat == ImageFormat::YCBCR420P10 ? 2 : 1; }
+    int numPlanes() const { return mLayout == Layout::kNV12 ? 2 : 3; }
+
+    // Plane 0 is Y, plane 1 is U (or UV for kNV12), plane 2 is V.
+    uint8_t* data(int plane) { return mPlanes[plane]; }
+    const uint8_t* data(int plane) const { return mPlanes[plane]; }
+    int stride(int plane) const { return mStrides[plane]; }
+    uint8_t* row(int plane, int y) { return mPlanes[plane] + static_cast<ptrdiff_t>(y) * mStrides[plane]; }
+    const uint8_t* row(int plane, int y) const
+    {
+        return mPlanes[plane] + static_cast<ptrdiff_t>(y) * mStrides[plane];
+    }
+
+private:
+    ImageFormat::Format mFormat;
+    Layout mLayout;
+    ColorMatrix mColorMatrix;
+    bool mFullRange;
+    int mWidth;
+    int mHeight;
+    uint8_t* mPlanes[3];
+    int mStrides[3];
+    std::unique_ptr<uint8_t[], ImageFrame::Deleter> mPixelData;
+};
+} // namespace yuzu
@@ -0,0 +1,186 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#include "point2.h"
+#include "vector.h"
+
+namespace yuzu
+{
+namespace deps
+{
+/**
+ * @brief A 2D affine transform, the top two rows of a 3 x 3 matrix whose last
+ * row is (0, 0, 1), stored row-major:
+ *
+ *     x' = m(0, 0) x + m(0, 1) y + m(0, 2)
+ *     y' = m(1, 0) x + m(1, 1) y + m(1, 2)
+ */
+template <class T>
+class Matrix2x3
+{
+public:
+    // The identity.
+    Matrix2x3() : mData{T(1), T(0), T(0), T(0), T(1), T(0)} {}
+    Matrix2x3(T m00, T m01, T m02, T m10, T m11, T m12) : mData{m00, m01, m02, m10, m11, m12} {}
+    Matrix2x3(const Vector3<T>& row0, const Vector3<T>& row1)
+        : Matrix2x3(row0.x(), row0.y(), row0.z(), row1.x(), row1.y(), row1.z())
+    {
+    }
+
+    static Matrix2x3 translation(T tx, T ty) { return Matrix2x3(T(1), T(0), tx, T(0), T(1), ty); }
+    static Matrix2x3 scaling(T sx, T sy) { return Matrix2x3(sx, T(0), T(0), T(0), sy, T(0)); }
+    // Counterclockwise by `angle` radians in a y-up frame, clockwise on screen.
+    static Matrix2x3 rotation(T angle) { return similarity(T(1), angle, T(0), T(0)); }
+    // Rotates and scales about the origin, then translates.
+    static Matrix2x3 similarity(T scale, T angle, T tx, T ty)
+    {
+        const T c = scale * std::cos(angle), s = scale * std::sin(angle);
+        return Matrix2x3(c, -s, tx, s, c, ty);
+    }
+
+    T& operator()(int row, int col) { return mData[row * 3 + col]; }
+    const T& operator()(int row, int col) const { return mData[row * 3 + col]; }
+    T* data() { return mData; }
+    const T* data() const { return mData; }
+    Vector3<T> row(int r) const { return Vector3<T>(mData[r * 3], mData[r * 3 + 1], mData[r * 3 + 2]); }
+
+    // The determinant of the linear part.
+    T determinant() const { return mData[0] * mData[4] - mData[1] * mData[3]; }
+
+    // Sets `inverse` and returns true unless the transform is singular.
+    bool invert(Matrix2x3& inverse) const
+    {
+        const double det = double(mData[0]) * mData[4] - double(mData[1]) * mData[3];
+        if (det == 0.0 || !std::isfinite(det))
+            return false;
+        const double a = mData[4] / det, b = -mData[1] / det, c = -mData[3] / det, d = mData[0] / det;
+        inverse = Matrix2x3(T(a), T(b), T(-(a * mData[2] + b * mData[5])), //
+                            T(c), T(d), T(-(c * mData[2] + d * mData[5])));
+        return true;
+    }
+
+    // This transform applied after `b`.
+    Matrix2x3 operator*(const Matrix2x3& b) const
+    {
+        const T* m = mData;
+        return Matrix2x3(m[0] * b.mData[0] + m[1] * b.mData[3], m[0] * b.mData[1] + m[1] * b.mData[4],
+                         m[0] * b.mData[2] + m[1] * b.mData[5] + m[2], //
+                         m[3] * b.mData[0] + m[4] * b.mData[3], m[3] * b.mData[1] + m[4] * b.mData[4],
+                         m[3] * b.mData[2] + m[4] * b.mData[5] + m[5]);
+    }
+
+    // The point mapped by the transform.
+    Point2<T> operator*(const Point2<T>& p) const
+    {
+        return Point2<T>(mData[0] * p.x() + mData[1] * p.y() + mData[2], //
+                         mData[3] * p.x() + mData[4] * p.y() + mData[5]);
+    }
+    // A direction: the linear part only.
+    Vector2<T> operator*(const Vector2<T>& v) const
+    {
+        return Vector2<T>(mData[0] * v.x() + mData[1] * v.y(), mData[3] * v.x() + mData[4] * v.y());
+    }
+    // Homogeneous coordinates, (x, y, w).
+    Vector2<T> operator*(const Vector3<T>& v) const { return Vector2<T>(row(0).dotProd(v), row(1).dotProd(v)); }
+
+    bool operator==(const Matrix2x3& b) const { return std::equal(mData, mData + 6, b.mData); }
+    bool operator!=(const Matrix2x3& b) const { return !(*this == b); }
+
+    friend std::ostream& operator<<(std::ostream& out, const Matrix2x3& m)
+    {
+        return out << "[" << m.row(0) << ", " << m.row(1) << "]";
+    }
+
+private:
+    T mData[6];
+};
+
+/**
+ * @brief A 3 x 3 matrix stored row-major, used as a 2D homography on points:
+ * (x, y) maps to (X / W, Y / W) with (X, Y, W) = m * (x, y, 1).
+ */
+template <class T>
+class Matrix3x3
+{
+public:
+    // The identity.
+    Matrix3x3() : mData{T(1), T(0), T(0), T(0), T(1), T(0), T(0), T(0), T(1)} {}
+    Matrix3x3(T m00, T m01, T m02, T m10, T m11, T m12, T m20, T m21, T m22)
+        : mData{m00, m01, m02, m10, m11, m12, m20, m21, m22}
+    {
+    }
+    Matrix3x3(const Vector3<T>& row0, const Vector3<T>& row1, const Vector3<T>& row2)
+        : Matrix3x3(row0.x(), row0.y(), row0.z(), row1.x(), row1.y(), row1.z(), row2.x(), row2.y(), row2.z())
+    {
+    }
+    explicit Matrix3x3(const Matrix2x3<T>& a) : Matrix3x3(a.row(0), a.row(1), Vector3<T>(T(0), T(0), T(1))) {}
+
+    T& operator()(int row, int col) { return mData[row * 3 + col]; }
+    const T& operator()(int row, int col) const { return mData[row * 3 + col]; }
+    T* data() { return mData; }
+    const T* data() const { return mData; }
+    Vector3<T> row(int r) const { return Vector3<T>(mData[r * 3], mData[r * 3 + 1], mData[r * 3 + 2]); }
+    Vector3<T> col(int c) const { return Vector3<T>(mData[c], mData[c + 3], mData[c + 6]); }
+
+    // Whether the last row is (0, 0, 1).
+    bool isAffine() const { return mData[6] == T(0) && mData[7] == T(0) && mData[8] == T(1); }
+    // The top two rows.
+    Matrix2x3<T> affine() const { return Matrix2x3<T>(row(0), row(1)); }
+
+    Matrix3x3 transpose() const { return Matrix3x3(col(0), col(1), col(2)); }
+    T determinant() const { return row(0).dotProd(row(1).crossProd(row(2))); }
+
+    // Sets `inverse` and returns true unless the matrix is singular.
+    bool invert(Matrix3x3& inverse) const
+    {
+        const T* m = mData;
+        double c[9] = {double(m[4]) * m[8] - double(m[5]) * m[7], double(m[2]) * m[7] - double(m[1]) * m[8],
+                       double(m[1]) * m[5] - double(m[2]) * m[4], double(m[5]) * m[6] - double(m[3]) * m[8],
+                       double(m[0]) * m[8] - double(m[2]) * m[6], double(m[2]) * m[3] - double(m[0]) * m[5],
+                       double(m[3]) * m[7] - double(m[4]) * m[6], double(m[1]) * m[6] - double(m[0]) * m[7],
+                       double(m[0]) * m[4] - double(m[1]) * m[3]};
+        const double det = m[0] * c[0] + m[1] * c[3] + m[2] * c[6];
+        if (det == 0.0 || !std::isfinite(det))
+            return false;
+        for (int i = 0; i < 9; ++i)
+            inverse.mData[i] = T(c[i] / det);
+        return true;
+    }
+
+    Matrix3x3 operator*(const Matrix3x3& b) const
+    {
+        Matrix3x3 out;
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                out.mData[r * 3 + c] = row(r).dotProd(b.col(c));
+        return out;
+    }
+
+    Vector3<T> operator*(const Vector3<T>& v) const
+    {
+        return Vector3<T>(row(0).dotProd(v), row(1).dotProd(v), row(2).dotProd(v));
+    }
+
+    // The point mapped by the homography.
+    Point2<T> operator*(const Point2<T>& p) const
+    {
+        const T w = mData[6] * p.x() + mData[7] * p.y() + mData[8];
+        return Point2<T>((mData[0] * p.x() + mData[1] * p.y() + mData[2]) / w,
+                         (mData[3] * p.x() + mData[4] * p.y() + mData[5]) / w);
+    }
+
+    bool operator==(const Matrix3x3& b) const { return std::equal(mData, mData + 9, b.mData); }
+    bool operator!=(const Matrix3x3& b) const { return !(*this == b); }
+
+    friend std::ostream& operator<<(std::ostream& out, const Matrix3x3& m)
+    {
+        return out << "[" << m.row(0) << ", " << m.row(1) << ", " << m.row(2) << "]";
+    }
+
+private:
+    T mData[9];
+};
+} // namespace deps
+} // namespace yuzu
@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "rectangle.h"
+
+namespace yuzu
+{
+namespace deps
+{
+/**
+ * @brief A static R-tree over rectangles, packed bottom up in one array.
+ *
+ * `build` sorts the rectangles by centre with a sort-tile-recursive pass into
+ * leaves of kNodeSize, then groups consecutive nodes level by level, so a
+ * rebuild is a sort and a linear pass with no allocation once the arrays have
+ * grown. Queries test with Rectangle's own `intersects` and `contains`, so
+ * they return exactly what a loop over every rectangle would, as indices into
+ * the array given to `build` in ascending order. Empty rectangles intersect
+ * and contain nothing and are left out.
+ */
+template <class T>
+class PackedRTree
+{
+public:
+    static constexpr size_t kNodeSize = 16;
+    // Enough for any count a size_t can hold.
+    static constexpr size_t kMaxLevels = 17;
+
+    PackedRTree() = default;
+    explicit PackedRTree(const std::vector<Rectangle<T>>& rects) { build(rects); }
+
+    void build(const std::vector<Rectangle<T>>& rects) { build(rects.data(), rects.size()); }
+    void build(const Rectangle<T>* rects, size_t count);
+
+    // Rectangles indexed, the empty ones excluded.
+    size_t size() const { return mItems.size(); }
+    bool empty() const { return mItems.empty(); }
+    // The union of every rectangle, empty if there are none.
+    Rectangle<T> bounds() const { return mBoxes.empty() ? Rectangle<T>() : mBoxes.back(); }
+
+    // The rectangles `r` with r.intersects(rect).
+    void queryIntersecting(const Rectangle<T>& rect, std::vector<size_t>& out) const;
+    // The rectangles `r` with r.contains(x, y).
+    void queryContaining(const T& x, const T& y, std::vector<size_t>& out) const;
+    void queryContaining(const Point2<T>& p, std::vector<size_t>& out) const { queryContaining(p.x(), p.y(), out); }
+    // The `k` rectangles whose centres are nearest to (x, y), nearest first,
+    // ties broken by index.
+    void nearestCentres(const T& x, const T& y, size_t k, std::vector<size_t>& out) const;
+
+private:
+    // Box `position` of level `level` covers these boxes of the level below.
+    size_t childBegin(size_t level, size_t position) const
+    {
+        return mLevelBegin[level - 1] + (position - mLevelBegin[level]) * kNodeSize;
+    }
+    size_t childEnd(size_t level, size_t position) const
+    {
+        return std::min(childBegin(level, position) + kNodeSize, mLevelBegin[level]);
+    }
+
+    static double centreX(const Rectangle<T>& r) { return (double(r.xmin()) + double(r.xmax())) * 0.5; }
+    static double centreY(const Rectangle<T>& r) { return (double(r.ymin()) + double(r.ymax())) * 0.5; }
+
+    // The original indices of the rectangles whose boxes, and every box
+    // above them, pass `test`.
+    template <class Test>
+    void search(Test test, std::vector<size_t>& out) const;
+
+    // Level 0 holds the rectangles in tree order, every level above the
+    // bounds of kNodeSize consecutive boxes below; the root is last.
+    std::vector<Rectangle<T>> mBoxes;
+    std::vector<size_t> mLevelBegin;
+    // The original index of each level 0 box.
+    std::vector<size_t> mItems;
+
+    // Build scratch, kept to spare the allocation on rebuilds.
+    struct Centre
+    {
+        double x;
+        double y;
+        size_t index;
+    };
+    std::vector<Centre> mOrder;
+};
+
+template <class T>
+void PackedRTree<T>::build(const Rectangle<T>* rects, size_t count)
+{
+    mOrder.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!rects[i].isEmpty())
+            mOrder.push_back({centreX(rects[i]), centreY(rects[i]), i});
+    }
+
+    // Sort-tile-recursive: vertical slices of whole leaves by centre x, then
+    // each slice by centre y, so a leaf holds neighbouring rectangles.
+    const size_t n = mOrder.size();
+    const size_t leaves = (n + kNodeSize - 1) / kNodeSize;
+    const size_t slices = size_t(std::ceil(std::sqrt(double(leaves))));
+    const size_t sliceSize = std::max<size_t>(1, slices) * kNodeSize;
+    std::sort(mOrder.begin(), mOrder.end(),
+              [](const Centre& a, const Centre& b) { return a.x < b.x || (a.x == b.x && a.index < b.index); });
+    for (size_t begin = 0; begin < n; begin += sliceSize)
+        std::sort(mOrder.begin() + begin, mOrder.begin() + std::min(begin + sliceSize, n),
+                  [](const Centre& a, const Centre& b) { return a.y < b.y || (a.y == b.y && a.index < b.index); });
+    mItems.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        mItems[i] = mOrder[i].index;
+
+    mBoxes.clear();
+    mLevelBegin.clear();
+    if (n == 0)
+        return;
+    mBoxes.reserve(n + n / (kNodeSize - 1) + 2);
+    for (size_t i : mItems)
+        mBoxes.push_back(rects[i]);
+    mLevelBegin.push_back(0);
+    size_t begin = 0, end = n;
+    while (end - begin > 1)
+    {
+        mLevelBegin.push_back(end);
+        for (size_t child = begin; child < end; child += kNodeSize)
+        {
+            Rectangle<T> box = mBoxes[child];
+            for (size_t c = child + 1; c < std::min(child + kNodeSize, end); ++c)
+                box = box.unionArea(mBoxes[c]);
+            mBoxes.push_back(box);
+        }
+        begin = end;
+        end = mBoxes.size();
+    }
+}
+
+template <class T>
+template <class Test>
+void PackedRTree<T>::search(Test test, std::vector<size_t>& out) const
+{
+    out.clear();
+    if (mBoxes.empty() || !test(mBoxes.back()))
+        return;
+    // Level and position pairs, at most kNodeSize per level of the tree. On
+    // the call stack, so const queries are safe from any number of threads.
+    size_t stack[2 * kNodeSize * kMaxLevels];
+    size_t depth = 0;
+    stack[depth++] = mLevelBegin.size() - 1;
+    stack[depth++] = mBoxes.size() - 1;
+    while (depth > 0)
+    {
+        const size_t position = stack[--depth];
+        const size_t level = stack[--depth];
+        if (level == 0)
+        {
+            out.push_back(mItems[position]);
+            continue;
+        }
+        for (size_t child = childBegin(level, position); child < childEnd(level, position); ++child)
+        {
+            if (!test(mBoxes[child]))
+                continue;
+            stack[depth++] = level - 1;
+            stack[depth++] = child;
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
+
+template <class T>
+void PackedRTree<T>::queryIntersecting(const Rectangle<T>& rect, std::vector<size_t>& out) const
+{
+    // A node's bounds intersect whatever any rectangle inside it intersects.
+    search([&rect](const Rectangle<T>& box) { return box.intersects(rect); }, out);
+}
+
+template <class T>
+void PackedRTree<T>::queryContaining(const T& x, const T& y, std::vector<size_t>& out) const
+{
+    search([&x, &y](const Rectangle<T>& box) { return box.contains(x, y); }, out);
+}
+
+template <class T>
+void PackedRTree<T>::nearestCentres(const T& x, const T& y, size_t k, std::vector<size_t>& out) const
+{
+    out.clear();
+    if (mBoxes.empty() || k == 0)
+        return;
+    // Best first. A centre lies inside its rectangle, so no centre under a
+    // node is nearer than the node's bounds; at equal distance nodes come
+    // before rectangles and rectangles by index, which keeps ties exact.
+    struct Entry
+    {
+        double distance;
+        bool isItem;
+        size_t level;
+        size_t position;
+    };
+    const double px = double(x), py = double(y);
+    auto later = [this](const Entry& a, const Entry& b)
+    {
+        if (a.distance != b.distance)
+            return a.distance > b.distance;
+        if (a.isItem != b.isItem)
+            return a.isItem;
+        return a.isItem && mItems[a.position] > mItems[b.position];
+    };
+    std::priority_queue<Entry, std::vector<Entry>, decltype(later)> queue(later);
+    auto boxDistance = [px, py](const Rectangle<T>& box)
+    {
+        const double dx = std::max({double(box.xmin()) - px, 0.0, px - double(box.xmax())});
+        const double dy = std::max({double(box.ymin()) - py, 0.0, py - double(box.ymax())});
+        return dx * dx + dy * dy;
+    };
+    auto push = [&](size_t level, size_t position)
+    {
+        const Rectangle<T>& box = mBoxes[position];
+        if (level > 0)
+        {
+            queue.push({boxDistance(box), false, level, position});
+            return;
+        }
+        const double dx = centreX(box) - px, dy = centreY(box) - py;
+        queue.push({dx * dx + dy * dy, true, 0, position});
+    };
+    push(mLevelBegin.size() - 1, mBoxes.size() - 1);
+    while (!queue.empty() && out.size() < k)
+    {
+        const Entry entry = queue.top();
+        queue.pop();
+        if (entry.isItem)
+        {
+            out.push_back(mItems[entry.position]);
+            continue;
+        }
+        for (size_t child = childBegin(entry.level, entry.position); child < childEnd(entry.level, entry.position);
+             ++child)
+            push(entry.level - 1, child);
+    }
+}
+} // namespace deps
+} // namespace yuzu
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <limits>
@@ -205,8 +206,8 @@ void Rectangle<T>::expand(const Point2<T>& p)
 template <typename T>
 void Rectangle<T>::expand(const Rectangle<T>& other)
 {
-    expand(other.min_);
-    expand(other.max_);
+    expand(other.mMin);
+    expand(other.mMax);
 }
 
 template <typename T>
@@ -224,7 +225,7 @@ bool Rectangle<T>::contains(const Point2<T>& p) const
 template <typename T>
 bool Rectangle<T>::contains(const Rectangle<T>& r) const
 {
-    return Contains(r.mMin) && Contains(r.mMax);
+    return contains(r.mMin) && contains(r.mMax);
 }
 
 template <typename T>
@@ -3,10 +3,20 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdlib>
+#include <initializer_list>
 #include <iosfwd>
 #include <limits>
 #include <ostream>
 #include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PILLAR_VECTOR_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PILLAR_VECTOR_NEON 1
+#include <arm_neon.h>
+#endif
 
 // reference: https://github.com/google/mediapipe/blob/master/mediapipe/framework/deps/vector.h
 
@@ -22,6 +32,202 @@ template <typename T>
 class Vector4;
 namespace internal
 {
+// Component-wise kernels over N values. VectorOps picks these, or for float
+// vectors of three and four components the SIMD ones below.
+template <typename T, std::size_t N>
+struct GenericVectorOps
+{
+    static void plusEq(T* a, const T* b) { plusEq(a, b, IdxSeqN{}); }
+    static void minusEq(T* a, const T* b) { minusEq(a, b, IdxSeqN{}); }
+    static void mulEq(T* a, T k) { mulEq(a, k, IdxSeqN{}); }
+    static void divEq(T* a, T k) { divEq(a, k, IdxSeqN{}); }
+    static void minEq(T* a, const T* b) { minEq(a, b, IdxSeqN{}); }
+    static void maxEq(T* a, const T* b) { maxEq(a, b, IdxSeqN{}); }
+    static T dot(const T* a, const T* b) { return dot(static_cast<T>(0), a, b, IdxSeqN{}); }
+
+    // Three components only.
+    static void cross(T* out, const T* a, const T* b)
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+private:
+    using IdxSeqN = std::make_index_sequence<N>;
+
+    // Ignores its arguments so that side-effects of variadic unpacking can occur.
+    static void ignore(std::initializer_list<bool>) {}
+
+    template <std::size_t... Is>
+    static T dot(T sum, const T* a, const T* b, std::index_sequence<Is...>)
+    {
+        ignore({(sum += a[Is] * b[Is], true)...});
+        return sum;
+    }
+
+    template <std::size_t... Is>
+    static void plusEq(T* a, const T* b, std::index_sequence<Is...>)
+    {
+        ignore({(a[Is] += b[Is], true)...});
+    }
+
+    template <std::size_t... Is>
+    static void minusEq(T* a, const T* b, std::index_sequence<Is...>)
+    {
+        ignore({(a[Is] -= b[Is], true)...});
+    }
+
+    template <std::size_t... Is>
+    static void mulEq(T* a, T b, std::index_sequence<Is...>)
+    {
+        ignore({(a[Is] *= b, true)...});
+    }
+
+    template <std::size_t... Is>
+    static void divEq(T* a, T b, std::index_sequence<Is...>)
+    {
+        ignore({(a[Is] /= b, true)...});
+    }
+
+    template <std::size_t... Is>
+    static void minEq(T* a, const T* b, std::index_sequence<Is...>)
+    {
+        ignore({(a[Is] = std::min(a[Is], b[Is]), true)...});
+    }
+
+    template <std::size_t... Is>
+    static void maxEq(T* a, const T* b, std::index_sequence<Is...>)
+    {
+        ignore({(a[Is] = std::max(a[Is], b[Is]), true)...});
+    }
+};
+
+template <typename T, std::size_t N>
+struct VectorOps : GenericVectorOps<T, N>
+{
+};
+
+#if defined(PILLAR_VECTOR_SSE) || defined(PILLAR_VECTOR_NEON)
+// Four floats in one register. Three-component vectors load a zero into the
+// fourth lane and never store it, so a Vector3<float> stays 12 bytes and no
+// access strays past it.
+namespace simd
+{
+#if defined(PILLAR_VECTOR_SSE)
+using Float4 = __m128;
+
+inline Float4 load4(const float* p) { return _mm_loadu_ps(p); }
+inline Float4 load3(const float* p)
+{
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)), _mm_load_ss(p + 2));
+}
+inline void store4(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+inline void store3(float* p, Float4 v)
+{
+    _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+    _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+}
+inline Float4 splat(float k) { return _mm_set1_ps(k); }
+inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+// Operands swapped to return `a` on ties and NaNs, as std::min and std::max.
+inline Float4 min(Float4 a, Float4 b) { return _mm_min_ps(b, a); }
+inline Float4 max(Float4 a, Float4 b) { return _mm_max_ps(b, a); }
+inline float sum(Float4 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+}
+// (y, z, x, w).
+inline Float4 rotate(Float4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)); }
+#else
+using Float4 = float32x4_t;
+
+inline Float4 load4(const float* p) { return vld1q_f32(p); }
+inline Float4 load3(const float* p) { return vcombine_f32(vld1_f32(p), vld1_lane_f32(p + 2, vdup_n_f32(0.0f), 0)); }
+inline void store4(float* p, Float4 v) { vst1q_f32(p, v); }
+inline void store3(float* p, Float4 v)
+{
+    vst1_f32(p, vget_low_f32(v));
+    vst1q_lane_f32(p + 2, v, 2);
+}
+inline Float4 splat(float k) { return vdupq_n_f32(k); }
+inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 div(Float4 a, Float4 b)
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vdivq_f32(a, b);
+#else
+    float x[4], y[4];
+    vst1q_f32(x, a);
+    vst1q_f32(y, b);
+    for (int i = 0; i < 4; ++i)
+        x[i] /= y[i];
+    return vld1q_f32(x);
+#endif
+}
+// Selects like std::min and std::max, `a` on ties and NaNs.
+inline Float4 min(Float4 a, Float4 b) { return vbslq_f32(vcltq_f32(b, a), b, a); }
+inline Float4 max(Float4 a, Float4 b) { return vbslq_f32(vcltq_f32(a, b), b, a); }
+inline float sum(Float4 v)
+{
+    const float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+}
+// (y, z, x, x).
+inline Float4 rotate(Float4 v) { return vsetq_lane_f32(vgetq_lane_f32(v, 0), vextq_f32(v, v, 1), 2); }
+#endif
+} // namespace simd
+
+// The dot product sums the lanes pairwise, which may differ from the
+// generic left-to-right sum in the last bit.
+template <std::size_t N>
+struct Float4Ops
+{
+    static_assert(N == 3 || N == 4, "three or four components");
+
+    static simd::Float4 load(const float* p) { return N == 4 ? simd::load4(p) : simd::load3(p); }
+    static void store(float* p, simd::Float4 v)
+    {
+        if (N == 4)
+            simd::store4(p, v);
+        else
+            simd::store3(p, v);
+    }
+
+    static void plusEq(float* a, const float* b) { store(a, simd::add(load(a), load(b))); }
+    static void minusEq(float* a, const float* b) { store(a, simd::sub(load(a), load(b))); }
+    static void mulEq(float* a, float k) { store(a, simd::mul(load(a), simd::splat(k))); }
+    static void divEq(float* a, float k) { store(a, simd::div(load(a), simd::splat(k))); }
+    static void minEq(float* a, const float* b) { store(a, simd::min(load(a), load(b))); }
+    static void maxEq(float* a, const float* b) { store(a, simd::max(load(a), load(b))); }
+    static float dot(const float* a, const float* b) { return simd::sum(simd::mul(load(a), load(b))); }
+
+    static void cross(float* out, const float* a, const float* b)
+    {
+        const simd::Float4 va = load(a), vb = load(b);
+        const simd::Float4 c = simd::sub(simd::mul(va, simd::rotate(vb)), simd::mul(simd::rotate(va), vb));
+        // c holds (z, x, y) of the cross product.
+        store(out, simd::rotate(c));
+    }
+};
+
+template <>
+struct VectorOps<float, 3> : Float4Ops<3>
+{
+};
+
+template <>
+struct VectorOps<float, 4> : Float4Ops<4>
+{
+};
+#endif
+
 template <template <typename> class VecTemplate, typename T, std::size_t N>
 class BasicVector
 {
@@ -31,6 +237,7 @@ protected:
     // Some methods return floating-point value even when T type is an integer.
     using FloatType = typename std::conditional<std::is_integral<T>::value, double, T>::type;
     using IdxSeqN = std::make_index_sequence<N>;
+    using Ops = VectorOps<T, N>;
 
     template <std::size_t I, typename F, typename... As>
     static auto reduce(F f, As*... as) -> decltype(f(as[I]...))
@@ -87,25 +294,25 @@ public:
 
     D& operator+=(const D& b)
     {
-        plusEq(static_cast<D&>(*this).data(), b.data(), IdxSeqN{});
+        Ops::plusEq(static_cast<D&>(*this).data(), b.data());
         return static_cast<D&>(*this);
     }
 
     D& operator-=(const D& b)
     {
-        minusEq(static_cast<D&>(*this).data(), b.data(), IdxSeqN{});
+        Ops::minusEq(static_cast<D&>(*this).data(), b.data());
         return static_cast<D&>(*this);
     }
 
     D& operator*=(T k)
     {
-        mulEq(static_cast<D&>(*this).data(), k, IdxSeqN{});
+        Ops::mulEq(static_cast<D&>(*this).data(), k);
         return static_cast<D&>(*this);
     }
 
     D& operator/=(T k)
     {
-        divEq(static_cast<D&>(*this).data(), k, IdxSeqN{});
+        Ops::divEq(static_cast<D&>(*this).data(), k);
         return static_cast<D&>(*this);
     }
 
@@ -140,22 +347,23 @@ public:
     // Element-wise max.  {max(a[0],b[0]), max(a[1],b[1]), ...}
     friend D max(const D& a, const D& b)
     {
-        return generate([](const T& x, const T& y) { return std::max(x, y); }, a, b);
+        D r(a);
+        Ops::maxEq(r.data(), b.data());
+        return r;
     }
 
     // Element-wise min.  {min(a[0],b[0]), min(a[1],b[1]), ...}
     friend D min(const D& a, const D& b)
     {
-        return generate([](const T& x, const T& y) { return std::min(x, y); }, a, b);
+        D r(a);
+        Ops::minEq(r.data(), b.data());
+        return r;
     }
 
-    T dotProd(const D& b) const
-    {
-        return dot(static_cast<T>(0), static_cast<const D&>(*this).data(), b.data(), IdxSeqN{});
-    }
+    T dotProd(const D& b) const { return Ops::dot(static_cast<const D&>(*this).data(), b.data()); }
 
     // Squared Euclidean norm (the dot product with itself).
-    T norm2() const { return DotProd(asD()); }
+    T norm2() const { return dotProd(asD()); }
 
     FloatType norm() const { return std::sqrt(norm2()); }
 
@@ -240,40 +448,6 @@ private:
     const D& asD() const { return static_cast<const D&>(*this); }
     D& asD() { return static_cast<D&>(*this); }
 
-    // Ignores its arguments so that side-effects of variadic unpacking can occur.
-    static void ignore(std::initializer_list<bool>) {}
-
-    template <std::size_t... Is>
-    static T dot(T sum, const T* a, const T* b, std::index_sequence<Is...>)
-    {
-        ignore({(sum += a[Is] * b[Is], true)...});
-        return sum;
-    }
-
-    template <std::size_t... Is>
-    static void plusEq(T* a, const T* b, std::index_sequence<Is...>)
-    {
-        ignore({(a[Is] += b[Is], true)...});
-    }
-
-    template <std::size_t... Is>
-    static void minusEq(T* a, const T* b, std::index_sequence<Is...>)
-    {
-        ignore({(a[Is] -= b[Is], true)...});
-    }
-
-    template <std::size_t... Is>
-    static void mulEq(T* a, T b, std::index_sequence<Is...>)
-    {
-        ignore({(a[Is] *= b, true)...});
-    }
-
-    template <std::size_t... Is>
-    static void divEq(T* a, T b, std::index_sequence<Is...>)
-    {
-        ignore({(a[Is] /= b, true)...});
-    }
-
     // ostream << uint8 prints the ASCII character, which is not useful.
     // Cast to int so that numbers will be printed instead.
     template <typename U>
@@ -374,9 +548,9 @@ public:
 
     Vector3 crossProd(const Vector3& vb) const
     {
-        Vector3(mData[1] * vb.mData[2] - mData[2] * vb.mData[1], //
-                mData[2] * vb.mData[0] - mData[0] * vb.mData[2], //
-                mData[0] * vb.mData[1] - mData[1] * vb.mData[0]);
+        Vector3 out;
+        internal::VectorOps<T, 3>::cross(out.mData, mData, vb.mData);
+        return out;
     }
 
     FloatType angle(const Vector3& va) const { return std::atan2(crossProd(va).norm(), this->dotProd(va)); }
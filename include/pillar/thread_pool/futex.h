@@ -0,0 +1,199 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#endif
+
+namespace yuzu
+{
+// Blocking on a 32-bit atomic word, the C++20 atomic wait/notify for C++17.
+// A futex on Linux, a table of striped condition variables elsewhere. As with
+// any futex, wakeups may be spurious: callers recheck their condition.
+namespace futex
+{
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+#if defined(__linux__)
+namespace detail
+{
+inline long call(std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op | FUTEX_PRIVATE_FLAG, value, timeout, nullptr,
+                   0);
+}
+} // namespace detail
+
+// Sleeps while `word` holds `expected`.
+inline void wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+    detail::call(word, FUTEX_WAIT, expected, nullptr);
+}
+
+// Same, for at most `timeout`.
+inline void waitFor(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout)
+{
+    if (timeout.count() <= 0)
+        return;
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    detail::call(word, FUTEX_WAIT, expected, &ts);
+}
+
+inline void wakeOne(std::atomic<uint32_t>& word) { detail::call(word, FUTEX_WAKE, 1, nullptr); }
+inline void wakeAll(std::atomic<uint32_t>& word) { detail::call(word, FUTEX_WAKE, INT_MAX, nullptr); }
+#else
+namespace detail
+{
+struct Bucket
+{
+    std::mutex mut;
+    std::condition_variable cond;
+};
+
+inline Bucket& bucketFor(const void* address)
+{
+    static Bucket buckets[64];
+    return buckets[(std::hash<const void*>()(address) >> 4) % 64];
+}
+} // namespace detail
+
+inline void wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+    detail::Bucket& bucket = detail::bucketFor(&word);
+    std::unique_lock<std::mutex> lk(bucket.mut);
+    if (word.load(std::memory_order_acquire) == expected)
+        bucket.cond.wait(lk);
+}
+
+inline void waitFor(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout)
+{
+    detail::Bucket& bucket = detail::bucketFor(&word);
+    std::unique_lock<std::mutex> lk(bucket.mut);
+    if (word.load(std::memory_order_acquire) == expected)
+        bucket.cond.wait_for(lk, timeout);
+}
+
+// Buckets are shared between words, so every waiter of the bucket is woken.
+inline void wakeOne(std::atomic<uint32_t>& word)
+{
+    detail::Bucket& bucket = detail::bucketFor(&word);
+    std::lock_guard<std::mutex> lk(bucket.mut);
+    bucket.cond.notify_all();
+}
+inline void wakeAll(std::atomic<uint32_t>& word) { wakeOne(word); }
+#endif
+} // namespace futex
+
+/**
+ * @brief Lets a thread sleep until a condition, checked without a lock, may
+ * have become true.
+ *
+ * A waiter calls `prepareWait`, rechecks its condition, then either
+ * `cancelWait` or `wait` with the returned key. A notifier makes the
+ * condition true, then calls `notify`, which costs a fence and a load when
+ * nobody sleeps. A notification between `prepareWait` and `wait` is not lost.
+ *
+ * One word holds the epoch (high half) and the number of registered waiters
+ * (low half). `notify` bumps the epoch and takes all waiters off the count,
+ * so a burst of notifications makes one futex call, not one per call.
+ */
+class EventCount
+{
+public:
+    EventCount() : mState(0) {}
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    uint32_t prepareWait()
+    {
+        const uint64_t state = mState.fetch_add(kWaiter, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return static_cast<uint32_t>(state >> kEpochShift);
+    }
+
+    void cancelWait(uint32_t key)
+    {
+        uint64_t state = mState.load(std::memory_order_relaxed);
+        // Once the epoch moved, a notifier already took us off the count.
+        while (static_cast<uint32_t>(state >> kEpochShift) == key &&
+               !mState.compare_exchange_weak(state, state - kWaiter, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void wait(uint32_t key)
+    {
+        while (epoch() == key)
+            futex::wait(epochWord(), key);
+    }
+
+    // Returns false on timeout.
+    template <class Rep, class Period>
+    bool waitFor(uint32_t key, std::chrono::duration<Rep, Period> timeout)
+    {
+        return waitUntil(key, std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <class Clock, class Duration>
+    bool waitUntil(uint32_t key, std::chrono::time_point<Clock, Duration> deadline)
+    {
+        while (epoch() == key)
+        {
+            const auto left = deadline - Clock::now();
+            if (left <= Duration::zero())
+            {
+                cancelWait(key);
+                return epoch() != key;
+            }
+            futex::waitFor(epochWord(), key, std::chrono::duration_cast<std::chrono::nanoseconds>(left));
+        }
+        return true;
+    }
+
+    // Wakes every registered waiter.
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t state = mState.load(std::memory_order_relaxed);
+        do
+        {
+            if ((state & kWaiterMask) == 0)
+                return;
+        } while (!mState.compare_exchange_weak(state, (state | kWaiterMask) + 1, std::memory_order_release,
+                                               std::memory_order_relaxed));
+        futex::wakeAll(epochWord());
+    }
+
+private:
+    static constexpr int kEpochShift = 32;
+    static constexpr uint64_t kWaiter = 1;
+    static constexpr uint64_t kWaiterMask = 0xffffffffull;
+
+    uint32_t epoch() const { return static_cast<uint32_t>(mState.load(std::memory_order_acquire) >> kEpochShift); }
+
+    // The futex sleeps on the epoch half of the word.
+    std::atomic<uint32_t>& epochWord()
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        const size_t offset = 0;
+#else
+        const size_t offset = sizeof(uint32_t);
+#endif
+        return *reinterpret_cast<std::atomic<uint32_t>*>(reinterpret_cast<char*>(&mState) + offset);
+    }
+
+    std::atomic<uint64_t> mState;
+};
+} // namespace yuzu
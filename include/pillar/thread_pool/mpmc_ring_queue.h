@@ -0,0 +1,188 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "pillar/thread_pool/futex.h"
+
+namespace yuzu
+{
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ *
+ * Dmitry Vyukov's ring: every slot carries a sequence number telling whether
+ * it is free for the producer claiming ticket `pos` (seq == pos) or filled
+ * for the consumer claiming it (seq == pos + 1). Producers and consumers only
+ * contend on their own cache-line padded counter, and a slot is handed over
+ * with a single release store.
+ *
+ * All memory is allocated by the constructor, so pushing and popping never
+ * allocate. `tryPush` fails when the queue is full, which gives producers
+ * backpressure; `push` and `waitAndPop` spin briefly, then sleep on a futex
+ * until the other side makes progress.
+ */
+template <class T>
+class MpmcRingQueue
+{
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit MpmcRingQueue(size_t capacity = 1024) : mHead(0), mTail(0)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+        mMask = rounded - 1;
+        mSlots.reset(new Slot[rounded]);
+        for (size_t i = 0; i < rounded; ++i)
+            mSlots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    ~MpmcRingQueue()
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        for (size_t pos = mHead.load(std::memory_order_relaxed); pos != tail; ++pos)
+            mSlots[pos & mMask].item()->~T();
+    }
+
+    MpmcRingQueue(const MpmcRingQueue&) = delete;
+    MpmcRingQueue& operator=(const MpmcRingQueue&) = delete;
+
+    // Fails, leaving `value` untouched, when the queue is full.
+    bool tryPush(const T& value) { return tryEmplace(value); }
+    bool tryPush(T&& value) { return tryEmplace(std::move(value)); }
+
+    // Blocks while the queue is full.
+    void push(T newValue)
+    {
+        for (int spin = 0; spin < kSpinRounds; ++spin)
+            if (tryEmplace(std::move(newValue)))
+                return;
+        for (;;)
+        {
+            const uint32_t key = mNotFull.prepareWait();
+            if (tryEmplace(std::move(newValue)))
+            {
+                mNotFull.cancelWait(key);
+                return;
+            }
+            mNotFull.wait(key);
+            if (tryEmplace(std::move(newValue)))
+                return;
+        }
+    }
+
+    bool tryPop(T& value)
+    {
+        size_t pos = mHead.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot& slot = mSlots[pos & mMask];
+            const size_t seq = slot.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    T* item = slot.item();
+                    value = std::move(*item);
+                    item->~T();
+                    slot.seq.store(pos + mMask + 1, std::memory_order_release);
+                    mNotFull.notify();
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = mHead.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Blocks while the queue is empty.
+    void waitAndPop(T& value)
+    {
+        for (int spin = 0; spin < kSpinRounds; ++spin)
+            if (tryPop(value))
+                return;
+        for (;;)
+        {
+            const uint32_t key = mNotEmpty.prepareWait();
+            if (tryPop(value))
+            {
+                mNotEmpty.cancelWait(key);
+                return;
+            }
+            mNotEmpty.wait(key);
+            if (tryPop(value))
+                return;
+        }
+    }
+
+    // Approximate while other threads push or pop.
+    size_t size() const
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mMask + 1; }
+
+private:
+    static constexpr int kSpinRounds = 64;
+
+    struct Slot
+    {
+        T* item() { return std::launder(reinterpret_cast<T*>(&storage)); }
+
+        std::atomic<size_t> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    template <class U>
+    bool tryEmplace(U&& value)
+    {
+        size_t pos = mTail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot& slot = mSlots[pos & mMask];
+            const size_t seq = slot.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    new (&slot.storage) T(std::forward<U>(value));
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    mNotEmpty.notify();
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = mTail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    // Consumers and producers each own a cache line.
+    alignas(64) std::atomic<size_t> mHead;
+    alignas(64) std::atomic<size_t> mTail;
+    alignas(64) std::unique_ptr<Slot[]> mSlots;
+    size_t mMask;
+    EventCount mNotEmpty;
+    EventCount mNotFull;
+};
+} // namespace yuzu
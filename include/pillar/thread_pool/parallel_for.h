@@ -0,0 +1,19 @@
+#pragma once
+#include <functional>
+
+namespace yuzu
+{
+/**
+ * @brief Splits `[begin, end)` into contiguous bands of at least `minBandSize`
+ * items and calls `fn(bandBegin, bandEnd)` for each band concurrently on the
+ * shared ThreadPool, at most one band per worker plus the caller. The calling
+ * thread processes bands itself and returns once every band is done; calling
+ * it from inside a pool task is fine.
+ *
+ * @param begin first index
+ * @param end one past the last index
+ * @param minBandSize smallest band worth a thread, ranges below it run inline
+ * @param fn the band body
+ */
+void parallelFor(int begin, int end, int minBandSize, const std::function<void(int, int)>& fn);
+} // namespace yuzu
@@ -0,0 +1,434 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pillar/status/status_code.h"
+#include "pillar/thread_pool/threadsafe_queue.h"
+
+namespace yuzu
+{
+struct PipelineOptions
+{
+    // Capacity of the queue in front of every stage and of the output queue.
+    // A full queue blocks the stage feeding it.
+    size_t queueCapacity = 16;
+    // Deliver the outputs in the order their inputs were pushed. `push` then
+    // also waits while the input would be more than one item per queue slot
+    // of the pipeline ahead of the next result to deliver.
+    bool ordered = false;
+};
+
+struct StageMetrics
+{
+    std::string name;
+    size_t workers = 0;
+    // Items the stage function was called on, and how many of them failed.
+    uint64_t processed = 0;
+    uint64_t failed = 0;
+    // Time spent in the stage function per item.
+    double meanLatencyUs = 0.0;
+    double maxLatencyUs = 0.0;
+    // Items waiting in front of the stage, now and at most.
+    size_t queueDepth = 0;
+    size_t maxQueueDepth = 0;
+};
+
+namespace pipeline_detail
+{
+template <class T>
+struct Item
+{
+    uint64_t seq = 0;
+    T value;
+};
+
+// Where a stage delivers its results: the next stage or the output.
+template <class T>
+class Sink
+{
+public:
+    virtual ~Sink() = default;
+    // False when the sink was closed or the pipeline cancelled.
+    virtual bool put(Item<T>&& item) = 0;
+    // Called once every producer feeding the sink is done.
+    virtual void close() = 0;
+};
+
+class Core;
+
+class StageBase
+{
+public:
+    StageBase(Core& core, std::string name, size_t workers);
+    virtual ~StageBase() = default;
+
+    virtual void start() = 0;
+    // Wakes every thread blocked on this stage.
+    virtual void cancel() = 0;
+    void join();
+    StageMetrics metrics() const;
+
+protected:
+    virtual size_t queueDepth() const = 0;
+    void record(std::chrono::steady_clock::duration latency, bool ok);
+    // Called after each push with the depth of the input queue.
+    void enqueued(size_t depth);
+
+protected:
+    Core& mCore;
+    const std::string mName;
+    const size_t mWorkers;
+    std::vector<std::thread> mThreads;
+    std::atomic<size_t> mLiveWorkers;
+
+private:
+    std::atomic<uint64_t> mProcessed;
+    std::atomic<uint64_t> mFailed;
+    std::atomic<uint64_t> mTotalNs;
+    std::atomic<uint64_t> mMaxNs;
+    std::atomic<size_t> mMaxDepth;
+};
+
+// State shared by the stages of one pipeline: the first error and the
+// cancellation flag.
+class Core
+{
+public:
+    // Keeps the first error and cancels every stage and the output.
+    void fail(Status status);
+    bool cancelled() const { return mCancelled.load(std::memory_order_acquire); }
+    Status status() const;
+
+    void add(std::unique_ptr<StageBase> stage) { mStages.push_back(std::move(stage)); }
+    size_t stageCount() const { return mStages.size(); }
+    void start();
+    void join();
+    std::vector<StageMetrics> metrics() const;
+
+    // Set once the output exists, so `fail` can wake its waiters too.
+    std::function<void()> cancelOutput;
+
+private:
+    std::vector<std::unique_ptr<StageBase>> mStages;
+    std::atomic<bool> mCancelled{false};
+    mutable std::mutex mMut;
+    Status mStatus = okStatus();
+};
+
+template <class In, class Out>
+class Stage final : public StageBase, public Sink<In>
+{
+public:
+    using Fn = std::function<Status(In&&, Out&)>;
+
+    Stage(Core& core, std::string name, size_t workers, size_t capacity, Fn fn)
+        : StageBase(core, std::move(name), workers), mInput(capacity), mFn(std::move(fn)), mNext(nullptr)
+    {
+    }
+
+    void connect(Sink<Out>* next) { mNext = next; }
+
+    bool put(Item<In>&& item) override
+    {
+        if (!mInput.push(std::move(item)))
+            return false;
+        enqueued(mInput.size());
+        return true;
+    }
+
+    void close() override { mInput.close(); }
+    void cancel() override { mInput.close(); }
+
+    void start() override
+    {
+        mLiveWorkers.store(mWorkers, std::memory_order_relaxed);
+        for (size_t i = 0; i < mWorkers; ++i)
+            mThreads.emplace_back(&Stage::run, this);
+    }
+
+private:
+    size_t queueDepth() const override { return mInput.size(); }
+
+    void run()
+    {
+        Item<In> item;
+        while (mInput.waitAndPop(item))
+        {
+            // Once cancelled, whatever is left in the queue is dropped.
+            if (mCore.cancelled())
+                continue;
+
+            Item<Out> out;
+            out.seq = item.seq;
+            const auto start = std::chrono::steady_clock::now();
+            const Status status = mFn(std::move(item.value), out.value);
+            record(std::chrono::steady_clock::now() - start, status.ok());
+            if (!status.ok())
+                mCore.fail(status);
+            else
+                mNext->put(std::move(out));
+        }
+        // The last worker out tells the next stage no more input is coming.
+        if (mLiveWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            mNext->close();
+    }
+
+private:
+    ThreadsafeQueue<Item<In>> mInput;
+    Fn mFn;
+    Sink<Out>* mNext;
+};
+
+// The end of the pipeline, optionally putting the results back in input
+// order. Out of order results wait in a buffer that stage workers never
+// block on: the buffer is bounded instead by `admit`, which holds back the
+// input until it is within `window` items of the next result to deliver.
+// Blocking workers would deadlock once the result everyone waits for sits
+// behind them in a full queue.
+template <class T>
+class Output final : public Sink<T>
+{
+public:
+    Output(Core& core, size_t capacity, size_t window, bool ordered)
+        : mCore(core), mQueue(capacity), mOrdered(ordered), mWindow(window), mNextSeq(0)
+    {
+    }
+
+    // Blocks until input `seq` fits in the window. False once cancelled.
+    bool admit(uint64_t seq)
+    {
+        if (!mOrdered)
+            return true;
+
+        std::unique_lock<std::mutex> lk(mMut);
+        mWindowCond.wait(lk, [&] { return seq < mNextSeq + mWindow || mCore.cancelled(); });
+        return !mCore.cancelled();
+    }
+
+    bool put(Item<T>&& item) override
+    {
+        if (!mOrdered)
+            return mQueue.push(std::move(item.value));
+
+        std::lock_guard<std::mutex> lk(mMut);
+        if (mCore.cancelled())
+            return false;
+        mPending.emplace(item.seq, std::move(item.value));
+        bool released = false;
+        for (auto it = mPending.begin(); it != mPending.end() && it->first == mNextSeq; it = mPending.erase(it))
+        {
+            mQueue.push(std::move(it->second));
+            ++mNextSeq;
+            released = true;
+        }
+        if (released)
+            mWindowCond.notify_all();
+        return true;
+    }
+
+    void close() override { mQueue.close(); }
+
+    void cancel()
+    {
+        // First, since `put` may block on the full queue holding `mMut`.
+        mQueue.close();
+        std::lock_guard<std::mutex> lk(mMut);
+        mWindowCond.notify_all();
+    }
+
+    bool pop(T& value) { return mQueue.waitAndPop(value); }
+
+private:
+    Core& mCore;
+    ThreadsafeQueue<T> mQueue;
+    const bool mOrdered;
+    const uint64_t mWindow;
+    std::mutex mMut;
+    std::condition_variable mWindowCond;
+    std::map<uint64_t, T> mPending;
+    uint64_t mNextSeq;
+};
+} // namespace pipeline_detail
+
+/**
+ * @brief A running chain of stages, built by PipelineBuilder.
+ *
+ * Inputs are pushed on one side, results popped on the other; every stage
+ * runs its own worker threads and is fed through a bounded queue, so a slow
+ * stage throttles everything upstream of it down to `push`. The first stage
+ * function returning an error cancels the pipeline: queued items are dropped,
+ * blocked calls return, and `finish` reports that error.
+ *
+ * Results must be popped while the pipeline runs, since a full output queue
+ * blocks the last stage.
+ */
+template <class In, class Out>
+class Pipeline
+{
+public:
+    ~Pipeline()
+    {
+        cancel();
+        mCore->join();
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Blocks while the first stage's queue is full, or while an ordered
+    // pipeline's reorder window is. Fails with kCancelled
+    // once the pipeline failed or was cancelled, with kFailedPrecondition
+    // after `close`.
+    Status push(In value)
+    {
+        std::lock_guard<std::mutex> lk(mPushMut);
+        if (mCore->cancelled())
+            return Status(StatusCode::kCancelled, "pipeline cancelled");
+        if (mClosed.load(std::memory_order_acquire))
+            return Status(StatusCode::kFailedPrecondition, "pipeline input is closed");
+
+        if (!mOutput->admit(mNextSeq))
+            return Status(StatusCode::kCancelled, "pipeline cancelled");
+
+        pipeline_detail::Item<In> item;
+        item.seq = mNextSeq;
+        item.value = std::move(value);
+        if (!mHead->put(std::move(item)))
+            return mCore->cancelled() ? Status(StatusCode::kCancelled, "pipeline cancelled")
+                                      : Status(StatusCode::kFailedPrecondition, "pipeline input is closed");
+        // Sequence numbers stay gapless, the ordered output waits for each.
+        ++mNextSeq;
+        return okStatus();
+    }
+
+    // No more input: the stages drain, then `pop` returns false.
+    void close()
+    {
+        if (!mClosed.exchange(true))
+            mHead->close();
+    }
+
+    // Blocks for the next result. Returns false once every result has been
+    // popped, or when the pipeline was cancelled.
+    bool pop(Out& value) { return mOutput->pop(value); }
+
+    void cancel() { mCore->fail(Status(StatusCode::kCancelled, "pipeline cancelled")); }
+
+    // Closes the input, waits for the stages to finish and returns the first
+    // error, ok if there was none.
+    Status finish()
+    {
+        close();
+        mCore->join();
+        return mCore->status();
+    }
+
+    std::vector<StageMetrics> metrics() const { return mCore->metrics(); }
+
+private:
+    template <class, class>
+    friend class PipelineBuilder;
+
+    Pipeline(std::unique_ptr<pipeline_detail::Core> core, std::unique_ptr<pipeline_detail::Output<Out>> output,
+             pipeline_detail::Sink<In>* head)
+        : mCore(std::move(core)), mOutput(std::move(output)), mHead(head), mClosed(false), mNextSeq(0)
+    {
+        pipeline_detail::Output<Out>* out = mOutput.get();
+        mCore->cancelOutput = [out] { out->cancel(); };
+        mCore->start();
+    }
+
+private:
+    std::unique_ptr<pipeline_detail::Core> mCore;
+    std::unique_ptr<pipeline_detail::Output<Out>> mOutput;
+    pipeline_detail::Sink<In>* mHead;
+    std::atomic<bool> mClosed;
+    std::mutex mPushMut;
+    uint64_t mNextSeq;
+};
+
+/**
+ * @brief Declares the stages of a Pipeline, checking at compile time that the
+ * output type of each stage is the input type of the next.
+ *
+ *   auto pipeline = PipelineBuilder<std::string>(options)
+ *                       .stage<ImageFrame>("decode", 2, decode)
+ *                       .stage<Tensor>("infer", 1, infer)
+ *                       .build();
+ *
+ * A stage function has the signature `Status(In&&, Out&)`, is called from
+ * `workers` threads at once and must be thread-safe. `Out` must be default
+ * constructible.
+ */
+template <class In, class Cur = In>
+class PipelineBuilder
+{
+public:
+    explicit PipelineBuilder(PipelineOptions options = PipelineOptions())
+        : mOptions(options), mCore(new pipeline_detail::Core()), mHead(nullptr)
+    {
+    }
+
+    template <class Next>
+    PipelineBuilder<In, Next> stage(std::string name, size_t workers, std::function<Status(Cur&&, Next&)> fn)
+    {
+        auto* stage = new pipeline_detail::Stage<Cur, Next>(*mCore, std::move(name), workers == 0 ? 1 : workers,
+                                                            mOptions.queueCapacity, std::move(fn));
+        mCore->add(std::unique_ptr<pipeline_detail::StageBase>(stage));
+        connect(stage);
+
+        PipelineBuilder<In, Next> next(mOptions);
+        next.mCore = std::move(mCore);
+        next.mHead = mHead;
+        next.mConnect = [stage](pipeline_detail::Sink<Next>* sink) { stage->connect(sink); };
+        return next;
+    }
+
+    std::unique_ptr<Pipeline<In, Cur>> build()
+    {
+        // A window as deep as every queue together never holds back input the
+        // queues could have taken.
+        const size_t capacity = mOptions.queueCapacity;
+        const size_t window = capacity == 0 ? 64 : capacity * (mCore->stageCount() + 1);
+        auto output = std::make_unique<pipeline_detail::Output<Cur>>(*mCore, capacity, window, mOptions.ordered);
+        connect(output.get());
+        return std::unique_ptr<Pipeline<In, Cur>>(new Pipeline<In, Cur>(std::move(mCore), std::move(output), mHead));
+    }
+
+private:
+    template <class, class>
+    friend class PipelineBuilder;
+
+    // Feeds the last stage declared so far, or the pipeline input, into `sink`.
+    void connect(pipeline_detail::Sink<Cur>* sink)
+    {
+        if (mConnect)
+        {
+            mConnect(sink);
+        }
+        else
+        {
+            if constexpr (std::is_same<In, Cur>::value)
+                mHead = sink;
+        }
+    }
+
+private:
+    PipelineOptions mOptions;
+    std::unique_ptr<pipeline_detail::Core> mCore;
+    pipeline_detail::Sink<In>* mHead;
+    std::function<void(pipeline_detail::Sink<Cur>*)> mConnect;
+};
+} // namespace yuzu
@@ -0,0 +1,272 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "pillar/thread_pool/futex.h"
+
+namespace yuzu
+{
+/**
+ * @brief Bounded single-producer single-consumer queue for pipeline edges.
+ *
+ * A Lamport ring: the producer owns the tail, the consumer the head, and each
+ * side keeps a private copy of the other's index which it only refreshes when
+ * the ring looks full (or empty). In the common case an operation touches no
+ * cache line written by the other thread. `tryPush`, `tryPop` and the batch
+ * calls are wait-free.
+ *
+ * With `FullPolicy::kOverwriteOldest` a push into a full ring drops the
+ * oldest item instead of failing, which suits live video where the latest
+ * frame matters. The consumer then claims items with a CAS, and a push may
+ * wait for a pop that is moving out the very item it would drop.
+ *
+ * Exactly one thread may push and one thread may pop at a time.
+ */
+template <class T>
+class SpscRingQueue
+{
+public:
+    enum class FullPolicy
+    {
+        // `tryPush` fails and `push` blocks while the ring is full.
+        kReject,
+        // Pushing never fails, the oldest item is dropped to make room.
+        kOverwriteOldest,
+    };
+
+    // `capacity` is rounded up to a power of two.
+    explicit SpscRingQueue(size_t capacity = 64, FullPolicy policy = FullPolicy::kReject)
+        : mPolicy(policy), mTail(0), mReleasedCache(0), mDropped(0), mHead(0), mReleased(0), mTailCache(0)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+        mMask = rounded - 1;
+        mItems = static_cast<T*>(::operator new(rounded * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    ~SpscRingQueue()
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        for (size_t pos = mReleased.load(std::memory_order_relaxed); pos != tail; ++pos)
+            mItems[pos & mMask].~T();
+        ::operator delete(mItems, std::align_val_t(alignof(T)));
+    }
+
+    SpscRingQueue(const SpscRingQueue&) = delete;
+    SpscRingQueue& operator=(const SpscRingQueue&) = delete;
+
+    // Producer. Fails, leaving `value` untouched, when a kReject ring is full.
+    bool tryPush(const T& value) { return tryEmplace(value); }
+    bool tryPush(T&& value) { return tryEmplace(std::move(value)); }
+
+    // Producer. Blocks while a kReject ring is full.
+    void push(T newValue)
+    {
+        while (!tryEmplace(std::move(newValue)))
+        {
+            const uint32_t key = mNotFull.prepareWait();
+            if (tryEmplace(std::move(newValue)))
+            {
+                mNotFull.cancelWait(key);
+                return;
+            }
+            mNotFull.wait(key);
+        }
+    }
+
+    // Producer. Pushes up to `count` items from `first` and publishes them at
+    // once; returns how many were taken. Pass a move iterator to move them.
+    template <class InputIt>
+    size_t pushN(InputIt first, size_t count)
+    {
+        if (mPolicy == FullPolicy::kOverwriteOldest)
+        {
+            for (size_t i = 0; i < count; ++i, ++first)
+                tryEmplace(*first);
+            return count;
+        }
+
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t room = capacity() - (tail - mReleasedCache);
+        if (room < count)
+        {
+            mReleasedCache = mReleased.load(std::memory_order_acquire);
+            room = capacity() - (tail - mReleasedCache);
+        }
+        const size_t n = count < room ? count : room;
+        for (size_t i = 0; i < n; ++i, ++first)
+            new (&mItems[(tail + i) & mMask]) T(*first);
+        if (n != 0)
+        {
+            mTail.store(tail + n, std::memory_order_release);
+            mNotEmpty.notify();
+        }
+        return n;
+    }
+
+    // Consumer.
+    bool tryPop(T& value) { return popN(&value, 1) == 1; }
+
+    // Consumer. Blocks while the ring is empty.
+    void waitAndPop(T& value)
+    {
+        while (!tryPop(value))
+        {
+            const uint32_t key = mNotEmpty.prepareWait();
+            if (tryPop(value))
+            {
+                mNotEmpty.cancelWait(key);
+                return;
+            }
+            mNotEmpty.wait(key);
+        }
+    }
+
+    // Consumer. Moves up to `maxCount` items to `out`, oldest first; returns
+    // how many.
+    template <class OutputIt>
+    size_t popN(OutputIt out, size_t maxCount)
+    {
+        if (mPolicy == FullPolicy::kOverwriteOldest)
+        {
+            size_t n = 0;
+            for (; n < maxCount && popClaimed(*out); ++n, ++out)
+            {
+            }
+            return n;
+        }
+
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        size_t available = mTailCache - head;
+        if (available < maxCount)
+        {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            available = mTailCache - head;
+        }
+        const size_t n = maxCount < available ? maxCount : available;
+        for (size_t i = 0; i < n; ++i, ++out)
+        {
+            T& item = mItems[(head + i) & mMask];
+            *out = std::move(item);
+            item.~T();
+        }
+        if (n != 0)
+        {
+            mHead.store(head + n, std::memory_order_relaxed);
+            mReleased.store(head + n, std::memory_order_release);
+            mNotFull.notify();
+        }
+        return n;
+    }
+
+    // Approximate unless called from the producer or the consumer while the
+    // other side is idle.
+    size_t size() const
+    {
+        const size_t tail = mTail.load(std::memory_order_acquire);
+        const size_t head = mHead.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mMask + 1; }
+    FullPolicy policy() const { return mPolicy; }
+
+    // Items dropped by kOverwriteOldest pushes.
+    size_t dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+    template <class U>
+    bool tryEmplace(U&& value)
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mReleasedCache > mMask)
+        {
+            mReleasedCache = mReleased.load(std::memory_order_acquire);
+            if (tail - mReleasedCache > mMask)
+            {
+                if (mPolicy == FullPolicy::kReject)
+                    return false;
+                dropOldest(tail);
+            }
+        }
+        new (&mItems[tail & mMask]) T(std::forward<U>(value));
+        mTail.store(tail + 1, std::memory_order_release);
+        mNotEmpty.notify();
+        return true;
+    }
+
+    // Producer, kOverwriteOldest on a full ring: frees the slot of the oldest
+    // item. When the consumer has already claimed that item, waits for it to
+    // finish moving it out instead.
+    void dropOldest(size_t tail)
+    {
+        for (;;)
+        {
+            size_t oldest = mReleasedCache;
+            if (mHead.compare_exchange_strong(oldest, oldest + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed))
+            {
+                mItems[oldest & mMask].~T();
+                mReleased.store(oldest + 1, std::memory_order_release);
+                mReleasedCache = oldest + 1;
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            std::this_thread::yield();
+            mReleasedCache = mReleased.load(std::memory_order_acquire);
+            if (tail - mReleasedCache <= mMask)
+                return;
+        }
+    }
+
+    // Consumer, kOverwriteOldest: the producer may drop the head concurrently,
+    // so the item is claimed before it is read.
+    template <class Out>
+    bool popClaimed(Out& out)
+    {
+        size_t head = mHead.load(std::memory_order_acquire);
+        do
+        {
+            // Drops can move the head past a stale cached tail.
+            if (head >= mTailCache)
+            {
+                mTailCache = mTail.load(std::memory_order_acquire);
+                if (head >= mTailCache)
+                    return false;
+            }
+        } while (!mHead.compare_exchange_weak(head, head + 1, std::memory_order_acquire, std::memory_order_acquire));
+
+        T& item = mItems[head & mMask];
+        out = std::move(item);
+        item.~T();
+        mReleased.store(head + 1, std::memory_order_release);
+        mNotFull.notify();
+        return true;
+    }
+
+private:
+    const FullPolicy mPolicy;
+    size_t mMask;
+    T* mItems;
+
+    // Producer side.
+    alignas(64) std::atomic<size_t> mTail;
+    size_t mReleasedCache;
+    std::atomic<size_t> mDropped;
+
+    // Consumer side. `mHead` is the next item to claim, `mReleased` the first
+    // slot still holding an item; they only differ while an item is moved out.
+    alignas(64) std::atomic<size_t> mHead;
+    std::atomic<size_t> mReleased;
+    size_t mTailCache;
+
+    alignas(64) EventCount mNotEmpty;
+    EventCount mNotFull;
+};
+} // namespace yuzu
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace yuzu
+{
+/**
+ * @brief A move-only `void()` callable, the unit of work of the thread pools.
+ *
+ * Unlike std::function it accepts move-only callables (a std::packaged_task,
+ * a lambda owning a unique_ptr), and callables of up to `kInlineSize` bytes
+ * are stored in place, so wrapping a small lambda does not allocate. Larger
+ * ones are moved to the heap.
+ */
+class Task
+{
+public:
+    static constexpr size_t kInlineSize = 48;
+
+    Task() noexcept : mVTable(nullptr) {}
+
+    template <class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+    Task(F&& f) : mVTable(&vtableFor<std::decay_t<F>>())
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (isInline<Fn>())
+            new (mStorage) Fn(std::forward<F>(f));
+        else
+            *reinterpret_cast<Fn**>(mStorage) = new Fn(std::forward<F>(f));
+    }
+
+    Task(Task&& other) noexcept : mVTable(other.mVTable)
+    {
+        if (mVTable != nullptr)
+        {
+            mVTable->move(mStorage, other.mStorage);
+            other.mVTable = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            mVTable = other.mVTable;
+            if (mVTable != nullptr)
+            {
+                mVTable->move(mStorage, other.mStorage);
+                other.mVTable = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    void operator()() { mVTable->invoke(mStorage); }
+
+    explicit operator bool() const noexcept { return mVTable != nullptr; }
+
+    // True if the callable lives in the task itself rather than on the heap.
+    bool isInline() const noexcept { return mVTable != nullptr && mVTable->isInline; }
+
+    void reset() noexcept
+    {
+        if (mVTable != nullptr)
+        {
+            mVTable->destroy(mStorage);
+            mVTable = nullptr;
+        }
+    }
+
+private:
+    struct VTable
+    {
+        void (*invoke)(void* storage);
+        // Move-constructs into `dst` and destroys `src`.
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+        bool isInline;
+    };
+
+    template <class Fn>
+    static constexpr bool isInline()
+    {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <class Fn>
+    static const VTable& vtableFor()
+    {
+        static constexpr VTable kInline = {
+            [](void* storage) { (*static_cast<Fn*>(storage))(); },
+            [](void* dst, void* src) noexcept
+            {
+                new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+                static_cast<Fn*>(src)->~Fn();
+            },
+            [](void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); },
+            true,
+        };
+        static constexpr VTable kHeap = {
+            [](void* storage) { (**static_cast<Fn**>(storage))(); },
+            [](void* dst, void* src) noexcept { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+            [](void* storage) noexcept { delete *static_cast<Fn**>(storage); },
+            false,
+        };
+        if constexpr (isInline<Fn>())
+            return kInline;
+        else
+            return kHeap;
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char mStorage[kInlineSize];
+    const VTable* mVTable;
+};
+} // namespace yuzu
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pillar/thread_pool/task.h"
+#include "pillar/thread_pool/threadsafe_queue.h"
+
+namespace yuzu
+{
+/**
+ * @brief A fixed set of worker threads fed from one ThreadsafeQueue<Task>.
+ *
+ * `submit` returns a std::future carrying the result, or the exception the
+ * callable threw. `post` is the fire-and-forget variant, it does not allocate
+ * for small callables; an exception escaping a posted task terminates the
+ * program, as it would on a std::thread.
+ *
+ * Destroying the pool runs every task already queued, then joins the workers.
+ */
+class ThreadPool
+{
+public:
+    // `threads` workers, zero means one per hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <class F, class... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        std::packaged_task<Result()> task(
+            [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable
+            { return std::apply(std::move(f), std::move(args)); });
+        std::future<Result> future = task.get_future();
+        post(Task(std::move(task)));
+        return future;
+    }
+
+    // Queues `task`. After `shutdown`, the task is destroyed without running
+    // and the future of a submitted task reports std::future_errc::broken_promise.
+    void post(Task task);
+
+    // Blocks until the queue is empty and no task is running.
+    void waitIdle();
+
+    // Stops accepting tasks and joins the workers. With `drain`, the tasks
+    // already queued run first, otherwise they are dropped. Idempotent.
+    void shutdown(bool drain = true);
+
+    size_t size() const { return mWorkers.size(); }
+    // Tasks queued or running.
+    size_t pending() const { return mPending.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void finishTask();
+
+private:
+    std::vector<std::thread> mWorkers;
+    ThreadsafeQueue<Task> mQueue;
+    std::atomic<bool> mAccepting;
+    std::atomic<size_t> mPending;
+    std::mutex mIdleMut;
+    std::condition_variable mIdleCond;
+    std::mutex mShutdownMut;
+};
+} // namespace yuzu
@@ -1,62 +1,127 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace yuzu
 {
+// Items are stored by value, pushing only allocates when the underlying
+// deque grows. The shared_ptr overloads wrap the popped item for callers that
+// want it.
+//
+// After `close` pushes are refused and, once the queue has drained, every
+// blocking pop returns false (or an empty pointer) instead of waiting.
+//
+// A non-zero `capacity` bounds the queue: `push` then blocks while it is full,
+// which gives producers backpressure.
 template <class T>
 class ThreadsafeQueue
 {
 public:
-    ThreadsafeQueue() = default;
+    explicit ThreadsafeQueue(size_t capacity = 0) : mCapacity(capacity) {}
 
-    void push(T newValue)
+    // Returns false, dropping `newValue`, once the queue is closed.
+    bool push(T newValue)
     {
-        std::shared_ptr<T> data(std::make_shared<T>(std::move(newValue)));
-        std::lock_guard<std::mutex> lk(mMut);
-        mData.push(data);
-        mDataCond.notify_one();
+        std::unique_lock<std::mutex> lk(mMut);
+        if (mCapacity != 0)
+            mSpaceCond.wait(lk, [this] { return mData.size() < mCapacity || mClosed; });
+        if (mClosed)
+            return false;
+        mData.push(std::move(newValue));
+        // A batch waiter may not want a single item, so it must not swallow
+        // the only notification.
+        if (mBatchWaiters != 0)
+            mDataCond.notify_all();
+        else
+            mDataCond.notify_one();
+        return true;
     }
 
-    void waitAndPop(T& value)
+    bool waitAndPop(T& value)
     {
         std::unique_lock<std::mutex> lk(mMut);
-        mDataCond.wait(lk, [this] { return !mData.empty(); });
-        value = std::move(*mData.front());
-        mData.pop();
+        mDataCond.wait(lk, [this] { return !mData.empty() || mClosed; });
+        return popLocked(value);
     }
 
     std::shared_ptr<T> waitAndPop()
     {
         std::unique_lock<std::mutex> lk(mMut);
-        mDataCond.wait(lk, [this] { return !mData.empty(); });
-        std::shared_ptr<T> res = mData.front();
-        mData.pop();
-        return res;
+        mDataCond.wait(lk, [this] { return !mData.empty() || mClosed; });
+        return popLocked();
+    }
+
+    // Returns false on timeout or once closed and drained.
+    template <class Rep, class Period>
+    bool waitAndPopFor(T& value, std::chrono::duration<Rep, Period> timeout)
+    {
+        return waitAndPopUntil(value, std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <class Clock, class Duration>
+    bool waitAndPopUntil(T& value, std::chrono::time_point<Clock, Duration> deadline)
+    {
+        std::unique_lock<std::mutex> lk(mMut);
+        mDataCond.wait_until(lk, deadline, [this] { return !mData.empty() || mClosed; });
+        return popLocked(value);
+    }
+
+    // Waits until `maxItems` items are queued, the queue is closed or
+    // `timeout` expires, then appends up to `maxItems` items to `out` under a
+    // single lock. Returns how many were appended, zero on timeout.
+    template <class Rep, class Period>
+    size_t waitAndPopBatch(std::vector<T>& out, size_t maxItems, std::chrono::duration<Rep, Period> timeout)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lk(mMut);
+        ++mBatchWaiters;
+        mDataCond.wait_until(lk, deadline, [&] { return mData.size() >= maxItems || mClosed; });
+        --mBatchWaiters;
+
+        const size_t n = std::min(maxItems, mData.size());
+        for (size_t i = 0; i < n; ++i)
+        {
+            out.push_back(std::move(mData.front()));
+            mData.pop();
+        }
+        if (mCapacity != 0 && n != 0)
+            mSpaceCond.notify_all();
+        return n;
     }
 
     bool tryPop(T& value)
     {
         std::lock_guard<std::mutex> lk(mMut);
-        if (mData.empty())
-            return false;
-        value = std::move(*mData.front());
-        mData.pop();
-        return true;
+        return popLocked(value);
     }
 
     std::shared_ptr<T> tryPop()
     {
         std::lock_guard<std::mutex> lk(mMut);
-        if (mData.empty())
-            return std::shared_ptr<T>();
-        std::shared_ptr<T> res = mData.front();
-        mData.pop();
-        return res;
+        return popLocked();
+    }
+
+    // Refuses further pushes and wakes every waiter. Items already queued can
+    // still be popped.
+    void close()
+    {
+        std::lock_guard<std::mutex> lk(mMut);
+        mClosed = true;
+        mDataCond.notify_all();
+        mSpaceCond.notify_all();
+    }
+
+    bool isClosed() const
+    {
+        std::lock_guard<std::mutex> lk(mMut);
+        return mClosed;
     }
 
     bool empty() const
@@ -71,15 +136,47 @@ public:
         return mData.size();
     }
 
+    // Zero when unbounded.
+    size_t capacity() const { return mCapacity; }
+
+private:
+    bool popLocked(T& value)
+    {
+        if (mData.empty())
+            return false;
+        value = std::move(mData.front());
+        mData.pop();
+        if (mCapacity != 0)
+            mSpaceCond.notify_one();
+        return true;
+    }
+
+    std::shared_ptr<T> popLocked()
+    {
+        if (mData.empty())
+            return std::shared_ptr<T>();
+        std::shared_ptr<T> res = std::make_shared<T>(std::move(mData.front()));
+        mData.pop();
+        if (mCapacity != 0)
+            mSpaceCond.notify_one();
+        return res;
+    }
+
 private:
-    std::queue<std::shared_ptr<T>> mData;
+    std::queue<T> mData;
     mutable std::mutex mMut;
     std::condition_variable mDataCond;
+    std::condition_variable mSpaceCond;
+    const size_t mCapacity;
+    size_t mBatchWaiters = 0;
+    bool mClosed = false;
 };
 } // namespace yuzu
 
 namespace yuzu
 {
+// Same contract as ThreadsafeQueue, with separate locks for the head and the
+// tail so a producer and a consumer do not contend.
 template <class T = int>
 class FineGrainedThreadsafeQueue
 {
@@ -104,8 +201,16 @@ public:
     std::shared_ptr<T> tryPop();
     bool tryPop(T& value);
     std::shared_ptr<T> waitAndPop();
-    void waitAndPop(T& value);
-    void push(T newValue);
+    bool waitAndPop(T& value);
+    template <class Rep, class Period>
+    bool waitAndPopFor(T& value, std::chrono::duration<Rep, Period> timeout);
+    template <class Clock, class Duration>
+    bool waitAndPopUntil(T& value, std::chrono::time_point<Clock, Duration> deadline);
+    template <class Rep, class Period>
+    size_t waitAndPopBatch(std::vector<T>& out, size_t maxItems, std::chrono::duration<Rep, Period> timeout);
+    bool push(T newValue);
+    void close();
+    bool isClosed() const { return mClosed.load(std::memory_order_acquire); }
     bool empty();
     size_t size();
 
@@ -116,30 +221,42 @@ private:
         return mTail;
     }
 
+    bool hasData() { return mHead.get() != getTail(); }
+
     std::unique_ptr<Node> popHead()
     {
         std::unique_ptr<Node> oldHead = std::move(mHead);
         mHead = std::move(oldHead->next);
-        --mCount;
+        mCount.fetch_sub(1, std::memory_order_relaxed);
         return oldHead;
     }
 
     std::unique_lock<std::mutex> waitForData()
     {
         std::unique_lock<std::mutex> headLock(mHeadMut);
-        mDataCond.wait(headLock, [&] { return mHead.get() != getTail(); });
+        mDataCond.wait(headLock, [&] { return hasData() || isClosed(); });
         return std::move(headLock);
     }
 
     std::unique_ptr<Node> waitPopHead()
     {
         std::unique_lock<std::mutex> headLock(waitForData());
+        if (!hasData())
+        {
+            return std::unique_ptr<Node>();
+        }
+
         return popHead();
     }
 
     std::unique_ptr<Node> waitPopHead(T& value)
     {
         std::unique_lock<std::mutex> headLock(waitForData());
+        if (!hasData())
+        {
+            return std::unique_ptr<Node>();
+        }
+
         value = std::move(*mHead->data);
         return popHead();
     }
@@ -147,7 +264,7 @@ private:
     std::unique_ptr<Node> tryPopHead()
     {
         std::lock_guard<std::mutex> headLock(mHeadMut);
-        if (mHead.get() == getTail())
+        if (!hasData())
         {
             return std::unique_ptr<Node>();
         }
@@ -158,7 +275,7 @@ private:
     std::unique_ptr<Node> tryPopHead(T& value)
     {
         std::lock_guard<std::mutex> headLock(mHeadMut);
-        if (mHead.get() == getTail())
+        if (!hasData())
         {
             return std::unique_ptr<Node>();
         }
@@ -168,38 +285,116 @@ private:
     }
 
 private:
-    size_t mCount = 0;
+    // Pushed under the tail lock, popped under the head lock.
+    std::atomic<size_t> mCount{0};
+    std::atomic<size_t> mBatchWaiters{0};
+    std::atomic<bool> mClosed{false};
 };
 
 template <class T>
-void FineGrainedThreadsafeQueue<T>::push(T newValue)
+bool FineGrainedThreadsafeQueue<T>::push(T newValue)
 {
     std::shared_ptr<T> newData(std::make_shared<T>(std::move(newValue)));
     std::unique_ptr<Node> p(new Node);
 
     {
         std::lock_guard<std::mutex> tailLock(mTailMut);
+        if (mClosed.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
         mTail->data = newData;
         Node* const newTail = p.get();
         mTail->next = std::move(p);
         mTail = newTail;
-        ++mCount;
+        mCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // See ThreadsafeQueue::push.
+    if (mBatchWaiters.load(std::memory_order_relaxed) != 0)
+    {
+        mDataCond.notify_all();
     }
+    else
+    {
+        mDataCond.notify_one();
+    }
+    return true;
+}
 
-    mDataCond.notify_one();
+template <class T>
+void FineGrainedThreadsafeQueue<T>::close()
+{
+    {
+        std::lock_guard<std::mutex> tailLock(mTailMut);
+        mClosed.store(true, std::memory_order_release);
+    }
+    // Under the head lock so that no waiter misses it between checking and
+    // sleeping.
+    std::lock_guard<std::mutex> headLock(mHeadMut);
+    mDataCond.notify_all();
 }
 
 template <class T>
 std::shared_ptr<T> FineGrainedThreadsafeQueue<T>::waitAndPop()
 {
     std::unique_ptr<Node> const oldHead = waitPopHead();
-    return oldHead->data;
+    return oldHead ? oldHead->data : std::shared_ptr<T>();
 }
 
 template <class T>
-void FineGrainedThreadsafeQueue<T>::waitAndPop(T& value)
+bool FineGrainedThreadsafeQueue<T>::waitAndPop(T& value)
 {
     std::unique_ptr<Node> const oldHead = waitPopHead(value);
+    return oldHead != nullptr;
+}
+
+template <class T>
+template <class Rep, class Period>
+bool FineGrainedThreadsafeQueue<T>::waitAndPopFor(T& value, std::chrono::duration<Rep, Period> timeout)
+{
+    return waitAndPopUntil(value, std::chrono::steady_clock::now() + timeout);
+}
+
+template <class T>
+template <class Clock, class Duration>
+bool FineGrainedThreadsafeQueue<T>::waitAndPopUntil(T& value, std::chrono::time_point<Clock, Duration> deadline)
+{
+    std::unique_lock<std::mutex> headLock(mHeadMut);
+    mDataCond.wait_until(headLock, deadline, [&] { return hasData() || isClosed(); });
+    if (!hasData())
+    {
+        return false;
+    }
+
+    value = std::move(*mHead->data);
+    popHead();
+    return true;
+}
+
+template <class T>
+template <class Rep, class Period>
+size_t FineGrainedThreadsafeQueue<T>::waitAndPopBatch(std::vector<T>& out, size_t maxItems,
+                                                      std::chrono::duration<Rep, Period> timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> headLock(mHeadMut);
+    mBatchWaiters.fetch_add(1, std::memory_order_relaxed);
+    mDataCond.wait_until(headLock, deadline,
+                         [&] { return mCount.load(std::memory_order_relaxed) >= maxItems || isClosed(); });
+    mBatchWaiters.fetch_sub(1, std::memory_order_relaxed);
+
+    // The tail is read once: every node before it is complete, and only the
+    // holder of the head lock touches them, so the batch drains without
+    // going back to the tail lock per item.
+    const Node* const tail = getTail();
+    size_t n = 0;
+    for (; n < maxItems && mHead.get() != tail; ++n)
+    {
+        out.push_back(std::move(*mHead->data));
+        popHead();
+    }
+    return n;
 }
 
 template <class T>
@@ -220,13 +415,11 @@ template <class T>
 bool FineGrainedThreadsafeQueue<T>::empty()
 {
     std::lock_guard<std::mutex> headLock(mHeadMut);
-    return mHead.get() == getTail();
+    return !hasData();
 }
 template <class T>
 size_t FineGrainedThreadsafeQueue<T>::size()
 {
-    std::lock_guard<std::mutex> headLock(mHeadMut);
-    std::lock_guard<std::mutex> tailLock(mTailMut);
-    return mCount;
+    return mCount.load(std::memory_order_relaxed);
 }
 } // namespace yuzu
@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace yuzu
+{
+/**
+ * @brief Chase-Lev work-stealing deque, with the memory orderings of
+ * Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models".
+ *
+ * The owner thread pushes and pops at the bottom (LIFO, the most recently
+ * spawned and cache-hot work first), any other thread steals from the top
+ * (FIFO, the oldest and usually largest work). The ring grows when full;
+ * outgrown rings are kept until the deque is destroyed, since a thief may
+ * still be reading them.
+ *
+ * `T` must be trivially copyable, typically a pointer.
+ */
+template <class T>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque holds trivially copyable items");
+
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit WorkStealingDeque(size_t capacity = 1024) : mTop(0), mBottom(0)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+        mRings.emplace_back(new Ring(rounded));
+        mRing.store(mRings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void push(T item)
+    {
+        const int64_t b = mBottom.load(std::memory_order_relaxed);
+        const int64_t t = mTop.load(std::memory_order_acquire);
+        Ring* ring = mRing.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(ring->mask))
+        {
+            ring = grow(ring, t, b);
+        }
+        ring->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        mBottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only, takes the most recently pushed item.
+    bool pop(T& item)
+    {
+        const int64_t b = mBottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = mRing.load(std::memory_order_relaxed);
+        mBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = mTop.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            mBottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = ring->get(b);
+        if (t == b)
+        {
+            // Last item, race the thieves for it.
+            const bool won =
+                mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            mBottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread, takes the oldest item. Fails when empty or when losing a
+    // race with another thief or the owner.
+    bool steal(T& item)
+    {
+        int64_t t = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = mBottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+
+        Ring* ring = mRing.load(std::memory_order_acquire);
+        item = ring->get(t);
+        return mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // Approximate when called concurrently with the owner.
+    size_t size() const
+    {
+        const int64_t b = mBottom.load(std::memory_order_relaxed);
+        const int64_t t = mTop.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Ring
+    {
+        explicit Ring(size_t capacity) : mask(capacity - 1), items(new std::atomic<T>[capacity]) {}
+
+        T get(int64_t i) const { return items[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T item) { items[static_cast<size_t>(i) & mask].store(item, std::memory_order_relaxed); }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    Ring* grow(Ring* ring, int64_t t, int64_t b)
+    {
+        mRings.emplace_back(new Ring(2 * (ring->mask + 1)));
+        Ring* bigger = mRings.back().get();
+        for (int64_t i = t; i < b; ++i)
+        {
+            bigger->put(i, ring->get(i));
+        }
+        mRing.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+private:
+    // Thieves hammer the top, the owner the bottom: keep them apart.
+    alignas(64) std::atomic<int64_t> mTop;
+    alignas(64) std::atomic<int64_t> mBottom;
+    alignas(64) std::atomic<Ring*> mRing;
+    // Owner only.
+    std::vector<std::unique_ptr<Ring>> mRings;
+};
+} // namespace yuzu
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pillar/thread_pool/task.h"
+#include "pillar/thread_pool/work_stealing_deque.h"
+
+namespace yuzu
+{
+/**
+ * @brief Work-stealing executor for many small, possibly nested tasks.
+ *
+ * Every worker owns a WorkStealingDeque. Tasks posted from inside a task of
+ * this pool go to the worker's own deque and are popped LIFO; tasks posted
+ * from other threads go to a shared injection queue. A worker out of work
+ * steals FIFO from the others, spins for a while, then parks on a condition
+ * variable until new work is posted. There is no single lock every task goes
+ * through, unlike ThreadPool, which keeps it scaling with the core count.
+ *
+ * Same surface as ThreadPool: `submit` returns a future carrying the result
+ * or the exception, `post` is fire-and-forget and an exception escaping a
+ * posted task terminates the program. Destroying the pool runs every task
+ * already posted, including those they spawn, then joins the workers.
+ */
+class WorkStealingPool
+{
+public:
+    // `threads` workers, zero means one per hardware thread.
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    template <class F, class... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        std::packaged_task<Result()> task(
+            [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable
+            { return std::apply(std::move(f), std::move(args)); });
+        std::future<Result> future = task.get_future();
+        post(Task(std::move(task)));
+        return future;
+    }
+
+    // Queues `task`, on the local deque when called from one of the workers.
+    // After `shutdown`, tasks from outside the pool are dropped.
+    void post(Task task);
+
+    // Blocks until no task is queued or running. Must not be called from a
+    // worker.
+    void waitIdle();
+
+    // Runs everything posted so far, then joins the workers. Idempotent;
+    // `size` is 0 afterwards.
+    void shutdown();
+
+    size_t size() const { return mWorkers.size(); }
+    size_t pending() const { return mPending.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker
+    {
+        ~Worker();
+
+        WorkStealingDeque<Task*> deque;
+        std::thread thread;
+        uint64_t rng;
+        // Free task slots, touched by this worker only.
+        std::vector<Task*> freeSlots;
+    };
+
+    void run(size_t index);
+    Task* findTask(Worker& self, size_t index);
+    Task* popInjected();
+    Task* acquireSlot(Worker& self);
+    void releaseSlot(Worker& self, Task* slot);
+    Task* takeSharedSlot();
+    bool hasQueuedWork() const;
+    void park();
+    void wakeOne();
+    void finishTask();
+
+private:
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+
+    // Guards the injection queue and the shared free slots. Tasks live in
+    // slots that are reused rather than freed: a worker keeps a cache of them
+    // and trades batches with the shared list when it runs dry or overflows,
+    // so slots freed by thieves flow back to the workers that post.
+    std::mutex mInjectMut;
+    std::deque<Task*> mInjected;
+    std::atomic<size_t> mInjectedCount;
+    std::vector<Task*> mFreeSlots;
+
+    // Event count for parking: a sleeper reads the epoch, announces itself,
+    // rechecks for work and only then waits for the epoch to move.
+    std::mutex mParkMut;
+    std::condition_variable mParkCond;
+    std::atomic<uint64_t> mEpoch;
+    std::atomic<int> mSleepers;
+
+    std::atomic<bool> mStopping;
+    std::atomic<size_t> mPending;
+    std::mutex mIdleMut;
+    std::condition_variable mIdleCond;
+    std::mutex mShutdownMut;
+};
+} // namespace yuzu
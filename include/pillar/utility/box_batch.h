@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/framework/deps/aligned_malloc_and_free.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+// A box kept by non-maximum suppression and its score, which soft-NMS may
+// have lowered.
+struct KeptBox
+{
+    size_t index;
+    float score;
+};
+
+/**
+ * @brief Detection boxes stored column by column: xmin, ymin, xmax, ymax,
+ * score and label each in their own aligned array.
+ *
+ * The suppression kernels load eight or sixteen boxes per instruction from the
+ * columns instead of pulling the fields out of Rectangle objects one at a time.
+ */
+class BoxBatch
+{
+public:
+    size_t size() const { return mScores.size(); }
+    bool empty() const { return mScores.empty(); }
+
+    void reserve(size_t count);
+    void clear();
+
+    void add(float xmin, float ymin, float xmax, float ymax, float score, int32_t label = 0);
+    void add(const Rectangle<float>& box, float score, int32_t label = 0);
+
+    const float* xmin() const { return mXMin.data(); }
+    const float* ymin() const { return mYMin.data(); }
+    const float* xmax() const { return mXMax.data(); }
+    const float* ymax() const { return mYMax.data(); }
+    const float* scores() const { return mScores.data(); }
+    const int32_t* labels() const { return mLabels.data(); }
+
+    Rectangle<float> rectangle(size_t i) const;
+    // The kept boxes, in the order given.
+    std::vector<Rectangle<float>> rectangles(const std::vector<KeptBox>& kept) const;
+
+private:
+    template <class T>
+    using Column = std::vector<T, AlignedAllocator<T>>;
+
+    Column<float> mXMin;
+    Column<float> mYMin;
+    Column<float> mXMax;
+    Column<float> mYMax;
+    Column<float> mScores;
+    Column<int32_t> mLabels;
+};
+
+struct NmsOptions
+{
+    // A box overlapping a kept one by more than this is suppressed.
+    float iouThreshold = 0.5f;
+    // Boxes scoring below this are dropped up front.
+    float scoreThreshold = 0.0f;
+    // Boxes kept at most, 0 keeps all. With `classAware` the limit is on the
+    // merged result.
+    size_t maxDetections = 0;
+    // Only boxes of the same label suppress each other.
+    bool classAware = false;
+};
+
+enum class SoftNmsMethod
+{
+    // score *= 1 - iou, for an overlap above `iouThreshold`.
+    kLinear,
+    // score *= exp(-iou * iou / sigma).
+    kGaussian,
+};
+
+struct SoftNmsOptions
+{
+    SoftNmsMethod method = SoftNmsMethod::kGaussian;
+    float sigma = 0.5f;
+    float iouThreshold = 0.3f;
+    // Boxes whose score falls below this are dropped.
+    float scoreThreshold = 0.001f;
+    size_t maxDetections = 0;
+    bool classAware = false;
+};
+
+// Intersection over union of `box` with every box of `boxes` into `ious`,
+// `boxes.size()` floats. Uses the widest SIMD kernel the CPU supports.
+void intersectionOverUnion(const BoxBatch& boxes, const Rectangle<float>& box, float* ious);
+void intersectionOverUnion(const BoxBatch& boxes, const Rectangle<float>& box, float* ious,
+                           cpu::SimdLevel maxLevel);
+
+// Greedy non-maximum suppression, the kept boxes best first. The candidates
+// are sorted once, per label with `classAware`, and every kept box removes
+// the ones it overlaps from the rest in one vectorized pass, so later passes
+// only see the survivors.
+void nonMaxSuppression(const BoxBatch& boxes, const NmsOptions& options, std::vector<KeptBox>& kept);
+void nonMaxSuppression(const BoxBatch& boxes, const NmsOptions& options, std::vector<KeptBox>& kept,
+                       cpu::SimdLevel maxLevel);
+
+// Soft-NMS (Bodla et al.): instead of removing overlapping boxes it lowers
+// their scores, so the next box kept is the best one left after decay.
+void softNonMaxSuppression(const BoxBatch& boxes, const SoftNmsOptions& options, std::vector<KeptBox>& kept);
+void softNonMaxSuppression(const BoxBatch& boxes, const SoftNmsOptions& options, std::vector<KeptBox>& kept,
+                           cpu::SimdLevel maxLevel);
+} // namespace yuzu
@@ -0,0 +1,77 @@
+#pragma once
+#include <ostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PILLAR_ARCH_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define PILLAR_ARCH_ARM 1
+#endif
+
+// Kernels for wider instruction sets are compiled into the same translation
+// unit as the scalar code and enabled per function, so the library itself is
+// built for the baseline ISA and picks the best kernel at runtime.
+#if defined(__GNUC__) || defined(__clang__)
+#define PILLAR_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PILLAR_TARGET(isa)
+#endif
+
+#define PILLAR_TARGET_SSE41 PILLAR_TARGET("sse4.1")
+#define PILLAR_TARGET_AVX2 PILLAR_TARGET("avx2,fma,f16c")
+#define PILLAR_TARGET_AVX512 PILLAR_TARGET("avx512f,avx512bw,avx512vl,avx512dq,avx2,fma,f16c")
+// VNNI is not part of a level, kernels using it also check features().
+#define PILLAR_TARGET_AVXVNNI PILLAR_TARGET("avx2,fma,f16c,avxvnni")
+#define PILLAR_TARGET_AVX512VNNI PILLAR_TARGET("avx512f,avx512bw,avx512vl,avx512dq,avx512vnni,avx2,fma,f16c")
+
+namespace yuzu
+{
+namespace cpu
+{
+enum class SimdLevel : int
+{
+    kScalar = 0,
+    // SSE2 up to SSE4.1, including SSSE3 shuffles.
+    kSSE41 = 1,
+    // AVX2 together with FMA and F16C.
+    kAVX2 = 2,
+    // AVX-512 F/BW/VL/DQ.
+    kAVX512 = 3,
+};
+
+struct Features
+{
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool avx512dq = false;
+    bool avx512vnni = false;
+    bool avxvnni = false;
+    bool neon = false;
+};
+
+/**
+ * @brief Returns the instruction set extensions supported by both the CPU and
+ * the operating system. Detected once, on first use.
+ */
+const Features& features();
+
+/**
+ * @brief Returns the widest SIMD level usable on this machine.
+ *
+ * The environment variable `PILLAR_SIMD_LEVEL` (scalar, sse41, avx2, avx512)
+ * caps the level, which is handy to compare kernels or to work around a
+ * misbehaving host.
+ */
+SimdLevel simdLevel();
+
+const char* toString(SimdLevel level);
+std::ostream& operator<<(std::ostream& os, SimdLevel level);
+} // namespace cpu
+} // namespace yuzu
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pillar/framework/deps/aligned_malloc_and_free.h"
+#include "pillar/framework/types/data_type.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+// A gallery row and its cosine similarity to a query.
+struct GalleryMatch
+{
+    size_t index;
+    float score;
+};
+
+/**
+ * @brief A gallery of `dim` float embeddings in one aligned row-major matrix.
+ * Rows are L2-normalized when added and padded with zeros to a whole number
+ * of cache lines, so matching a query is a dot product per row and a batch of
+ * queries is a tiled matrix product against the whole gallery.
+ *
+ * Rows can be kept as floats, half precision or int8 with one scale per row,
+ * trading recall for a half or a quarter of the memory.
+ */
+class EmbeddingGallery
+{
+public:
+    // `storage` is DataType::kFLOAT, kHALF or kINT8, anything else keeps floats.
+    // A zero `dim` is rejected: the gallery stays empty and refuses every row.
+    explicit EmbeddingGallery(unsigned int dim, DataType storage = DataType::kFLOAT);
+
+    // A read-only view over `count` rows already in the gallery layout:
+    // normalized, `stride()` elements each, 64-byte aligned, with one scale
+    // per row for int8. Nothing is copied, the memory must outlive the view.
+    // With a zero `dim` the view is empty whatever `count` says.
+    EmbeddingGallery(unsigned int dim, DataType storage, const void* rows, size_t count,
+                     const float* scales = nullptr);
+
+    unsigned int dim() const { return mDim; }
+    DataType storage() const { return mStorage; }
+    // Elements per row, `dim` rounded up to a whole cache line.
+    size_t stride() const { return mStride; }
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    bool isView() const { return mView; }
+    // Bytes per row, a multiple of 64.
+    size_t rowPitch() const { return mRowBytes; }
+    // Bytes taken by the rows and their scales.
+    size_t memoryBytes() const { return mSize * (mRowBytes + (mStorage == DataType::kINT8 ? sizeof(float) : 0)); }
+
+    void reserve(size_t rows);
+    void clear();
+
+    // The normalized row `i` of a float gallery, `stride()` floats.
+    const float* row(size_t i) const { return reinterpret_cast<const float*>(rowBytes(i)); }
+
+    // Row `i` as stored, `rowPitch()` bytes.
+    const void* rowData(size_t i) const { return rowBytes(i); }
+
+    // The normalized row `i` as `dim` floats, whatever the storage.
+    void dequantizeRow(size_t i, float* out) const;
+
+    // Normalizes and appends `embedding`, `dim` floats. A zero vector has no
+    // direction and is rejected, so is any add to a view.
+    Status add(const float* embedding);
+
+    // Appends `count` row-major embeddings. Stops at the first zero vector,
+    // the rows before it stay added.
+    Status addBatch(const float* embeddings, size_t count);
+
+    // Cosine similarity of `query` against every row into `scores`, `size()`
+    // floats.
+    Status match(const float* query, float* scores) const;
+
+    // Cosine similarity of `count` row-major queries against every row into
+    // `scores`, row-major `count` x `size()`.
+    Status match(const float* queries, size_t count, float* scores) const;
+
+    // Same, with a kernel no wider than `maxLevel`.
+    Status match(const float* queries, size_t count, float* scores, cpu::SimdLevel maxLevel) const;
+
+    // The `k` rows most similar to `query` scoring at least `threshold`,
+    // best first, ties by index. Scores are selected as each block is
+    // computed, no gallery-sized score vector is built. With `k == 0` every
+    // row passing `threshold` is returned.
+    Status topK(const float* query, size_t k, float threshold, std::vector<GalleryMatch>& matches) const;
+
+    // Same for `count` row-major queries, `matches[q]` for query `q`.
+    Status topK(const float* queries, size_t count, size_t k, float threshold,
+                std::vector<std::vector<GalleryMatch>>& matches) const;
+
+private:
+    // Queries normalized, and quantized for int8 rows, in the row layout.
+    struct Queries;
+
+    Status prepareQueries(const float* queries, size_t count, cpu::SimdLevel level, Queries& prepared) const;
+
+    // Scores every prepared query against rows [first, first + rows).
+    void scoreBlock(const Queries& queries, size_t first, size_t rows, float* scores, size_t scoreStride) const;
+
+    // Rows per block of the tiled product.
+    size_t blockRows() const;
+
+    const uint8_t* rowBytes(size_t i) const { return (mView ? mViewRows : mData.data()) + i * mRowBytes; }
+    const float* scaleData() const { return mView ? mViewScales : mScales.data(); }
+
+    unsigned int mDim;
+    DataType mStorage;
+    size_t mStride;
+    size_t mRowBytes;
+    size_t mSize = 0;
+    std::vector<uint8_t, AlignedAllocator<uint8_t>> mData;
+    // Per-row scales of int8 rows.
+    std::vector<float> mScales;
+    // A view's rows and scales, owned by the caller. Owned rows are always
+    // reached through the vectors above, so copies and moves stay valid.
+    const uint8_t* mViewRows = nullptr;
+    const float* mViewScales = nullptr;
+    bool mView = false;
+    // The normalized embedding before it is stored.
+    std::vector<float> mScratch;
+};
+} // namespace yuzu
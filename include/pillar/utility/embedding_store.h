@@ -0,0 +1,160 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "pillar/framework/types/data_type.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/embedding_gallery.h"
+
+namespace yuzu
+{
+// An embedding store is two files, in native byte order:
+//
+// `path`, the compacted base, written once and then only mapped:
+//   [file header, 64 bytes]
+//   [rows: count x rowPitch bytes, normalized, in the EmbeddingGallery layout]
+//   [ids: count x uint64, the id of each row]
+//   [index: count x (id, row) uint64 pairs sorted by id]
+// every section starting on a page boundary.
+//
+// `path.wal`, the write-ahead log of puts and removes since the base was
+// written, replayed on open and folded into a new base by compaction.
+namespace embedding_store
+{
+constexpr uint64_t kSectionAlignment = 4096;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dim;
+    int32_t storage;
+    uint32_t rowPitch;
+    uint64_t count;
+    uint64_t rowsOffset;
+    uint64_t idsOffset;
+    uint64_t indexOffset;
+    uint8_t reserved[8];
+};
+
+struct IndexEntry
+{
+    uint64_t id;
+    uint64_t row;
+};
+
+static_assert(sizeof(FileHeader) == 64, "unexpected file header size");
+} // namespace embedding_store
+
+struct EmbeddingStoreOptions
+{
+    // DataType::kFLOAT or kHALF.
+    DataType storage = DataType::kFLOAT;
+    // fdatasync the log after every write instead of on `sync()` only.
+    bool syncWrites = false;
+    // Log size that wakes the background compaction, 0 disables it.
+    size_t compactLogBytes = size_t(64) << 20;
+};
+
+// A stored embedding and its cosine similarity to a query.
+struct StoreMatch
+{
+    uint64_t id;
+    float score;
+};
+
+/**
+ * @brief A persistent id -> embedding map that opens in constant time.
+ *
+ * The base file is mapped read-only and searched in place through an
+ * EmbeddingGallery view, ids are found by binary search in its sorted index,
+ * so opening a store reads no rows at all. Puts and removes are appended to
+ * the log before they are applied to a small in-memory delta; a background
+ * thread folds the log into a new base once it grows past
+ * `compactLogBytes`. Searches may run concurrently with each other and with
+ * writes. POSIX only; `open` returns kUnimplemented on Windows.
+ */
+class EmbeddingStore
+{
+public:
+    EmbeddingStore();
+    ~EmbeddingStore();
+    EmbeddingStore(const EmbeddingStore&) = delete;
+    EmbeddingStore& operator=(const EmbeddingStore&) = delete;
+
+    // Opens the store at `path`, creating it if missing. An existing store
+    // keeps its own dimension and storage, which must match.
+    Status open(const std::string& path, unsigned int dim, const EmbeddingStoreOptions& options = {});
+    // Stops the background compaction and closes the files. The log is kept
+    // and replayed by the next open.
+    Status close();
+
+    bool isOpen() const;
+    unsigned int dim() const { return mDim; }
+    // Live embeddings.
+    size_t size() const;
+    bool contains(uint64_t id) const;
+
+    // Inserts or replaces the embedding of `id`, `dim` floats.
+    Status put(uint64_t id, const float* embedding);
+    Status remove(uint64_t id);
+    // The stored, normalized embedding of `id` as `dim` floats.
+    Status get(uint64_t id, float* embedding) const;
+
+    // The `k` live embeddings most similar to `query` scoring at least
+    // `threshold`, best first, scored against the mapped rows in place.
+    Status topK(const float* query, size_t k, float threshold, std::vector<StoreMatch>& matches) const;
+
+    // Flushes the log to disk.
+    Status sync();
+    // Folds the log into a new base file now.
+    Status compact();
+
+    size_t logBytes() const;
+
+private:
+    struct Base;
+    struct Delta;
+    struct Record;
+
+    Status mapBase(std::unique_ptr<Base>& base) const;
+    Status openLog();
+    Status writeRecord(const Record& record);
+    void apply(const Record& record);
+    // The live base row of `id`.
+    bool findBase(uint64_t id, size_t& row) const;
+    // Where `id` lives, in the delta or the base.
+    bool findLive(uint64_t id, bool& inBase, size_t& row) const;
+    // Applies the log records from `from` on, cutting off a torn tail.
+    Status replayLog(uint64_t from);
+    void requestCompaction();
+    void compactLoop();
+
+    std::string mPath;
+    unsigned int mDim;
+    EmbeddingStoreOptions mOptions;
+
+    // Guards everything below; searches share it, writes own it.
+    mutable std::shared_mutex mMut;
+    std::unique_ptr<Base> mBase;
+    std::unique_ptr<Delta> mDelta;
+    int mLogFd;
+    uint64_t mLogBytes;
+
+    // One compaction at a time.
+    std::mutex mCompactMut;
+    std::thread mCompactor;
+    std::mutex mWakeMut;
+    std::condition_variable mWake;
+    bool mStopping;
+    bool mCompactRequested;
+};
+} // namespace yuzu
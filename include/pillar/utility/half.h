@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// reference: https://gist.github.com/rygorous/2156668
+
+namespace yuzu
+{
+/**
+ * @brief Converts a float to IEEE 754 half precision bits, rounding to the
+ * nearest even value. Matches the F16C conversion, so scalar and SIMD paths
+ * agree bit for bit.
+ *
+ * @param value a float
+ * @return uint16_t half precision bits
+ */
+inline uint16_t floatToHalf(float value)
+{
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    const uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint16_t h;
+    if (f >= 0x47800000u)
+    {
+        // Inf or NaN, NaN stays quiet.
+        h = f > 0x7f800000u ? 0x7e00 : 0x7c00;
+    }
+    else if (f < 0x38800000u)
+    {
+        // Subnormal or zero: let the float adder do the rounding.
+        float magic;
+        const uint32_t magicBits = 0x3f000000u;
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        float shifted;
+        std::memcpy(&shifted, &f, sizeof(shifted));
+        shifted += magic;
+        uint32_t bits;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+        h = static_cast<uint16_t>(bits - magicBits);
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (f >> 13) & 1;
+        f += 0xc8000fffu + mantissaOdd;
+        h = static_cast<uint16_t>(f >> 13);
+    }
+    return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+/**
+ * @brief Converts IEEE 754 half precision bits to a float, exactly.
+ *
+ * @param value half precision bits
+ * @return float
+ */
+inline float halfToFloat(uint16_t value)
+{
+    constexpr uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t bits = (value & 0x7fffu) << 13;
+    const uint32_t exponent = bits & shiftedExponent;
+    bits += (127 - 15) << 23;
+
+    float result;
+    if (exponent == shiftedExponent)
+    {
+        // Inf or NaN.
+        bits += (128 - 16) << 23;
+        std::memcpy(&result, &bits, sizeof(result));
+    }
+    else if (exponent == 0)
+    {
+        // Zero or subnormal, renormalize.
+        bits += 1 << 23;
+        const uint32_t magicBits = 113u << 23;
+        float magic;
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        std::memcpy(&result, &bits, sizeof(result));
+        result -= magic;
+    }
+    else
+    {
+        std::memcpy(&result, &bits, sizeof(result));
+    }
+
+    uint32_t out;
+    std::memcpy(&out, &result, sizeof(out));
+    out |= static_cast<uint32_t>(value & 0x8000u) << 16;
+    std::memcpy(&result, &out, sizeof(result));
+    return result;
+}
+} // namespace yuzu
@@ -0,0 +1,188 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pillar/framework/deps/aligned_malloc_and_free.h"
+#include "pillar/status/status_code.h"
+
+namespace yuzu
+{
+// Index file: a header, then one section per array, each starting on a page
+// boundary so a mapped file can serve the vectors and links in place.
+//
+//   [file header, 128 bytes]
+//   [vectors: count x stride floats, normalized]
+//   [level 0 links: count x (1 + 2M) uint32, the count first]
+//   [labels: count x uint64]
+//   [levels: count x int32]
+//   [tombstones: count x uint8]
+//   [upper links: for every node, level x (1 + M) uint32, in node order]
+namespace hnsw
+{
+constexpr uint64_t kSectionAlignment = 4096;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dim;
+    uint32_t M;
+    uint32_t efConstruction;
+    int32_t maxLevel;
+    uint32_t reserved0;
+    uint64_t count;
+    int64_t entryPoint;
+    uint64_t stride;
+    uint64_t vectorsOffset;
+    uint64_t linksOffset;
+    uint64_t labelsOffset;
+    uint64_t levelsOffset;
+    uint64_t deletedOffset;
+    uint64_t upperOffset;
+    uint8_t reserved1[24];
+};
+
+static_assert(sizeof(FileHeader) == 128, "unexpected file header size");
+} // namespace hnsw
+
+struct HnswOptions
+{
+    // Links per node on the upper levels, twice as many on level 0.
+    unsigned int M = 16;
+    // Candidate list size while inserting; higher builds a better graph.
+    unsigned int efConstruction = 200;
+    // Default candidate list size while searching; higher raises recall.
+    unsigned int efSearch = 64;
+    // Seeds the level draw, so single-threaded builds are reproducible.
+    uint32_t seed = 100;
+};
+
+// A labelled embedding and its cosine similarity to a query.
+struct IndexMatch
+{
+    uint64_t label;
+    float score;
+};
+
+/**
+ * @brief Approximate nearest neighbour search over cosine similarity with a
+ * hierarchical navigable small world graph.
+ *
+ * Embeddings are normalized on insert, so similarity is a dot product. The
+ * capacity is fixed up front and nothing is reallocated afterwards, which
+ * lets `add`, `remove` and `search` run concurrently from any number of
+ * threads; node links are guarded by striped locks. Removal leaves a
+ * tombstone: the node keeps routing searches but is never returned.
+ * `save` and `load` must not overlap with writers.
+ */
+class HnswIndex
+{
+public:
+    HnswIndex(unsigned int dim, size_t capacity, const HnswOptions& options = HnswOptions());
+    ~HnswIndex();
+    HnswIndex(const HnswIndex&) = delete;
+    HnswIndex& operator=(const HnswIndex&) = delete;
+
+    unsigned int dim() const { return mDim; }
+    size_t capacity() const { return mCapacity; }
+    // Nodes in the graph, tombstones included.
+    size_t size() const { return mCount.load(std::memory_order_acquire); }
+    size_t deletedCount() const { return mDeletedCount.load(std::memory_order_relaxed); }
+
+    unsigned int efSearch() const { return mEfSearch.load(std::memory_order_relaxed); }
+    void setEfSearch(unsigned int ef) { mEfSearch.store(ef, std::memory_order_relaxed); }
+
+    // Inserts `embedding`, `dim` floats, under `label`. Fails on a zero
+    // vector, a label already present or a full index.
+    Status add(uint64_t label, const float* embedding);
+
+    // Tombstones `label`, which can then be added again.
+    Status remove(uint64_t label);
+
+    // The `k` live embeddings most similar to `query`, best first, searching
+    // with a candidate list of max(ef, k).
+    Status search(const float* query, size_t k, std::vector<IndexMatch>& matches) const;
+    Status search(const float* query, size_t k, unsigned int ef, std::vector<IndexMatch>& matches) const;
+
+    // Writes the index to one file, see hnsw::FileHeader.
+    Status save(const std::string& path) const;
+
+    // Replaces the index with the one in `path`, with room for at least
+    // `capacity` nodes. kDataLoss for a file that is truncated or whose
+    // sizes, levels or links are inconsistent; the index is then empty.
+    Status load(const std::string& path, size_t capacity = 0);
+
+private:
+    struct VisitedList;
+    // Score and node, ordered by score.
+    using Candidate = std::pair<float, uint32_t>;
+
+    void allocate(size_t capacity);
+    const float* vector(uint32_t node) const { return mVectors.data() + size_t(node) * mStride; }
+    uint32_t* links(uint32_t node, int level);
+    const uint32_t* links(uint32_t node, int level) const;
+    unsigned int maxLinks(int level) const { return level == 0 ? 2 * mM : mM; }
+    std::mutex& nodeLock(uint32_t node) const { return mNodeLocks[node & (kLockStripes - 1)]; }
+    bool isDeleted(uint32_t node) const { return mDeleted[node].load(std::memory_order_acquire) != 0; }
+    float score(const float* query, uint32_t node) const;
+
+    int drawLevel();
+    // Copies the links of `node` at `level` under its lock.
+    void copyLinks(uint32_t node, int level, std::vector<uint32_t>& out) const;
+    uint32_t greedyClosest(const float* query, uint32_t entry, int fromLevel, int toLevel) const;
+    // The `ef` best nodes found from `entry` at `level`, worst on top. With
+    // `liveOnly` tombstones route the search but are not collected.
+    std::vector<Candidate> searchLayer(const float* query, uint32_t entry, size_t ef, int level, bool liveOnly) const;
+    // Keeps at most `m` candidates that are closer to the query than to any
+    // candidate already kept, best first.
+    void selectNeighbors(std::vector<Candidate>& candidates, size_t m) const;
+    void connect(uint32_t node, const std::vector<Candidate>& neighbors, int level);
+
+    std::unique_ptr<VisitedList> acquireVisited() const;
+    void releaseVisited(std::unique_ptr<VisitedList> list) const;
+
+    static constexpr size_t kLockStripes = 4096;
+
+    unsigned int mDim;
+    size_t mStride;
+    unsigned int mM;
+    unsigned int mEfConstruction;
+    std::atomic<unsigned int> mEfSearch;
+    double mLevelScale;
+    size_t mCapacity;
+
+    std::atomic<size_t> mCount;
+    std::atomic<size_t> mDeletedCount;
+    std::vector<float, AlignedAllocator<float>> mVectors;
+    // Level 0 links of every node: the count, then up to 2M neighbours.
+    std::vector<uint32_t> mLinks0;
+    // Links above level 0, `level` blocks of 1 + M per node.
+    std::vector<std::vector<uint32_t>> mUpperLinks;
+    std::vector<int> mLevels;
+    std::vector<uint64_t> mLabels;
+    std::unique_ptr<std::atomic<uint8_t>[]> mDeleted;
+    std::unique_ptr<std::mutex[]> mNodeLocks;
+
+    // The entry point and the top level; held through an insert that raises
+    // the top level.
+    mutable std::mutex mEntryMutex;
+    int64_t mEntryPoint;
+    int mMaxLevel;
+
+    std::mutex mLabelMutex;
+    std::unordered_map<uint64_t, uint32_t> mLabelToNode;
+
+    std::mutex mRngMutex;
+    std::mt19937 mRng;
+
+    mutable std::mutex mVisitedMutex;
+    mutable std::vector<std::unique_ptr<VisitedList>> mVisitedPool;
+};
+} // namespace yuzu
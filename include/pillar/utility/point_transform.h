@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+namespace math
+{
+// The similarity, a rotation, a uniform scale and a translation, that takes
+// the `src` points closest to the `dst` points in the least-squares sense, by
+// Umeyama's method ("Least-squares estimation of transformation parameters
+// between two point patterns", 1991). Reflections are never returned.
+// kInvalidArgument without two distinct source points.
+Status estimateSimilarity(const Point2<float>* src, const Point2<float>* dst, size_t count,
+                          Matrix2x3<float>& transform);
+
+// Maps `count` points through `transform`, as `transform * in[i]` does one at
+// a time. `out` may be `in`. Runs the column kernels of vector_batch.h on the
+// points split into x and y, the widest one the CPU supports; the overloads
+// taking `maxLevel` use no wider one.
+void transformPoints(const Matrix2x3<float>& transform, const Point2<float>* in, Point2<float>* out, size_t count);
+void transformPoints(const Matrix2x3<float>& transform, const Point2<float>* in, Point2<float>* out, size_t count,
+                     cpu::SimdLevel maxLevel);
+
+// Same through a homography, with the perspective division, on the
+// interleaved points directly.
+void transformPoints(const Matrix3x3<float>& homography, const Point2<float>* in, Point2<float>* out, size_t count);
+void transformPoints(const Matrix3x3<float>& homography, const Point2<float>* in, Point2<float>* out, size_t count,
+                     cpu::SimdLevel maxLevel);
+} // namespace math
+} // namespace yuzu
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+namespace math
+{
+// Symmetric per-vector int8 quantization: `dst[i] = round(src[i] / scale)`,
+// within [-127, 127] so negation never overflows. Returns the scale, 0 for a
+// zero vector.
+float quantizeInt8(const float* src, unsigned int len, int8_t* dst);
+
+// `dst[i] = src[i] * scale`.
+void dequantizeInt8(const int8_t* src, unsigned int len, float scale, float* dst);
+
+// IEEE half precision bits, rounded to nearest even like F16C.
+void quantizeHalf(const float* src, unsigned int len, uint16_t* dst);
+void dequantizeHalf(const uint16_t* src, unsigned int len, float* dst);
+
+// Exact integer dot product of two int8 vectors from `quantizeInt8`, values
+// in [-127, 127]. Uses VNNI when the CPU has it, pmaddubsw otherwise.
+int32_t dotProduct(const int8_t* A, const int8_t* B, unsigned int len);
+int32_t dotProduct(const int8_t* A, const int8_t* B, unsigned int len, cpu::SimdLevel maxLevel);
+
+// Dot product of a float vector with a half precision one, converted with
+// F16C and summed in float.
+float dotProduct(const float* A, const uint16_t* B, unsigned int len);
+float dotProduct(const float* A, const uint16_t* B, unsigned int len, cpu::SimdLevel maxLevel);
+} // namespace math
+} // namespace yuzu
@@ -1,14 +1,26 @@
 #pragma once
 #include <vector>
 
+#include "pillar/utility/cpu_features.h"
 #include "pillar/utility/ext/math.h"
 
 namespace yuzu
 {
 namespace math
 {
+// Cosine similarity of two `len` float vectors. Uses the widest SIMD kernel
+// the CPU supports, picked on the first call; the scalar fallback sums in
+// double, the SIMD kernels in float over several accumulators.
 float cosineSimilarity(const float* A, const float* B, unsigned int len);
 
+// Same, with a kernel no wider than `maxLevel`.
+float cosineSimilarity(const float* A, const float* B, unsigned int len, cpu::SimdLevel maxLevel);
+
+// Dot product of two `len` float vectors, for unit vectors the cosine
+// similarity without the norms. Dispatched like cosineSimilarity.
+float dotProduct(const float* A, const float* B, unsigned int len);
+float dotProduct(const float* A, const float* B, unsigned int len, cpu::SimdLevel maxLevel);
+
 // Calculate cosine sililarity of vectors.
 template <class T = float>
 std::vector<T> cosineSimilarity(const std::vector<T>& vectorA, const std::vector<std::vector<T>>& matrix)
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/framework/deps/aligned_malloc_and_free.h"
+#include "pillar/status/status_code.h"
+#include "pillar/utility/box_batch.h"
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+// SSD anchor layout, as in MediaPipe's SsdAnchorsCalculator. The defaults are
+// the BlazeFace short range model: 128 x 128 input, 896 anchors.
+struct SsdAnchorOptions
+{
+    int inputWidth = 128;
+    int inputHeight = 128;
+    float minScale = 0.1484375f;
+    float maxScale = 0.75f;
+    float anchorOffsetX = 0.5f;
+    float anchorOffsetY = 0.5f;
+    // One entry per layer; consecutive layers of the same stride share a grid.
+    std::vector<int> strides = {8, 16, 16, 16};
+    std::vector<float> aspectRatios = {1.0f};
+    // Adds an anchor between this layer's scale and the next one's, with this
+    // aspect ratio; 0 disables it.
+    float interpolatedScaleAspectRatio = 1.0f;
+    bool reduceBoxesInLowestLayer = false;
+    // Every anchor is 1 x 1 and the regressor predicts absolute sizes.
+    bool fixedAnchorSize = true;
+
+    bool operator==(const SsdAnchorOptions& other) const;
+};
+
+/**
+ * @brief SSD anchors as columns of centers and sizes, normalized to the input.
+ *
+ * Anchors depend only on the options, so `get` generates them once per
+ * layout and hands every caller, on any thread, the same immutable grid.
+ */
+class AnchorGrid
+{
+public:
+    // The grid for `options`, generated on the first call with them.
+    static Status get(const SsdAnchorOptions& options, std::shared_ptr<const AnchorGrid>& grid);
+
+    // Generates a grid that is not shared.
+    static Status generate(const SsdAnchorOptions& options, AnchorGrid& grid);
+
+    size_t size() const { return mXCenter.size(); }
+    const float* xCenter() const { return mXCenter.data(); }
+    const float* yCenter() const { return mYCenter.data(); }
+    const float* width() const { return mWidth.data(); }
+    const float* height() const { return mHeight.data(); }
+
+    Anchor anchor(size_t i) const;
+
+private:
+    template <class T>
+    using Column = std::vector<T, AlignedAllocator<T>>;
+
+    Column<float> mXCenter;
+    Column<float> mYCenter;
+    Column<float> mWidth;
+    Column<float> mHeight;
+};
+
+// How to read the regressor and classifier outputs, as in MediaPipe's
+// TensorsToDetectionsCalculator. The defaults fit BlazeFace.
+struct SsdDecoderOptions
+{
+    int numClasses = 1;
+    // Values per anchor in the raw boxes, the box and then any keypoints.
+    int numCoords = 16;
+    int boxCoordOffset = 0;
+    float xScale = 128.0f;
+    float yScale = 128.0f;
+    float wScale = 128.0f;
+    float hScale = 128.0f;
+    // Sizes are predicted in log space.
+    bool applyExponentialOnBoxSize = false;
+    // Boxes are x, y, w, h rather than y, x, h, w.
+    bool reverseOutputOrder = true;
+    // Scores are logits; they are clipped to +-scoreClippingThreshold, if
+    // positive, before the sigmoid.
+    bool sigmoidScore = true;
+    float scoreClippingThreshold = 100.0f;
+    float minScoreThreshold = 0.5f;
+    bool flipVertically = false;
+};
+
+// Decodes the boxes of every anchor whose best class scores at least
+// `minScoreThreshold` into `boxes`, normalized corners with the score and the
+// class as label. `rawBoxes` is anchors x numCoords and `rawScores` anchors x
+// numClasses. With a sigmoid the threshold is compared against the logits, so
+// rejected anchors cost no exp; eight or sixteen anchors are tested at once
+// and a group with no survivor is skipped without decoding.
+Status decodeSsdBoxes(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors,
+                      const SsdDecoderOptions& options, BoxBatch& boxes);
+Status decodeSsdBoxes(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors,
+                      const SsdDecoderOptions& options, BoxBatch& boxes, cpu::SimdLevel maxLevel);
+} // namespace yuzu
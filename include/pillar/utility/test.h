@@ -3,6 +3,7 @@
 #include <array>
 #include <iostream>
 #include <random>
+#include <string_view>
 
 namespace yuzu
 {
@@ -18,6 +19,14 @@ void print(T&&... args)
     std::cout << "\n";
 }
 
+// Prints `what` with its outcome; returns 1 on failure so that results can
+// be summed into the exit code.
+inline int expect(bool condition, std::string_view what)
+{
+    std::cout << what << (condition ? ": ok" : ": FAILED") << std::endl;
+    return condition ? 0 : 1;
+}
+
 template <int N>
 std::array<float, N> createTensor()
 {
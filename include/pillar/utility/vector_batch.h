@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+
+#include "pillar/utility/cpu_features.h"
+
+namespace yuzu
+{
+namespace math
+{
+// Batched counterparts of Vector2/Vector3<float>, for landmark sets held as
+// one array per coordinate. Each uses the widest SIMD kernel the CPU supports,
+// picked on the first call; the overloads taking `maxLevel` use no wider one.
+
+// Scales each (x[i], y[i]) or (x[i], y[i], z[i]) to unit length in place, as
+// Vector::normalize does; zero vectors stay zero.
+void normalizeVectors(float* x, float* y, size_t count);
+void normalizeVectors(float* x, float* y, size_t count, cpu::SimdLevel maxLevel);
+void normalizeVectors(float* x, float* y, float* z, size_t count);
+void normalizeVectors(float* x, float* y, float* z, size_t count, cpu::SimdLevel maxLevel);
+
+// Maps each point through the row-major 2 x 3 affine `m`:
+// x' = m[0] x + m[1] y + m[2] and y' = m[3] x + m[4] y + m[5].
+// The outputs may be the inputs.
+void transformPoints(const float* m, const float* x, const float* y, float* outX, float* outY, size_t count);
+void transformPoints(const float* m, const float* x, const float* y, float* outX, float* outY, size_t count,
+                     cpu::SimdLevel maxLevel);
+
+// Same with the row-major 3 x 4 affine `m`, a linear part and a translation
+// column.
+void transformPoints(const float* m, const float* x, const float* y, const float* z, float* outX, float* outY,
+                     float* outZ, size_t count);
+void transformPoints(const float* m, const float* x, const float* y, const float* z, float* outX, float* outY,
+                     float* outZ, size_t count, cpu::SimdLevel maxLevel);
+} // namespace math
+} // namespace yuzu
@@ -0,0 +1,544 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "pillar/framework/formats/frame_dump.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+constexpr char kFileMagic[8] = {'P', 'I', 'L', 'L', 'A', 'R', 'F', 'D'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kFrameMagic = 0x4d524650; // "PFRM"
+constexpr uint64_t kIndexAlignment = 64;
+constexpr size_t kMaxSpareBuffers = 4;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Where the pixel data of a frame appended at `fileEnd` starts.
+uint64_t dataOffsetAfter(uint64_t fileEnd)
+{
+    return alignUp(fileEnd + sizeof(frame_dump::FrameHeader), frame_dump::kDataAlignment);
+}
+
+#if !defined(_WIN32)
+bool writeAll(int fd, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, p, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// The status for a failed open(2).
+Status openStatus(int error, const char* message)
+{
+    switch (error)
+    {
+        case ENOENT:
+        case ENOTDIR:
+            return Status(StatusCode::kNotFound, message);
+        case EACCES:
+        case EPERM:
+        case EROFS:
+            return Status(StatusCode::kPermissionDenied, message);
+        case EISDIR:
+        case ENAMETOOLONG:
+        case EINVAL:
+            return Status(StatusCode::kInvalidArgument, message);
+        case EMFILE:
+        case ENFILE:
+        case ENOMEM:
+        case ENOSPC:
+        case EDQUOT:
+            return Status(StatusCode::kResourceExhausted, message);
+        default:
+            return Status(StatusCode::kUnknown, message);
+    }
+}
+
+bool writeZeros(int fd, size_t size)
+{
+    static const uint8_t zeros[frame_dump::kDataAlignment] = {};
+    while (size > 0)
+    {
+        const size_t n = std::min(size, sizeof(zeros));
+        if (!writeAll(fd, zeros, n))
+            return false;
+        size -= n;
+    }
+    return true;
+}
+#endif
+
+// Whether the frame whose pixel data starts at `dataOffset` lies within a
+// file of `fileSize` bytes and its rows fit in its data.
+bool isValidFrame(const frame_dump::FrameHeader& frame, uint64_t dataOffset, uint64_t fileSize)
+{
+    if (frame.magic != kFrameMagic || dataOffset > fileSize || frame.dataSize > fileSize - dataOffset)
+    {
+        return false;
+    }
+    const int pixelBytes = ImageFrame::numberOfChannelsForFormat(static_cast<ImageFormat::Format>(frame.format)) *
+                           ImageFrame::byteDepthForFormat(static_cast<ImageFormat::Format>(frame.format));
+    return pixelBytes > 0 && frame.width > 0 && frame.height > 0 && frame.step > 0 &&
+           int64_t(frame.width) * pixelBytes <= frame.step && uint64_t(frame.step) * frame.height <= frame.dataSize;
+}
+} // namespace
+
+// A frame waiting to be written: either a frame taken over as is, or pixels
+// copied into `staging`.
+struct FrameDumpWriter::Record
+{
+    frame_dump::FrameHeader header;
+    ImageFrame frame;
+    std::vector<uint8_t> staging;
+    const uint8_t* pixels;
+};
+
+// ----------------------------------------------
+// FrameDumpWriter
+// ----------------------------------------------
+FrameDumpWriter::FrameDumpWriter(size_t maxPendingBytes)
+    : mMaxPendingBytes(maxPendingBytes), mFd(-1), mFileEnd(0), mPendingBytes(0), mFramesWritten(0),
+      mFramesDropped(0), mBytesWritten(0), mPendingRecords(0), mClosing(false), mStatus(okStatus())
+{
+}
+
+FrameDumpWriter::~FrameDumpWriter() { close(); }
+
+Status FrameDumpWriter::open(const std::string& path)
+{
+#if defined(_WIN32)
+    return Status(StatusCode::kUnimplemented, "frame dumps need POSIX file I/O");
+#else
+    if (isOpen())
+    {
+        return Status(StatusCode::kFailedPrecondition, "writer is already open");
+    }
+
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return openStatus(errno, "cannot create the dump file");
+    }
+
+    frame_dump::FileHeader header = {};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kVersion;
+    header.dataAlignment = frame_dump::kDataAlignment;
+    if (!writeAll(fd, &header, sizeof(header)))
+    {
+        ::close(fd);
+        return Status(StatusCode::kDataLoss, "cannot write the dump file header");
+    }
+
+    mFd = fd;
+    mFileEnd = sizeof(header);
+    mIndex.clear();
+    mPendingBytes = 0;
+    mFramesWritten = 0;
+    mFramesDropped = 0;
+    mBytesWritten = sizeof(header);
+    mStatus = okStatus();
+    mClosing = false;
+    mThread = std::thread(&FrameDumpWriter::run, this);
+    return okStatus();
+#endif
+}
+
+Status FrameDumpWriter::write(const ConstImageFrameView& frame, int64_t timestamp)
+{
+    if (frame.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "frame is empty");
+    }
+
+    // Rows are repacked with the step ImageFrame would use.
+    const int rowBytes = frame.width() * frame.channels() * frame.byteDepth();
+    const int step = ((rowBytes - 1) | (ImageFrame::kDefaultAlignmentBoundary - 1)) + 1;
+    const size_t dataSize = size_t(step) * frame.height();
+    if (!reservePending(dataSize))
+    {
+        ++mFramesDropped;
+        return Status(StatusCode::kResourceExhausted, "too many bytes pending, frame dropped");
+    }
+
+    auto record = std::make_unique<Record>();
+    {
+        // Reuse a buffer the writer thread is done with, a fresh one costs a
+        // page fault per 4 KiB.
+        std::lock_guard<std::mutex> lk(mMut);
+        if (!mSpareBuffers.empty())
+        {
+            record->staging = std::move(mSpareBuffers.back());
+            mSpareBuffers.pop_back();
+        }
+    }
+    record->staging.resize(dataSize);
+    for (int y = 0; y < frame.height(); ++y)
+    {
+        std::memcpy(record->staging.data() + size_t(y) * step, frame.row(y), rowBytes);
+    }
+    record->pixels = record->staging.data();
+    record->header = {};
+    record->header.format = frame.format();
+    record->header.width = frame.width();
+    record->header.height = frame.height();
+    record->header.step = step;
+    record->header.timestamp = timestamp;
+    record->header.dataSize = dataSize;
+    return enqueue(std::move(record));
+}
+
+Status FrameDumpWriter::write(ImageFrame&& frame, int64_t timestamp)
+{
+    if (frame.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "frame is empty");
+    }
+
+    const size_t dataSize = size_t(frame.pixelDataSize());
+    if (!reservePending(dataSize))
+    {
+        ++mFramesDropped;
+        return Status(StatusCode::kResourceExhausted, "too many bytes pending, frame dropped");
+    }
+
+    auto record = std::make_unique<Record>();
+    record->header = {};
+    record->header.format = frame.format();
+    record->header.width = frame.width();
+    record->header.height = frame.height();
+    record->header.step = frame.step();
+    record->header.timestamp = timestamp;
+    record->header.dataSize = dataSize;
+    record->pixels = frame.pixelData();
+    record->frame = std::move(frame);
+    return enqueue(std::move(record));
+}
+
+bool FrameDumpWriter::reservePending(size_t bytes)
+{
+    size_t pending = mPendingBytes.load(std::memory_order_relaxed);
+    do
+    {
+        if (bytes > mMaxPendingBytes || pending > mMaxPendingBytes - bytes)
+        {
+            return false;
+        }
+    } while (!mPendingBytes.compare_exchange_weak(pending, pending + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+Status FrameDumpWriter::enqueue(std::unique_ptr<Record> record)
+{
+    record->header.magic = kFrameMagic;
+    // Pushed under the lock close() takes to push the stop record, so no
+    // frame can land behind it.
+    std::lock_guard<std::mutex> lk(mMut);
+    if (!isOpen() || mClosing || !mStatus.ok())
+    {
+        mPendingBytes -= record->header.dataSize;
+        if (!mStatus.ok())
+        {
+            return mStatus;
+        }
+        return Status(StatusCode::kFailedPrecondition, "writer is not open");
+    }
+    ++mPendingRecords;
+    mQueue.push(std::move(record));
+    return okStatus();
+}
+
+void FrameDumpWriter::run()
+{
+    for (;;)
+    {
+        std::unique_ptr<Record> record;
+        mQueue.waitAndPop(record);
+        // A null record asks the thread to stop, everything before it has
+        // been written.
+        if (!record)
+        {
+            return;
+        }
+
+        bool failed = false;
+        {
+            std::lock_guard<std::mutex> lk(mMut);
+            failed = !mStatus.ok();
+        }
+        if (!failed && !writeRecord(*record))
+        {
+            fail(Status(StatusCode::kDataLoss, "writing the dump file failed"));
+        }
+
+        const size_t dataSize = record->header.dataSize;
+        std::vector<uint8_t> staging = std::move(record->staging);
+        record.reset();
+        mPendingBytes -= dataSize;
+        std::lock_guard<std::mutex> lk(mMut);
+        if (!staging.empty() && mSpareBuffers.size() < kMaxSpareBuffers)
+        {
+            mSpareBuffers.push_back(std::move(staging));
+        }
+        if (--mPendingRecords == 0)
+        {
+            mDrained.notify_all();
+        }
+    }
+}
+
+bool FrameDumpWriter::writeRecord(const Record& record)
+{
+#if defined(_WIN32)
+    return false;
+#else
+    const uint64_t dataOffset = dataOffsetAfter(mFileEnd);
+    const uint64_t headerOffset = dataOffset - sizeof(frame_dump::FrameHeader);
+    if (!writeZeros(mFd, headerOffset - mFileEnd) || !writeAll(mFd, &record.header, sizeof(record.header)) ||
+        !writeAll(mFd, record.pixels, record.header.dataSize))
+    {
+        return false;
+    }
+
+    mIndex.push_back({dataOffset, record.header.timestamp});
+    mBytesWritten += dataOffset + record.header.dataSize - mFileEnd;
+    ++mFramesWritten;
+    mFileEnd = dataOffset + record.header.dataSize;
+    return true;
+#endif
+}
+
+void FrameDumpWriter::fail(Status status)
+{
+    std::lock_guard<std::mutex> lk(mMut);
+    if (mStatus.ok())
+    {
+        mStatus = status;
+    }
+}
+
+Status FrameDumpWriter::flush()
+{
+    std::unique_lock<std::mutex> lk(mMut);
+    mDrained.wait(lk, [this] { return mPendingRecords == 0; });
+    return mStatus;
+}
+
+Status FrameDumpWriter::close()
+{
+#if defined(_WIN32)
+    return okStatus();
+#else
+    {
+        std::lock_guard<std::mutex> lk(mMut);
+        if (!isOpen() || mClosing)
+        {
+            return okStatus();
+        }
+        mClosing = true;
+        mQueue.push(nullptr);
+    }
+    mThread.join();
+
+    Status status;
+    {
+        std::lock_guard<std::mutex> lk(mMut);
+        status = mStatus;
+    }
+
+    if (status.ok())
+    {
+        const uint64_t indexOffset = alignUp(mFileEnd, kIndexAlignment);
+        frame_dump::FileHeader header = {};
+        std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+        header.version = kVersion;
+        header.dataAlignment = frame_dump::kDataAlignment;
+        header.frameCount = mIndex.size();
+        header.indexOffset = indexOffset;
+        const size_t indexBytes = mIndex.size() * sizeof(frame_dump::IndexEntry);
+        if (!writeZeros(mFd, indexOffset - mFileEnd) || !writeAll(mFd, mIndex.data(), indexBytes) ||
+            ::pwrite(mFd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+        {
+            status = Status(StatusCode::kDataLoss, "writing the dump index failed");
+        }
+        mBytesWritten += indexOffset - mFileEnd + indexBytes;
+    }
+
+    std::lock_guard<std::mutex> lk(mMut);
+    ::close(mFd);
+    mFd = -1;
+    mSpareBuffers.clear();
+    return status;
+#endif
+}
+
+FrameDumpWriter::Stats FrameDumpWriter::stats() const
+{
+    return {mFramesWritten.load(), mFramesDropped.load(), mBytesWritten.load()};
+}
+
+// ----------------------------------------------
+// FrameDumpReader
+// ----------------------------------------------
+FrameDumpReader::FrameDumpReader() : mData(nullptr), mSize(0) {}
+
+FrameDumpReader::~FrameDumpReader() { close(); }
+
+Status FrameDumpReader::open(const std::string& path)
+{
+#if defined(_WIN32)
+    return Status(StatusCode::kUnimplemented, "frame dumps need POSIX file I/O");
+#else
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return openStatus(errno, "cannot open the dump file");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(frame_dump::FileHeader))
+    {
+        ::close(fd);
+        return Status(StatusCode::kDataLoss, "dump file is truncated");
+    }
+
+    // Private and writable: frames are handed out as mutable ImageFrames,
+    // writes go to private copies of the pages.
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return Status(StatusCode::kResourceExhausted, "cannot map the dump file");
+    }
+    mData = static_cast<uint8_t*>(data);
+    mSize = size_t(st.st_size);
+    ::madvise(mData, mSize, MADV_SEQUENTIAL);
+
+    const auto* header = reinterpret_cast<const frame_dump::FileHeader*>(mData);
+    if (std::memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) != 0 || header->version != kVersion ||
+        header->dataAlignment != frame_dump::kDataAlignment)
+    {
+        close();
+        return Status(StatusCode::kDataLoss, "not a frame dump file");
+    }
+
+    const uint64_t maxFrames = mSize / sizeof(frame_dump::IndexEntry);
+    if (header->indexOffset == 0 || header->indexOffset > mSize || header->frameCount > maxFrames ||
+        header->frameCount * sizeof(frame_dump::IndexEntry) > mSize - header->indexOffset)
+    {
+        return scanFrames();
+    }
+
+    const auto* entries = reinterpret_cast<const frame_dump::IndexEntry*>(mData + header->indexOffset);
+    mIndex.assign(entries, entries + header->frameCount);
+    for (const frame_dump::IndexEntry& entry : mIndex)
+    {
+        if (entry.dataOffset < sizeof(frame_dump::FileHeader) + sizeof(frame_dump::FrameHeader) ||
+            entry.dataOffset % frame_dump::kDataAlignment != 0 || entry.dataOffset > mSize)
+        {
+            return scanFrames();
+        }
+        const auto* frame =
+            reinterpret_cast<const frame_dump::FrameHeader*>(mData + entry.dataOffset - sizeof(frame_dump::FrameHeader));
+        if (!isValidFrame(*frame, entry.dataOffset, mSize))
+        {
+            return scanFrames();
+        }
+    }
+    return okStatus();
+#endif
+}
+
+Status FrameDumpReader::scanFrames()
+{
+    mIndex.clear();
+    uint64_t fileEnd = sizeof(frame_dump::FileHeader);
+    for (;;)
+    {
+        const uint64_t dataOffset = dataOffsetAfter(fileEnd);
+        if (dataOffset > mSize)
+        {
+            break;
+        }
+        const auto* frame =
+            reinterpret_cast<const frame_dump::FrameHeader*>(mData + dataOffset - sizeof(frame_dump::FrameHeader));
+        // A torn last frame is dropped.
+        if (!isValidFrame(*frame, dataOffset, mSize))
+        {
+            break;
+        }
+        mIndex.push_back({dataOffset, frame->timestamp});
+        fileEnd = dataOffset + frame->dataSize;
+    }
+    return okStatus();
+}
+
+void FrameDumpReader::close()
+{
+#if !defined(_WIN32)
+    if (mData != nullptr)
+    {
+        ::munmap(mData, mSize);
+    }
+#endif
+    mData = nullptr;
+    mSize = 0;
+    mIndex.clear();
+}
+
+const frame_dump::FrameHeader& FrameDumpReader::header(size_t index) const
+{
+    return *reinterpret_cast<const frame_dump::FrameHeader*>(mData + mIndex[index].dataOffset -
+                                                             sizeof(frame_dump::FrameHeader));
+}
+
+Status FrameDumpReader::frame(size_t index, ImageFrame& frame) const
+{
+    if (index >= mIndex.size())
+    {
+        return Status(StatusCode::kOutOfRange, "frame index out of range");
+    }
+
+    const frame_dump::FrameHeader& h = header(index);
+    frame.adoptPixelData(static_cast<ImageFormat::Format>(h.format), h.width, h.height, h.step,
+                         mData + mIndex[index].dataOffset, ImageFrame::PixelDataDeleter::kNone);
+    return okStatus();
+}
+
+ConstImageFrameView FrameDumpReader::view(size_t index) const
+{
+    if (index >= mIndex.size())
+    {
+        return ConstImageFrameView();
+    }
+
+    const frame_dump::FrameHeader& h = header(index);
+    return ConstImageFrameView(static_cast<ImageFormat::Format>(h.format), h.width, h.height, h.step,
+                               mData + mIndex[index].dataOffset);
+}
+} // namespace yuzu
@@ -0,0 +1,820 @@
+#include <cmath>
+#include <cstring>
+
+#include "pillar/framework/formats/image_format_conversion.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+using RowKernel = void (*)(const uint8_t* src, uint8_t* dst, int count);
+
+// BT.601 luma weights in 8-bit fixed point, they sum up to 256.
+constexpr int kWeightR = 77;
+constexpr int kWeightG = 150;
+constexpr int kWeightB = 29;
+
+constexpr float kU8ToFloat = 1.0f / 255.0f;
+constexpr float kU16ToFloat = 1.0f / 65535.0f;
+
+// ----------------------------------------------
+// Scalar kernels
+// ----------------------------------------------
+
+// dst channel `c` takes src channel `I<c>`, a negative index writes an opaque alpha.
+template <int SrcChannels, int DstChannels, int I0, int I1, int I2, int I3>
+void swizzleRow(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[4] = {I0, I1, I2, I3};
+    for (int x = 0; x < width; ++x, src += SrcChannels, dst += DstChannels)
+    {
+        for (int c = 0; c < DstChannels; ++c)
+        {
+            dst[c] = idx[c] < 0 ? 255 : src[idx[c]];
+        }
+    }
+}
+
+template <int Channels, int R, int G, int B>
+void grayRow(const uint8_t* src, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += Channels)
+    {
+        dst[x] = static_cast<uint8_t>((kWeightR * src[R] + kWeightG * src[G] + kWeightB * src[B] + 128) >> 8);
+    }
+}
+
+template <int DstChannels>
+void expandGrayRow(const uint8_t* src, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x, dst += DstChannels)
+    {
+        dst[0] = dst[1] = dst[2] = src[x];
+        if (DstChannels == 4)
+        {
+            dst[3] = 255;
+        }
+    }
+}
+
+void widenRow(const uint8_t* src, uint8_t* dst, int count)
+{
+    uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = static_cast<uint16_t>(src[i] * 257);
+    }
+}
+
+void narrowRow(const uint8_t* src, uint8_t* dst, int count)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+    for (int i = 0; i < count; ++i)
+    {
+        dst[i] = static_cast<uint8_t>(in[i] >> 8);
+    }
+}
+
+void u8ToFloatRow(const uint8_t* src, uint8_t* dst, int count)
+{
+    float* out = reinterpret_cast<float*>(dst);
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = static_cast<float>(src[i]) * kU8ToFloat;
+    }
+}
+
+void u16ToFloatRow(const uint8_t* src, uint8_t* dst, int count)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+    float* out = reinterpret_cast<float*>(dst);
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = static_cast<float>(in[i]) * kU16ToFloat;
+    }
+}
+
+void floatToU8Row(const uint8_t* src, uint8_t* dst, int count)
+{
+    const float* in = reinterpret_cast<const float*>(src);
+    for (int i = 0; i < count; ++i)
+    {
+        // Written so that NaN ends up as 0, like the SIMD kernels.
+        float v = in[i] * 255.0f;
+        v = v > 0.0f ? v : 0.0f;
+        v = v < 255.0f ? v : 255.0f;
+        dst[i] = static_cast<uint8_t>(std::lrint(v));
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+// ----------------------------------------------
+// Shuffle masks
+// ----------------------------------------------
+struct ByteMask
+{
+    alignas(16) int8_t b[16];
+};
+
+// Output byte `DstChannels * p + c` of a 4-pixel group takes source byte
+// `SrcChannels * p + idx[c]`.
+ByteMask swizzleMask(int srcChannels, int dstChannels, const int* idx)
+{
+    ByteMask m;
+    std::memset(m.b, 0x80, sizeof(m.b));
+    for (int p = 0; p < 4; ++p)
+    {
+        for (int c = 0; c < dstChannels; ++c)
+        {
+            m.b[dstChannels * p + c] = idx[c] < 0 ? int8_t(0x80) : int8_t(srcChannels * p + idx[c]);
+        }
+    }
+    return m;
+}
+
+ByteMask alphaMask(int dstChannels, const int* idx)
+{
+    ByteMask m;
+    std::memset(m.b, 0, sizeof(m.b));
+    for (int p = 0; p < 4; ++p)
+    {
+        for (int c = 0; c < dstChannels; ++c)
+        {
+            m.b[dstChannels * p + c] = idx[c] < 0 ? int8_t(0xff) : 0;
+        }
+    }
+    return m;
+}
+
+// Gathers channel `channel` of 3-channel pixels from the `part`-th 16 bytes of
+// a 48-byte block into the matching lanes of a 16-pixel plane.
+ByteMask planeMask3(int channel, int part)
+{
+    ByteMask m;
+    for (int i = 0; i < 16; ++i)
+    {
+        const int from = 3 * i + channel - 16 * part;
+        m.b[i] = (from >= 0 && from < 16) ? int8_t(from) : int8_t(0x80);
+    }
+    return m;
+}
+
+// Gathers channel `channel` of the four 4-channel pixels in the `part`-th load
+// into lanes `4 * part` to `4 * part + 3`.
+ByteMask planeMask4(int channel, int part)
+{
+    ByteMask m;
+    std::memset(m.b, 0x80, sizeof(m.b));
+    for (int p = 0; p < 4; ++p)
+    {
+        m.b[4 * part + p] = int8_t(4 * p + channel);
+    }
+    return m;
+}
+
+// Output byte `i` of the `part`-th 16 bytes of an expanded gray block.
+ByteMask expandMask(int dstChannels, int part)
+{
+    ByteMask m;
+    for (int i = 0; i < 16; ++i)
+    {
+        const int byte = 16 * part + i;
+        m.b[i] = (dstChannels == 4 && byte % 4 == 3) ? int8_t(0x80) : int8_t(byte / dstChannels);
+    }
+    return m;
+}
+
+// ----------------------------------------------
+// SSE4.1 kernels
+// ----------------------------------------------
+PILLAR_TARGET_SSE41 inline __m128i load128(const void* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+PILLAR_TARGET_SSE41 inline void store128(void* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+PILLAR_TARGET_SSE41 inline __m128i grayFromPlanesSse(__m128i r, __m128i g, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wr = _mm_set1_epi16(kWeightR);
+    const __m128i wg = _mm_set1_epi16(kWeightG);
+    const __m128i wb = _mm_set1_epi16(kWeightB);
+    const __m128i half = _mm_set1_epi16(128);
+
+    // The weighted sum stays below 65536, so unsigned 16-bit lanes are enough.
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(r, zero), wr),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(g, zero), wg));
+    lo = _mm_add_epi16(lo, _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wb), half));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(r, zero), wr),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(g, zero), wg));
+    hi = _mm_add_epi16(hi, _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), wb), half));
+    return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+
+template <int I0, int I1, int I2, int I3>
+PILLAR_TARGET_SSE41 void swizzle3to4Sse(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[4] = {I0, I1, I2, I3};
+    const __m128i mask = load128(swizzleMask(3, 4, idx).b);
+    const __m128i alpha = load128(alphaMask(4, idx).b);
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 48, dst += 64)
+    {
+        const __m128i a = load128(src);
+        const __m128i b = load128(src + 16);
+        const __m128i c = load128(src + 32);
+        store128(dst, _mm_or_si128(_mm_shuffle_epi8(a, mask), alpha));
+        store128(dst + 16, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), mask), alpha));
+        store128(dst + 32, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), mask), alpha));
+        store128(dst + 48, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), mask), alpha));
+    }
+    swizzleRow<3, 4, I0, I1, I2, I3>(src, dst, width - x);
+}
+
+template <int I0, int I1, int I2>
+PILLAR_TARGET_SSE41 void swizzle4to3Sse(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[3] = {I0, I1, I2};
+    const __m128i mask = load128(swizzleMask(4, 3, idx).b);
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 64, dst += 48)
+    {
+        const __m128i s0 = _mm_shuffle_epi8(load128(src), mask);
+        const __m128i s1 = _mm_shuffle_epi8(load128(src + 16), mask);
+        const __m128i s2 = _mm_shuffle_epi8(load128(src + 32), mask);
+        const __m128i s3 = _mm_shuffle_epi8(load128(src + 48), mask);
+        store128(dst, _mm_or_si128(s0, _mm_slli_si128(s1, 12)));
+        store128(dst + 16, _mm_or_si128(_mm_srli_si128(s1, 4), _mm_slli_si128(s2, 8)));
+        store128(dst + 32, _mm_or_si128(_mm_srli_si128(s2, 8), _mm_slli_si128(s3, 4)));
+    }
+    swizzleRow<4, 3, I0, I1, I2, -1>(src, dst, width - x);
+}
+
+template <int I0, int I1, int I2, int I3>
+PILLAR_TARGET_SSE41 void swizzle4to4Sse(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[4] = {I0, I1, I2, I3};
+    const __m128i mask = load128(swizzleMask(4, 4, idx).b);
+    const __m128i alpha = load128(alphaMask(4, idx).b);
+    int x = 0;
+    for (; x + 4 <= width; x += 4, src += 16, dst += 16)
+    {
+        store128(dst, _mm_or_si128(_mm_shuffle_epi8(load128(src), mask), alpha));
+    }
+    swizzleRow<4, 4, I0, I1, I2, I3>(src, dst, width - x);
+}
+
+template <int R, int G, int B>
+PILLAR_TARGET_SSE41 void gray3Sse(const uint8_t* src, uint8_t* dst, int width)
+{
+    __m128i masks[3][3];
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int part = 0; part < 3; ++part)
+        {
+            masks[c][part] = load128(planeMask3(c, part).b);
+        }
+    }
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 48)
+    {
+        const __m128i a = load128(src);
+        const __m128i b = load128(src + 16);
+        const __m128i c = load128(src + 32);
+        __m128i planes[3];
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            planes[ch] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, masks[ch][0]), _mm_shuffle_epi8(b, masks[ch][1])),
+                                      _mm_shuffle_epi8(c, masks[ch][2]));
+        }
+        store128(dst + x, grayFromPlanesSse(planes[R], planes[G], planes[B]));
+    }
+    grayRow<3, R, G, B>(src, dst + x, width - x);
+}
+
+template <int R, int G, int B>
+PILLAR_TARGET_SSE41 void gray4Sse(const uint8_t* src, uint8_t* dst, int width)
+{
+    __m128i masks[3][4];
+    const int channels[3] = {R, G, B};
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int part = 0; part < 4; ++part)
+        {
+            masks[c][part] = load128(planeMask4(channels[c], part).b);
+        }
+    }
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 64)
+    {
+        const __m128i v[4] = {load128(src), load128(src + 16), load128(src + 32), load128(src + 48)};
+        __m128i planes[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            planes[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v[0], masks[c][0]), _mm_shuffle_epi8(v[1], masks[c][1])),
+                                     _mm_or_si128(_mm_shuffle_epi8(v[2], masks[c][2]), _mm_shuffle_epi8(v[3], masks[c][3])));
+        }
+        store128(dst + x, grayFromPlanesSse(planes[0], planes[1], planes[2]));
+    }
+    grayRow<4, R, G, B>(src, dst + x, width - x);
+}
+
+template <int DstChannels>
+PILLAR_TARGET_SSE41 void expandGraySse(const uint8_t* src, uint8_t* dst, int width)
+{
+    __m128i masks[DstChannels];
+    for (int part = 0; part < DstChannels; ++part)
+    {
+        masks[part] = load128(expandMask(DstChannels, part).b);
+    }
+    const __m128i alpha = DstChannels == 4 ? _mm_set1_epi32(int(0xff000000)) : _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, dst += 16 * DstChannels)
+    {
+        const __m128i g = load128(src + x);
+        for (int part = 0; part < DstChannels; ++part)
+        {
+            store128(dst + 16 * part, _mm_or_si128(_mm_shuffle_epi8(g, masks[part]), alpha));
+        }
+    }
+    expandGrayRow<DstChannels>(src + x, dst, width - x);
+}
+
+PILLAR_TARGET_SSE41 void widenSse(const uint8_t* src, uint8_t* dst, int count)
+{
+    uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+    const __m128i scale = _mm_set1_epi16(257);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i v = load128(src + i);
+        store128(out + i, _mm_mullo_epi16(_mm_cvtepu8_epi16(v), scale));
+        store128(out + i + 8, _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(v, 8)), scale));
+    }
+    widenRow(src + i, reinterpret_cast<uint8_t*>(out + i), count - i);
+}
+
+PILLAR_TARGET_SSE41 void narrowSse(const uint8_t* src, uint8_t* dst, int count)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i a = _mm_srli_epi16(load128(in + i), 8);
+        const __m128i b = _mm_srli_epi16(load128(in + i + 8), 8);
+        store128(dst + i, _mm_packus_epi16(a, b));
+    }
+    narrowRow(reinterpret_cast<const uint8_t*>(in + i), dst + i, count - i);
+}
+
+PILLAR_TARGET_SSE41 void u8ToFloatSse(const uint8_t* src, uint8_t* dst, int count)
+{
+    float* out = reinterpret_cast<float*>(dst);
+    const __m128 scale = _mm_set1_ps(kU8ToFloat);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = load128(src + i);
+        for (int k = 0; k < 4; ++k, v = _mm_srli_si128(v, 4))
+        {
+            _mm_storeu_ps(out + i + 4 * k, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)), scale));
+        }
+    }
+    u8ToFloatRow(src + i, reinterpret_cast<uint8_t*>(out + i), count - i);
+}
+
+PILLAR_TARGET_SSE41 void u16ToFloatSse(const uint8_t* src, uint8_t* dst, int count)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+    float* out = reinterpret_cast<float*>(dst);
+    const __m128 scale = _mm_set1_ps(kU16ToFloat);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i v = load128(in + i);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(v)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8))), scale));
+    }
+    u16ToFloatRow(reinterpret_cast<const uint8_t*>(in + i), reinterpret_cast<uint8_t*>(out + i), count - i);
+}
+
+PILLAR_TARGET_SSE41 inline __m128i floatToI32Sse(const float* in)
+{
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 upper = _mm_set1_ps(255.0f);
+    // max(v, 0) with v first turns NaN into 0.
+    __m128 v = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in), scale), _mm_setzero_ps());
+    return _mm_cvtps_epi32(_mm_min_ps(v, upper));
+}
+
+PILLAR_TARGET_SSE41 void floatToU8Sse(const uint8_t* src, uint8_t* dst, int count)
+{
+    const float* in = reinterpret_cast<const float*>(src);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i a = _mm_packs_epi32(floatToI32Sse(in + i), floatToI32Sse(in + i + 4));
+        const __m128i b = _mm_packs_epi32(floatToI32Sse(in + i + 8), floatToI32Sse(in + i + 12));
+        store128(dst + i, _mm_packus_epi16(a, b));
+    }
+    floatToU8Row(reinterpret_cast<const uint8_t*>(in + i), dst + i, count - i);
+}
+
+// ----------------------------------------------
+// AVX2 kernels
+// ----------------------------------------------
+// The byte shuffles of AVX2 work within 128-bit lanes, so the 3- and
+// 4-channel kernels run two independent SSE-sized blocks side by side, one
+// per lane.
+PILLAR_TARGET_AVX2 inline __m256i load256(const void* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+PILLAR_TARGET_AVX2 inline void store256(void* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+PILLAR_TARGET_AVX2 inline __m256i loadLanes(const void* lo, const void* hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(load128(lo)), load128(hi), 1);
+}
+PILLAR_TARGET_AVX2 inline __m256i broadcastMask(const ByteMask& m)
+{
+    return _mm256_broadcastsi128_si256(load128(m.b));
+}
+
+PILLAR_TARGET_AVX2 inline __m256i grayFromPlanesAvx2(__m256i r, __m256i g, __m256i b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i wr = _mm256_set1_epi16(kWeightR);
+    const __m256i wg = _mm256_set1_epi16(kWeightG);
+    const __m256i wb = _mm256_set1_epi16(kWeightB);
+    const __m256i half = _mm256_set1_epi16(128);
+
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(r, zero), wr),
+                                  _mm256_mullo_epi16(_mm256_unpacklo_epi8(g, zero), wg));
+    lo = _mm256_add_epi16(lo, _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), wb), half));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(r, zero), wr),
+                                  _mm256_mullo_epi16(_mm256_unpackhi_epi8(g, zero), wg));
+    hi = _mm256_add_epi16(hi, _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), wb), half));
+    return _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+}
+
+template <int I0, int I1, int I2, int I3>
+PILLAR_TARGET_AVX2 void swizzle3to4Avx2(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[4] = {I0, I1, I2, I3};
+    const __m256i mask = broadcastMask(swizzleMask(3, 4, idx));
+    const __m256i alpha = broadcastMask(alphaMask(4, idx));
+    int x = 0;
+    for (; x + 32 <= width; x += 32, src += 96, dst += 128)
+    {
+        const __m256i a = loadLanes(src, src + 48);
+        const __m256i b = loadLanes(src + 16, src + 64);
+        const __m256i c = loadLanes(src + 32, src + 80);
+        const __m256i o0 = _mm256_or_si256(_mm256_shuffle_epi8(a, mask), alpha);
+        const __m256i o1 = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_alignr_epi8(b, a, 12), mask), alpha);
+        const __m256i o2 = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_alignr_epi8(c, b, 8), mask), alpha);
+        const __m256i o3 = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_srli_si256(c, 4), mask), alpha);
+        store256(dst, _mm256_permute2x128_si256(o0, o1, 0x20));
+        store256(dst + 32, _mm256_permute2x128_si256(o2, o3, 0x20));
+        store256(dst + 64, _mm256_permute2x128_si256(o0, o1, 0x31));
+        store256(dst + 96, _mm256_permute2x128_si256(o2, o3, 0x31));
+    }
+    swizzle3to4Sse<I0, I1, I2, I3>(src, dst, width - x);
+}
+
+template <int I0, int I1, int I2>
+PILLAR_TARGET_AVX2 void swizzle4to3Avx2(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[3] = {I0, I1, I2};
+    const __m256i mask = broadcastMask(swizzleMask(4, 3, idx));
+    int x = 0;
+    for (; x + 32 <= width; x += 32, src += 128, dst += 96)
+    {
+        const __m256i s0 = _mm256_shuffle_epi8(loadLanes(src, src + 64), mask);
+        const __m256i s1 = _mm256_shuffle_epi8(loadLanes(src + 16, src + 80), mask);
+        const __m256i s2 = _mm256_shuffle_epi8(loadLanes(src + 32, src + 96), mask);
+        const __m256i s3 = _mm256_shuffle_epi8(loadLanes(src + 48, src + 112), mask);
+        const __m256i o0 = _mm256_or_si256(s0, _mm256_slli_si256(s1, 12));
+        const __m256i o1 = _mm256_or_si256(_mm256_srli_si256(s1, 4), _mm256_slli_si256(s2, 8));
+        const __m256i o2 = _mm256_or_si256(_mm256_srli_si256(s2, 8), _mm256_slli_si256(s3, 4));
+        store256(dst, _mm256_permute2x128_si256(o0, o1, 0x20));
+        store128(dst + 32, _mm256_castsi256_si128(o2));
+        store128(dst + 48, _mm256_extracti128_si256(o0, 1));
+        store256(dst + 64, _mm256_permute2x128_si256(o1, o2, 0x31));
+    }
+    swizzle4to3Sse<I0, I1, I2>(src, dst, width - x);
+}
+
+template <int I0, int I1, int I2, int I3>
+PILLAR_TARGET_AVX2 void swizzle4to4Avx2(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int idx[4] = {I0, I1, I2, I3};
+    const __m256i mask = broadcastMask(swizzleMask(4, 4, idx));
+    const __m256i alpha = broadcastMask(alphaMask(4, idx));
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 32, dst += 32)
+    {
+        store256(dst, _mm256_or_si256(_mm256_shuffle_epi8(load256(src), mask), alpha));
+    }
+    swizzle4to4Sse<I0, I1, I2, I3>(src, dst, width - x);
+}
+
+template <int R, int G, int B>
+PILLAR_TARGET_AVX2 void gray3Avx2(const uint8_t* src, uint8_t* dst, int width)
+{
+    __m256i masks[3][3];
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int part = 0; part < 3; ++part)
+        {
+            masks[c][part] = broadcastMask(planeMask3(c, part));
+        }
+    }
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32, src += 96)
+    {
+        const __m256i a = loadLanes(src, src + 48);
+        const __m256i b = loadLanes(src + 16, src + 64);
+        const __m256i c = loadLanes(src + 32, src + 80);
+        __m256i planes[3];
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            planes[ch] = _mm256_or_si256(
+                _mm256_or_si256(_mm256_shuffle_epi8(a, masks[ch][0]), _mm256_shuffle_epi8(b, masks[ch][1])),
+                _mm256_shuffle_epi8(c, masks[ch][2]));
+        }
+        store256(dst + x, grayFromPlanesAvx2(planes[R], planes[G], planes[B]));
+    }
+    gray3Sse<R, G, B>(src, dst + x, width - x);
+}
+
+template <int R, int G, int B>
+PILLAR_TARGET_AVX2 void gray4Avx2(const uint8_t* src, uint8_t* dst, int width)
+{
+    __m256i masks[3][4];
+    const int channels[3] = {R, G, B};
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int part = 0; part < 4; ++part)
+        {
+            masks[c][part] = broadcastMask(planeMask4(channels[c], part));
+        }
+    }
+    // Each load holds pixels 8k..8k+3 in the low lane and 8k+4..8k+7 in the
+    // high lane, this puts the 4-pixel groups back in order.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32, src += 128)
+    {
+        const __m256i v[4] = {load256(src), load256(src + 32), load256(src + 64), load256(src + 96)};
+        __m256i planes[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            planes[c] = _mm256_or_si256(
+                _mm256_or_si256(_mm256_shuffle_epi8(v[0], masks[c][0]), _mm256_shuffle_epi8(v[1], masks[c][1])),
+                _mm256_or_si256(_mm256_shuffle_epi8(v[2], masks[c][2]), _mm256_shuffle_epi8(v[3], masks[c][3])));
+        }
+        const __m256i y = grayFromPlanesAvx2(planes[0], planes[1], planes[2]);
+        store256(dst + x, _mm256_permutevar8x32_epi32(y, order));
+    }
+    gray4Sse<R, G, B>(src, dst + x, width - x);
+}
+
+PILLAR_TARGET_AVX2 void widenAvx2(const uint8_t* src, uint8_t* dst, int count)
+{
+    uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+    const __m256i scale = _mm256_set1_epi16(257);
+    int i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        store256(out + i, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(load128(src + i)), scale));
+        store256(out + i + 16, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(load128(src + i + 16)), scale));
+    }
+    widenSse(src + i, reinterpret_cast<uint8_t*>(out + i), count - i);
+}
+
+PILLAR_TARGET_AVX2 void narrowAvx2(const uint8_t* src, uint8_t* dst, int count)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+    int i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m256i a = _mm256_srli_epi16(load256(in + i), 8);
+        const __m256i b = _mm256_srli_epi16(load256(in + i + 16), 8);
+        store256(dst + i, _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+    }
+    narrowSse(reinterpret_cast<const uint8_t*>(in + i), dst + i, count - i);
+}
+
+PILLAR_TARGET_AVX2 void u8ToFloatAvx2(const uint8_t* src, uint8_t* dst, int count)
+{
+    float* out = reinterpret_cast<float*>(dst);
+    const __m256 scale = _mm256_set1_ps(kU8ToFloat);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i v = load128(src + i);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)), scale));
+        _mm256_storeu_ps(out + i + 8,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8))), scale));
+    }
+    u8ToFloatSse(src + i, reinterpret_cast<uint8_t*>(out + i), count - i);
+}
+
+PILLAR_TARGET_AVX2 void u16ToFloatAvx2(const uint8_t* src, uint8_t* dst, int count)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+    float* out = reinterpret_cast<float*>(dst);
+    const __m256 scale = _mm256_set1_ps(kU16ToFloat);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(load128(in + i))), scale));
+        _mm256_storeu_ps(out + i + 8,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(load128(in + i + 8))), scale));
+    }
+    u16ToFloatSse(reinterpret_cast<const uint8_t*>(in + i), reinterpret_cast<uint8_t*>(out + i), count - i);
+}
+
+PILLAR_TARGET_AVX2 inline __m256i floatToI32Avx2(const float* in)
+{
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    const __m256 upper = _mm256_set1_ps(255.0f);
+    __m256 v = _mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in), scale), _mm256_setzero_ps());
+    return _mm256_cvtps_epi32(_mm256_min_ps(v, upper));
+}
+
+PILLAR_TARGET_AVX2 void floatToU8Avx2(const uint8_t* src, uint8_t* dst, int count)
+{
+    const float* in = reinterpret_cast<const float*>(src);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m256i a = _mm256_packs_epi32(floatToI32Avx2(in + i), floatToI32Avx2(in + i + 8));
+        const __m256i b = _mm256_packs_epi32(floatToI32Avx2(in + i + 16), floatToI32Avx2(in + i + 24));
+        store256(dst + i, _mm256_permutevar8x32_epi32(_mm256_packus_epi16(a, b), order));
+    }
+    floatToU8Sse(reinterpret_cast<const uint8_t*>(in + i), dst + i, count - i);
+}
+
+#define PILLAR_SIMD_KERNELS(sse41, avx2) sse41, avx2
+#else
+#define PILLAR_SIMD_KERNELS(sse41, avx2) nullptr, nullptr
+#endif // PILLAR_ARCH_X86
+
+// ----------------------------------------------
+// Dispatch
+// ----------------------------------------------
+struct Conversion
+{
+    ImageFormat::Format from;
+    ImageFormat::Format to;
+    // Element-wise kernels process `width * channels` values per row.
+    bool elementWise;
+    RowKernel scalar;
+    RowKernel sse41;
+    RowKernel avx2;
+};
+
+const Conversion kConversions[] = {
+    {ImageFormat::SRGB, ImageFormat::SBGRA, false, swizzleRow<3, 4, 2, 1, 0, -1>,
+     PILLAR_SIMD_KERNELS((swizzle3to4Sse<2, 1, 0, -1>), (swizzle3to4Avx2<2, 1, 0, -1>))},
+    {ImageFormat::SRGB, ImageFormat::SRGBA, false, swizzleRow<3, 4, 0, 1, 2, -1>,
+     PILLAR_SIMD_KERNELS((swizzle3to4Sse<0, 1, 2, -1>), (swizzle3to4Avx2<0, 1, 2, -1>))},
+    {ImageFormat::SBGRA, ImageFormat::SRGB, false, swizzleRow<4, 3, 2, 1, 0, -1>,
+     PILLAR_SIMD_KERNELS((swizzle4to3Sse<2, 1, 0>), (swizzle4to3Avx2<2, 1, 0>))},
+    {ImageFormat::SRGBA, ImageFormat::SRGB, false, swizzleRow<4, 3, 0, 1, 2, -1>,
+     PILLAR_SIMD_KERNELS((swizzle4to3Sse<0, 1, 2>), (swizzle4to3Avx2<0, 1, 2>))},
+    {ImageFormat::SRGBA, ImageFormat::SBGRA, false, swizzleRow<4, 4, 2, 1, 0, 3>,
+     PILLAR_SIMD_KERNELS((swizzle4to4Sse<2, 1, 0, 3>), (swizzle4to4Avx2<2, 1, 0, 3>))},
+    {ImageFormat::SBGRA, ImageFormat::SRGBA, false, swizzleRow<4, 4, 2, 1, 0, 3>,
+     PILLAR_SIMD_KERNELS((swizzle4to4Sse<2, 1, 0, 3>), (swizzle4to4Avx2<2, 1, 0, 3>))},
+    {ImageFormat::SRGB, ImageFormat::GRAY8, false, grayRow<3, 0, 1, 2>,
+     PILLAR_SIMD_KERNELS((gray3Sse<0, 1, 2>), (gray3Avx2<0, 1, 2>))},
+    {ImageFormat::SRGBA, ImageFormat::GRAY8, false, grayRow<4, 0, 1, 2>,
+     PILLAR_SIMD_KERNELS((gray4Sse<0, 1, 2>), (gray4Avx2<0, 1, 2>))},
+    {ImageFormat::SBGRA, ImageFormat::GRAY8, false, grayRow<4, 2, 1, 0>,
+     PILLAR_SIMD_KERNELS((gray4Sse<2, 1, 0>), (gray4Avx2<2, 1, 0>))},
+    {ImageFormat::GRAY8, ImageFormat::SRGB, false, expandGrayRow<3>,
+     PILLAR_SIMD_KERNELS(expandGraySse<3>, expandGraySse<3>)},
+    {ImageFormat::GRAY8, ImageFormat::SRGBA, false, expandGrayRow<4>,
+     PILLAR_SIMD_KERNELS(expandGraySse<4>, expandGraySse<4>)},
+    {ImageFormat::GRAY8, ImageFormat::SBGRA, false, expandGrayRow<4>,
+     PILLAR_SIMD_KERNELS(expandGraySse<4>, expandGraySse<4>)},
+    {ImageFormat::GRAY8, ImageFormat::GRAY16, true, widenRow, PILLAR_SIMD_KERNELS(widenSse, widenAvx2)},
+    {ImageFormat::SRGB, ImageFormat::SRGB48, true, widenRow, PILLAR_SIMD_KERNELS(widenSse, widenAvx2)},
+    {ImageFormat::SRGBA, ImageFormat::SRGBA64, true, widenRow, PILLAR_SIMD_KERNELS(widenSse, widenAvx2)},
+    {ImageFormat::GRAY16, ImageFormat::GRAY8, true, narrowRow, PILLAR_SIMD_KERNELS(narrowSse, narrowAvx2)},
+    {ImageFormat::SRGB48, ImageFormat::SRGB, true, narrowRow, PILLAR_SIMD_KERNELS(narrowSse, narrowAvx2)},
+    {ImageFormat::SRGBA64, ImageFormat::SRGBA, true, narrowRow, PILLAR_SIMD_KERNELS(narrowSse, narrowAvx2)},
+    {ImageFormat::GRAY8, ImageFormat::VEC32F1, true, u8ToFloatRow, PILLAR_SIMD_KERNELS(u8ToFloatSse, u8ToFloatAvx2)},
+    {ImageFormat::GRAY16, ImageFormat::VEC32F1, true, u16ToFloatRow,
+     PILLAR_SIMD_KERNELS(u16ToFloatSse, u16ToFloatAvx2)},
+    {ImageFormat::VEC32F1, ImageFormat::GRAY8, true, floatToU8Row, PILLAR_SIMD_KERNELS(floatToU8Sse, floatToU8Avx2)},
+};
+
+#undef PILLAR_SIMD_KERNELS
+
+const Conversion* findConversion(ImageFormat::Format from, ImageFormat::Format to)
+{
+    for (const Conversion& conversion : kConversions)
+    {
+        if (conversion.from == from && conversion.to == to)
+        {
+            return &conversion;
+        }
+    }
+    return nullptr;
+}
+
+RowKernel selectKernel(const Conversion& conversion, cpu::SimdLevel level)
+{
+    if (level >= cpu::SimdLevel::kAVX2 && conversion.avx2 != nullptr)
+    {
+        return conversion.avx2;
+    }
+    if (level >= cpu::SimdLevel::kSSE41 && conversion.sse41 != nullptr)
+    {
+        return conversion.sse41;
+    }
+    return conversion.scalar;
+}
+} // namespace
+
+bool isConversionSupported(ImageFormat::Format from, ImageFormat::Format to)
+{
+    return from == to || findConversion(from, to) != nullptr;
+}
+
+Status convertFormat(const ImageFrame& src, ImageFormat::Format format, ImageFrame& dst)
+{
+    if (&src == &dst)
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination must be different frames");
+    }
+
+    if (src.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "source frame is empty");
+    }
+
+    if (!isConversionSupported(src.format(), format))
+    {
+        return Status(StatusCode::kUnimplemented, "unsupported format conversion");
+    }
+
+    if (dst.isEmpty() || dst.format() != format || dst.width() != src.width() || dst.height() != src.height())
+    {
+        dst.reset(format, src.width(), src.height(), ImageFrame::kDefaultAlignmentBoundary);
+    }
+    return convertFormat(ConstImageFrameView(src), ImageFrameView(dst), cpu::simdLevel());
+}
+
+Status convertFormat(const ConstImageFrameView& src, const ImageFrameView& dst)
+{
+    return convertFormat(src, dst, cpu::simdLevel());
+}
+
+Status convertFormat(const ConstImageFrameView& src, const ImageFrameView& dst, cpu::SimdLevel maxLevel)
+{
+    if (src.isEmpty() || dst.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "source or destination is empty");
+    }
+
+    if (src.width() != dst.width() || src.height() != dst.height())
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination dimensions differ");
+    }
+
+    if (src.format() == dst.format())
+    {
+        const int rowBytes = src.width() * src.channels() * src.byteDepth();
+        for (int y = 0; y < src.height(); ++y)
+        {
+            std::memcpy(dst.row(y), src.row(y), rowBytes);
+        }
+        return okStatus();
+    }
+
+    const Conversion* conversion = findConversion(src.format(), dst.format());
+    if (conversion == nullptr)
+    {
+        return Status(StatusCode::kUnimplemented, "unsupported format conversion");
+    }
+
+    const RowKernel kernel = selectKernel(*conversion, std::min(maxLevel, cpu::simdLevel()));
+    const int count = conversion->elementWise ? src.width() * src.channels() : src.width();
+    for (int y = 0; y < src.height(); ++y)
+    {
+        kernel(src.row(y), dst.row(y), count);
+    }
+    return okStatus();
+}
+} // namespace yuzu
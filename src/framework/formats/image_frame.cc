@@ -5,6 +5,7 @@
 
 #include "pillar/framework/deps/aligned_malloc_and_free.h"
 #include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_view.h"
 
 namespace yuzu
 {
@@ -14,6 +15,10 @@ const ImageFrame::Deleter ImageFrame::PixelDataDeleter::kAlignedFree = alignedFr
 const ImageFrame::Deleter ImageFrame::PixelDataDeleter::kNone = [](uint8_t* x) {};
 
 ImageFrame::ImageFrame() : mFormat(ImageFormat::Format::UNKNOWN), mWidth(0), mHeight(0), mWidthStep(0) {}
+ImageFrame::ImageFrame(ImageFormat::Format format, int width, int height, uint32_t alignmentBoundary)
+{ //
+    reset(format, width, height, alignmentBoundary);
+}
 ImageFrame::ImageFrame(ImageFormat::Format format, int width, int height)
 { //
     reset(format, width, height, kDefaultAlignmentBoundary);
@@ -228,36 +233,14 @@ void ImageFrame::internalCopyFrom(int width, int height, int widthStep, int chan
     }
 }
 
-void ImageFrame::internalCopyToBuffer(int widthStep, char* buffer) const
+void ImageFrame::copyFrom(const ImageFrame& imageFrame, uint32_t alignmentBoundary)
 {
-    const int rowBytes = channelSize() * channels() * mWidth;
-    if (widthStep == 0)
-    {
-        widthStep = channelSize() * channels() * mWidth;
-    }
-
-    const char* src = reinterpret_cast<const char*>(mPixelData.get());
-    char* dst = buffer;
-    if (widthStep == rowBytes && mWidthStep == rowBytes)
-    {
-        std::memcpy(dst, src, mHeight * rowBytes);
-    }
-    else
-    {
-        for (int i = mHeight; i > 0; --i)
-        {
-            memcpy(dst, src, rowBytes);
-            src += mWidthStep;
-            dst += widthStep;
-        }
-    }
+    copyPixelData(imageFrame.format(), imageFrame.width(), imageFrame.height(), imageFrame.step(),
+                  imageFrame.pixelData(), alignmentBoundary);
 }
-
-void ImageFrame::copyFrom(const ImageFrame& imageFrame, uint32_t alignmentBoundary)
+void ImageFrame::copyFrom(const ConstImageFrameView& view, uint32_t alignmentBoundary)
 {
-    reset(imageFrame.format(), imageFrame.width(), imageFrame.height(), alignmentBoundary);
-    internalCopyFrom(imageFrame.width(), imageFrame.height(), imageFrame.step(), imageFrame.channelSize(),
-                     imageFrame.pixelData());
+    copyPixelData(view.format(), view.width(), view.height(), view.step(), view.pixelData(), alignmentBoundary);
 }
 void ImageFrame::copyPixelData(ImageFormat::Format format, int width, int height, const uint8_t* pixelData,
                                uint32_t alignmentBoundary)
@@ -267,55 +250,28 @@ void ImageFrame::copyPixelData(ImageFormat::Format format, int width, int height
 void ImageFrame::copyPixelData(ImageFormat::Format format, int width, int height, int withStep,
                                const uint8_t* pixelData, uint32_t alignmentBoundary)
 {
-    reset(format, width, height, alignmentBoundary);
-    internalCopyFrom(width, height, withStep, channelSizeForFormat(format), pixelData);
+    // `pixelData` may point into this frame, e.g. a crop of it: fill a new
+    // buffer and let the old one go only once the copy is done.
+    ImageFrame copy(format, width, height, alignmentBoundary);
+    copy.internalCopyFrom(width, height, withStep, channelSizeForFormat(format), pixelData);
+    *this = std::move(copy);
 }
 
-void ImageFrame::copyToBuffer(uint8_t* buffer, int bufferSize) const
+Status ImageFrame::copyToBuffer(uint8_t* buffer, int bufferSize) const
 {
-    // dataSize <= bufferSize
-    const int dataSize = mWidth * mHeight * channels();
-    if (isContiguous())
-    {
-        const uint8_t* src = reinterpret_cast<const uint8_t*>(mPixelData.get());
-        std::copy_n(src, dataSize, buffer);
-    }
-    else
-    {
-        internalCopyToBuffer(0, reinterpret_cast<char*>(buffer));
-    }
+    return ConstImageFrameView(*this).copyToBuffer(buffer, bufferSize);
 }
 
-void ImageFrame::copyToBuffer(uint16_t* buffer, int bufferSize) const
+Status ImageFrame::copyToBuffer(uint16_t* buffer, int bufferSize) const
 {
-    // dataSize <= bufferSize
     // byteDepth == 2
-    const int dataSize = mWidth * mHeight * channels();
-    if (isContiguous())
-    {
-        const uint16_t* src = reinterpret_cast<const uint16_t*>(mPixelData.get());
-        std::copy_n(src, dataSize, buffer);
-    }
-    else
-    {
-        internalCopyToBuffer(0, reinterpret_cast<char*>(buffer));
-    }
+    return ConstImageFrameView(*this).copyToBuffer(buffer, bufferSize);
 }
 
-void ImageFrame::copyToBuffer(float* buffer, int bufferSize) const
+Status ImageFrame::copyToBuffer(float* buffer, int bufferSize) const
 {
-    // dataSize <= bufferSize
     // byteDepth == 4
-    const int dataSize = mWidth * mHeight * channels();
-    if (isContiguous())
-    {
-        const float* src = reinterpret_cast<const float*>(mPixelData.get());
-        std::copy_n(src, dataSize, buffer);
-    }
-    else
-    {
-        internalCopyToBuffer(0, reinterpret_cast<char*>(buffer));
-    }
+    return ConstImageFrameView(*this).copyToBuffer(buffer, bufferSize);
 }
 
 std::ostream& operator<<(std::ostream& os, const ImageFrame& obj)
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "pillar/framework/deps/aligned_malloc_and_free.h"
+#include "pillar/framework/formats/image_frame_pool.h"
+
+namespace yuzu
+{
+namespace
+{
+struct PoolKey
+{
+    ImageFormat::Format format;
+    int width;
+    int height;
+    uint32_t alignment;
+
+    bool operator==(const PoolKey& other) const
+    {
+        return format == other.format && width == other.width && height == other.height &&
+               alignment == other.alignment;
+    }
+};
+
+struct PoolKeyHash
+{
+    size_t operator()(const PoolKey& key) const
+    {
+        size_t h = static_cast<size_t>(key.format);
+        h = h * 31 + static_cast<size_t>(key.width);
+        h = h * 31 + static_cast<size_t>(key.height);
+        h = h * 31 + static_cast<size_t>(key.alignment);
+        return h;
+    }
+};
+
+// Stored right in front of the pixel data, so the deleter only has to capture
+// the pool itself and still knows where the buffer belongs.
+struct BufferHeader
+{
+    PoolKey key;
+    size_t bytes;
+    size_t offset;
+};
+
+constexpr size_t kMinimumAllocAlignment = 16;
+
+int alignedStep(ImageFormat::Format format, int width, uint32_t alignmentBoundary)
+{
+    int step = width * ImageFrame::numberOfChannelsForFormat(format) * ImageFrame::byteDepthForFormat(format);
+    if (alignmentBoundary > 1)
+    {
+        step = ((step - 1) | (alignmentBoundary - 1)) + 1;
+    }
+    return step;
+}
+
+uint8_t* allocateBuffer(const PoolKey& key, size_t bytes)
+{
+    const size_t alignment = std::max<size_t>(key.alignment, kMinimumAllocAlignment);
+    const size_t offset = (sizeof(BufferHeader) + alignment - 1) / alignment * alignment;
+    uint8_t* base = reinterpret_cast<uint8_t*>(alignedMalloc(offset + bytes, static_cast<int>(alignment)));
+    if (base == nullptr)
+    {
+        return nullptr;
+    }
+
+    uint8_t* pixelData = base + offset;
+    BufferHeader* header = reinterpret_cast<BufferHeader*>(pixelData) - 1;
+    header->key = key;
+    header->bytes = bytes;
+    header->offset = offset;
+    return pixelData;
+}
+
+const BufferHeader& headerOf(const uint8_t* pixelData) { return *(reinterpret_cast<const BufferHeader*>(pixelData) - 1); }
+
+void freeBuffer(uint8_t* pixelData) { alignedFree(pixelData - headerOf(pixelData).offset); }
+} // namespace
+
+namespace internal
+{
+struct ImageFramePoolState
+{
+    explicit ImageFramePoolState(size_t maxBytesRetained) : maxBytesRetained(maxBytesRetained) {}
+
+    ~ImageFramePoolState()
+    {
+        for (auto& bucket : freeLists)
+        {
+            for (uint8_t* pixelData : bucket.second)
+            {
+                freeBuffer(pixelData);
+            }
+        }
+    }
+
+    uint8_t* take(const PoolKey& key, size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mut);
+            auto it = freeLists.find(key);
+            if (it != freeLists.end() && !it->second.empty())
+            {
+                uint8_t* pixelData = it->second.back();
+                it->second.pop_back();
+                stats.bytesRetained -= bytes;
+                ++stats.hits;
+                return pixelData;
+            }
+            ++stats.misses;
+        }
+
+        uint8_t* pixelData = allocateBuffer(key, bytes);
+        if (pixelData != nullptr)
+        {
+            std::lock_guard<std::mutex> lk(mut);
+            bytesOwned += bytes;
+            stats.highWaterMark = std::max(stats.highWaterMark, bytesOwned);
+        }
+        return pixelData;
+    }
+
+    // Keeps the buffer for reuse, returns false if the pool is full.
+    bool retain(uint8_t* pixelData)
+    {
+        const BufferHeader& header = headerOf(pixelData);
+        std::lock_guard<std::mutex> lk(mut);
+        if (maxBytesRetained != 0 && stats.bytesRetained + header.bytes > maxBytesRetained)
+        {
+            bytesOwned -= header.bytes;
+            return false;
+        }
+
+        freeLists[header.key].push_back(pixelData);
+        stats.bytesRetained += header.bytes;
+        return true;
+    }
+
+    void recycle(uint8_t* pixelData)
+    {
+        if (!retain(pixelData))
+        {
+            freeBuffer(pixelData);
+        }
+    }
+
+    const size_t maxBytesRetained;
+    mutable std::mutex mut;
+    std::unordered_map<PoolKey, std::vector<uint8_t*>, PoolKeyHash> freeLists;
+    ImageFramePool::Stats stats;
+    size_t bytesOwned = 0;
+};
+} // namespace internal
+
+namespace
+{
+ImageFrame acquireFrom(const std::shared_ptr<internal::ImageFramePoolState>& state, ImageFormat::Format format,
+                       int width, int height, uint32_t alignmentBoundary)
+{
+    const PoolKey key{format, width, height, alignmentBoundary};
+    const int step = alignedStep(format, width, alignmentBoundary);
+    uint8_t* pixelData = state->take(key, static_cast<size_t>(step) * height);
+    if (pixelData == nullptr)
+    {
+        return ImageFrame();
+    }
+
+    std::weak_ptr<internal::ImageFramePoolState> pool = state;
+    ImageFrame::Deleter deleter = [pool](uint8_t* pixelData)
+    {
+        if (pixelData == nullptr)
+        {
+            return;
+        }
+
+        if (auto state = pool.lock())
+        {
+            state->recycle(pixelData);
+        }
+        else
+        {
+            freeBuffer(pixelData);
+        }
+    };
+    return ImageFrame(format, width, height, step, pixelData, std::move(deleter));
+}
+} // namespace
+
+ImageFramePool::ImageFramePool(size_t maxBytesRetained)
+    : mState(std::make_shared<internal::ImageFramePoolState>(maxBytesRetained))
+{
+}
+
+ImageFramePool::~ImageFramePool() = default;
+
+ImageFrame ImageFramePool::acquire(ImageFormat::Format format, int width, int height, uint32_t alignmentBoundary)
+{
+    return acquireFrom(mState, format, width, height, alignmentBoundary);
+}
+
+ImageFrame ImageFramePool::acquireCopy(const ImageFrame& imageFrame, uint32_t alignmentBoundary)
+{
+    ImageFrame frame = acquire(imageFrame.format(), imageFrame.width(), imageFrame.height(), alignmentBoundary);
+    if (frame.isEmpty() || imageFrame.isEmpty())
+    {
+        return frame;
+    }
+
+    const int rowBytes = imageFrame.width() * imageFrame.channels() * imageFrame.byteDepth();
+    const uint8_t* src = imageFrame.pixelData();
+    uint8_t* dst = frame.pixelData();
+    if (imageFrame.step() == rowBytes && frame.step() == rowBytes)
+    {
+        std::memcpy(dst, src, static_cast<size_t>(rowBytes) * frame.height());
+    }
+    else
+    {
+        for (int i = frame.height(); i > 0; --i)
+        {
+            std::memcpy(dst, src, rowBytes);
+            src += imageFrame.step();
+            dst += frame.step();
+        }
+    }
+    return frame;
+}
+
+void ImageFramePool::reserve(ImageFormat::Format format, int width, int height, uint32_t alignmentBoundary,
+                             size_t count)
+{
+    const PoolKey key{format, width, height, alignmentBoundary};
+    const size_t bytes = static_cast<size_t>(alignedStep(format, width, alignmentBoundary)) * height;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t* pixelData = allocateBuffer(key, bytes);
+        if (pixelData == nullptr)
+        {
+            return;
+        }
+
+        std::memset(pixelData, 0, bytes);
+        {
+            std::lock_guard<std::mutex> lk(mState->mut);
+            mState->bytesOwned += bytes;
+            mState->stats.highWaterMark = std::max(mState->stats.highWaterMark, mState->bytesOwned);
+        }
+
+        if (!mState->retain(pixelData))
+        {
+            freeBuffer(pixelData);
+            return;
+        }
+    }
+}
+
+void ImageFramePool::clear()
+{
+    std::unordered_map<PoolKey, std::vector<uint8_t*>, PoolKeyHash> freeLists;
+    {
+        std::lock_guard<std::mutex> lk(mState->mut);
+        freeLists.swap(mState->freeLists);
+        mState->bytesOwned -= mState->stats.bytesRetained;
+        mState->stats.bytesRetained = 0;
+    }
+
+    for (auto& bucket : freeLists)
+    {
+        for (uint8_t* pixelData : bucket.second)
+        {
+            freeBuffer(pixelData);
+        }
+    }
+}
+
+ImageFramePool::Stats ImageFramePool::stats() const
+{
+    std::lock_guard<std::mutex> lk(mState->mut);
+    return mState->stats;
+}
+
+ImageFramePool::Allocator ImageFramePool::allocator() const
+{
+    std::weak_ptr<internal::ImageFramePoolState> pool = mState;
+    return [pool](ImageFormat::Format format, int width, int height, uint32_t alignmentBoundary)
+    {
+        if (auto state = pool.lock())
+        {
+            return acquireFrom(state, format, width, height, alignmentBoundary);
+        }
+        return ImageFrame(format, width, height, alignmentBoundary);
+    };
+}
+} // namespace yuzu
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "pillar/framework/formats/image_resize.h"
+#include "pillar/thread_pool/parallel_for.h"
+#include "pillar/utility/cpu_features.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+// Row buffers get this many spare floats so 4-wide loads and stores may run
+// past the last pixel.
+constexpr int kRowPadding = 4;
+
+// Filter taps along one axis, stored tap-major: tap k of destination
+// position d is at [k * dstLength + d].
+struct AxisCoefficients
+{
+    int taps;
+    int dstLength;
+    std::vector<int32_t> index;
+    std::vector<float> weight;
+};
+
+std::shared_ptr<const AxisCoefficients> computeBilinear(int srcLength, int dstLength)
+{
+    auto coefficients = std::make_shared<AxisCoefficients>();
+    coefficients->taps = 2;
+    coefficients->dstLength = dstLength;
+    coefficients->index.resize(2 * dstLength);
+    coefficients->weight.resize(2 * dstLength);
+
+    const double scale = double(srcLength) / dstLength;
+    for (int d = 0; d < dstLength; ++d)
+    {
+        const double s = (d + 0.5) * scale - 0.5;
+        int i0 = static_cast<int>(std::floor(s));
+        double f = s - i0;
+        if (i0 < 0)
+        {
+            i0 = 0;
+            f = 0.0;
+        }
+        if (i0 >= srcLength - 1)
+        {
+            i0 = srcLength - 1;
+            f = 0.0;
+        }
+
+        coefficients->index[d] = i0;
+        coefficients->index[dstLength + d] = std::min(i0 + 1, srcLength - 1);
+        coefficients->weight[d] = static_cast<float>(1.0 - f);
+        coefficients->weight[dstLength + d] = static_cast<float>(f);
+    }
+    return coefficients;
+}
+
+std::shared_ptr<const AxisCoefficients> computeArea(int srcLength, int dstLength)
+{
+    const double scale = double(srcLength) / dstLength;
+    auto coefficients = std::make_shared<AxisCoefficients>();
+    coefficients->taps = static_cast<int>(std::ceil(scale)) + 1;
+    coefficients->dstLength = dstLength;
+    coefficients->index.resize(coefficients->taps * dstLength);
+    coefficients->weight.resize(coefficients->taps * dstLength);
+
+    for (int d = 0; d < dstLength; ++d)
+    {
+        const double start = d * scale;
+        const double end = std::min((d + 1) * scale, double(srcLength));
+        int k = 0;
+        int last = static_cast<int>(start);
+        for (int i = static_cast<int>(std::floor(start)); i < end && k < coefficients->taps; ++i, ++k)
+        {
+            const double overlap = std::min(end, i + 1.0) - std::max(start, double(i));
+            coefficients->index[k * dstLength + d] = i;
+            coefficients->weight[k * dstLength + d] = static_cast<float>(overlap / (end - start));
+            last = i;
+        }
+        // Unused taps point at a valid row with zero weight.
+        for (; k < coefficients->taps; ++k)
+        {
+            coefficients->index[k * dstLength + d] = last;
+            coefficients->weight[k * dstLength + d] = 0.0f;
+        }
+    }
+    return coefficients;
+}
+
+// Coefficients only depend on the mode and the two lengths, a video stream
+// keeps asking for the same few of them.
+std::shared_ptr<const AxisCoefficients> axisCoefficients(InterpolationMode mode, int srcLength, int dstLength)
+{
+    using Key = std::tuple<int, int, int>;
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return (size_t(std::get<0>(key)) * 31 + size_t(std::get<1>(key))) * 1000003 + size_t(std::get<2>(key));
+        }
+    };
+    constexpr size_t kMaxCachedEntries = 64;
+    static std::mutex mut;
+    static std::unordered_map<Key, std::shared_ptr<const AxisCoefficients>, KeyHash> cache;
+
+    const Key key(static_cast<int>(mode), srcLength, dstLength);
+    {
+        std::lock_guard<std::mutex> lk(mut);
+        auto it = cache.find(key);
+        if (it != cache.end())
+        {
+            return it->second;
+        }
+    }
+
+    auto coefficients = mode == InterpolationMode::kArea ? computeArea(srcLength, dstLength)
+                                                         : computeBilinear(srcLength, dstLength);
+    std::lock_guard<std::mutex> lk(mut);
+    if (cache.size() >= kMaxCachedEntries)
+    {
+        cache.clear();
+    }
+    cache.emplace(key, coefficients);
+    return coefficients;
+}
+
+// ----------------------------------------------
+// Horizontal pass: float source row -> float row of destination width
+// ----------------------------------------------
+void horizontalScalar(const float* in, float* out, const AxisCoefficients& cx, int channels)
+{
+    const int n = cx.dstLength;
+    for (int x = 0; x < n; ++x)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            float acc = 0.0f;
+            for (int k = 0; k < cx.taps; ++k)
+            {
+                acc += cx.weight[k * n + x] * in[cx.index[k * n + x] * channels + c];
+            }
+            out[x * channels + c] = acc;
+        }
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+// One channel: 8 destination pixels at a time, gathering the taps.
+PILLAR_TARGET_AVX2 void horizontalGray(const float* in, float* out, const AxisCoefficients& cx)
+{
+    const int n = cx.dstLength;
+    int x = 0;
+    for (; x + 8 <= n; x += 8)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        for (int k = 0; k < cx.taps; ++k)
+        {
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&cx.index[k * n + x]));
+            const __m256 w = _mm256_loadu_ps(&cx.weight[k * n + x]);
+            acc = _mm256_fmadd_ps(_mm256_i32gather_ps(in, idx, 4), w, acc);
+        }
+        _mm256_storeu_ps(out + x, acc);
+    }
+
+    for (; x < n; ++x)
+    {
+        float acc = 0.0f;
+        for (int k = 0; k < cx.taps; ++k)
+        {
+            acc += cx.weight[k * n + x] * in[cx.index[k * n + x]];
+        }
+        out[x] = acc;
+    }
+}
+
+// Two to four channels: one pixel per 128-bit register. Stores spill into the
+// next pixel, which is written right after, and into the row padding.
+PILLAR_TARGET_AVX2 void horizontalPixels(const float* in, float* out, const AxisCoefficients& cx, int channels)
+{
+    const int n = cx.dstLength;
+    for (int x = 0; x < n; ++x)
+    {
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < cx.taps; ++k)
+        {
+            const __m128 px = _mm_loadu_ps(in + cx.index[k * n + x] * channels);
+            acc = _mm_fmadd_ps(px, _mm_set1_ps(cx.weight[k * n + x]), acc);
+        }
+        _mm_storeu_ps(out + x * channels, acc);
+    }
+}
+#endif
+
+void horizontal(const float* in, float* out, const AxisCoefficients& cx, int channels)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (cpu::simdLevel() >= cpu::SimdLevel::kAVX2)
+    {
+        if (channels == 1)
+        {
+            horizontalGray(in, out, cx);
+            return;
+        }
+        if (channels <= 4)
+        {
+            horizontalPixels(in, out, cx, channels);
+            return;
+        }
+    }
+#endif
+    horizontalScalar(in, out, cx, channels);
+}
+
+// ----------------------------------------------
+// Vertical pass: blend filtered rows into the destination row
+// ----------------------------------------------
+inline void storeValue(uint8_t* out, float v)
+{
+    *out = static_cast<uint8_t>(std::lrint(std::min(std::max(v, 0.0f), 255.0f)));
+}
+inline void storeValue(uint16_t* out, float v)
+{
+    *out = static_cast<uint16_t>(std::lrint(std::min(std::max(v, 0.0f), 65535.0f)));
+}
+inline void storeValue(float* out, float v) { *out = v; }
+
+template <class T>
+void verticalScalar(const float* const* rows, const float* weights, int taps, T* out, int length, int start)
+{
+    for (int i = start; i < length; ++i)
+    {
+        float acc = 0.0f;
+        for (int k = 0; k < taps; ++k)
+        {
+            acc += weights[k] * rows[k][i];
+        }
+        storeValue(out + i, acc);
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+PILLAR_TARGET_AVX2 inline void store8(uint8_t* out, __m256 v)
+{
+    const __m256i i32 = _mm256_cvtps_epi32(v);
+    const __m128i i16 = _mm_packs_epi32(_mm256_castsi256_si128(i32), _mm256_extracti128_si256(i32, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(i16, i16));
+}
+PILLAR_TARGET_AVX2 inline void store8(uint16_t* out, __m256 v)
+{
+    const __m256i i32 = _mm256_cvtps_epi32(v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_packus_epi32(_mm256_castsi256_si128(i32), _mm256_extracti128_si256(i32, 1)));
+}
+PILLAR_TARGET_AVX2 inline void store8(float* out, __m256 v) { _mm256_storeu_ps(out, v); }
+
+template <class T>
+PILLAR_TARGET_AVX2 void verticalAvx2(const float* const* rows, const float* weights, int taps, T* out, int length)
+{
+    int i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        __m256 acc = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), _mm256_set1_ps(weights[0]));
+        for (int k = 1; k < taps; ++k)
+        {
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(weights[k]), acc);
+        }
+        store8(out + i, acc);
+    }
+    verticalScalar(rows, weights, taps, out, length, i);
+}
+#endif
+
+template <class T>
+void vertical(const float* const* rows, const float* weights, int taps, T* out, int length)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (cpu::simdLevel() >= cpu::SimdLevel::kAVX2)
+    {
+        verticalAvx2(rows, weights, taps, out, length);
+        return;
+    }
+#endif
+    verticalScalar(rows, weights, taps, out, length, 0);
+}
+
+// Resizes destination rows [y0, y1). Each band keeps its own ring of
+// horizontally filtered source rows, so rows shared by neighbouring
+// destination rows are fetched and filtered once.
+template <class T>
+void resizeBand(const RowFetcher& fetchRow, int srcWidth, const ImageFrameView& dst, const AxisCoefficients& cx,
+                const AxisCoefficients& cy, int y0, int y1)
+{
+    const int channels = dst.channels();
+    const int dstLength = dst.width() * channels;
+    const int ringSize = cy.taps;
+    const int ringStride = dstLength + kRowPadding;
+
+    std::vector<float> srcRow(srcWidth * channels + kRowPadding, 0.0f);
+    std::vector<float> ring(size_t(ringSize) * ringStride, 0.0f);
+    std::vector<int> ringRow(ringSize, -1);
+    std::vector<const float*> rows(cy.taps);
+    std::vector<float> weights(cy.taps);
+
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int k = 0; k < cy.taps; ++k)
+        {
+            const int sy = cy.index[k * cy.dstLength + y];
+            const int slot = sy % ringSize;
+            float* filtered = ring.data() + size_t(slot) * ringStride;
+            if (ringRow[slot] != sy)
+            {
+                fetchRow(sy, srcRow.data());
+                horizontal(srcRow.data(), filtered, cx, channels);
+                ringRow[slot] = sy;
+            }
+            rows[k] = filtered;
+            weights[k] = cy.weight[k * cy.dstLength + y];
+        }
+        vertical(rows.data(), weights.data(), cy.taps, reinterpret_cast<T*>(dst.row(y)), dstLength);
+    }
+}
+
+template <class T>
+RowFetcher viewRowFetcher(const ConstImageFrameView& src)
+{
+    const int length = src.width() * src.channels();
+    return [src, length](int y, float* row)
+    {
+        const T* in = reinterpret_cast<const T*>(src.row(y));
+        std::copy(in, in + length, row);
+    };
+}
+
+template <class T>
+void fillRows(const ImageFrameView& view, int y0, int y1, int x0, int x1, T value)
+{
+    const int channels = view.channels();
+    for (int y = y0; y < y1; ++y)
+    {
+        T* row = reinterpret_cast<T*>(view.row(y));
+        std::fill(row + x0 * channels, row + x1 * channels, value);
+    }
+}
+
+void fill(const ImageFrameView& view, int y0, int y1, int x0, int x1, float value)
+{
+    switch (view.byteDepth())
+    {
+        case 1:
+            fillRows<uint8_t>(view, y0, y1, x0, x1, static_cast<uint8_t>(value));
+            break;
+        case 2:
+            fillRows<uint16_t>(view, y0, y1, x0, x1, static_cast<uint16_t>(value));
+            break;
+        case 4:
+            fillRows<float>(view, y0, y1, x0, x1, value);
+            break;
+    }
+}
+} // namespace
+
+Status resize(const ConstImageFrameView& src, const ImageFrameView& dst, InterpolationMode mode)
+{
+    if (src.isEmpty() || dst.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "source or destination is empty");
+    }
+
+    if (src.format() != dst.format())
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination formats differ");
+    }
+
+    const int byteDepth = src.byteDepth();
+    if (byteDepth != 1 && byteDepth != 2 && byteDepth != 4)
+    {
+        return Status(StatusCode::kUnimplemented, "unsupported format for resize");
+    }
+
+    RowFetcher fetchRow = byteDepth == 1   ? viewRowFetcher<uint8_t>(src)
+                          : byteDepth == 2 ? viewRowFetcher<uint16_t>(src)
+                                           : viewRowFetcher<float>(src);
+    return resize(fetchRow, src.width(), src.height(), dst, mode);
+}
+
+Status resize(const RowFetcher& fetchRow, int width, int height, const ImageFrameView& dst, InterpolationMode mode)
+{
+    if (width <= 0 || height <= 0 || dst.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "empty source or destination");
+    }
+
+    const int byteDepth = dst.byteDepth();
+    if (byteDepth != 1 && byteDepth != 2 && byteDepth != 4)
+    {
+        return Status(StatusCode::kUnimplemented, "unsupported format for resize");
+    }
+
+    const auto cx = axisCoefficients(mode, width, dst.width());
+    const auto cy = axisCoefficients(mode, height, dst.height());
+    // Bands below roughly 64k pixels are not worth a thread.
+    const int minBandRows = std::max(8, (1 << 16) / std::max(1, dst.width()));
+    parallelFor(0, dst.height(), minBandRows,
+                [&](int y0, int y1)
+                {
+                    if (byteDepth == 1)
+                        resizeBand<uint8_t>(fetchRow, width, dst, *cx, *cy, y0, y1);
+                    else if (byteDepth == 2)
+                        resizeBand<uint16_t>(fetchRow, width, dst, *cx, *cy, y0, y1);
+                    else
+                        resizeBand<float>(fetchRow, width, dst, *cx, *cy, y0, y1);
+                });
+    return okStatus();
+}
+
+Status resize(const ImageFrame& src, int width, int height, ImageFrame& dst, InterpolationMode mode)
+{
+    if (&src == &dst)
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination must be different frames");
+    }
+
+    if (src.isEmpty() || width <= 0 || height <= 0)
+    {
+        return Status(StatusCode::kInvalidArgument, "empty source or destination size");
+    }
+
+    if (dst.isEmpty() || dst.format() != src.format() || dst.width() != width || dst.height() != height)
+    {
+        dst.reset(src.format(), width, height, ImageFrame::kDefaultAlignmentBoundary);
+    }
+    return resize(ConstImageFrameView(src), ImageFrameView(dst), mode);
+}
+
+Status letterbox(const ConstImageFrameView& src, const ImageFrameView& dst, Rectangle<float>& mapping,
+                 InterpolationMode mode, float padValue)
+{
+    if (src.isEmpty() || dst.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "source or destination is empty");
+    }
+
+    const double scale = std::min(double(dst.width()) / src.width(), double(dst.height()) / src.height());
+    const int width = std::max(1, std::min(dst.width(), static_cast<int>(std::lround(src.width() * scale))));
+    const int height = std::max(1, std::min(dst.height(), static_cast<int>(std::lround(src.height() * scale))));
+    const int left = (dst.width() - width) / 2;
+    const int top = (dst.height() - height) / 2;
+
+    Status status = resize(src, dst.crop(Rectangle<int>(left, top, width, height)), mode);
+    if (!status.ok())
+    {
+        return status;
+    }
+
+    fill(dst, 0, top, 0, dst.width(), padValue);
+    fill(dst, top + height, dst.height(), 0, dst.width(), padValue);
+    fill(dst, top, top + height, 0, left, padValue);
+    fill(dst, top, top + height, left + width, dst.width(), padValue);
+
+    const float sx = float(width) / src.width();
+    const float sy = float(height) / src.height();
+    mapping = Rectangle<float>(-left / sx, -top / sy, dst.width() / sx, dst.height() / sy);
+    return okStatus();
+}
+} // namespace yuzu
@@ -0,0 +1,295 @@
+#include <cstring>
+
+#include "pillar/framework/formats/image_to_tensor.h"
+#include "pillar/utility/cpu_features.h"
+#include "pillar/utility/half.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+struct Plan
+{
+    // Bytes per source pixel.
+    int srcStride;
+    // Tensor channels.
+    int channels;
+    // Byte offset in the source pixel of every tensor channel.
+    int srcIndex[3];
+    float scale[3];
+    float bias[3];
+};
+
+inline void storeValue(float* out, float v) { *out = v; }
+inline void storeValue(uint16_t* out, float v) { *out = floatToHalf(v); }
+
+// `channelStride` and `pixelStride` describe the layout: CHW uses
+// (H * W, 1) and HWC uses (1, C).
+template <class OutT>
+void scalarRow(const uint8_t* src, int width, const Plan& plan, OutT* out, size_t channelStride, size_t pixelStride)
+{
+    for (int x = 0; x < width; ++x, src += plan.srcStride, out += pixelStride)
+    {
+        for (int c = 0; c < plan.channels; ++c)
+        {
+            storeValue(out + c * channelStride, float(src[plan.srcIndex[c]]) * plan.scale[c] + plan.bias[c]);
+        }
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+PILLAR_TARGET_AVX2 inline __m128i load128(const void* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+PILLAR_TARGET_AVX2 inline void store8(float* out, __m256 v) { _mm256_storeu_ps(out, v); }
+PILLAR_TARGET_AVX2 inline void store8(uint16_t* out, __m256 v)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+PILLAR_TARGET_AVX2 inline void store4(float* out, __m128 v) { _mm_storeu_ps(out, v); }
+PILLAR_TARGET_AVX2 inline void store4(uint16_t* out, __m128 v)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+
+// Converts 16 bytes to floats and applies `v * scale + bias`.
+template <class OutT>
+PILLAR_TARGET_AVX2 inline void storeNormalized16(OutT* out, __m128i bytes, __m256 scale, __m256 bias)
+{
+    const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    const __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+    store8(out, _mm256_fmadd_ps(lo, scale, bias));
+    store8(out + 8, _mm256_fmadd_ps(hi, scale, bias));
+}
+
+// Loads 16 pixels as four registers holding 4 pixels each in their low bytes.
+PILLAR_TARGET_AVX2 inline void loadGroups(const uint8_t* src, int srcStride, __m128i groups[4])
+{
+    if (srcStride == 4)
+    {
+        for (int q = 0; q < 4; ++q)
+        {
+            groups[q] = load128(src + 16 * q);
+        }
+        return;
+    }
+
+    const __m128i a = load128(src);
+    const __m128i b = load128(src + 16);
+    const __m128i c = load128(src + 32);
+    groups[0] = a;
+    groups[1] = _mm_alignr_epi8(b, a, 12);
+    groups[2] = _mm_alignr_epi8(c, b, 8);
+    groups[3] = _mm_srli_si128(c, 4);
+}
+
+template <class OutT>
+PILLAR_TARGET_AVX2 void grayRowAvx2(const uint8_t* src, int width, const Plan& plan, OutT* out)
+{
+    const __m256 scale = _mm256_set1_ps(plan.scale[0]);
+    const __m256 bias = _mm256_set1_ps(plan.bias[0]);
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        storeNormalized16(out + x, load128(src + x), scale, bias);
+    }
+    scalarRow(src + x, width - x, plan, out + x, 1, 1);
+}
+
+template <class OutT>
+PILLAR_TARGET_AVX2 void planarRowAvx2(const uint8_t* src, int width, const Plan& plan, OutT* out, size_t planeSize)
+{
+    // masks[c][q] gathers channel c of group q into bytes 4q..4q+3.
+    __m128i masks[3][4];
+    __m256 scale[3], bias[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int q = 0; q < 4; ++q)
+        {
+            alignas(16) int8_t m[16];
+            std::memset(m, 0x80, sizeof(m));
+            for (int p = 0; p < 4; ++p)
+            {
+                m[4 * q + p] = int8_t(plan.srcStride * p + plan.srcIndex[c]);
+            }
+            masks[c][q] = load128(m);
+        }
+        scale[c] = _mm256_set1_ps(plan.scale[c]);
+        bias[c] = _mm256_set1_ps(plan.bias[c]);
+    }
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 16 * plan.srcStride)
+    {
+        __m128i groups[4];
+        loadGroups(src, plan.srcStride, groups);
+        for (int c = 0; c < 3; ++c)
+        {
+            const __m128i plane =
+                _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(groups[0], masks[c][0]), _mm_shuffle_epi8(groups[1], masks[c][1])),
+                             _mm_or_si128(_mm_shuffle_epi8(groups[2], masks[c][2]), _mm_shuffle_epi8(groups[3], masks[c][3])));
+            storeNormalized16(out + c * planeSize + x, plane, scale[c], bias[c]);
+        }
+    }
+    scalarRow(src, width - x, plan, out + x, planeSize, 1);
+}
+
+template <class OutT>
+PILLAR_TARGET_AVX2 void interleavedRowAvx2(const uint8_t* src, int width, const Plan& plan, OutT* out)
+{
+    // Packs the 4 pixels of a group into 12 bytes in tensor channel order.
+    alignas(16) int8_t m[16];
+    std::memset(m, 0x80, sizeof(m));
+    for (int p = 0; p < 4; ++p)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            m[3 * p + c] = int8_t(plan.srcStride * p + plan.srcIndex[c]);
+        }
+    }
+    const __m128i mask = load128(m);
+
+    // The 12 values of a group are channels 0,1,2,0,1,2,0,1 | 2,0,1,2.
+    const __m256 scaleLo = _mm256_setr_ps(plan.scale[0], plan.scale[1], plan.scale[2], plan.scale[0], plan.scale[1],
+                                          plan.scale[2], plan.scale[0], plan.scale[1]);
+    const __m256 biasLo = _mm256_setr_ps(plan.bias[0], plan.bias[1], plan.bias[2], plan.bias[0], plan.bias[1],
+                                         plan.bias[2], plan.bias[0], plan.bias[1]);
+    const __m128 scaleHi = _mm_setr_ps(plan.scale[2], plan.scale[0], plan.scale[1], plan.scale[2]);
+    const __m128 biasHi = _mm_setr_ps(plan.bias[2], plan.bias[0], plan.bias[1], plan.bias[2]);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 16 * plan.srcStride, out += 48)
+    {
+        __m128i groups[4];
+        loadGroups(src, plan.srcStride, groups);
+        for (int q = 0; q < 4; ++q)
+        {
+            const __m128i packed = _mm_shuffle_epi8(groups[q], mask);
+            const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(packed));
+            const __m128 hi = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(packed, 8)));
+            store8(out + 12 * q, _mm256_fmadd_ps(lo, scaleLo, biasLo));
+            store4(out + 12 * q + 8, _mm_fmadd_ps(hi, scaleHi, biasHi));
+        }
+    }
+    scalarRow(src, width - x, plan, out, 1, 3);
+}
+#endif // PILLAR_ARCH_X86
+
+template <class OutT>
+void convert(const ConstImageFrameView& src, const Plan& plan, TensorLayout layout, OutT* out)
+{
+    const int width = src.width();
+    const int height = src.height();
+    const size_t planeSize = size_t(width) * height;
+    const bool planar = layout == TensorLayout::kNCHW && plan.channels > 1;
+
+#if defined(PILLAR_ARCH_X86)
+    if (cpu::simdLevel() >= cpu::SimdLevel::kAVX2)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            if (plan.channels == 1)
+                grayRowAvx2(src.row(y), width, plan, out + size_t(y) * width);
+            else if (planar)
+                planarRowAvx2(src.row(y), width, plan, out + size_t(y) * width, planeSize);
+            else
+                interleavedRowAvx2(src.row(y), width, plan, out + size_t(y) * width * 3);
+        }
+        return;
+    }
+#endif
+
+    for (int y = 0; y < height; ++y)
+    {
+        if (planar)
+            scalarRow(src.row(y), width, plan, out + size_t(y) * width, planeSize, 1);
+        else
+            scalarRow(src.row(y), width, plan, out + size_t(y) * width * plan.channels, 1, plan.channels);
+    }
+}
+} // namespace
+
+Status toTensor(const ConstImageFrameView& src, const TensorConversionOptions& options, void* buffer,
+                const Dims& dims)
+{
+    if (src.isEmpty() || buffer == nullptr)
+    {
+        return Status(StatusCode::kInvalidArgument, "empty frame or tensor buffer");
+    }
+
+    Plan plan;
+    switch (src.format())
+    {
+        case ImageFormat::SRGB:
+            plan.srcStride = 3;
+            plan.channels = 3;
+            break;
+        case ImageFormat::SBGRA:
+            plan.srcStride = 4;
+            plan.channels = 3;
+            break;
+        case ImageFormat::GRAY8:
+            plan.srcStride = 1;
+            plan.channels = 1;
+            break;
+        default:
+            return Status(StatusCode::kUnimplemented, "toTensor supports SRGB, SBGRA and GRAY8 frames");
+    }
+
+    // Source byte offsets of R, G and B.
+    const int rgb[3] = {src.format() == ImageFormat::SBGRA ? 2 : 0, 1, src.format() == ImageFormat::SBGRA ? 0 : 2};
+    for (int c = 0; c < plan.channels; ++c)
+    {
+        const int rgbChannel = (plan.channels == 1 || options.channelOrder == ChannelOrder::kRGB) ? c : 2 - c;
+        plan.srcIndex[c] = plan.channels == 1 ? 0 : rgb[rgbChannel];
+        plan.scale[c] = options.scale[c];
+        plan.bias[c] = -options.mean[c] * options.scale[c];
+    }
+
+    int batch = 1, channels = 0, height = 0, width = 0;
+    const bool nchw = options.layout == TensorLayout::kNCHW;
+    if (dims.nbDims == 4)
+    {
+        batch = dims.d[0];
+        channels = nchw ? dims.d[1] : dims.d[3];
+        height = nchw ? dims.d[2] : dims.d[1];
+        width = nchw ? dims.d[3] : dims.d[2];
+    }
+    else if (dims.nbDims == 3)
+    {
+        channels = nchw ? dims.d[0] : dims.d[2];
+        height = nchw ? dims.d[1] : dims.d[0];
+        width = nchw ? dims.d[2] : dims.d[1];
+    }
+    else
+    {
+        return Status(StatusCode::kInvalidArgument, "tensor must have 3 or 4 dimensions");
+    }
+
+    if (channels != plan.channels || height != src.height() || width != src.width())
+    {
+        return Status(StatusCode::kInvalidArgument, "tensor dimensions do not match the frame");
+    }
+
+    if (options.batchIndex < 0 || options.batchIndex >= batch)
+    {
+        return Status(StatusCode::kOutOfRange, "batch index out of range");
+    }
+
+    const size_t offset = size_t(options.batchIndex) * channels * height * width;
+    switch (options.dataType)
+    {
+        case DataType::kFLOAT:
+            convert(src, plan, options.layout, reinterpret_cast<float*>(buffer) + offset);
+            return okStatus();
+        case DataType::kHALF:
+            convert(src, plan, options.layout, reinterpret_cast<uint16_t*>(buffer) + offset);
+            return okStatus();
+        default:
+            return Status(StatusCode::kUnimplemented, "toTensor writes kFLOAT or kHALF tensors");
+    }
+}
+} // namespace yuzu
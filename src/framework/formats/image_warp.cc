@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "pillar/framework/formats/image_warp.h"
+#include "pillar/thread_pool/parallel_for.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+// Destination tiles: a rotated or scaled warp walks the source diagonally,
+// and a tile keeps that footprint small enough to stay in cache.
+constexpr int kTileSize = 64;
+
+struct WarpJob
+{
+    ConstImageFrameView src;
+    ImageFrameView dst;
+    // Destination to source, row-major.
+    const float* inverse;
+    float borderValue;
+    int channels;
+};
+
+inline void storeValue(uint8_t* out, float v)
+{
+    *out = static_cast<uint8_t>(std::lrint(std::min(std::max(v, 0.0f), 255.0f)));
+}
+inline void storeValue(uint16_t* out, float v)
+{
+    *out = static_cast<uint16_t>(std::lrint(std::min(std::max(v, 0.0f), 65535.0f)));
+}
+inline void storeValue(float* out, float v) { *out = v; }
+
+template <class T>
+inline float tap(const WarpJob& job, int x, int y, int c)
+{
+    if (x < 0 || y < 0 || x >= job.src.width() || y >= job.src.height())
+        return job.borderValue;
+    return static_cast<float>(reinterpret_cast<const T*>(job.src.row(y))[x * job.channels + c]);
+}
+
+// Every channel of the bilinear sample at source position (sx, sy).
+template <class T>
+void samplePixel(const WarpJob& job, float sx, float sy, T* out)
+{
+    const int width = job.src.width(), height = job.src.height(), channels = job.channels;
+    // All four taps outside, also for NaNs and for coordinates beyond int.
+    if (!(sx > -1.0f && sy > -1.0f && sx < float(width) && sy < float(height)))
+    {
+        for (int c = 0; c < channels; ++c)
+            storeValue(out + c, job.borderValue);
+        return;
+    }
+
+    const int ix = static_cast<int>(std::floor(sx)), iy = static_cast<int>(std::floor(sy));
+    const float fx = sx - ix, fy = sy - iy;
+    const float w00 = (1.0f - fx) * (1.0f - fy), w01 = fx * (1.0f - fy), w10 = (1.0f - fx) * fy, w11 = fx * fy;
+    if (ix >= 0 && iy >= 0 && ix + 1 < width && iy + 1 < height)
+    {
+        const T* p0 = reinterpret_cast<const T*>(job.src.row(iy)) + ix * channels;
+        const T* p1 = reinterpret_cast<const T*>(job.src.row(iy + 1)) + ix * channels;
+        for (int c = 0; c < channels; ++c)
+            storeValue(out + c, w00 * p0[c] + w01 * p0[c + channels] + w10 * p1[c] + w11 * p1[c + channels]);
+        return;
+    }
+    for (int c = 0; c < channels; ++c)
+    {
+        storeValue(out + c, w00 * tap<T>(job, ix, iy, c) + w01 * tap<T>(job, ix + 1, iy, c) +
+                                w10 * tap<T>(job, ix, iy + 1, c) + w11 * tap<T>(job, ix + 1, iy + 1, c));
+    }
+}
+
+template <class T>
+void warpTileScalar(const WarpJob& job, int x0, int y0, int x1, int y1)
+{
+    const float* m = job.inverse;
+    for (int y = y0; y < y1; ++y)
+    {
+        T* out = reinterpret_cast<T*>(job.dst.row(y));
+        const float rowX = m[1] * y + m[2], rowY = m[4] * y + m[5];
+        for (int x = x0; x < x1; ++x)
+            samplePixel<T>(job, m[0] * x + rowX, m[3] * x + rowY, out + x * job.channels);
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+// Eight values from the left tap on, which hold both taps of a pixel of up
+// to four channels.
+PILLAR_TARGET_AVX2 inline __m256 load8(const uint8_t* p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+PILLAR_TARGET_AVX2 inline __m256 load8(const uint16_t* p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+}
+PILLAR_TARGET_AVX2 inline __m256 load8(const float* p) { return _mm256_loadu_ps(p); }
+
+// The first `channels` lanes, rounded and saturated like storeValue.
+PILLAR_TARGET_AVX2 inline void storePixel(uint8_t* out, __m128 v, int channels)
+{
+    const __m128i i32 = _mm_cvtps_epi32(v);
+    const __m128i i16 = _mm_packs_epi32(i32, i32);
+    const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(i16, i16));
+    std::memcpy(out, &bytes, channels);
+}
+PILLAR_TARGET_AVX2 inline void storePixel(uint16_t* out, __m128 v, int channels)
+{
+    const __m128i i32 = _mm_cvtps_epi32(v);
+    const int64_t words = _mm_cvtsi128_si64(_mm_packus_epi32(i32, i32));
+    std::memcpy(out, &words, channels * sizeof(uint16_t));
+}
+PILLAR_TARGET_AVX2 inline void storePixel(float* out, __m128 v, int channels)
+{
+    float values[4];
+    _mm_storeu_ps(values, v);
+    std::memcpy(out, values, channels * sizeof(float));
+}
+
+// One pixel per step: the two taps of the top row go to the low and high
+// halves of one register and those of the bottom row to another, so a pixel
+// is two multiplies, a fused add and a fold of the halves. Taps near the
+// borders go through samplePixel. AVX-512 would only add idle lanes.
+template <class T>
+PILLAR_TARGET_AVX2 void warpTileAvx2(const WarpJob& job, int x0, int y0, int x1, int y1)
+{
+    const float* m = job.inverse;
+    const int channels = job.channels;
+    const int rowLength = job.src.width() * channels;
+    // The last left tap whose eight values stay in the row.
+    const int lastX = rowLength >= 8 ? (rowLength - 8) / channels : -1;
+    const float xLimit = float(lastX + 1), yLimit = float(job.src.height() - 1);
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 3, channels, channels + 1, channels + 2, channels + 3);
+    for (int y = y0; y < y1; ++y)
+    {
+        T* out = reinterpret_cast<T*>(job.dst.row(y));
+        const float rowX = m[1] * y + m[2], rowY = m[4] * y + m[5];
+        for (int x = x0; x < x1; ++x)
+        {
+            const float sx = m[0] * x + rowX, sy = m[3] * x + rowY;
+            T* pixel = out + x * channels;
+            if (!(sx >= 0.0f && sy >= 0.0f && sx < xLimit && sy < yLimit))
+            {
+                samplePixel<T>(job, sx, sy, pixel);
+                continue;
+            }
+            const int ix = static_cast<int>(sx), iy = static_cast<int>(sy);
+            const float fx = sx - ix, fy = sy - iy;
+            const T* p0 = reinterpret_cast<const T*>(job.src.row(iy)) + ix * channels;
+            const T* p1 = reinterpret_cast<const T*>(job.src.row(iy + 1)) + ix * channels;
+            const __m256 wx = _mm256_set_m128(_mm_set1_ps(fx), _mm_set1_ps(1.0f - fx));
+            const __m256 top = _mm256_permutevar8x32_ps(load8(p0), perm);
+            const __m256 bottom = _mm256_permutevar8x32_ps(load8(p1), perm);
+            const __m256 v = _mm256_fmadd_ps(top, _mm256_mul_ps(wx, _mm256_set1_ps(1.0f - fy)),
+                                             _mm256_mul_ps(bottom, _mm256_mul_ps(wx, _mm256_set1_ps(fy))));
+            storePixel(pixel, _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)), channels);
+        }
+    }
+}
+#endif
+
+using TileKernel = void (*)(const WarpJob& job, int x0, int y0, int x1, int y1);
+
+template <class T>
+TileKernel selectTileKernel(cpu::SimdLevel level, int channels)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX2 && channels <= 4)
+    {
+        return warpTileAvx2<T>;
+    }
+#endif
+    (void)level;
+    (void)channels;
+    return warpTileScalar<T>;
+}
+} // namespace
+
+Status warpAffine(const ConstImageFrameView& src, const ImageFrameView& dst, const Matrix2x3<float>& transform,
+                  float borderValue)
+{
+    return warpAffine(src, dst, transform, borderValue, cpu::simdLevel());
+}
+
+Status warpAffine(const ConstImageFrameView& src, const ImageFrameView& dst, const Matrix2x3<float>& transform,
+                  float borderValue, cpu::SimdLevel maxLevel)
+{
+    if (src.isEmpty() || dst.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "source or destination is empty");
+    }
+
+    if (src.format() != dst.format())
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination formats differ");
+    }
+
+    // Any shared byte would be read after it has been written, e.g. with two
+    // crops of one frame, so the spans the rows cover must be disjoint.
+    const uintptr_t srcBegin = reinterpret_cast<uintptr_t>(src.pixelData());
+    const uintptr_t dstBegin = reinterpret_cast<uintptr_t>(dst.pixelData());
+    const uintptr_t srcEnd = srcBegin + size_t(src.height()) * size_t(src.step());
+    const uintptr_t dstEnd = dstBegin + size_t(dst.height()) * size_t(dst.step());
+    if (srcBegin < dstEnd && dstBegin < srcEnd)
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination must not overlap");
+    }
+
+    const int byteDepth = src.byteDepth();
+    if (byteDepth != 1 && byteDepth != 2 && byteDepth != 4)
+    {
+        return Status(StatusCode::kUnimplemented, "unsupported format for warpAffine");
+    }
+
+    Matrix2x3<float> inverse;
+    if (!transform.invert(inverse))
+    {
+        return Status(StatusCode::kInvalidArgument, "the transform is singular");
+    }
+
+    const cpu::SimdLevel level = std::min(maxLevel, cpu::simdLevel());
+    const int channels = src.channels();
+    const TileKernel kernel = byteDepth == 1   ? selectTileKernel<uint8_t>(level, channels)
+                              : byteDepth == 2 ? selectTileKernel<uint16_t>(level, channels)
+                                               : selectTileKernel<float>(level, channels);
+    const WarpJob job{src, dst, inverse.data(), borderValue, channels};
+    const int tilesX = (dst.width() + kTileSize - 1) / kTileSize;
+    const int tilesY = (dst.height() + kTileSize - 1) / kTileSize;
+    // Bands below roughly 64k pixels are not worth a thread.
+    parallelFor(0, tilesX * tilesY, std::max(1, (1 << 16) / (kTileSize * kTileSize)),
+                [&](int t0, int t1)
+                {
+                    for (int t = t0; t < t1; ++t)
+                    {
+                        const int x0 = (t % tilesX) * kTileSize, y0 = (t / tilesX) * kTileSize;
+                        kernel(job, x0, y0, std::min(x0 + kTileSize, dst.width()),
+                               std::min(y0 + kTileSize, dst.height()));
+                    }
+                });
+    return okStatus();
+}
+} // namespace yuzu
@@ -0,0 +1,81 @@
+#include <atomic>
+#include <cstring>
+
+#include "pillar/framework/formats/shared_image_frame.h"
+
+namespace yuzu
+{
+SharedImageFrame::SharedImageFrame(ImageFrame&& frame, ImageFramePool::Allocator allocator)
+    : mFrame(std::make_shared<ImageFrame>(std::move(frame))), mAllocator(std::move(allocator))
+{
+}
+
+const ImageFrame& SharedImageFrame::frame() const
+{
+    static const ImageFrame kEmpty;
+    return mFrame ? *mFrame : kEmpty;
+}
+
+bool SharedImageFrame::isUnique() const
+{
+    if (mFrame.use_count() != 1)
+    {
+        return false;
+    }
+    // Pairs with the release of the last other handle, so its reads of the
+    // pixels happen before our writes.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+ImageFrame& SharedImageFrame::mutableFrame()
+{
+    if (!mFrame)
+    {
+        mFrame = std::make_shared<ImageFrame>();
+    }
+    else if (!isUnique())
+    {
+        mFrame = std::make_shared<ImageFrame>(copyFrame());
+    }
+    return *mFrame;
+}
+
+ImageFrame SharedImageFrame::release()
+{
+    ImageFrame frame;
+    if (mFrame)
+    {
+        frame = isUnique() ? std::move(*mFrame) : copyFrame();
+    }
+    mFrame.reset();
+    return frame;
+}
+
+ImageFrame SharedImageFrame::copyFrame() const
+{
+    const ImageFrame& src = *mFrame;
+    if (src.isEmpty())
+    {
+        return ImageFrame();
+    }
+
+    ImageFrame copy;
+    if (mAllocator)
+    {
+        copy = mAllocator(src.format(), src.width(), src.height(), ImageFrame::kDefaultAlignmentBoundary);
+    }
+    if (copy.isEmpty())
+    {
+        copy.reset(src.format(), src.width(), src.height(), ImageFrame::kDefaultAlignmentBoundary);
+    }
+
+    const int rowBytes = src.width() * src.channels() * src.byteDepth();
+    for (int y = 0; y < src.height(); ++y)
+    {
+        std::memcpy(copy.pixelData() + static_cast<size_t>(y) * copy.step(),
+                    src.pixelData() + static_cast<size_t>(y) * src.step(), rowBytes);
+    }
+    return copy;
+}
+} // namespace yuzu
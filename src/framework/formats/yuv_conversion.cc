@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "pillar/framework/formats/yuv_conversion.h"
+#include "pillar/thread_pool/parallel_for.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+constexpr int kFractionBits = 13;
+constexpr int kRounding = 1 << (kFractionBits - 1);
+
+// Fixed-point conversion coefficients:
+//   R = (cy * (Y - yOffset) + crv * V' + kRounding) >> kFractionBits
+//   G = (cy * (Y - yOffset) + cgu * U' + cgv * V' + kRounding) >> kFractionBits
+//   B = (cy * (Y - yOffset) + cbu * U' + kRounding) >> kFractionBits
+// with U' = U - 128 and V' = V - 128. All of them fit an int16, which the
+// AVX2 kernel relies on.
+struct YUVCoefficients
+{
+    int yOffset;
+    int16_t cy;
+    int16_t crv;
+    int16_t cgu;
+    int16_t cgv;
+    int16_t cbu;
+    // Right shift that brings samples down to 8 bits.
+    int sampleShift;
+};
+
+YUVCoefficients coefficientsFor(const YUVImage& image)
+{
+    const double kr = image.colorMatrix() == YUVImage::ColorMatrix::kBT709 ? 0.2126 : 0.299;
+    const double kb = image.colorMatrix() == YUVImage::ColorMatrix::kBT709 ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    const double lumaScale = image.fullRange() ? 1.0 : 255.0 / 219.0;
+    const double chromaScale = image.fullRange() ? 1.0 : 255.0 / 224.0;
+
+    auto fixed = [](double v) { return static_cast<int16_t>(std::lround(v * (1 << kFractionBits))); };
+    YUVCoefficients k;
+    k.yOffset = image.fullRange() ? 0 : 16;
+    k.cy = fixed(lumaScale);
+    k.crv = fixed(2.0 * (1.0 - kr) * chromaScale);
+    k.cgu = fixed(-2.0 * (1.0 - kb) * kb / kg * chromaScale);
+    k.cgv = fixed(-2.0 * (1.0 - kr) * kr / kg * chromaScale);
+    k.cbu = fixed(2.0 * (1.0 - kb) * chromaScale);
+    k.sampleShift = image.bitDepth() - 8;
+    return k;
+}
+
+// Converts one row. `u` and `v` point at the chroma row, consecutive chroma
+// samples are `chromaStep` samples apart (1 for kI420, 2 for kNV12).
+using YUVRowKernel = void (*)(const uint8_t* y, const uint8_t* u, const uint8_t* v, int chromaStep, uint8_t* dst,
+                              int width, const YUVCoefficients& k);
+
+inline uint8_t clampToByte(int v)
+{
+    return static_cast<uint8_t>(std::min(std::max(v, 0), 255));
+}
+
+// ----------------------------------------------
+// Scalar kernel
+// ----------------------------------------------
+template <class T, bool BGRA>
+void yuvRowScalar(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, int chromaStep, uint8_t* dst,
+                  int width, const YUVCoefficients& k)
+{
+    const T* y = reinterpret_cast<const T*>(yRow);
+    const T* u = reinterpret_cast<const T*>(uRow);
+    const T* v = reinterpret_cast<const T*>(vRow);
+    constexpr int kChannels = BGRA ? 4 : 3;
+    for (int x = 0; x < width; ++x, dst += kChannels)
+    {
+        const int c = (x >> 1) * chromaStep;
+        const int luma = k.cy * ((y[x] >> k.sampleShift) - k.yOffset) + kRounding;
+        const int cb = (u[c] >> k.sampleShift) - 128;
+        const int cr = (v[c] >> k.sampleShift) - 128;
+        const uint8_t r = clampToByte((luma + k.crv * cr) >> kFractionBits);
+        const uint8_t g = clampToByte((luma + k.cgu * cb + k.cgv * cr) >> kFractionBits);
+        const uint8_t b = clampToByte((luma + k.cbu * cb) >> kFractionBits);
+        if (BGRA)
+        {
+            dst[0] = b;
+            dst[1] = g;
+            dst[2] = r;
+            dst[3] = 255;
+        }
+        else
+        {
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+        }
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+// ----------------------------------------------
+// AVX2 kernel, 16 pixels per iteration
+// ----------------------------------------------
+
+// pshufb mask picking the bytes of `channel` for the 16-byte chunk `chunk` of
+// a 48-byte, 3-channel run of 16 pixels.
+PILLAR_TARGET_AVX2 inline __m128i interleave3Mask(int chunk, int channel)
+{
+    alignas(16) int8_t mask[16];
+    for (int j = 0; j < 16; ++j)
+    {
+        const int i = 16 * chunk + j;
+        mask[j] = i % 3 == channel ? static_cast<int8_t>(i / 3) : static_cast<int8_t>(-128);
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+// Packs two vectors of 8 int32 (pixels 0-3 | 8-11 and 4-7 | 12-15) into 16
+// saturated bytes in pixel order.
+PILLAR_TARGET_AVX2 inline __m128i packChannel(__m256i lo, __m256i hi)
+{
+    const __m256i words =
+        _mm256_packs_epi32(_mm256_srai_epi32(lo, kFractionBits), _mm256_srai_epi32(hi, kFractionBits));
+    return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+}
+
+// Broadcasts the int16 pair (lo, hi) to every 32-bit lane, the operand
+// layout `_mm256_madd_epi16` expects.
+PILLAR_TARGET_AVX2 inline __m256i pair(int lo, int hi)
+{
+    return _mm256_set1_epi32(int32_t(uint16_t(lo)) | int32_t(uint32_t(uint16_t(hi)) << 16));
+}
+
+template <bool NV12, bool BGRA>
+PILLAR_TARGET_AVX2 void yuvRowAvx2(const uint8_t* y, const uint8_t* u, const uint8_t* v, int chromaStep,
+                                   uint8_t* dst, int width, const YUVCoefficients& k)
+{
+    const __m256i lumaOffset = _mm256_set1_epi16(static_cast<int16_t>(k.yOffset));
+    const __m256i chromaOffset = _mm256_set1_epi16(128);
+    const __m256i ones = _mm256_set1_epi16(1);
+    // (Y - yOffset, 1) pairs times (cy, rounding), (U', V') pairs times the
+    // chroma coefficients of each channel.
+    const __m256i lumaK = pair(k.cy, kRounding);
+    const __m256i redK = pair(0, k.crv);
+    const __m256i greenK = pair(k.cgu, k.cgv);
+    const __m256i blueK = pair(k.cbu, 0);
+
+    const __m128i alpha = _mm_set1_epi8(-1);
+    __m128i masks[3][3];
+    if (!BGRA)
+    {
+        for (int chunk = 0; chunk < 3; ++chunk)
+            for (int channel = 0; channel < 3; ++channel)
+                masks[chunk][channel] = interleave3Mask(chunk, channel);
+    }
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        // Luma in pixel order: lane 0 holds pixels 0-7, lane 1 pixels 8-15.
+        const __m256i luma = _mm256_sub_epi16(
+            _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x))), lumaOffset);
+        // Chroma as interleaved U V words: lane 0 pairs 0-3, lane 1 pairs 4-7.
+        const __m128i uv8 = NV12 ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x))
+                                 : _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)),
+                                                     _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)));
+        const __m256i uv = _mm256_sub_epi16(_mm256_cvtepu8_epi16(uv8), chromaOffset);
+
+        // Every chroma pair serves two pixels. The unpacks line up pixels
+        // 0-3 | 8-11 in `*Lo` and 4-7 | 12-15 in `*Hi`.
+        const __m256i uvLo = _mm256_unpacklo_epi32(uv, uv);
+        const __m256i uvHi = _mm256_unpackhi_epi32(uv, uv);
+        const __m256i lumaLo = _mm256_madd_epi16(_mm256_unpacklo_epi16(luma, ones), lumaK);
+        const __m256i lumaHi = _mm256_madd_epi16(_mm256_unpackhi_epi16(luma, ones), lumaK);
+
+        const __m128i r = packChannel(_mm256_add_epi32(lumaLo, _mm256_madd_epi16(uvLo, redK)),
+                                      _mm256_add_epi32(lumaHi, _mm256_madd_epi16(uvHi, redK)));
+        const __m128i g = packChannel(_mm256_add_epi32(lumaLo, _mm256_madd_epi16(uvLo, greenK)),
+                                      _mm256_add_epi32(lumaHi, _mm256_madd_epi16(uvHi, greenK)));
+        const __m128i b = packChannel(_mm256_add_epi32(lumaLo, _mm256_madd_epi16(uvLo, blueK)),
+                                      _mm256_add_epi32(lumaHi, _mm256_madd_epi16(uvHi, blueK)));
+
+        if (BGRA)
+        {
+            const __m128i bgLo = _mm_unpacklo_epi8(b, g);
+            const __m128i bgHi = _mm_unpackhi_epi8(b, g);
+            const __m128i raLo = _mm_unpacklo_epi8(r, alpha);
+            const __m128i raHi = _mm_unpackhi_epi8(r, alpha);
+            __m128i* out = reinterpret_cast<__m128i*>(dst + 4 * x);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bgLo, raLo));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLo, raLo));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHi, raHi));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHi, raHi));
+        }
+        else
+        {
+            __m128i* out = reinterpret_cast<__m128i*>(dst + 3 * x);
+            for (int chunk = 0; chunk < 3; ++chunk)
+            {
+                const __m128i bytes = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, masks[chunk][0]),
+                                                                _mm_shuffle_epi8(g, masks[chunk][1])),
+                                                   _mm_shuffle_epi8(b, masks[chunk][2]));
+                _mm_storeu_si128(out + chunk, bytes);
+            }
+        }
+    }
+
+    // `x` is even here, so the tail starts on a chroma boundary.
+    const int offset = (x >> 1) * chromaStep;
+    yuvRowScalar<uint8_t, BGRA>(y + x, u + offset, v + offset, chromaStep, dst + x * (BGRA ? 4 : 3), width - x, k);
+}
+#endif
+
+YUVRowKernel selectKernel(const YUVImage& src, ImageFormat::Format format, cpu::SimdLevel level)
+{
+    const bool bgra = format == ImageFormat::SBGRA;
+    if (src.byteDepth() == 2)
+    {
+        return bgra ? yuvRowScalar<uint16_t, true> : yuvRowScalar<uint16_t, false>;
+    }
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        if (src.layout() == YUVImage::Layout::kNV12)
+            return bgra ? yuvRowAvx2<true, true> : yuvRowAvx2<true, false>;
+        return bgra ? yuvRowAvx2<false, true> : yuvRowAvx2<false, false>;
+    }
+#endif
+    return bgra ? yuvRowScalar<uint8_t, true> : yuvRowScalar<uint8_t, false>;
+}
+
+// Converts row `y` of `src` into `dst` with `kernel`.
+void convertRow(const YUVImage& src, int y, YUVRowKernel kernel, const YUVCoefficients& k, uint8_t* dst)
+{
+    const bool nv12 = src.layout() == YUVImage::Layout::kNV12;
+    const uint8_t* u = src.row(1, y / 2);
+    const uint8_t* v = nv12 ? u + src.byteDepth() : src.row(2, y / 2);
+    kernel(src.row(0, y), u, v, nv12 ? 2 : 1, dst, src.width(), k);
+}
+
+Status validate(const YUVImage& src, const ImageFrameView& dst)
+{
+    if (src.isEmpty() || dst.isEmpty())
+    {
+        return Status(StatusCode::kInvalidArgument, "source or destination is empty");
+    }
+
+    if (src.format() != ImageFormat::YCBCR420P && src.format() != ImageFormat::YCBCR420P10)
+    {
+        return Status(StatusCode::kInvalidArgument, "source is not a YCbCr 4:2:0 image");
+    }
+
+    if (dst.format() != ImageFormat::SRGB && dst.format() != ImageFormat::SBGRA)
+    {
+        return Status(StatusCode::kUnimplemented, "YUV converts to SRGB or SBGRA only");
+    }
+    return okStatus();
+}
+} // namespace
+
+Status convertYUVToRGB(const YUVImage& src, const ImageFrameView& dst, cpu::SimdLevel maxLevel)
+{
+    Status status = validate(src, dst);
+    if (!status.ok())
+    {
+        return status;
+    }
+
+    if (src.width() != dst.width() || src.height() != dst.height())
+    {
+        return Status(StatusCode::kInvalidArgument, "source and destination dimensions differ");
+    }
+
+    const YUVRowKernel kernel = selectKernel(src, dst.format(), std::min(maxLevel, cpu::simdLevel()));
+    const YUVCoefficients k = coefficientsFor(src);
+    const int minBandRows = std::max(8, (1 << 16) / std::max(1, dst.width()));
+    parallelFor(0, dst.height(), minBandRows,
+                [&](int y0, int y1)
+                {
+                    for (int y = y0; y < y1; ++y)
+                    {
+                        convertRow(src, y, kernel, k, dst.row(y));
+                    }
+                });
+    return okStatus();
+}
+
+Status convertYUVToRGB(const YUVImage& src, const ImageFrameView& dst, InterpolationMode mode)
+{
+    Status status = validate(src, dst);
+    if (!status.ok())
+    {
+        return status;
+    }
+
+    if (src.width() == dst.width() && src.height() == dst.height())
+    {
+        return convertYUVToRGB(src, dst, cpu::simdLevel());
+    }
+
+    const YUVRowKernel kernel = selectKernel(src, dst.format(), cpu::simdLevel());
+    const YUVCoefficients k = coefficientsFor(src);
+    const int length = src.width() * dst.channels();
+    // Each resampling band converts into its own scratch row.
+    RowFetcher fetchRow = [&](int y, float* row)
+    {
+        thread_local std::vector<uint8_t> scratch;
+        scratch.resize(length);
+        convertRow(src, y, kernel, k, scratch.data());
+        std::copy(scratch.begin(), scratch.end(), row);
+    };
+    return resize(fetchRow, src.width(), src.height(), dst, mode);
+}
+
+Status convertYUVToRGB(const YUVImage& src, ImageFormat::Format format, int width, int height, ImageFrame& dst,
+                       InterpolationMode mode)
+{
+    if (format != ImageFormat::SRGB && format != ImageFormat::SBGRA)
+    {
+        return Status(StatusCode::kUnimplemented, "YUV converts to SRGB or SBGRA only");
+    }
+
+    if (width <= 0 || height <= 0)
+    {
+        return Status(StatusCode::kInvalidArgument, "invalid destination dimensions");
+    }
+
+    if (dst.isEmpty() || dst.format() != format || dst.width() != width || dst.height() != height)
+    {
+        dst.reset(format, width, height, ImageFrame::kDefaultAlignmentBoundary);
+    }
+    return convertYUVToRGB(src, ImageFrameView(dst), mode);
+}
+} // namespace yuzu
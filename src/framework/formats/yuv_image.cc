@@ -0,0 +1,103 @@
+#include "pillar/framework/formats/yuv_image.h"
+#include "pillar/framework/deps/aligned_malloc_and_free.h"
+
+namespace yuzu
+{
+namespace
+{
+size_t alignUp(size_t value, uint32_t alignmentBoundary)
+{
+    return ((value - 1) | (alignmentBoundary - 1)) + 1;
+}
+} // namespace
+
+YUVImage::YUVImage()
+    : mFormat(ImageFormat::UNKNOWN), mLayout(Layout::kI420), mColorMatrix(ColorMatrix::kBT601), mFullRange(false),
+      mWidth(0), mHeight(0), mPlanes{nullptr, nullptr, nullptr}, mStrides{0, 0, 0}
+{
+}
+
+YUVImage::YUVImage(Layout layout, int width, int height, uint32_t alignmentBoundary, ImageFormat::Format format)
+    : YUVImage()
+{
+    reset(layout, width, height, alignmentBoundary, format);
+}
+
+YUVImage::YUVImage(YUVImage&& moveFrom) : YUVImage() { *this = std::move(moveFrom); }
+
+YUVImage& YUVImage::operator=(YUVImage&& moveFrom)
+{
+    mPixelData = std::move(moveFrom.mPixelData);
+    mFormat = moveFrom.mFormat;
+    mLayout = moveFrom.mLayout;
+    mColorMatrix = moveFrom.mColorMatrix;
+    mFullRange = moveFrom.mFullRange;
+    mWidth = moveFrom.mWidth;
+    mHeight = moveFrom.mHeight;
+    for (int i = 0; i < 3; ++i)
+    {
+        mPlanes[i] = moveFrom.mPlanes[i];
+        mStrides[i] = moveFrom.mStrides[i];
+        moveFrom.mPlanes[i] = nullptr;
+        moveFrom.mStrides[i] = 0;
+    }
+
+    moveFrom.mFormat = ImageFormat::UNKNOWN;
+    moveFrom.mWidth = 0;
+    moveFrom.mHeight = 0;
+    return *this;
+}
+
+void YUVImage::reset(Layout layout, int width, int height, uint32_t alignmentBoundary, ImageFormat::Format format)
+{
+    mFormat = format;
+    mLayout = layout;
+    mWidth = width;
+    mHeight = height;
+
+    const size_t lumaStride = alignUp(size_t(width) * byteDepth(), alignmentBoundary);
+    const size_t chromaSamples = layout == Layout::kNV12 ? 2 * chromaWidth() : chromaWidth();
+    const size_t chromaStride = alignUp(chromaSamples * byteDepth(), alignmentBoundary);
+    // Row strides are multiples of the alignment, so are the plane offsets.
+    const size_t lumaSize = lumaStride * height;
+    const size_t chromaSize = chromaStride * chromaHeight();
+    const size_t totalSize = lumaSize + chromaSize * (numPlanes() - 1);
+
+    mPixelData = {reinterpret_cast<uint8_t*>(alignedMalloc(totalSize, alignmentBoundary)),
+                  ImageFrame::PixelDataDeleter::kAlignedFree};
+    mPlanes[0] = mPixelData.get();
+    mPlanes[1] = mPlanes[0] + lumaSize;
+    mPlanes[2] = layout == Layout::kNV12 ? nullptr : mPlanes[1] + chromaSize;
+    mStrides[0] = static_cast<int>(lumaStride);
+    mStrides[1] = static_cast<int>(chromaStride);
+    mStrides[2] = layout == Layout::kNV12 ? 0 : static_cast<int>(chromaStride);
+}
+
+void YUVImage::adoptPlanes(Layout layout, int width, int height, uint8_t* y, int yStride, uint8_t* u, int uStride,
+                           uint8_t* v, int vStride, ImageFrame::Deleter deleter, ImageFormat::Format format)
+{
+    mFormat = format;
+    mLayout = layout;
+    mWidth = width;
+    mHeight = height;
+    mPixelData = {y, deleter};
+    mPlanes[0] = y;
+    mPlanes[1] = u;
+    mPlanes[2] = layout == Layout::kNV12 ? nullptr : v;
+    mStrides[0] = yStride;
+    mStrides[1] = uStride;
+    mStrides[2] = layout == Layout::kNV12 ? 0 : vStride;
+}
+
+std::unique_ptr<uint8_t[], ImageFrame::Deleter> YUVImage::release()
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        mPlanes[i] = nullptr;
+        mStrides[i] = 0;
+    }
+    mWidth = 0;
+    mHeight = 0;
+    return std::move(mPixelData);
+}
+} // namespace yuzu
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "pillar/thread_pool/parallel_for.h"
+#include "pillar/thread_pool/thread_pool.h"
+#include "pillar/utility/singleton.h"
+
+namespace yuzu
+{
+namespace
+{
+struct BandState
+{
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    std::mutex mut;
+    std::condition_variable cond;
+};
+} // namespace
+
+void parallelFor(int begin, int end, int minBandSize, const std::function<void(int, int)>& fn)
+{
+    const int count = end - begin;
+    if (count <= 0)
+    {
+        return;
+    }
+
+    ThreadPool& pool = SingleTon<ThreadPool>::instance();
+    const int threads = static_cast<int>(pool.size());
+    const int bands = std::max(1, std::min(threads, count / std::max(1, minBandSize)));
+    if (bands == 1)
+    {
+        fn(begin, end);
+        return;
+    }
+
+    // Bands are claimed, not assigned: the caller works through them too and
+    // only waits for bands already running, so nested calls from a pool
+    // worker cannot deadlock. Helpers that start late find nothing left and
+    // never touch `fn`.
+    auto state = std::make_shared<BandState>();
+    const int bandSize = count / bands;
+    const int remainder = count % bands;
+    auto work = [state, &fn, begin, bands, bandSize, remainder]
+    {
+        for (int i = state->next.fetch_add(1); i < bands; i = state->next.fetch_add(1))
+        {
+            const int bandBegin = begin + i * bandSize + std::min(i, remainder);
+            const int bandEnd = bandBegin + bandSize + (i < remainder ? 1 : 0);
+            fn(bandBegin, bandEnd);
+            if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == bands)
+            {
+                std::lock_guard<std::mutex> lk(state->mut);
+                state->cond.notify_all();
+            }
+        }
+    };
+
+    for (int i = 0; i < bands - 1; ++i)
+    {
+        pool.post(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lk(state->mut);
+    state->cond.wait(lk, [&] { return state->done.load(std::memory_order_acquire) == bands; });
+}
+} // namespace yuzu
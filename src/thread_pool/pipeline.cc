@@ -0,0 +1,124 @@
+#include <algorithm>
+
+#include "pillar/thread_pool/pipeline.h"
+
+namespace yuzu
+{
+namespace pipeline_detail
+{
+namespace
+{
+template <class T>
+void updateMax(std::atomic<T>& max, T value)
+{
+    T current = max.load(std::memory_order_relaxed);
+    while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+} // namespace
+
+StageBase::StageBase(Core& core, std::string name, size_t workers)
+    : mCore(core), mName(std::move(name)), mWorkers(workers), mLiveWorkers(0), mProcessed(0), mFailed(0),
+      mTotalNs(0), mMaxNs(0), mMaxDepth(0)
+{
+}
+
+void StageBase::join()
+{
+    for (std::thread& thread : mThreads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+}
+
+void StageBase::record(std::chrono::steady_clock::duration latency, bool ok)
+{
+    const uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+    mProcessed.fetch_add(1, std::memory_order_relaxed);
+    if (!ok)
+    {
+        mFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+    mTotalNs.fetch_add(ns, std::memory_order_relaxed);
+    updateMax(mMaxNs, ns);
+}
+
+void StageBase::enqueued(size_t depth) { updateMax(mMaxDepth, depth); }
+
+StageMetrics StageBase::metrics() const
+{
+    StageMetrics metrics;
+    metrics.name = mName;
+    metrics.workers = mWorkers;
+    metrics.processed = mProcessed.load(std::memory_order_relaxed);
+    metrics.failed = mFailed.load(std::memory_order_relaxed);
+    if (metrics.processed != 0)
+    {
+        metrics.meanLatencyUs = double(mTotalNs.load(std::memory_order_relaxed)) / double(metrics.processed) / 1e3;
+    }
+    metrics.maxLatencyUs = double(mMaxNs.load(std::memory_order_relaxed)) / 1e3;
+    metrics.queueDepth = queueDepth();
+    metrics.maxQueueDepth = mMaxDepth.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+void Core::fail(Status status)
+{
+    {
+        std::lock_guard<std::mutex> lk(mMut);
+        if (mCancelled.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        mStatus = status;
+        mCancelled.store(true, std::memory_order_release);
+    }
+
+    for (auto& stage : mStages)
+    {
+        stage->cancel();
+    }
+    if (cancelOutput)
+    {
+        cancelOutput();
+    }
+}
+
+Status Core::status() const
+{
+    std::lock_guard<std::mutex> lk(mMut);
+    return mStatus;
+}
+
+void Core::start()
+{
+    for (auto& stage : mStages)
+    {
+        stage->start();
+    }
+}
+
+void Core::join()
+{
+    for (auto& stage : mStages)
+    {
+        stage->join();
+    }
+}
+
+std::vector<StageMetrics> Core::metrics() const
+{
+    std::vector<StageMetrics> metrics;
+    metrics.reserve(mStages.size());
+    for (const auto& stage : mStages)
+    {
+        metrics.push_back(stage->metrics());
+    }
+    return metrics;
+}
+} // namespace pipeline_detail
+} // namespace yuzu
@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "pillar/thread_pool/thread_pool.h"
+
+namespace yuzu
+{
+ThreadPool::ThreadPool(size_t threads) : mAccepting(true), mPending(0)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    mWorkers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        mWorkers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() { shutdown(true); }
+
+void ThreadPool::post(Task task)
+{
+    if (!task || !mAccepting.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    mPending.fetch_add(1, std::memory_order_relaxed);
+    // Lost a race with shutdown.
+    if (!mQueue.push(std::move(task)))
+    {
+        finishTask();
+    }
+}
+
+void ThreadPool::run()
+{
+    for (;;)
+    {
+        Task task;
+        // Fails once the queue is closed and drained.
+        if (!mQueue.waitAndPop(task))
+        {
+            return;
+        }
+        task();
+        task.reset();
+        finishTask();
+    }
+}
+
+void ThreadPool::finishTask()
+{
+    if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        std::lock_guard<std::mutex> lk(mIdleMut);
+        mIdleCond.notify_all();
+    }
+}
+
+void ThreadPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lk(mIdleMut);
+    mIdleCond.wait(lk, [this] { return mPending.load(std::memory_order_acquire) == 0; });
+}
+
+void ThreadPool::shutdown(bool drain)
+{
+    std::lock_guard<std::mutex> lk(mShutdownMut);
+    if (mWorkers.empty())
+    {
+        return;
+    }
+
+    mAccepting.store(false, std::memory_order_release);
+    if (!drain)
+    {
+        Task task;
+        while (mQueue.tryPop(task))
+        {
+            task.reset();
+            finishTask();
+        }
+    }
+
+    // Workers finish what is queued, then see the closed queue and return.
+    mQueue.close();
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+    mWorkers.clear();
+}
+} // namespace yuzu
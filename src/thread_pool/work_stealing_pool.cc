@@ -0,0 +1,328 @@
+#include <algorithm>
+
+#include "pillar/thread_pool/work_stealing_pool.h"
+#include "pillar/utility/cpu_features.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+// Rounds of stealing before a worker gives up and parks.
+constexpr int kSpinRounds = 64;
+// Task slots moved between a worker's cache and the shared list at a time.
+constexpr size_t kSlotBatch = 64;
+
+struct CurrentWorker
+{
+    const WorkStealingPool* pool = nullptr;
+    size_t index = 0;
+};
+thread_local CurrentWorker tCurrent;
+
+inline void cpuRelax()
+{
+#if defined(PILLAR_ARCH_X86)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+uint64_t nextRandom(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads)
+    : mInjectedCount(0), mEpoch(0), mSleepers(0), mStopping(false), mPending(0)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    mWorkers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        mWorkers.emplace_back(new Worker());
+        mWorkers.back()->rng = 0x9e3779b97f4a7c15ull * (i + 1);
+        mWorkers.back()->freeSlots.reserve(2 * kSlotBatch);
+    }
+    // Workers steal from each other, start them once all deques exist.
+    for (size_t i = 0; i < threads; ++i)
+    {
+        mWorkers[i]->thread = std::thread(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    shutdown();
+    for (Task* slot : mFreeSlots)
+    {
+        delete slot;
+    }
+}
+
+WorkStealingPool::Worker::~Worker()
+{
+    for (Task* slot : freeSlots)
+    {
+        delete slot;
+    }
+}
+
+void WorkStealingPool::post(Task task)
+{
+    if (!task)
+    {
+        return;
+    }
+
+    if (tCurrent.pool == this)
+    {
+        Worker& self = *mWorkers[tCurrent.index];
+        Task* slot = acquireSlot(self);
+        *slot = std::move(task);
+        mPending.fetch_add(1, std::memory_order_relaxed);
+        self.deque.push(slot);
+    }
+    else
+    {
+        // Checked under the lock shutdown() sets the flag under, so a task is
+        // either queued before the workers start draining or dropped.
+        std::lock_guard<std::mutex> lk(mInjectMut);
+        if (mStopping.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        Task* slot = takeSharedSlot();
+        *slot = std::move(task);
+        mPending.fetch_add(1, std::memory_order_relaxed);
+        mInjected.push_back(slot);
+        mInjectedCount.store(mInjected.size(), std::memory_order_relaxed);
+    }
+    wakeOne();
+}
+
+Task* WorkStealingPool::acquireSlot(Worker& self)
+{
+    if (self.freeSlots.empty())
+    {
+        std::lock_guard<std::mutex> lk(mInjectMut);
+        const size_t n = std::min(kSlotBatch, mFreeSlots.size());
+        self.freeSlots.insert(self.freeSlots.end(), mFreeSlots.end() - n, mFreeSlots.end());
+        mFreeSlots.resize(mFreeSlots.size() - n);
+    }
+    if (self.freeSlots.empty())
+    {
+        return new Task();
+    }
+    Task* slot = self.freeSlots.back();
+    self.freeSlots.pop_back();
+    return slot;
+}
+
+void WorkStealingPool::releaseSlot(Worker& self, Task* slot)
+{
+    self.freeSlots.push_back(slot);
+    if (self.freeSlots.size() >= 2 * kSlotBatch)
+    {
+        std::lock_guard<std::mutex> lk(mInjectMut);
+        mFreeSlots.insert(mFreeSlots.end(), self.freeSlots.end() - kSlotBatch, self.freeSlots.end());
+        self.freeSlots.resize(self.freeSlots.size() - kSlotBatch);
+    }
+}
+
+// Called with mInjectMut held.
+Task* WorkStealingPool::takeSharedSlot()
+{
+    if (mFreeSlots.empty())
+    {
+        return new Task();
+    }
+    Task* slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    return slot;
+}
+
+Task* WorkStealingPool::popInjected()
+{
+    if (mInjectedCount.load(std::memory_order_relaxed) == 0)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lk(mInjectMut);
+    if (mInjected.empty())
+    {
+        return nullptr;
+    }
+    Task* task = mInjected.front();
+    mInjected.pop_front();
+    mInjectedCount.store(mInjected.size(), std::memory_order_relaxed);
+    return task;
+}
+
+Task* WorkStealingPool::findTask(Worker& self, size_t index)
+{
+    Task* task = nullptr;
+    if (self.deque.pop(task))
+    {
+        return task;
+    }
+    if ((task = popInjected()) != nullptr)
+    {
+        return task;
+    }
+
+    // One sweep over the other workers, from a random victim on.
+    const size_t n = mWorkers.size();
+    const size_t start = static_cast<size_t>(nextRandom(self.rng) % n);
+    for (size_t k = 0; k < n; ++k)
+    {
+        const size_t victim = (start + k) % n;
+        if (victim != index && mWorkers[victim]->deque.steal(task))
+        {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+bool WorkStealingPool::hasQueuedWork() const
+{
+    if (mInjectedCount.load(std::memory_order_relaxed) != 0)
+    {
+        return true;
+    }
+    for (const auto& worker : mWorkers)
+    {
+        if (!worker->deque.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t index)
+{
+    tCurrent.pool = this;
+    tCurrent.index = index;
+    Worker& self = *mWorkers[index];
+
+    for (;;)
+    {
+        Task* task = findTask(self, index);
+        for (int spin = 0; task == nullptr && spin < kSpinRounds; ++spin)
+        {
+            cpuRelax();
+            task = findTask(self, index);
+        }
+
+        if (task != nullptr)
+        {
+            (*task)();
+            task->reset();
+            releaseSlot(self, task);
+            finishTask();
+            continue;
+        }
+
+        if (mStopping.load(std::memory_order_acquire) && mPending.load(std::memory_order_acquire) == 0)
+        {
+            break;
+        }
+        park();
+    }
+    tCurrent = CurrentWorker();
+}
+
+void WorkStealingPool::park()
+{
+    const uint64_t epoch = mEpoch.load(std::memory_order_acquire);
+    mSleepers.fetch_add(1, std::memory_order_seq_cst);
+    // Pairs with the fence in `wakeOne`: either the poster sees us sleeping,
+    // or we see its task here.
+    if (hasQueuedWork() ||
+        (mStopping.load(std::memory_order_seq_cst) && mPending.load(std::memory_order_acquire) == 0))
+    {
+        mSleepers.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lk(mParkMut);
+    mParkCond.wait(lk, [&] { return mEpoch.load(std::memory_order_relaxed) != epoch; });
+    mSleepers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WorkStealingPool::wakeOne()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleepers.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mParkMut);
+        mEpoch.fetch_add(1, std::memory_order_relaxed);
+    }
+    mParkCond.notify_one();
+}
+
+void WorkStealingPool::finishTask()
+{
+    if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mIdleMut);
+            mIdleCond.notify_all();
+        }
+        // Workers waiting for the end of a shutdown have to notice as well.
+        if (mStopping.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lk(mParkMut);
+            mEpoch.fetch_add(1, std::memory_order_relaxed);
+            mParkCond.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lk(mIdleMut);
+    mIdleCond.wait(lk, [this] { return mPending.load(std::memory_order_acquire) == 0; });
+}
+
+void WorkStealingPool::shutdown()
+{
+    std::lock_guard<std::mutex> lk(mShutdownMut);
+    if (mWorkers.empty() || mStopping.load())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> injectLock(mInjectMut);
+        std::lock_guard<std::mutex> parkLock(mParkMut);
+        mStopping.store(true, std::memory_order_seq_cst);
+        mEpoch.fetch_add(1, std::memory_order_relaxed);
+    }
+    mParkCond.notify_all();
+    for (auto& worker : mWorkers)
+    {
+        worker->thread.join();
+    }
+    mWorkers.clear();
+}
+} // namespace yuzu
@@ -0,0 +1,387 @@
+#include <math.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+
+#include "pillar/utility/box_batch.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+// The four coordinate columns of a run of boxes.
+struct Corners
+{
+    const float* xmin;
+    const float* ymin;
+    const float* xmax;
+    const float* ymax;
+};
+
+// IoU of `box` (xmin, ymin, xmax, ymax) with `count` boxes into `out`. A
+// zero union means a zero intersection, dividing by FLT_MIN then yields 0.
+using IouKernel = void (*)(const Corners& boxes, size_t count, const float* box, float* out);
+
+inline float iouOne(float x0, float y0, float x1, float y1, const float* box, float boxArea)
+{
+    const float w = std::max(0.0f, std::min(x1, box[2]) - std::max(x0, box[0]));
+    const float h = std::max(0.0f, std::min(y1, box[3]) - std::max(y0, box[1]));
+    const float inter = w * h;
+    const float area = (x1 - x0) * (y1 - y0);
+    return inter / std::max(area + boxArea - inter, FLT_MIN);
+}
+
+void iouScalar(const Corners& boxes, size_t count, const float* box, float* out)
+{
+    const float boxArea = (box[2] - box[0]) * (box[3] - box[1]);
+    for (size_t i = 0; i < count; ++i)
+        out[i] = iouOne(boxes.xmin[i], boxes.ymin[i], boxes.xmax[i], boxes.ymax[i], box, boxArea);
+}
+
+#if defined(PILLAR_ARCH_X86)
+PILLAR_TARGET_AVX2 void iouAvx2(const Corners& boxes, size_t count, const float* box, float* out)
+{
+    const float boxArea = (box[2] - box[0]) * (box[3] - box[1]);
+    const __m256 bx0 = _mm256_set1_ps(box[0]), by0 = _mm256_set1_ps(box[1]);
+    const __m256 bx1 = _mm256_set1_ps(box[2]), by1 = _mm256_set1_ps(box[3]);
+    const __m256 barea = _mm256_set1_ps(boxArea);
+    const __m256 zero = _mm256_setzero_ps(), tiny = _mm256_set1_ps(FLT_MIN);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x0 = _mm256_loadu_ps(boxes.xmin + i), y0 = _mm256_loadu_ps(boxes.ymin + i);
+        const __m256 x1 = _mm256_loadu_ps(boxes.xmax + i), y1 = _mm256_loadu_ps(boxes.ymax + i);
+        const __m256 w = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(x1, bx1), _mm256_max_ps(x0, bx0)));
+        const __m256 h = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(y1, by1), _mm256_max_ps(y0, by0)));
+        const __m256 inter = _mm256_mul_ps(w, h);
+        const __m256 area = _mm256_mul_ps(_mm256_sub_ps(x1, x0), _mm256_sub_ps(y1, y0));
+        const __m256 uni = _mm256_max_ps(_mm256_sub_ps(_mm256_add_ps(area, barea), inter), tiny);
+        _mm256_storeu_ps(out + i, _mm256_div_ps(inter, uni));
+    }
+    for (; i < count; ++i)
+        out[i] = iouOne(boxes.xmin[i], boxes.ymin[i], boxes.xmax[i], boxes.ymax[i], box, boxArea);
+}
+
+PILLAR_TARGET_AVX512 void iouAvx512(const Corners& boxes, size_t count, const float* box, float* out)
+{
+    const float boxArea = (box[2] - box[0]) * (box[3] - box[1]);
+    const __m512 bx0 = _mm512_set1_ps(box[0]), by0 = _mm512_set1_ps(box[1]);
+    const __m512 bx1 = _mm512_set1_ps(box[2]), by1 = _mm512_set1_ps(box[3]);
+    const __m512 barea = _mm512_set1_ps(boxArea);
+    const __m512 zero = _mm512_setzero_ps(), tiny = _mm512_set1_ps(FLT_MIN);
+    // The last step is masked, so there is no scalar tail.
+    for (size_t i = 0; i < count; i += 16)
+    {
+        const size_t left = count - i;
+        const __mmask16 mask = left >= 16 ? __mmask16(0xffff) : __mmask16((1u << left) - 1);
+        const __m512 x0 = _mm512_maskz_loadu_ps(mask, boxes.xmin + i), y0 = _mm512_maskz_loadu_ps(mask, boxes.ymin + i);
+        const __m512 x1 = _mm512_maskz_loadu_ps(mask, boxes.xmax + i), y1 = _mm512_maskz_loadu_ps(mask, boxes.ymax + i);
+        const __m512 w = _mm512_max_ps(zero, _mm512_sub_ps(_mm512_min_ps(x1, bx1), _mm512_max_ps(x0, bx0)));
+        const __m512 h = _mm512_max_ps(zero, _mm512_sub_ps(_mm512_min_ps(y1, by1), _mm512_max_ps(y0, by0)));
+        const __m512 inter = _mm512_mul_ps(w, h);
+        const __m512 area = _mm512_mul_ps(_mm512_sub_ps(x1, x0), _mm512_sub_ps(y1, y0));
+        const __m512 uni = _mm512_max_ps(_mm512_sub_ps(_mm512_add_ps(area, barea), inter), tiny);
+        _mm512_mask_storeu_ps(out + i, mask, _mm512_div_ps(inter, uni));
+    }
+}
+#endif // PILLAR_ARCH_X86
+
+IouKernel selectKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return iouAvx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return iouAvx2;
+    }
+#endif
+    (void)level;
+    return iouScalar;
+}
+
+IouKernel defaultKernel()
+{
+    // Picked once, the CPU does not change under us.
+    static const IouKernel kernel = selectKernel(cpu::simdLevel());
+    return kernel;
+}
+
+bool betterBox(const KeptBox& a, const KeptBox& b)
+{
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+
+// The candidates of one label, best first, as a working copy of the columns
+// that every suppression pass compacts in place.
+class Candidates
+{
+public:
+    template <class T>
+    using Column = std::vector<T, AlignedAllocator<T>>;
+
+    size_t count = 0;
+    Column<float> xmin, ymin, xmax, ymax, score, iou;
+    Column<uint32_t> index;
+
+    void load(const BoxBatch& boxes, const uint32_t* order, size_t n)
+    {
+        for (Column<float>* column : {&xmin, &ymin, &xmax, &ymax, &score, &iou})
+            column->resize(n);
+        index.resize(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint32_t j = order[i];
+            xmin[i] = boxes.xmin()[j];
+            ymin[i] = boxes.ymin()[j];
+            xmax[i] = boxes.xmax()[j];
+            ymax[i] = boxes.ymax()[j];
+            score[i] = boxes.scores()[j];
+            index[i] = j;
+        }
+        count = n;
+    }
+
+    // IoU of candidate `i` with every candidate after it into `iou`.
+    void overlapsAfter(size_t i, IouKernel kernel)
+    {
+        const float box[4] = {xmin[i], ymin[i], xmax[i], ymax[i]};
+        const size_t from = i + 1;
+        kernel({xmin.data() + from, ymin.data() + from, xmax.data() + from, ymax.data() + from}, count - from, box,
+               iou.data());
+    }
+
+    // Moves candidate `from` to slot `to`, `to` <= `from`.
+    void move(size_t to, size_t from)
+    {
+        xmin[to] = xmin[from];
+        ymin[to] = ymin[from];
+        xmax[to] = xmax[from];
+        ymax[to] = ymax[from];
+        score[to] = score[from];
+        index[to] = index[from];
+    }
+
+    void swap(size_t a, size_t b)
+    {
+        std::swap(xmin[a], xmin[b]);
+        std::swap(ymin[a], ymin[b]);
+        std::swap(xmax[a], xmax[b]);
+        std::swap(ymax[a], ymax[b]);
+        std::swap(score[a], score[b]);
+        std::swap(index[a], index[b]);
+    }
+};
+
+// Candidate indices scoring at least `threshold`, grouped by label when
+// `classAware` and best first within a group; `groups` gets the group ends.
+void sortCandidates(const BoxBatch& boxes, float threshold, bool classAware, std::vector<uint32_t>& order,
+                    std::vector<size_t>& groups)
+{
+    order.clear();
+    groups.clear();
+    const float* scores = boxes.scores();
+    const int32_t* labels = boxes.labels();
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        if (scores[i] >= threshold)
+            order.push_back(static_cast<uint32_t>(i));
+    }
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b)
+              {
+                  if (classAware && labels[a] != labels[b])
+                      return labels[a] < labels[b];
+                  return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+              });
+    for (size_t i = 1; i <= order.size(); ++i)
+    {
+        if (i == order.size() || (classAware && labels[order[i]] != labels[order[i - 1]]))
+            groups.push_back(i);
+    }
+}
+
+// Greedy suppression within one group, already best first.
+void suppressGreedy(Candidates& c, float iouThreshold, size_t maxKeep, IouKernel kernel, std::vector<KeptBox>& kept)
+{
+    size_t keptHere = 0;
+    for (size_t i = 0; i < c.count; ++i)
+    {
+        kept.push_back({c.index[i], c.score[i]});
+        if (++keptHere == maxKeep)
+            break;
+        c.overlapsAfter(i, kernel);
+        // Branch-free compaction of the survivors behind the kept box.
+        size_t write = i + 1;
+        for (size_t j = i + 1; j < c.count; ++j)
+        {
+            c.move(write, j);
+            write += c.iou[j - i - 1] <= iouThreshold;
+        }
+        c.count = write;
+    }
+}
+
+// Soft suppression within one group: keeps the best box left, decays the
+// scores of the rest by their overlap with it and drops those that fall
+// below the threshold.
+void suppressSoft(Candidates& c, const SoftNmsOptions& options, size_t maxKeep, IouKernel kernel,
+                  std::vector<KeptBox>& kept)
+{
+    size_t keptHere = 0;
+    const bool linear = options.method == SoftNmsMethod::kLinear;
+    const float inverseSigma = 1.0f / options.sigma;
+    for (size_t i = 0; i < c.count; ++i)
+    {
+        size_t best = i;
+        for (size_t j = i + 1; j < c.count; ++j)
+        {
+            if (c.score[j] > c.score[best] || (c.score[j] == c.score[best] && c.index[j] < c.index[best]))
+                best = j;
+        }
+        c.swap(i, best);
+        kept.push_back({c.index[i], c.score[i]});
+        if (++keptHere == maxKeep)
+            break;
+        c.overlapsAfter(i, kernel);
+        size_t write = i + 1;
+        for (size_t j = i + 1; j < c.count; ++j)
+        {
+            const float iou = c.iou[j - i - 1];
+            // Most candidates lie elsewhere in the image, keep exp off them.
+            float weight = 1.0f;
+            if (linear)
+                weight = iou > options.iouThreshold ? 1.0f - iou : 1.0f;
+            else if (iou > 0.0f)
+                weight = expf(-iou * iou * inverseSigma);
+            c.move(write, j);
+            c.score[write] *= weight;
+            write += c.score[write] >= options.scoreThreshold;
+        }
+        c.count = write;
+    }
+}
+
+// Sorts once, runs `suppress` per group and merges the groups best first.
+template <class Suppress>
+void suppressGroups(const BoxBatch& boxes, float scoreThreshold, bool classAware, size_t maxDetections,
+                    std::vector<KeptBox>& kept, Suppress suppress)
+{
+    kept.clear();
+    std::vector<uint32_t> order;
+    std::vector<size_t> groups;
+    sortCandidates(boxes, scoreThreshold, classAware, order, groups);
+    Candidates candidates;
+    size_t begin = 0;
+    for (size_t end : groups)
+    {
+        candidates.load(boxes, order.data() + begin, end - begin);
+        suppress(candidates, kept);
+        begin = end;
+    }
+    if (groups.size() > 1)
+        std::sort(kept.begin(), kept.end(), betterBox);
+    if (maxDetections != 0 && kept.size() > maxDetections)
+        kept.resize(maxDetections);
+}
+} // namespace
+
+void BoxBatch::reserve(size_t count)
+{
+    mXMin.reserve(count);
+    mYMin.reserve(count);
+    mXMax.reserve(count);
+    mYMax.reserve(count);
+    mScores.reserve(count);
+    mLabels.reserve(count);
+}
+
+void BoxBatch::clear()
+{
+    mXMin.clear();
+    mYMin.clear();
+    mXMax.clear();
+    mYMax.clear();
+    mScores.clear();
+    mLabels.clear();
+}
+
+void BoxBatch::add(float xmin, float ymin, float xmax, float ymax, float score, int32_t label)
+{
+    mXMin.push_back(xmin);
+    mYMin.push_back(ymin);
+    mXMax.push_back(xmax);
+    mYMax.push_back(ymax);
+    mScores.push_back(score);
+    mLabels.push_back(label);
+}
+
+void BoxBatch::add(const Rectangle<float>& box, float score, int32_t label)
+{
+    add(box.xmin(), box.ymin(), box.xmax(), box.ymax(), score, label);
+}
+
+Rectangle<float> BoxBatch::rectangle(size_t i) const
+{
+    return Rectangle<float>(Point2<float>(mXMin[i], mYMin[i]), Point2<float>(mXMax[i], mYMax[i]));
+}
+
+std::vector<Rectangle<float>> BoxBatch::rectangles(const std::vector<KeptBox>& kept) const
+{
+    std::vector<Rectangle<float>> out;
+    out.reserve(kept.size());
+    for (const KeptBox& box : kept)
+        out.push_back(rectangle(box.index));
+    return out;
+}
+
+void intersectionOverUnion(const BoxBatch& boxes, const Rectangle<float>& box, float* ious)
+{
+    const float corners[4] = {box.xmin(), box.ymin(), box.xmax(), box.ymax()};
+    defaultKernel()({boxes.xmin(), boxes.ymin(), boxes.xmax(), boxes.ymax()}, boxes.size(), corners, ious);
+}
+
+void intersectionOverUnion(const BoxBatch& boxes, const Rectangle<float>& box, float* ious, cpu::SimdLevel maxLevel)
+{
+    const float corners[4] = {box.xmin(), box.ymin(), box.xmax(), box.ymax()};
+    selectKernel(std::min(maxLevel, cpu::simdLevel()))({boxes.xmin(), boxes.ymin(), boxes.xmax(), boxes.ymax()},
+                                                      boxes.size(), corners, ious);
+}
+
+void nonMaxSuppression(const BoxBatch& boxes, const NmsOptions& options, std::vector<KeptBox>& kept)
+{
+    nonMaxSuppression(boxes, options, kept, cpu::simdLevel());
+}
+
+void nonMaxSuppression(const BoxBatch& boxes, const NmsOptions& options, std::vector<KeptBox>& kept,
+                       cpu::SimdLevel maxLevel)
+{
+    const IouKernel kernel =
+        maxLevel >= cpu::simdLevel() ? defaultKernel() : selectKernel(std::min(maxLevel, cpu::simdLevel()));
+    suppressGroups(boxes, options.scoreThreshold, options.classAware, options.maxDetections, kept,
+                   [&](Candidates& c, std::vector<KeptBox>& out)
+                   { suppressGreedy(c, options.iouThreshold, options.maxDetections, kernel, out); });
+}
+
+void softNonMaxSuppression(const BoxBatch& boxes, const SoftNmsOptions& options, std::vector<KeptBox>& kept)
+{
+    softNonMaxSuppression(boxes, options, kept, cpu::simdLevel());
+}
+
+void softNonMaxSuppression(const BoxBatch& boxes, const SoftNmsOptions& options, std::vector<KeptBox>& kept,
+                           cpu::SimdLevel maxLevel)
+{
+    const IouKernel kernel =
+        maxLevel >= cpu::simdLevel() ? defaultKernel() : selectKernel(std::min(maxLevel, cpu::simdLevel()));
+    suppressGroups(boxes, options.scoreThreshold, options.classAware, options.maxDetections, kept,
+                   [&](Candidates& c, std::vector<KeptBox>& out)
+                   { suppressSoft(c, options, options.maxDetections, kernel, out); });
+}
+} // namespace yuzu
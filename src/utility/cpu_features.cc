@@ -0,0 +1,175 @@
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "pillar/utility/cpu_features.h"
+
+#if defined(PILLAR_ARCH_X86)
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace yuzu
+{
+namespace cpu
+{
+namespace
+{
+#if defined(PILLAR_ARCH_X86)
+void cpuid(int leaf, int subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; ++i)
+    {
+        regs[i] = static_cast<uint32_t>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t xgetbv()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+Features detect()
+{
+    Features f;
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1)
+    {
+        return f;
+    }
+
+    cpuid(1, 0, regs);
+    const uint32_t ecx1 = regs[2];
+    const uint32_t edx1 = regs[3];
+    f.sse2 = edx1 & (1u << 26);
+    f.ssse3 = ecx1 & (1u << 9);
+    f.sse41 = ecx1 & (1u << 19);
+
+    // The OS has to save the wider registers on context switches, which is
+    // reported through XCR0.
+    const bool osxsave = ecx1 & (1u << 27);
+    const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+    const bool osYmm = (xcr0 & 0x6) == 0x6;
+    const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+
+    f.avx = osYmm && (ecx1 & (1u << 28));
+    f.fma = f.avx && (ecx1 & (1u << 12));
+    f.f16c = f.avx && (ecx1 & (1u << 29));
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, 0, regs);
+        const uint32_t ebx7 = regs[1];
+        const uint32_t ecx7 = regs[2];
+        f.avx2 = f.avx && (ebx7 & (1u << 5));
+        f.avx512f = osZmm && (ebx7 & (1u << 16));
+        f.avx512dq = f.avx512f && (ebx7 & (1u << 17));
+        f.avx512bw = f.avx512f && (ebx7 & (1u << 30));
+        f.avx512vl = f.avx512f && (ebx7 & (1u << 31));
+        f.avx512vnni = f.avx512f && (ecx7 & (1u << 11));
+
+        cpuid(7, 1, regs);
+        f.avxvnni = f.avx2 && (regs[0] & (1u << 4));
+    }
+    return f;
+}
+#else
+Features detect()
+{
+    Features f;
+#if defined(PILLAR_ARCH_ARM)
+    f.neon = true;
+#endif
+    return f;
+}
+#endif
+
+SimdLevel detectLevel()
+{
+    const Features& f = features();
+    SimdLevel level = SimdLevel::kScalar;
+    if (f.sse2 && f.ssse3 && f.sse41)
+    {
+        level = SimdLevel::kSSE41;
+    }
+    if (level == SimdLevel::kSSE41 && f.avx2 && f.fma && f.f16c)
+    {
+        level = SimdLevel::kAVX2;
+    }
+    if (level == SimdLevel::kAVX2 && f.avx512f && f.avx512bw && f.avx512vl && f.avx512dq)
+    {
+        level = SimdLevel::kAVX512;
+    }
+
+    const char* cap = std::getenv("PILLAR_SIMD_LEVEL");
+    if (cap != nullptr)
+    {
+        const std::string value(cap);
+        SimdLevel maxLevel = level;
+        if (value == "scalar")
+            maxLevel = SimdLevel::kScalar;
+        else if (value == "sse41")
+            maxLevel = SimdLevel::kSSE41;
+        else if (value == "avx2")
+            maxLevel = SimdLevel::kAVX2;
+        else if (value == "avx512")
+            maxLevel = SimdLevel::kAVX512;
+
+        if (static_cast<int>(maxLevel) < static_cast<int>(level))
+        {
+            level = maxLevel;
+        }
+    }
+    return level;
+}
+} // namespace
+
+const Features& features()
+{
+    static const Features f = detect();
+    return f;
+}
+
+SimdLevel simdLevel()
+{
+    static const SimdLevel level = detectLevel();
+    return level;
+}
+
+const char* toString(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::kScalar:
+            return "scalar";
+        case SimdLevel::kSSE41:
+            return "sse41";
+        case SimdLevel::kAVX2:
+            return "avx2";
+        case SimdLevel::kAVX512:
+            return "avx512";
+        default:
+            return "";
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, SimdLevel level) { return os << toString(level); }
+} // namespace cpu
+} // namespace yuzu
@@ -0,0 +1,464 @@
+#include <math.h>
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "pillar/thread_pool/parallel_for.h"
+#include "pillar/utility/embedding_gallery.h"
+#include "pillar/utility/quantize.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+// Rows are padded to a whole cache line, the kernels never need a tail.
+constexpr size_t kRowAlignBytes = 64;
+
+// Gallery rows streamed per block, sized to stay in L2 while every group of
+// queries sweeps over them.
+constexpr size_t kBlockBytes = 128 * 1024;
+
+// Writes the unit vector of `src` into `dst`, the norm summed in double.
+bool normalizeInto(const float* src, unsigned int dim, float* dst)
+{
+    double sum = 0.0;
+    for (unsigned int i = 0; i < dim; ++i)
+        sum += double(src[i]) * src[i];
+    if (!(sum > 0.0))
+        return false;
+    const double inv = 1.0 / sqrt(sum);
+    for (unsigned int i = 0; i < dim; ++i)
+        dst[i] = static_cast<float>(src[i] * inv);
+    return true;
+}
+
+// A tile scores Q queries against R consecutive rows, `stride` floats each,
+// into out[i * outStride + j].
+struct ScalarTile
+{
+    template <int Q, int R>
+    static void run(const float* q, const float* r, size_t stride, float* out, size_t outStride)
+    {
+        float acc[Q][R] = {};
+        for (size_t k = 0; k < stride; ++k)
+            for (int i = 0; i < Q; ++i)
+                for (int j = 0; j < R; ++j)
+                    acc[i][j] += q[i * stride + k] * r[j * stride + k];
+        for (int i = 0; i < Q; ++i)
+            for (int j = 0; j < R; ++j)
+                out[i * outStride + j] = acc[i][j];
+    }
+};
+
+#if defined(PILLAR_ARCH_X86)
+PILLAR_TARGET_AVX2 inline float hsum256(__m256 v)
+{
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+}
+
+struct Avx2Tile
+{
+    template <int Q, int R>
+    PILLAR_TARGET_AVX2 static void run(const float* q, const float* r, size_t stride, float* out, size_t outStride)
+    {
+        __m256 acc[Q][R];
+        for (int i = 0; i < Q; ++i)
+            for (int j = 0; j < R; ++j)
+                acc[i][j] = _mm256_setzero_ps();
+        for (size_t k = 0; k < stride; k += 8)
+        {
+            __m256 rows[R];
+            for (int j = 0; j < R; ++j)
+                rows[j] = _mm256_load_ps(r + j * stride + k);
+            for (int i = 0; i < Q; ++i)
+            {
+                const __m256 query = _mm256_load_ps(q + i * stride + k);
+                for (int j = 0; j < R; ++j)
+                    acc[i][j] = _mm256_fmadd_ps(query, rows[j], acc[i][j]);
+            }
+        }
+        for (int i = 0; i < Q; ++i)
+            for (int j = 0; j < R; ++j)
+                out[i * outStride + j] = hsum256(acc[i][j]);
+    }
+};
+
+struct Avx512Tile
+{
+    template <int Q, int R>
+    PILLAR_TARGET_AVX512 static void run(const float* q, const float* r, size_t stride, float* out, size_t outStride)
+    {
+        __m512 acc[Q][R];
+        for (int i = 0; i < Q; ++i)
+            for (int j = 0; j < R; ++j)
+                acc[i][j] = _mm512_setzero_ps();
+        for (size_t k = 0; k < stride; k += 16)
+        {
+            __m512 rows[R];
+            for (int j = 0; j < R; ++j)
+                rows[j] = _mm512_load_ps(r + j * stride + k);
+            for (int i = 0; i < Q; ++i)
+            {
+                const __m512 query = _mm512_load_ps(q + i * stride + k);
+                for (int j = 0; j < R; ++j)
+                    acc[i][j] = _mm512_fmadd_ps(query, rows[j], acc[i][j]);
+            }
+        }
+        for (int i = 0; i < Q; ++i)
+            for (int j = 0; j < R; ++j)
+                out[i * outStride + j] = _mm512_reduce_add_ps(acc[i][j]);
+    }
+};
+#endif // PILLAR_ARCH_X86
+
+// Sweeps Q queries over `rowCount` rows, R rows per tile.
+template <class Tile, int Q, int R>
+void sweep(const float* q, const float* rows, size_t rowCount, size_t stride, float* out, size_t outStride)
+{
+    size_t r = 0;
+    for (; r + R <= rowCount; r += R)
+        Tile::template run<Q, R>(q, rows + r * stride, stride, out + r, outStride);
+    for (; r < rowCount; ++r)
+        Tile::template run<Q, 1>(q, rows + r * stride, stride, out + r, outStride);
+}
+
+using BlockKernel = void (*)(const float* queries, size_t queryCount, const float* rows, size_t rowCount,
+                             size_t stride, float* scores, size_t scoreStride);
+
+// Scores every query against one block of rows, Q queries at a time so each
+// row loaded from the block feeds Q accumulators.
+template <class Tile, int Q, int R>
+void blockKernel(const float* queries, size_t queryCount, const float* rows, size_t rowCount, size_t stride,
+                 float* scores, size_t scoreStride)
+{
+    size_t q = 0;
+    for (; q + Q <= queryCount; q += Q)
+        sweep<Tile, Q, R>(queries + q * stride, rows, rowCount, stride, scores + q * scoreStride, scoreStride);
+    for (; q < queryCount; ++q)
+        sweep<Tile, 1, R>(queries + q * stride, rows, rowCount, stride, scores + q * scoreStride, scoreStride);
+}
+
+// Best first, ties by index so results do not depend on the band split.
+bool betterMatch(const GalleryMatch& a, const GalleryMatch& b)
+{
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+
+// Feeds one block of scores into `heap`, a min-heap of at most `k` matches
+// keyed by betterMatch, or a plain list when `k == 0`. Once the heap is full a
+// score only needs one comparison against its worst entry to be rejected.
+void selectInto(std::vector<GalleryMatch>& heap, const float* scores, size_t rows, size_t firstIndex, size_t k,
+                float threshold)
+{
+    for (size_t r = 0; r < rows; ++r)
+    {
+        const float score = scores[r];
+        if (score < threshold)
+            continue;
+        const GalleryMatch match{firstIndex + r, score};
+        if (k == 0)
+        {
+            heap.push_back(match);
+        }
+        else if (heap.size() < k)
+        {
+            heap.push_back(match);
+            std::push_heap(heap.begin(), heap.end(), betterMatch);
+        }
+        else if (betterMatch(match, heap.front()))
+        {
+            std::pop_heap(heap.begin(), heap.end(), betterMatch);
+            heap.back() = match;
+            std::push_heap(heap.begin(), heap.end(), betterMatch);
+        }
+    }
+}
+
+BlockKernel selectKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    // 4 x 4 zmm accumulators plus the loads fit the 32 registers, 4 x 2 ymm
+    // fit the 16.
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return blockKernel<Avx512Tile, 4, 4>;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return blockKernel<Avx2Tile, 4, 2>;
+    }
+#endif
+    (void)level;
+    return blockKernel<ScalarTile, 2, 2>;
+}
+} // namespace
+
+struct EmbeddingGallery::Queries
+{
+    size_t count = 0;
+    cpu::SimdLevel level = cpu::SimdLevel::kScalar;
+    // Float and half galleries match float queries.
+    std::vector<float, AlignedAllocator<float>> floats;
+    // Int8 galleries match int8 queries, with their scales.
+    std::vector<int8_t, AlignedAllocator<int8_t>> ints;
+    std::vector<float> scales;
+};
+
+EmbeddingGallery::EmbeddingGallery(unsigned int dim, DataType storage)
+    : mDim(dim), mStorage(storage == DataType::kHALF || storage == DataType::kINT8 ? storage : DataType::kFLOAT)
+{
+    const size_t elementBytes = mStorage == DataType::kFLOAT ? 4 : mStorage == DataType::kHALF ? 2 : 1;
+    mRowBytes = (dim * elementBytes + kRowAlignBytes - 1) / kRowAlignBytes * kRowAlignBytes;
+    mStride = mRowBytes / elementBytes;
+    mScratch.resize(dim);
+}
+
+EmbeddingGallery::EmbeddingGallery(unsigned int dim, DataType storage, const void* rows, size_t count,
+                                   const float* scales)
+    : EmbeddingGallery(dim, storage)
+{
+    // Zero-width rows have no layout to read, so nothing is ever scored.
+    mViewRows = mDim == 0 ? nullptr : static_cast<const uint8_t*>(rows);
+    mViewScales = mDim == 0 ? nullptr : scales;
+    mSize = mDim == 0 ? 0 : count;
+    mView = true;
+}
+
+void EmbeddingGallery::reserve(size_t rows)
+{
+    if (mView)
+        return;
+    mData.reserve(rows * mRowBytes);
+    if (mStorage == DataType::kINT8)
+        mScales.reserve(rows);
+}
+
+void EmbeddingGallery::clear()
+{
+    // A view detaches and becomes an empty gallery of its own.
+    mData.clear();
+    mScales.clear();
+    mViewRows = nullptr;
+    mViewScales = nullptr;
+    mSize = 0;
+    mView = false;
+}
+
+void EmbeddingGallery::dequantizeRow(size_t i, float* out) const
+{
+    switch (mStorage)
+    {
+    case DataType::kHALF:
+        math::dequantizeHalf(reinterpret_cast<const uint16_t*>(rowBytes(i)), mDim, out);
+        break;
+    case DataType::kINT8:
+        math::dequantizeInt8(reinterpret_cast<const int8_t*>(rowBytes(i)), mDim, scaleData()[i], out);
+        break;
+    default:
+        std::copy(row(i), row(i) + mDim, out);
+        break;
+    }
+}
+
+Status EmbeddingGallery::add(const float* embedding)
+{
+    if (mView)
+        return Status(StatusCode::kFailedPrecondition, "gallery is a read-only view");
+    if (mDim == 0)
+        return Status(StatusCode::kInvalidArgument, "dimension must not be zero");
+    if (!normalizeInto(embedding, mDim, mScratch.data()))
+        return Status(StatusCode::kInvalidArgument, "embedding has zero norm");
+
+    // New rows come zeroed, so the padding is already in place.
+    mData.resize(mData.size() + mRowBytes, 0);
+    uint8_t* dst = mData.data() + mSize * mRowBytes;
+    switch (mStorage)
+    {
+    case DataType::kHALF:
+        math::quantizeHalf(mScratch.data(), mDim, reinterpret_cast<uint16_t*>(dst));
+        break;
+    case DataType::kINT8:
+        mScales.push_back(math::quantizeInt8(mScratch.data(), mDim, reinterpret_cast<int8_t*>(dst)));
+        break;
+    default:
+        std::copy(mScratch.begin(), mScratch.end(), reinterpret_cast<float*>(dst));
+        break;
+    }
+    ++mSize;
+    return okStatus();
+}
+
+Status EmbeddingGallery::addBatch(const float* embeddings, size_t count)
+{
+    reserve(mSize + count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Status status = add(embeddings + i * mDim);
+        if (!status.ok())
+            return status;
+    }
+    return okStatus();
+}
+
+Status EmbeddingGallery::match(const float* query, float* scores) const
+{
+    return match(query, 1, scores);
+}
+
+Status EmbeddingGallery::match(const float* queries, size_t count, float* scores) const
+{
+    return match(queries, count, scores, cpu::SimdLevel::kAVX512);
+}
+
+Status EmbeddingGallery::match(const float* queries, size_t count, float* scores, cpu::SimdLevel maxLevel) const
+{
+    if (count == 0 || mSize == 0)
+        return okStatus();
+    Queries prepared;
+    Status status = prepareQueries(queries, count, maxLevel, prepared);
+    if (!status.ok())
+        return status;
+
+    const size_t rowsPerBlock = blockRows();
+    const int blocks = static_cast<int>((mSize + rowsPerBlock - 1) / rowsPerBlock);
+    parallelFor(0, blocks, 1,
+                [&](int bandBegin, int bandEnd)
+                {
+                    for (int b = bandBegin; b < bandEnd; ++b)
+                    {
+                        const size_t first = size_t(b) * rowsPerBlock;
+                        scoreBlock(prepared, first, std::min(rowsPerBlock, mSize - first), scores + first, mSize);
+                    }
+                });
+    return okStatus();
+}
+
+Status EmbeddingGallery::topK(const float* query, size_t k, float threshold, std::vector<GalleryMatch>& matches) const
+{
+    std::vector<std::vector<GalleryMatch>> all;
+    Status status = topK(query, 1, k, threshold, all);
+    matches = all.empty() ? std::vector<GalleryMatch>() : std::move(all[0]);
+    return status;
+}
+
+Status EmbeddingGallery::topK(const float* queries, size_t count, size_t k, float threshold,
+                              std::vector<std::vector<GalleryMatch>>& matches) const
+{
+    matches.assign(count, {});
+    if (count == 0 || mSize == 0)
+        return okStatus();
+    Queries prepared;
+    Status status = prepareQueries(queries, count, cpu::SimdLevel::kAVX512, prepared);
+    if (!status.ok())
+        return status;
+
+    const size_t rowsPerBlock = blockRows();
+    const int blocks = static_cast<int>((mSize + rowsPerBlock - 1) / rowsPerBlock);
+    std::mutex mergeMutex;
+    parallelFor(0, blocks, 1,
+                [&](int bandBegin, int bandEnd)
+                {
+                    // Each band scores one block at a time into scratch and
+                    // keeps its own bounded heaps, merged once at the end.
+                    std::vector<float> scores(count * rowsPerBlock);
+                    std::vector<std::vector<GalleryMatch>> heaps(count);
+                    for (int b = bandBegin; b < bandEnd; ++b)
+                    {
+                        const size_t first = size_t(b) * rowsPerBlock;
+                        const size_t rows = std::min(rowsPerBlock, mSize - first);
+                        scoreBlock(prepared, first, rows, scores.data(), rowsPerBlock);
+                        for (size_t q = 0; q < count; ++q)
+                            selectInto(heaps[q], scores.data() + q * rowsPerBlock, rows, first, k, threshold);
+                    }
+                    std::lock_guard<std::mutex> lock(mergeMutex);
+                    for (size_t q = 0; q < count; ++q)
+                        matches[q].insert(matches[q].end(), heaps[q].begin(), heaps[q].end());
+                });
+
+    for (std::vector<GalleryMatch>& candidates : matches)
+    {
+        const size_t keep = k == 0 ? candidates.size() : std::min(k, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(), betterMatch);
+        candidates.resize(keep);
+    }
+    return okStatus();
+}
+
+Status EmbeddingGallery::prepareQueries(const float* queries, size_t count, cpu::SimdLevel level,
+                                        Queries& prepared) const
+{
+    // Queries take the gallery's padded layout so the kernels see aligned
+    // rows of the same stride.
+    prepared.count = count;
+    prepared.level = std::min(level, cpu::simdLevel());
+    prepared.floats.assign(count * mStride, 0.0f);
+    for (size_t q = 0; q < count; ++q)
+    {
+        if (!normalizeInto(queries + q * mDim, mDim, prepared.floats.data() + q * mStride))
+            return Status(StatusCode::kInvalidArgument, "query has zero norm");
+    }
+    if (mStorage == DataType::kINT8)
+    {
+        prepared.ints.assign(count * mStride, 0);
+        prepared.scales.resize(count);
+        for (size_t q = 0; q < count; ++q)
+            prepared.scales[q] =
+                math::quantizeInt8(prepared.floats.data() + q * mStride, mDim, prepared.ints.data() + q * mStride);
+    }
+    return okStatus();
+}
+
+void EmbeddingGallery::scoreBlock(const Queries& queries, size_t first, size_t rows, float* scores,
+                                  size_t scoreStride) const
+{
+    // Half and int8 rows go through the pairwise kernels; the block still
+    // stays in cache while every query passes over it.
+    const unsigned int len = static_cast<unsigned int>(mStride);
+    switch (mStorage)
+    {
+    case DataType::kHALF:
+        for (size_t q = 0; q < queries.count; ++q)
+        {
+            const float* query = queries.floats.data() + q * mStride;
+            for (size_t r = 0; r < rows; ++r)
+            {
+                const uint16_t* row = reinterpret_cast<const uint16_t*>(rowBytes(first + r));
+                scores[q * scoreStride + r] = math::dotProduct(query, row, len, queries.level);
+            }
+        }
+        break;
+    case DataType::kINT8:
+    {
+        const float* rowScales = scaleData() + first;
+        for (size_t q = 0; q < queries.count; ++q)
+        {
+            const int8_t* query = queries.ints.data() + q * mStride;
+            for (size_t r = 0; r < rows; ++r)
+            {
+                const int8_t* row = reinterpret_cast<const int8_t*>(rowBytes(first + r));
+                scores[q * scoreStride + r] =
+                    float(math::dotProduct(query, row, len, queries.level)) * queries.scales[q] * rowScales[r];
+            }
+        }
+        break;
+    }
+    default:
+        selectKernel(queries.level)(queries.floats.data(), queries.count, row(first), rows, mStride, scores,
+                                    scoreStride);
+        break;
+    }
+}
+
+size_t EmbeddingGallery::blockRows() const
+{
+    return std::max<size_t>(16, kBlockBytes / mRowBytes);
+}
+} // namespace yuzu
@@ -0,0 +1,743 @@
+#include <math.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "pillar/utility/embedding_store.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+constexpr char kBaseMagic[8] = {'P', 'I', 'L', 'L', 'A', 'R', 'E', 'S'};
+constexpr char kLogMagic[8] = {'P', 'I', 'L', 'L', 'A', 'R', 'W', 'L'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kPut = 1;
+constexpr uint32_t kRemove = 2;
+
+struct LogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dim;
+};
+
+// Followed by the payload and a checksum of both.
+struct RecordHeader
+{
+    uint32_t type;
+    uint32_t payloadBytes;
+    uint64_t id;
+};
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// FNV-1a, enough to tell a torn record from a whole one.
+uint32_t checksum(const void* data, size_t size, uint32_t hash = 2166136261u)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+#if !defined(_WIN32)
+bool writeAll(int fd, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, p, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+bool readAt(int fd, uint64_t offset, void* data, size_t size)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = ::pread(fd, p, size, off_t(offset));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        offset += uint64_t(n);
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// Batches small writes of a file written front to back.
+class FileWriter
+{
+public:
+    explicit FileWriter(int fd) : mFd(fd), mPosition(0), mOk(true) { mBuffer.reserve(kBufferSize); }
+
+    void put(const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        mBuffer.insert(mBuffer.end(), p, p + size);
+        mPosition += size;
+        if (mBuffer.size() >= kBufferSize)
+            flush();
+    }
+
+    void padTo(uint64_t offset)
+    {
+        mBuffer.resize(mBuffer.size() + size_t(offset - mPosition), 0);
+        mPosition = offset;
+    }
+
+    bool flush()
+    {
+        mOk = mOk && writeAll(mFd, mBuffer.data(), mBuffer.size());
+        mBuffer.clear();
+        return mOk;
+    }
+
+private:
+    static constexpr size_t kBufferSize = size_t(1) << 20;
+
+    int mFd;
+    uint64_t mPosition;
+    bool mOk;
+    std::vector<uint8_t> mBuffer;
+};
+
+// Writes a base file next to `path` and renames it over `path` once it is
+// on disk, so a crash leaves either the old base or the new one.
+Status writeBase(const std::string& path, unsigned int dim, DataType storage, size_t rowPitch,
+                 const std::vector<uint64_t>& ids, const std::vector<const void*>& rows)
+{
+    const uint64_t count = ids.size();
+    embedding_store::FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kBaseMagic, sizeof(kBaseMagic));
+    header.version = kVersion;
+    header.dim = dim;
+    header.storage = static_cast<int32_t>(storage);
+    header.rowPitch = static_cast<uint32_t>(rowPitch);
+    header.count = count;
+    header.rowsOffset = embedding_store::kSectionAlignment;
+    header.idsOffset = alignUp(header.rowsOffset + count * rowPitch, embedding_store::kSectionAlignment);
+    header.indexOffset = alignUp(header.idsOffset + count * sizeof(uint64_t), embedding_store::kSectionAlignment);
+
+    std::vector<embedding_store::IndexEntry> index(count);
+    for (uint64_t i = 0; i < count; ++i)
+        index[i] = {ids[i], i};
+    std::sort(index.begin(), index.end(),
+              [](const embedding_store::IndexEntry& a, const embedding_store::IndexEntry& b) { return a.id < b.id; });
+
+    const std::string temporary = path + ".tmp";
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return Status(StatusCode::kPermissionDenied, "cannot create the store file");
+    FileWriter writer(fd);
+    writer.put(&header, sizeof(header));
+    writer.padTo(header.rowsOffset);
+    for (const void* row : rows)
+        writer.put(row, rowPitch);
+    writer.padTo(header.idsOffset);
+    writer.put(ids.data(), count * sizeof(uint64_t));
+    writer.padTo(header.indexOffset);
+    writer.put(index.data(), count * sizeof(embedding_store::IndexEntry));
+    bool ok = writer.flush() && ::fdatasync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || ::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        ::unlink(temporary.c_str());
+        return Status(StatusCode::kDataLoss, "writing the store file failed");
+    }
+    return okStatus();
+}
+#endif
+} // namespace
+
+// The mapped base file.
+struct EmbeddingStore::Base
+{
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t count = 0;
+    const uint64_t* ids = nullptr;
+    const embedding_store::IndexEntry* index = nullptr;
+    std::unique_ptr<EmbeddingGallery> rows;
+    // Rows replaced or removed since the base was written.
+    std::vector<uint8_t> deleted;
+    size_t deletedCount = 0;
+
+    ~Base()
+    {
+#if !defined(_WIN32)
+        if (data != nullptr)
+            ::munmap(data, size);
+#endif
+    }
+};
+
+// Rows put since the base was written.
+struct EmbeddingStore::Delta
+{
+    EmbeddingGallery rows;
+    std::vector<uint64_t> ids;
+    std::vector<uint8_t> deleted;
+    size_t deletedCount = 0;
+    std::unordered_map<uint64_t, size_t> live;
+
+    Delta(unsigned int dim, DataType storage) : rows(dim, storage) {}
+};
+
+struct EmbeddingStore::Record
+{
+    uint32_t type;
+    uint64_t id;
+    const float* embedding;
+};
+
+EmbeddingStore::EmbeddingStore()
+    : mDim(0), mLogFd(-1), mLogBytes(0), mStopping(false), mCompactRequested(false)
+{
+}
+
+EmbeddingStore::~EmbeddingStore()
+{
+    close();
+}
+
+Status EmbeddingStore::open(const std::string& path, unsigned int dim, const EmbeddingStoreOptions& options)
+{
+#if defined(_WIN32)
+    (void)path;
+    (void)dim;
+    (void)options;
+    return Status(StatusCode::kUnimplemented, "embedding stores need POSIX file I/O");
+#else
+    if (isOpen())
+        return Status(StatusCode::kFailedPrecondition, "store is already open");
+    if (options.storage != DataType::kFLOAT && options.storage != DataType::kHALF)
+        return Status(StatusCode::kInvalidArgument, "stores keep float or half rows");
+    if (dim == 0)
+        return Status(StatusCode::kInvalidArgument, "dimension must not be zero");
+
+    std::unique_lock<std::shared_mutex> lock(mMut);
+    mPath = path;
+    mDim = dim;
+    mOptions = options;
+    if (::access(path.c_str(), F_OK) != 0)
+    {
+        const EmbeddingGallery layout(dim, options.storage);
+        Status status = writeBase(path, dim, options.storage, layout.rowPitch(), {}, {});
+        if (!status.ok())
+            return status;
+    }
+    Status status = mapBase(mBase);
+    if (status.ok())
+    {
+        mDelta.reset(new Delta(dim, options.storage));
+        status = openLog();
+    }
+    if (!status.ok())
+    {
+        mBase.reset();
+        mDelta.reset();
+        if (mLogFd >= 0)
+            ::close(mLogFd);
+        mLogFd = -1;
+        return status;
+    }
+    lock.unlock();
+
+    if (options.compactLogBytes > 0)
+    {
+        mStopping = false;
+        mCompactRequested = false;
+        mCompactor = std::thread(&EmbeddingStore::compactLoop, this);
+    }
+    return okStatus();
+#endif
+}
+
+Status EmbeddingStore::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMut);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    if (mCompactor.joinable())
+        mCompactor.join();
+
+    std::lock_guard<std::mutex> compactLock(mCompactMut);
+    std::unique_lock<std::shared_mutex> lock(mMut);
+    Status status = okStatus();
+#if !defined(_WIN32)
+    if (mLogFd >= 0)
+    {
+        if (::fdatasync(mLogFd) != 0)
+            status = Status(StatusCode::kDataLoss, "flushing the store log failed");
+        ::close(mLogFd);
+    }
+#endif
+    mLogFd = -1;
+    mLogBytes = 0;
+    mBase.reset();
+    mDelta.reset();
+    return status;
+}
+
+bool EmbeddingStore::isOpen() const
+{
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    return mLogFd >= 0;
+}
+
+size_t EmbeddingStore::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    if (!mBase)
+        return 0;
+    return mBase->count - mBase->deletedCount + mDelta->live.size();
+}
+
+bool EmbeddingStore::contains(uint64_t id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    bool inBase;
+    size_t row;
+    return mBase && findLive(id, inBase, row);
+}
+
+size_t EmbeddingStore::logBytes() const
+{
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    return mLogBytes;
+}
+
+Status EmbeddingStore::put(uint64_t id, const float* embedding)
+{
+    double sum = 0.0;
+    for (unsigned int i = 0; i < mDim; ++i)
+        sum += double(embedding[i]) * embedding[i];
+    if (!(sum > 0.0))
+        return Status(StatusCode::kInvalidArgument, "embedding has zero norm");
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mMut);
+        if (mLogFd < 0)
+            return Status(StatusCode::kFailedPrecondition, "store is not open");
+        const Record record{kPut, id, embedding};
+        Status status = writeRecord(record);
+        if (!status.ok())
+            return status;
+        apply(record);
+    }
+    requestCompaction();
+    return okStatus();
+}
+
+Status EmbeddingStore::remove(uint64_t id)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(mMut);
+        if (mLogFd < 0)
+            return Status(StatusCode::kFailedPrecondition, "store is not open");
+        bool inBase;
+        size_t row;
+        if (!findLive(id, inBase, row))
+            return Status(StatusCode::kNotFound, "id is not in the store");
+        const Record record{kRemove, id, nullptr};
+        Status status = writeRecord(record);
+        if (!status.ok())
+            return status;
+        apply(record);
+    }
+    requestCompaction();
+    return okStatus();
+}
+
+Status EmbeddingStore::get(uint64_t id, float* embedding) const
+{
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    bool inBase;
+    size_t row;
+    if (!mBase || !findLive(id, inBase, row))
+        return Status(StatusCode::kNotFound, "id is not in the store");
+    if (inBase)
+        mBase->rows->dequantizeRow(row, embedding);
+    else
+        mDelta->rows.dequantizeRow(row, embedding);
+    return okStatus();
+}
+
+Status EmbeddingStore::topK(const float* query, size_t k, float threshold, std::vector<StoreMatch>& matches) const
+{
+    matches.clear();
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    if (!mBase)
+        return Status(StatusCode::kFailedPrecondition, "store is not open");
+
+    // Dead rows are still scored, asking for that many more keeps k live
+    // ones; compaction keeps the surplus small.
+    std::vector<GalleryMatch> found;
+    Status status = mBase->rows->topK(query, k == 0 ? 0 : k + mBase->deletedCount, threshold, found);
+    if (!status.ok())
+        return status;
+    for (const GalleryMatch& m : found)
+    {
+        if (!mBase->deleted[m.index])
+            matches.push_back({mBase->ids[m.index], m.score});
+    }
+    status = mDelta->rows.topK(query, k == 0 ? 0 : k + mDelta->deletedCount, threshold, found);
+    if (!status.ok())
+        return status;
+    for (const GalleryMatch& m : found)
+    {
+        if (!mDelta->deleted[m.index])
+            matches.push_back({mDelta->ids[m.index], m.score});
+    }
+    std::sort(matches.begin(), matches.end(), [](const StoreMatch& a, const StoreMatch& b)
+              { return a.score > b.score || (a.score == b.score && a.id < b.id); });
+    if (k != 0 && matches.size() > k)
+        matches.resize(k);
+    return okStatus();
+}
+
+Status EmbeddingStore::sync()
+{
+#if defined(_WIN32)
+    return Status(StatusCode::kUnimplemented, "embedding stores need POSIX file I/O");
+#else
+    std::shared_lock<std::shared_mutex> lock(mMut);
+    if (mLogFd < 0)
+        return Status(StatusCode::kFailedPrecondition, "store is not open");
+    return ::fdatasync(mLogFd) == 0 ? okStatus() : Status(StatusCode::kDataLoss, "flushing the store log failed");
+#endif
+}
+
+Status EmbeddingStore::compact()
+{
+#if defined(_WIN32)
+    return Status(StatusCode::kUnimplemented, "embedding stores need POSIX file I/O");
+#else
+    std::lock_guard<std::mutex> compactLock(mCompactMut);
+
+    // Only compaction replaces the base, so its mapped rows stay put while
+    // the new file is written without the lock. The delta is copied.
+    std::vector<uint64_t> ids;
+    std::vector<const void*> rows;
+    std::vector<uint8_t> deltaRows;
+    uint64_t logEnd;
+    size_t rowPitch;
+    {
+        std::shared_lock<std::shared_mutex> lock(mMut);
+        if (mLogFd < 0)
+            return Status(StatusCode::kFailedPrecondition, "store is not open");
+        logEnd = mLogBytes;
+        if (logEnd == sizeof(LogHeader))
+            return okStatus();
+        rowPitch = mBase->rows->rowPitch();
+        for (size_t r = 0; r < mBase->count; ++r)
+        {
+            if (mBase->deleted[r])
+                continue;
+            ids.push_back(mBase->ids[r]);
+            rows.push_back(mBase->rows->rowData(r));
+        }
+        const size_t baseRows = rows.size();
+        deltaRows.resize(mDelta->live.size() * rowPitch);
+        for (size_t r = 0; r < mDelta->ids.size(); ++r)
+        {
+            if (mDelta->deleted[r])
+                continue;
+            const uint8_t* row = static_cast<const uint8_t*>(mDelta->rows.rowData(r));
+            std::copy(row, row + rowPitch, deltaRows.begin() + (ids.size() - baseRows) * rowPitch);
+            ids.push_back(mDelta->ids[r]);
+        }
+        for (size_t r = baseRows; r < ids.size(); ++r)
+            rows.push_back(deltaRows.data() + (r - baseRows) * rowPitch);
+    }
+    Status status = writeBase(mPath, mDim, mOptions.storage, rowPitch, ids, rows);
+    if (!status.ok())
+        return status;
+
+    // Records logged meanwhile move to a fresh log and are replayed on the
+    // new base. The base was renamed first: until the log is replaced too,
+    // the whole old log replays on the new base, which is harmless since
+    // puts replace and removes of missing ids do nothing. So nothing is
+    // swapped before both files are in place, and a failure on the way
+    // leaves the store on the old base and the old log, still consistent.
+    std::unique_lock<std::shared_mutex> lock(mMut);
+    std::unique_ptr<Base> base;
+    status = mapBase(base);
+    if (!status.ok())
+        return status;
+
+    std::vector<uint8_t> tail(size_t(mLogBytes - logEnd));
+    const std::string logPath = mPath + ".wal";
+    const std::string temporary = logPath + ".tmp";
+    LogHeader header;
+    std::memcpy(header.magic, kLogMagic, sizeof(kLogMagic));
+    header.version = kVersion;
+    header.dim = mDim;
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && readAt(mLogFd, logEnd, tail.data(), tail.size()) && writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, tail.data(), tail.size()) && ::fdatasync(fd) == 0;
+    if (fd >= 0)
+        ok = ::close(fd) == 0 && ok;
+    if (!ok || ::rename(temporary.c_str(), logPath.c_str()) != 0)
+    {
+        ::unlink(temporary.c_str());
+        return Status(StatusCode::kDataLoss, "rewriting the store log failed");
+    }
+
+    // The old log is unlinked now, its descriptor must not be written again.
+    mBase = std::move(base);
+    mDelta.reset(new Delta(mDim, mOptions.storage));
+    ::close(mLogFd);
+    mLogFd = -1;
+    status = openLog();
+    if (!status.ok() && mLogFd >= 0)
+    {
+        ::close(mLogFd);
+        mLogFd = -1;
+    }
+    return status;
+#endif
+}
+
+#if !defined(_WIN32)
+Status EmbeddingStore::mapBase(std::unique_ptr<Base>& base) const
+{
+    const int fd = ::open(mPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return Status(StatusCode::kNotFound, "cannot open the store file");
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(embedding_store::FileHeader))
+    {
+        ::close(fd);
+        return Status(StatusCode::kDataLoss, "store file is truncated");
+    }
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return Status(StatusCode::kResourceExhausted, "cannot map the store file");
+
+    base.reset(new Base());
+    base->data = static_cast<uint8_t*>(data);
+    base->size = st.st_size;
+    const auto* header = reinterpret_cast<const embedding_store::FileHeader*>(base->data);
+    if (std::memcmp(header->magic, kBaseMagic, sizeof(kBaseMagic)) != 0 || header->version != kVersion)
+        return Status(StatusCode::kDataLoss, "not an embedding store file");
+    if (header->dim != mDim || header->storage != static_cast<int32_t>(mOptions.storage))
+        return Status(StatusCode::kInvalidArgument, "store has a different dimension or storage");
+
+    // Every section has to lie in the file, whatever the header says; the
+    // products are never formed, so huge counts or offsets cannot wrap. The
+    // mapping is page aligned, the rows need the 64 bytes of a gallery row.
+    const uint64_t fileSize = base->size;
+    auto fits = [fileSize](uint64_t offset, uint64_t items, uint64_t itemBytes)
+    { return offset <= fileSize && items <= (fileSize - offset) / itemBytes; };
+    const size_t rowPitch = EmbeddingGallery(mDim, mOptions.storage).rowPitch();
+    const uint64_t count = header->count;
+    if (header->rowPitch != rowPitch || header->rowsOffset % 64 != 0 ||
+        header->idsOffset % alignof(uint64_t) != 0 || header->indexOffset % alignof(embedding_store::IndexEntry) != 0 ||
+        !fits(header->rowsOffset, count, rowPitch) || !fits(header->idsOffset, count, sizeof(uint64_t)) ||
+        !fits(header->indexOffset, count, sizeof(embedding_store::IndexEntry)))
+        return Status(StatusCode::kDataLoss, "store file is truncated or corrupt");
+    const auto* index = reinterpret_cast<const embedding_store::IndexEntry*>(base->data + header->indexOffset);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (index[i].row >= count)
+            return Status(StatusCode::kDataLoss, "store file is truncated or corrupt");
+    }
+    base->count = size_t(count);
+    base->rows.reset(new EmbeddingGallery(mDim, mOptions.storage, base->data + header->rowsOffset, base->count));
+    base->ids = reinterpret_cast<const uint64_t*>(base->data + header->idsOffset);
+    base->index = index;
+    base->deleted.assign(base->count, 0);
+    return okStatus();
+}
+
+Status EmbeddingStore::openLog()
+{
+    const std::string logPath = mPath + ".wal";
+    mLogFd = ::open(logPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (mLogFd < 0)
+        return Status(StatusCode::kPermissionDenied, "cannot open the store log");
+    struct stat st;
+    if (::fstat(mLogFd, &st) != 0)
+        return Status(StatusCode::kDataLoss, "cannot read the store log");
+    LogHeader header;
+    if (st.st_size == 0)
+    {
+        std::memcpy(header.magic, kLogMagic, sizeof(kLogMagic));
+        header.version = kVersion;
+        header.dim = mDim;
+        if (!writeAll(mLogFd, &header, sizeof(header)))
+            return Status(StatusCode::kDataLoss, "cannot write the store log");
+        mLogBytes = sizeof(header);
+        return okStatus();
+    }
+    if (!readAt(mLogFd, 0, &header, sizeof(header)) || std::memcmp(header.magic, kLogMagic, sizeof(kLogMagic)) != 0 ||
+        header.version != kVersion || header.dim != mDim)
+        return Status(StatusCode::kDataLoss, "not a log of this store");
+    mLogBytes = st.st_size;
+    return replayLog(sizeof(header));
+}
+
+Status EmbeddingStore::writeRecord(const Record& record)
+{
+    RecordHeader header;
+    header.type = record.type;
+    header.payloadBytes = record.type == kPut ? mDim * sizeof(float) : 0;
+    header.id = record.id;
+    std::vector<uint8_t> bytes(sizeof(header) + header.payloadBytes + sizeof(uint32_t));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    if (header.payloadBytes != 0)
+        std::memcpy(bytes.data() + sizeof(header), record.embedding, header.payloadBytes);
+    const uint32_t sum = checksum(bytes.data(), sizeof(header) + header.payloadBytes);
+    std::memcpy(bytes.data() + sizeof(header) + header.payloadBytes, &sum, sizeof(sum));
+
+    // O_APPEND, a record lands whole at the end or, on a crash, is a torn
+    // tail that replay cuts off.
+    if (!writeAll(mLogFd, bytes.data(), bytes.size()) || (mOptions.syncWrites && ::fdatasync(mLogFd) != 0))
+        return Status(StatusCode::kDataLoss, "writing the store log failed");
+    mLogBytes += bytes.size();
+    return okStatus();
+}
+
+Status EmbeddingStore::replayLog(uint64_t from)
+{
+    std::vector<uint8_t> log(size_t(mLogBytes - from));
+    if (!readAt(mLogFd, from, log.data(), log.size()))
+        return Status(StatusCode::kDataLoss, "cannot read the store log");
+
+    size_t offset = 0;
+    std::vector<float> embedding(mDim);
+    while (offset + sizeof(RecordHeader) + sizeof(uint32_t) <= log.size())
+    {
+        RecordHeader header;
+        std::memcpy(&header, log.data() + offset, sizeof(header));
+        const bool known = (header.type == kPut && header.payloadBytes == mDim * sizeof(float)) ||
+                           (header.type == kRemove && header.payloadBytes == 0);
+        const size_t size = sizeof(header) + header.payloadBytes;
+        if (!known || offset + size + sizeof(uint32_t) > log.size())
+            break;
+        uint32_t sum;
+        std::memcpy(&sum, log.data() + offset + size, sizeof(sum));
+        if (sum != checksum(log.data() + offset, size))
+            break;
+        std::memcpy(embedding.data(), log.data() + offset + sizeof(header), header.payloadBytes);
+        apply({header.type, header.id, embedding.data()});
+        offset += size + sizeof(uint32_t);
+    }
+    if (offset != log.size())
+    {
+        // A torn or corrupt tail, the writes after the last whole record.
+        mLogBytes = from + offset;
+        if (::ftruncate(mLogFd, off_t(mLogBytes)) != 0)
+            return Status(StatusCode::kDataLoss, "cannot cut the torn store log tail");
+    }
+    return okStatus();
+}
+#endif
+
+void EmbeddingStore::apply(const Record& record)
+{
+    bool inBase;
+    size_t row;
+    if (findLive(record.id, inBase, row))
+    {
+        if (inBase)
+        {
+            mBase->deleted[row] = 1;
+            ++mBase->deletedCount;
+        }
+        else
+        {
+            mDelta->deleted[row] = 1;
+            ++mDelta->deletedCount;
+            mDelta->live.erase(record.id);
+        }
+    }
+    if (record.type == kPut && mDelta->rows.add(record.embedding).ok())
+    {
+        mDelta->live[record.id] = mDelta->ids.size();
+        mDelta->ids.push_back(record.id);
+        mDelta->deleted.push_back(0);
+    }
+}
+
+bool EmbeddingStore::findBase(uint64_t id, size_t& row) const
+{
+    const embedding_store::IndexEntry* end = mBase->index + mBase->count;
+    const embedding_store::IndexEntry* it = std::lower_bound(
+        mBase->index, end, id, [](const embedding_store::IndexEntry& e, uint64_t key) { return e.id < key; });
+    if (it == end || it->id != id || mBase->deleted[it->row])
+        return false;
+    row = size_t(it->row);
+    return true;
+}
+
+bool EmbeddingStore::findLive(uint64_t id, bool& inBase, size_t& row) const
+{
+    auto it = mDelta->live.find(id);
+    if (it != mDelta->live.end())
+    {
+        inBase = false;
+        row = it->second;
+        return true;
+    }
+    inBase = true;
+    return findBase(id, row);
+}
+
+void EmbeddingStore::requestCompaction()
+{
+    if (mOptions.compactLogBytes == 0 || logBytes() < mOptions.compactLogBytes)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mWakeMut);
+        mCompactRequested = true;
+    }
+    mWake.notify_one();
+}
+
+void EmbeddingStore::compactLoop()
+{
+    std::unique_lock<std::mutex> lock(mWakeMut);
+    while (true)
+    {
+        mWake.wait(lock, [this] { return mStopping || mCompactRequested; });
+        if (mStopping)
+            break;
+        mCompactRequested = false;
+        lock.unlock();
+        // A failed compaction leaves the store as it was, the next request
+        // tries again.
+        compact();
+        lock.lock();
+    }
+}
+} // namespace yuzu
@@ -0,0 +1,631 @@
+#include <math.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+#include "pillar/utility/hnsw_index.h"
+#include "pillar/utility/similarity.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+constexpr char kFileMagic[8] = {'P', 'I', 'L', 'L', 'A', 'R', 'H', 'N'};
+constexpr uint32_t kVersion = 1;
+
+// Vectors start on a cache line.
+constexpr size_t kStrideFloats = 16;
+// Bounds a loaded file must respect; levels are drawn with a mean of 1 / ln M.
+constexpr uint32_t kMaxFileM = 1u << 16;
+constexpr int32_t kMaxFileLevel = 64;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Writes the unit vector of `src` into `dst`, the norm summed in double.
+bool normalizeInto(const float* src, unsigned int dim, float* dst)
+{
+    double sum = 0.0;
+    for (unsigned int i = 0; i < dim; ++i)
+        sum += double(src[i]) * src[i];
+    if (!(sum > 0.0))
+        return false;
+    const double inv = 1.0 / sqrt(sum);
+    for (unsigned int i = 0; i < dim; ++i)
+        dst[i] = static_cast<float>(src[i] * inv);
+    return true;
+}
+
+#if !defined(_WIN32)
+bool writeAll(int fd, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, p, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+bool padTo(int fd, uint64_t& position, uint64_t offset)
+{
+    static const uint8_t zeros[hnsw::kSectionAlignment] = {};
+    const size_t size = size_t(offset - position);
+    position = offset;
+    return writeAll(fd, zeros, size);
+}
+
+bool readAt(int fd, uint64_t offset, void* data, size_t size)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = ::pread(fd, p, size, off_t(offset));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        offset += uint64_t(n);
+        size -= size_t(n);
+    }
+    return true;
+}
+#endif
+} // namespace
+
+// Marks the nodes one search has seen; reset by bumping the tag instead of
+// clearing the array.
+struct HnswIndex::VisitedList
+{
+    std::vector<uint16_t> marks;
+    uint16_t tag = 0;
+
+    void reset(size_t capacity)
+    {
+        if (marks.size() != capacity)
+        {
+            marks.assign(capacity, 0);
+            tag = 0;
+        }
+        if (++tag == 0)
+        {
+            std::fill(marks.begin(), marks.end(), uint16_t(0));
+            tag = 1;
+        }
+    }
+
+    // True the first time `node` is seen.
+    bool visit(uint32_t node)
+    {
+        if (marks[node] == tag)
+            return false;
+        marks[node] = tag;
+        return true;
+    }
+};
+
+HnswIndex::HnswIndex(unsigned int dim, size_t capacity, const HnswOptions& options)
+    : mDim(dim), mStride((size_t(dim) + kStrideFloats - 1) / kStrideFloats * kStrideFloats),
+      mM(std::max(2u, options.M)), mEfConstruction(std::max(options.efConstruction, mM)),
+      mEfSearch(options.efSearch), mLevelScale(1.0 / log(double(mM))), mCapacity(0), mCount(0), mDeletedCount(0),
+      mNodeLocks(new std::mutex[kLockStripes]), mEntryPoint(-1), mMaxLevel(-1), mRng(options.seed)
+{
+    allocate(capacity);
+}
+
+HnswIndex::~HnswIndex() = default;
+
+void HnswIndex::allocate(size_t capacity)
+{
+    mCapacity = capacity;
+    mVectors.assign(capacity * mStride, 0.0f);
+    mLinks0.assign(capacity * (1 + 2 * size_t(mM)), 0);
+    mUpperLinks.assign(capacity, {});
+    mLevels.assign(capacity, 0);
+    mLabels.assign(capacity, 0);
+    mDeleted.reset(new std::atomic<uint8_t>[capacity]);
+    for (size_t i = 0; i < capacity; ++i)
+        mDeleted[i].store(0, std::memory_order_relaxed);
+}
+
+uint32_t* HnswIndex::links(uint32_t node, int level)
+{
+    if (level == 0)
+        return mLinks0.data() + size_t(node) * (1 + 2 * size_t(mM));
+    return mUpperLinks[node].data() + size_t(level - 1) * (1 + mM);
+}
+
+const uint32_t* HnswIndex::links(uint32_t node, int level) const
+{
+    return const_cast<HnswIndex*>(this)->links(node, level);
+}
+
+float HnswIndex::score(const float* query, uint32_t node) const
+{
+    return math::dotProduct(query, vector(node), mDim);
+}
+
+int HnswIndex::drawLevel()
+{
+    std::lock_guard<std::mutex> lock(mRngMutex);
+    // 1 - u is in (0, 1], its log is finite.
+    const double u = 1.0 - std::uniform_real_distribution<double>(0.0, 1.0)(mRng);
+    return static_cast<int>(-log(u) * mLevelScale);
+}
+
+void HnswIndex::copyLinks(uint32_t node, int level, std::vector<uint32_t>& out) const
+{
+    std::lock_guard<std::mutex> lock(nodeLock(node));
+    const uint32_t* l = links(node, level);
+    out.assign(l + 1, l + 1 + l[0]);
+}
+
+uint32_t HnswIndex::greedyClosest(const float* query, uint32_t entry, int fromLevel, int toLevel) const
+{
+    uint32_t current = entry;
+    float best = score(query, current);
+    std::vector<uint32_t> neighbours;
+    for (int level = fromLevel; level >= toLevel; --level)
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            copyLinks(current, level, neighbours);
+            for (uint32_t n : neighbours)
+            {
+                const float s = score(query, n);
+                if (s > best)
+                {
+                    best = s;
+                    current = n;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return current;
+}
+
+std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const float* query, uint32_t entry, size_t ef, int level,
+                                                         bool liveOnly) const
+{
+    std::unique_ptr<VisitedList> visited = acquireVisited();
+    // `top` keeps the worst of the best `ef` on top, `frontier` the most
+    // promising node still to expand.
+    std::vector<Candidate> top, frontier;
+    const std::greater<Candidate> worstFirst;
+
+    const float entryScore = score(query, entry);
+    visited->visit(entry);
+    frontier.emplace_back(entryScore, entry);
+    if (!liveOnly || !isDeleted(entry))
+        top.emplace_back(entryScore, entry);
+    float bound = top.empty() ? -INFINITY : entryScore;
+
+    std::vector<uint32_t> neighbours;
+    while (!frontier.empty())
+    {
+        const Candidate current = frontier.front();
+        if (current.first < bound && top.size() >= ef)
+            break;
+        std::pop_heap(frontier.begin(), frontier.end());
+        frontier.pop_back();
+
+        copyLinks(current.second, level, neighbours);
+        for (uint32_t n : neighbours)
+        {
+            if (!visited->visit(n))
+                continue;
+            const float s = score(query, n);
+            if (top.size() < ef || s > bound)
+            {
+                frontier.emplace_back(s, n);
+                std::push_heap(frontier.begin(), frontier.end());
+                if (!liveOnly || !isDeleted(n))
+                {
+                    top.emplace_back(s, n);
+                    std::push_heap(top.begin(), top.end(), worstFirst);
+                    if (top.size() > ef)
+                    {
+                        std::pop_heap(top.begin(), top.end(), worstFirst);
+                        top.pop_back();
+                    }
+                }
+                if (!top.empty())
+                    bound = top.front().first;
+            }
+        }
+    }
+    releaseVisited(std::move(visited));
+    return top;
+}
+
+void HnswIndex::selectNeighbors(std::vector<Candidate>& candidates, size_t m) const
+{
+    std::sort(candidates.begin(), candidates.end(), std::greater<Candidate>());
+    if (candidates.size() <= m)
+        return;
+    std::vector<Candidate> kept;
+    kept.reserve(m);
+    for (const Candidate& c : candidates)
+    {
+        if (kept.size() >= m)
+            break;
+        bool diverse = true;
+        for (const Candidate& k : kept)
+        {
+            if (math::dotProduct(vector(c.second), vector(k.second), mDim) > c.first)
+            {
+                diverse = false;
+                break;
+            }
+        }
+        if (diverse)
+            kept.push_back(c);
+    }
+    candidates.swap(kept);
+}
+
+void HnswIndex::connect(uint32_t node, const std::vector<Candidate>& neighbours, int level)
+{
+    {
+        std::lock_guard<std::mutex> lock(nodeLock(node));
+        uint32_t* l = links(node, level);
+        l[0] = static_cast<uint32_t>(neighbours.size());
+        for (size_t i = 0; i < neighbours.size(); ++i)
+            l[1 + i] = neighbours[i].second;
+    }
+
+    const unsigned int limit = maxLinks(level);
+    std::vector<Candidate> candidates;
+    for (const Candidate& neighbour : neighbours)
+    {
+        const uint32_t n = neighbour.second;
+        std::lock_guard<std::mutex> lock(nodeLock(n));
+        uint32_t* l = links(n, level);
+        if (l[0] < limit)
+        {
+            l[1 + l[0]] = node;
+            ++l[0];
+            continue;
+        }
+        // Full: the neighbour keeps the most diverse of its links and the
+        // new node.
+        candidates.clear();
+        candidates.emplace_back(neighbour.first, node);
+        for (uint32_t i = 0; i < l[0]; ++i)
+            candidates.emplace_back(math::dotProduct(vector(n), vector(l[1 + i]), mDim), l[1 + i]);
+        selectNeighbors(candidates, limit);
+        l[0] = static_cast<uint32_t>(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i)
+            l[1 + i] = candidates[i].second;
+    }
+}
+
+std::unique_ptr<HnswIndex::VisitedList> HnswIndex::acquireVisited() const
+{
+    std::unique_ptr<VisitedList> list;
+    {
+        std::lock_guard<std::mutex> lock(mVisitedMutex);
+        if (!mVisitedPool.empty())
+        {
+            list = std::move(mVisitedPool.back());
+            mVisitedPool.pop_back();
+        }
+    }
+    if (!list)
+        list.reset(new VisitedList());
+    list->reset(mCapacity);
+    return list;
+}
+
+void HnswIndex::releaseVisited(std::unique_ptr<VisitedList> list) const
+{
+    std::lock_guard<std::mutex> lock(mVisitedMutex);
+    mVisitedPool.push_back(std::move(list));
+}
+
+Status HnswIndex::add(uint64_t label, const float* embedding)
+{
+    std::vector<float> query(mDim);
+    if (!normalizeInto(embedding, mDim, query.data()))
+        return Status(StatusCode::kInvalidArgument, "embedding has zero norm");
+
+    uint32_t node;
+    {
+        std::lock_guard<std::mutex> lock(mLabelMutex);
+        if (mLabelToNode.count(label) != 0)
+            return Status(StatusCode::kAlreadyExists, "label is already in the index");
+        const size_t count = mCount.load(std::memory_order_relaxed);
+        if (count >= mCapacity)
+            return Status(StatusCode::kResourceExhausted, "index is full");
+        node = static_cast<uint32_t>(count);
+        mLabelToNode.emplace(label, node);
+        mCount.store(count + 1, std::memory_order_release);
+    }
+
+    // The node is invisible until linked, its data needs no lock.
+    const int level = drawLevel();
+    std::copy(query.begin(), query.end(), mVectors.begin() + size_t(node) * mStride);
+    mLabels[node] = label;
+    mLevels[node] = level;
+    if (level > 0)
+        mUpperLinks[node].assign(size_t(level) * (1 + mM), 0);
+
+    std::unique_lock<std::mutex> entryLock(mEntryMutex);
+    const int64_t entry = mEntryPoint;
+    const int maxLevel = mMaxLevel;
+    if (entry < 0)
+    {
+        mEntryPoint = node;
+        mMaxLevel = level;
+        return okStatus();
+    }
+    // A node raising the top level holds the entry point until it is linked,
+    // so no other node can take its place half way.
+    if (level <= maxLevel)
+        entryLock.unlock();
+
+    uint32_t current = static_cast<uint32_t>(entry);
+    if (level < maxLevel)
+        current = greedyClosest(query.data(), current, maxLevel, level + 1);
+    for (int l = std::min(level, maxLevel); l >= 0; --l)
+    {
+        std::vector<Candidate> candidates = searchLayer(query.data(), current, mEfConstruction, l, false);
+        selectNeighbors(candidates, mM);
+        current = candidates.front().second;
+        connect(node, candidates, l);
+    }
+
+    if (level > maxLevel)
+    {
+        mEntryPoint = node;
+        mMaxLevel = level;
+    }
+    return okStatus();
+}
+
+Status HnswIndex::remove(uint64_t label)
+{
+    std::lock_guard<std::mutex> lock(mLabelMutex);
+    auto it = mLabelToNode.find(label);
+    if (it == mLabelToNode.end())
+        return Status(StatusCode::kNotFound, "label is not in the index");
+    mDeleted[it->second].store(1, std::memory_order_release);
+    mLabelToNode.erase(it);
+    mDeletedCount.fetch_add(1, std::memory_order_relaxed);
+    return okStatus();
+}
+
+Status HnswIndex::search(const float* query, size_t k, std::vector<IndexMatch>& matches) const
+{
+    return search(query, k, efSearch(), matches);
+}
+
+Status HnswIndex::search(const float* query, size_t k, unsigned int ef, std::vector<IndexMatch>& matches) const
+{
+    matches.clear();
+    std::vector<float> normalized(mDim);
+    if (!normalizeInto(query, mDim, normalized.data()))
+        return Status(StatusCode::kInvalidArgument, "query has zero norm");
+
+    int64_t entry;
+    int maxLevel;
+    {
+        std::lock_guard<std::mutex> lock(mEntryMutex);
+        entry = mEntryPoint;
+        maxLevel = mMaxLevel;
+    }
+    if (entry < 0 || k == 0)
+        return okStatus();
+
+    const uint32_t start = greedyClosest(normalized.data(), static_cast<uint32_t>(entry), maxLevel, 1);
+    std::vector<Candidate> top = searchLayer(normalized.data(), start, std::max<size_t>(ef, k), 0, true);
+    std::sort(top.begin(), top.end(), std::greater<Candidate>());
+    if (top.size() > k)
+        top.resize(k);
+    matches.reserve(top.size());
+    for (const Candidate& c : top)
+        matches.push_back({mLabels[c.second], c.first});
+    return okStatus();
+}
+
+Status HnswIndex::save(const std::string& path) const
+{
+#if defined(_WIN32)
+    (void)path;
+    return Status(StatusCode::kUnimplemented, "index files need POSIX file I/O");
+#else
+    hnsw::FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kVersion;
+    header.dim = mDim;
+    header.M = mM;
+    header.efConstruction = mEfConstruction;
+    {
+        std::lock_guard<std::mutex> lock(mEntryMutex);
+        header.entryPoint = mEntryPoint;
+        header.maxLevel = mMaxLevel;
+    }
+    const uint64_t count = mCount.load(std::memory_order_acquire);
+    header.count = count;
+    header.stride = mStride;
+    const uint64_t linksPerNode = 1 + 2 * uint64_t(mM);
+    header.vectorsOffset = alignUp(sizeof(header), hnsw::kSectionAlignment);
+    header.linksOffset = alignUp(header.vectorsOffset + count * mStride * sizeof(float), hnsw::kSectionAlignment);
+    header.labelsOffset = alignUp(header.linksOffset + count * linksPerNode * 4, hnsw::kSectionAlignment);
+    header.levelsOffset = alignUp(header.labelsOffset + count * 8, hnsw::kSectionAlignment);
+    header.deletedOffset = alignUp(header.levelsOffset + count * 4, hnsw::kSectionAlignment);
+    header.upperOffset = alignUp(header.deletedOffset + count, hnsw::kSectionAlignment);
+
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return Status(StatusCode::kPermissionDenied, "cannot create the index file");
+
+    std::vector<uint8_t> deleted(count);
+    for (uint64_t i = 0; i < count; ++i)
+        deleted[i] = mDeleted[i].load(std::memory_order_acquire);
+    uint64_t position = sizeof(header);
+    bool ok = writeAll(fd, &header, sizeof(header));
+    ok = ok && padTo(fd, position, header.vectorsOffset) &&
+         writeAll(fd, mVectors.data(), count * mStride * sizeof(float));
+    position += count * mStride * sizeof(float);
+    ok = ok && padTo(fd, position, header.linksOffset) && writeAll(fd, mLinks0.data(), count * linksPerNode * 4);
+    position += count * linksPerNode * 4;
+    ok = ok && padTo(fd, position, header.labelsOffset) && writeAll(fd, mLabels.data(), count * 8);
+    position += count * 8;
+    ok = ok && padTo(fd, position, header.levelsOffset) && writeAll(fd, mLevels.data(), count * 4);
+    position += count * 4;
+    ok = ok && padTo(fd, position, header.deletedOffset) && writeAll(fd, deleted.data(), count);
+    position += count;
+    ok = ok && padTo(fd, position, header.upperOffset);
+    for (uint64_t i = 0; ok && i < count; ++i)
+        ok = writeAll(fd, mUpperLinks[i].data(), mUpperLinks[i].size() * 4);
+    ok = ::close(fd) == 0 && ok;
+    return ok ? okStatus() : Status(StatusCode::kDataLoss, "writing the index file failed");
+#endif
+}
+
+Status HnswIndex::load(const std::string& path, size_t capacity)
+{
+#if defined(_WIN32)
+    (void)path;
+    (void)capacity;
+    return Status(StatusCode::kUnimplemented, "index files need POSIX file I/O");
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return Status(StatusCode::kNotFound, "cannot open the index file");
+    // A file refused before anything is read into the index still leaves it
+    // empty, as after a failure further on.
+    auto corrupt = [this, fd](const char* message)
+    {
+        ::close(fd);
+        mLabelToNode.clear();
+        mCount.store(0, std::memory_order_release);
+        mDeletedCount.store(0, std::memory_order_relaxed);
+        mEntryPoint = -1;
+        mMaxLevel = -1;
+        return Status(StatusCode::kDataLoss, message);
+    };
+    struct stat st;
+    hnsw::FileHeader header;
+    if (::fstat(fd, &st) != 0 || !readAt(fd, 0, &header, sizeof(header)) ||
+        std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 || header.version != kVersion)
+        return corrupt("not an HNSW index file");
+
+    // Every size below is checked against the file before anything is read or
+    // allocated, so a corrupt or hostile file fails here instead of sending a
+    // search out of bounds.
+    const uint64_t fileSize = uint64_t(st.st_size);
+    const uint64_t count = header.count;
+    // Whether `items` elements of `size` bytes from `offset` on lie in the file.
+    auto fits = [fileSize](uint64_t offset, uint64_t items, uint64_t size)
+    { return offset <= fileSize && (items == 0 || (fileSize - offset) / items >= size); };
+    const bool shapeOk = header.dim > 0 && header.M >= 2 && header.M <= kMaxFileM && header.stride >= header.dim &&
+                         header.stride <= fileSize / sizeof(float) && header.maxLevel <= kMaxFileLevel &&
+                         count <= std::numeric_limits<uint32_t>::max();
+    const uint64_t linksPerNode = 1 + 2 * uint64_t(header.M);
+    const bool entryOk = count == 0 ? header.entryPoint < 0
+                                    : header.entryPoint >= 0 && uint64_t(header.entryPoint) < count &&
+                                          header.maxLevel >= 0;
+    if (!shapeOk || !entryOk || !fits(header.vectorsOffset, count, header.stride * sizeof(float)) ||
+        !fits(header.linksOffset, count, linksPerNode * 4) || !fits(header.labelsOffset, count, 8) ||
+        !fits(header.levelsOffset, count, 4) || !fits(header.deletedOffset, count, 1) ||
+        header.upperOffset > fileSize)
+        return corrupt("index file header is corrupt");
+
+    // Levels first: they size the upper links, which must fit what is left.
+    std::vector<int> levels(count);
+    bool ok = readAt(fd, header.levelsOffset, levels.data(), count * 4);
+    uint64_t upperBytes = 0;
+    for (uint64_t i = 0; ok && i < count; ++i)
+    {
+        ok = levels[i] >= 0 && levels[i] <= header.maxLevel;
+        upperBytes += uint64_t(std::max(levels[i], 0)) * (1 + header.M) * 4;
+    }
+    if (!ok || upperBytes > fileSize - header.upperOffset ||
+        (count > 0 && levels[size_t(header.entryPoint)] != header.maxLevel))
+        return corrupt("index file levels are corrupt");
+
+    mDim = header.dim;
+    mStride = header.stride;
+    mM = header.M;
+    mEfConstruction = header.efConstruction;
+    mLevelScale = 1.0 / log(double(mM));
+    allocate(std::max<size_t>(count, capacity));
+    std::copy(levels.begin(), levels.end(), mLevels.begin());
+
+    std::vector<uint8_t> deleted(count);
+    ok = readAt(fd, header.vectorsOffset, mVectors.data(), count * mStride * sizeof(float)) &&
+         readAt(fd, header.linksOffset, mLinks0.data(), count * linksPerNode * 4) &&
+         readAt(fd, header.labelsOffset, mLabels.data(), count * 8) &&
+         readAt(fd, header.deletedOffset, deleted.data(), count);
+    uint64_t offset = header.upperOffset;
+    for (uint64_t i = 0; ok && i < count; ++i)
+    {
+        if (mLevels[i] <= 0)
+            continue;
+        mUpperLinks[i].resize(size_t(mLevels[i]) * (1 + mM));
+        ok = readAt(fd, offset, mUpperLinks[i].data(), mUpperLinks[i].size() * 4);
+        offset += mUpperLinks[i].size() * 4;
+    }
+    ::close(fd);
+
+    // Every link list within its bound, to nodes that exist at that level.
+    for (uint64_t i = 0; ok && i < count; ++i)
+    {
+        for (int level = 0; ok && level <= mLevels[i]; ++level)
+        {
+            const uint32_t* l = links(static_cast<uint32_t>(i), level);
+            ok = l[0] <= maxLinks(level);
+            for (uint32_t j = 1; ok && j <= l[0]; ++j)
+                ok = l[j] < count && mLevels[l[j]] >= level;
+        }
+    }
+
+    mLabelToNode.clear();
+    size_t deletedCount = 0;
+    for (uint64_t i = 0; ok && i < count; ++i)
+    {
+        mDeleted[i].store(deleted[i], std::memory_order_relaxed);
+        if (deleted[i])
+            ++deletedCount;
+        else
+            mLabelToNode.emplace(mLabels[i], static_cast<uint32_t>(i));
+    }
+    mCount.store(ok ? count : 0, std::memory_order_release);
+    mDeletedCount.store(ok ? deletedCount : 0, std::memory_order_relaxed);
+    mEntryPoint = ok ? header.entryPoint : -1;
+    mMaxLevel = ok ? header.maxLevel : -1;
+    if (!ok)
+    {
+        mLabelToNode.clear();
+        return Status(StatusCode::kDataLoss, "index file is truncated or corrupt");
+    }
+    return okStatus();
+#endif
+}
+} // namespace yuzu
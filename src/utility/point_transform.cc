@@ -0,0 +1,202 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "pillar/utility/point_transform.h"
+#include "pillar/utility/vector_batch.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace math
+{
+namespace
+{
+// Points are read as interleaved floats, x0 y0 x1 y1 ...; `m` is the
+// row-major matrix.
+using HomographyKernel = void (*)(const float* m, const float* in, float* out, size_t count);
+
+void homographyScalar(const float* m, const float* in, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float x = in[2 * i], y = in[2 * i + 1];
+        const float w = m[6] * x + m[7] * y + m[8];
+        out[2 * i] = (m[0] * x + m[1] * y + m[2]) / w;
+        out[2 * i + 1] = (m[3] * x + m[4] * y + m[5]) / w;
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+// With v = (x, y) pairs and s the pairs swapped, (y, x), each output lane is
+// a * v + b * s + c for per-lane coefficients: x' takes (m0, m1, m2) and y'
+// takes (m4, m3, m5), then both are divided by w.
+PILLAR_TARGET_AVX2 inline __m256 pairs256(float forX, float forY)
+{
+    return _mm256_setr_ps(forX, forY, forX, forY, forX, forY, forX, forY);
+}
+
+// The divisor w = m6 x + m7 y + m8 goes to both lanes of a pair.
+PILLAR_TARGET_AVX2 void homographyAvx2(const float* m, const float* in, float* out, size_t count)
+{
+    const __m256 a = pairs256(m[0], m[4]), b = pairs256(m[1], m[3]), c = pairs256(m[2], m[5]);
+    const __m256 d = pairs256(m[6], m[7]), e = pairs256(m[7], m[6]), f = _mm256_set1_ps(m[8]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256 v = _mm256_loadu_ps(in + 2 * i);
+        const __m256 s = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+        const __m256 w = _mm256_fmadd_ps(d, v, _mm256_fmadd_ps(e, s, f));
+        _mm256_storeu_ps(out + 2 * i, _mm256_div_ps(_mm256_fmadd_ps(a, v, _mm256_fmadd_ps(b, s, c)), w));
+    }
+    homographyScalar(m, in + 2 * i, out + 2 * i, count - i);
+}
+
+PILLAR_TARGET_AVX512 inline __m512 pairs512(float forX, float forY)
+{
+    return _mm512_setr4_ps(forX, forY, forX, forY);
+}
+
+// Eight points per step, one masked step covers the tail.
+PILLAR_TARGET_AVX512 inline __mmask16 pointMask(size_t left)
+{
+    return left >= 8 ? __mmask16(0xffff) : __mmask16((1u << (2 * left)) - 1);
+}
+
+PILLAR_TARGET_AVX512 void homographyAvx512(const float* m, const float* in, float* out, size_t count)
+{
+    const __m512 a = pairs512(m[0], m[4]), b = pairs512(m[1], m[3]), c = pairs512(m[2], m[5]);
+    const __m512 d = pairs512(m[6], m[7]), e = pairs512(m[7], m[6]), f = _mm512_set1_ps(m[8]);
+    for (size_t i = 0; i < count; i += 8)
+    {
+        const __mmask16 mask = pointMask(count - i);
+        const __m512 v = _mm512_maskz_loadu_ps(mask, in + 2 * i);
+        const __m512 s = _mm512_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+        const __m512 w = _mm512_fmadd_ps(d, v, _mm512_fmadd_ps(e, s, f));
+        _mm512_mask_storeu_ps(out + 2 * i, mask,
+                              _mm512_div_ps(_mm512_fmadd_ps(a, v, _mm512_fmadd_ps(b, s, c)), w));
+    }
+}
+#endif // PILLAR_ARCH_X86
+
+HomographyKernel selectHomographyKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return homographyAvx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return homographyAvx2;
+    }
+#endif
+    (void)level;
+    return homographyScalar;
+}
+
+// Point2<float> is two floats, an array of them is the interleaved layout.
+static_assert(sizeof(Point2<float>) == 2 * sizeof(float), "Point2<float> must be two packed floats");
+
+const float* coordinates(const Point2<float>* points) { return reinterpret_cast<const float*>(points); }
+float* coordinates(Point2<float>* points) { return reinterpret_cast<float*>(points); }
+
+// Runs a kernel over coordinate columns, vector_batch.h style, on blocks of
+// points split into columns on the stack and interleaved again after.
+template <class Kernel>
+void transformColumns(const Point2<float>* in, Point2<float>* out, size_t count, Kernel kernel)
+{
+    constexpr size_t kBlock = 256;
+    float x[kBlock], y[kBlock], outX[kBlock], outY[kBlock];
+    for (size_t first = 0; first < count; first += kBlock)
+    {
+        const size_t n = std::min(kBlock, count - first);
+        const float* src = coordinates(in) + 2 * first;
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = src[2 * i];
+            y[i] = src[2 * i + 1];
+        }
+        kernel(x, y, outX, outY, n);
+        float* dst = coordinates(out) + 2 * first;
+        for (size_t i = 0; i < n; ++i)
+        {
+            dst[2 * i] = outX[i];
+            dst[2 * i + 1] = outY[i];
+        }
+    }
+}
+} // namespace
+
+Status estimateSimilarity(const Point2<float>* src, const Point2<float>* dst, size_t count,
+                          Matrix2x3<float>& transform)
+{
+    if (count < 2)
+    {
+        return Status(StatusCode::kInvalidArgument, "at least two points are needed");
+    }
+
+    double srcX = 0.0, srcY = 0.0, dstX = 0.0, dstY = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        srcX += src[i].x(), srcY += src[i].y();
+        dstX += dst[i].x(), dstY += dst[i].y();
+    }
+    srcX /= count, srcY /= count, dstX /= count, dstY /= count;
+
+    // In 2D the SVD of the covariance has a closed form: with centered points
+    // p and q, the rotation angle is atan2(sum p x q, sum p . q) and the scale
+    // the length of that pair over the source variance.
+    double variance = 0.0, dot = 0.0, cross = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double px = src[i].x() - srcX, py = src[i].y() - srcY;
+        const double qx = dst[i].x() - dstX, qy = dst[i].y() - dstY;
+        variance += px * px + py * py;
+        dot += px * qx + py * qy;
+        cross += px * qy - py * qx;
+    }
+    if (!(variance > 0.0))
+    {
+        return Status(StatusCode::kInvalidArgument, "the source points coincide");
+    }
+
+    const double a = dot / variance, b = cross / variance;
+    transform = Matrix2x3<float>(float(a), float(-b), float(dstX - (a * srcX - b * srcY)), //
+                                 float(b), float(a), float(dstY - (b * srcX + a * srcY)));
+    return okStatus();
+}
+
+void transformPoints(const Matrix2x3<float>& transform, const Point2<float>* in, Point2<float>* out, size_t count)
+{
+    transformColumns(in, out, count,
+                     [&](const float* x, const float* y, float* outX, float* outY, size_t n)
+                     { transformPoints(transform.data(), x, y, outX, outY, n); });
+}
+
+void transformPoints(const Matrix2x3<float>& transform, const Point2<float>* in, Point2<float>* out, size_t count,
+                     cpu::SimdLevel maxLevel)
+{
+    transformColumns(in, out, count,
+                     [&](const float* x, const float* y, float* outX, float* outY, size_t n)
+                     { transformPoints(transform.data(), x, y, outX, outY, n, maxLevel); });
+}
+
+void transformPoints(const Matrix3x3<float>& homography, const Point2<float>* in, Point2<float>* out, size_t count)
+{
+    // Picked once, the CPU does not change under us.
+    static const HomographyKernel kernel = selectHomographyKernel(cpu::simdLevel());
+    kernel(homography.data(), coordinates(in), coordinates(out), count);
+}
+
+void transformPoints(const Matrix3x3<float>& homography, const Point2<float>* in, Point2<float>* out, size_t count,
+                     cpu::SimdLevel maxLevel)
+{
+    selectHomographyKernel(std::min(maxLevel, cpu::simdLevel()))(homography.data(), coordinates(in),
+                                                                 coordinates(out), count);
+}
+} // namespace math
+} // namespace yuzu
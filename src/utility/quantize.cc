@@ -0,0 +1,276 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "pillar/utility/half.h"
+#include "pillar/utility/quantize.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace math
+{
+namespace
+{
+using Int8Kernel = int32_t (*)(const int8_t* A, const int8_t* B, unsigned int len);
+using HalfKernel = float (*)(const float* A, const uint16_t* B, unsigned int len);
+
+int32_t dotInt8Scalar(const int8_t* A, const int8_t* B, unsigned int len)
+{
+    int32_t sum = 0;
+    for (unsigned int i = 0; i < len; ++i)
+        sum += int32_t(A[i]) * B[i];
+    return sum;
+}
+
+float dotHalfScalar(const float* A, const uint16_t* B, unsigned int len)
+{
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < len; ++i)
+        sum += A[i] * halfToFloat(B[i]);
+    return sum;
+}
+
+#if defined(PILLAR_ARCH_X86)
+PILLAR_TARGET_AVX2 inline int32_t hsumEpi32(__m256i v)
+{
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(x);
+}
+
+PILLAR_TARGET_AVX2 inline float hsum256(__m256 v)
+{
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+}
+
+// The multiply-add instructions take one unsigned and one signed operand, so
+// |a| is paired with b carrying the sign of a. With values in [-127, 127] a
+// pmaddubsw pair sums to at most 32258 and never saturates.
+PILLAR_TARGET_AVX2 inline __m256i stepInt8Avx2(__m256i acc, __m256i a, __m256i b)
+{
+    const __m256i pairs = _mm256_maddubs_epi16(_mm256_abs_epi8(a), _mm256_sign_epi8(b, a));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+
+PILLAR_TARGET_AVX2 int32_t dotInt8Avx2(const int8_t* A, const int8_t* B, unsigned int len)
+{
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    unsigned int i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        acc0 = stepInt8Avx2(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i)),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i)));
+        acc1 = stepInt8Avx2(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i + 32)),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i + 32)));
+    }
+    if (i + 32 <= len)
+    {
+        acc0 = stepInt8Avx2(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i)),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i)));
+        i += 32;
+    }
+    int32_t sum = hsumEpi32(_mm256_add_epi32(acc0, acc1));
+    for (; i < len; ++i)
+        sum += int32_t(A[i]) * B[i];
+    return sum;
+}
+
+PILLAR_TARGET_AVXVNNI inline __m256i stepInt8AvxVnni(__m256i acc, __m256i a, __m256i b)
+{
+    return _mm256_dpbusd_avx_epi32(acc, _mm256_abs_epi8(a), _mm256_sign_epi8(b, a));
+}
+
+PILLAR_TARGET_AVXVNNI int32_t dotInt8AvxVnni(const int8_t* A, const int8_t* B, unsigned int len)
+{
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    unsigned int i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        acc0 = stepInt8AvxVnni(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i)),
+                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i)));
+        acc1 = stepInt8AvxVnni(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i + 32)),
+                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i + 32)));
+    }
+    if (i + 32 <= len)
+    {
+        acc0 = stepInt8AvxVnni(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i)),
+                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i)));
+        i += 32;
+    }
+    int32_t sum = hsumEpi32(_mm256_add_epi32(acc0, acc1));
+    for (; i < len; ++i)
+        sum += int32_t(A[i]) * B[i];
+    return sum;
+}
+
+// AVX-512 has no vpsignb, b is negated under the sign mask of a instead.
+PILLAR_TARGET_AVX512 inline __m512i signOf(__m512i b, __m512i a)
+{
+    return _mm512_mask_sub_epi8(b, _mm512_movepi8_mask(a), _mm512_setzero_si512(), b);
+}
+
+PILLAR_TARGET_AVX512 int32_t dotInt8Avx512(const int8_t* A, const int8_t* B, unsigned int len)
+{
+    const __m512i ones = _mm512_set1_epi16(1);
+    __m512i acc = _mm512_setzero_si512();
+    for (unsigned int i = 0; i < len; i += 64)
+    {
+        const unsigned int left = len - i;
+        const __mmask64 mask = left >= 64 ? ~__mmask64(0) : (__mmask64(1) << left) - 1;
+        const __m512i a = _mm512_maskz_loadu_epi8(mask, A + i), b = _mm512_maskz_loadu_epi8(mask, B + i);
+        const __m512i pairs = _mm512_maddubs_epi16(_mm512_abs_epi8(a), signOf(b, a));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(pairs, ones));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+PILLAR_TARGET_AVX512VNNI int32_t dotInt8Avx512Vnni(const int8_t* A, const int8_t* B, unsigned int len)
+{
+    __m512i acc = _mm512_setzero_si512();
+    for (unsigned int i = 0; i < len; i += 64)
+    {
+        const unsigned int left = len - i;
+        const __mmask64 mask = left >= 64 ? ~__mmask64(0) : (__mmask64(1) << left) - 1;
+        const __m512i a = _mm512_maskz_loadu_epi8(mask, A + i), b = _mm512_maskz_loadu_epi8(mask, B + i);
+        acc = _mm512_dpbusd_epi32(acc, _mm512_abs_epi8(a), signOf(b, a));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+PILLAR_TARGET_AVX2 float dotHalfAvx2(const float* A, const uint16_t* B, unsigned int len)
+{
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m256 b0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(B + i)));
+        const __m256 b1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(B + i + 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i), b0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i + 8), b1, acc1);
+    }
+    float sum = hsum256(_mm256_add_ps(acc0, acc1));
+    for (; i < len; ++i)
+        sum += A[i] * halfToFloat(B[i]);
+    return sum;
+}
+
+PILLAR_TARGET_AVX512 float dotHalfAvx512(const float* A, const uint16_t* B, unsigned int len)
+{
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m512 b0 = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i)));
+        const __m512 b1 = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + i + 16)));
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(A + i), b0, acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(A + i + 16), b1, acc1);
+    }
+    for (; i < len; i += 16)
+    {
+        const unsigned int left = len - i;
+        const __mmask16 mask = left >= 16 ? __mmask16(0xffff) : __mmask16((1u << left) - 1);
+        const __m512 b0 = _mm512_cvtph_ps(_mm256_maskz_loadu_epi16(mask, B + i));
+        acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, A + i), b0, acc0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+#endif // PILLAR_ARCH_X86
+
+Int8Kernel selectInt8Kernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return cpu::features().avx512vnni ? dotInt8Avx512Vnni : dotInt8Avx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return cpu::features().avxvnni ? dotInt8AvxVnni : dotInt8Avx2;
+    }
+#endif
+    (void)level;
+    return dotInt8Scalar;
+}
+
+HalfKernel selectHalfKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return dotHalfAvx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return dotHalfAvx2;
+    }
+#endif
+    (void)level;
+    return dotHalfScalar;
+}
+} // namespace
+
+float quantizeInt8(const float* src, unsigned int len, int8_t* dst)
+{
+    float maxAbs = 0.0f;
+    for (unsigned int i = 0; i < len; ++i)
+        maxAbs = std::max(maxAbs, fabsf(src[i]));
+    if (!(maxAbs > 0.0f))
+    {
+        std::fill(dst, dst + len, int8_t(0));
+        return 0.0f;
+    }
+    const float inv = 127.0f / maxAbs;
+    for (unsigned int i = 0; i < len; ++i)
+        dst[i] = static_cast<int8_t>(std::min(127.0f, std::max(-127.0f, rintf(src[i] * inv))));
+    return maxAbs / 127.0f;
+}
+
+void dequantizeInt8(const int8_t* src, unsigned int len, float scale, float* dst)
+{
+    for (unsigned int i = 0; i < len; ++i)
+        dst[i] = src[i] * scale;
+}
+
+void quantizeHalf(const float* src, unsigned int len, uint16_t* dst)
+{
+    for (unsigned int i = 0; i < len; ++i)
+        dst[i] = floatToHalf(src[i]);
+}
+
+void dequantizeHalf(const uint16_t* src, unsigned int len, float* dst)
+{
+    for (unsigned int i = 0; i < len; ++i)
+        dst[i] = halfToFloat(src[i]);
+}
+
+int32_t dotProduct(const int8_t* A, const int8_t* B, unsigned int len)
+{
+    static const Int8Kernel kernel = selectInt8Kernel(cpu::simdLevel());
+    return kernel(A, B, len);
+}
+
+int32_t dotProduct(const int8_t* A, const int8_t* B, unsigned int len, cpu::SimdLevel maxLevel)
+{
+    return selectInt8Kernel(std::min(maxLevel, cpu::simdLevel()))(A, B, len);
+}
+
+float dotProduct(const float* A, const uint16_t* B, unsigned int len)
+{
+    static const HalfKernel kernel = selectHalfKernel(cpu::simdLevel());
+    return kernel(A, B, len);
+}
+
+float dotProduct(const float* A, const uint16_t* B, unsigned int len, cpu::SimdLevel maxLevel)
+{
+    return selectHalfKernel(std::min(maxLevel, cpu::simdLevel()))(A, B, len);
+}
+} // namespace math
+} // namespace yuzu
@@ -1,12 +1,24 @@
 #include <math.h>
 
+#include <algorithm>
+
 #include "pillar/utility/similarity.h"
 
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
 namespace yuzu
 {
 namespace math
 {
-float cosineSimilarity(const float* A, const float* B, unsigned int len)
+namespace
+{
+using CosineKernel = float (*)(const float* A, const float* B, unsigned int len);
+using DotKernel = float (*)(const float* A, const float* B, unsigned int len);
+
+// Double accumulators, the reference numerics.
+float cosineScalar(const float* A, const float* B, unsigned int len)
 {
     double dot = 0.0, denomA = 0.0, denomB = 0.0;
     for (unsigned int i = 0u; i < len; ++i)
@@ -17,5 +29,230 @@ float cosineSimilarity(const float* A, const float* B, unsigned int len)
     }
     return dot / (sqrt(denomA * denomB));
 }
+
+float dotScalar(const float* A, const float* B, unsigned int len)
+{
+    float dot = 0.0f;
+    for (unsigned int i = 0u; i < len; ++i)
+        dot += A[i] * B[i];
+    return dot;
+}
+
+// The SIMD kernels sum in float over several independent accumulators and
+// only combine the three sums in double.
+inline float combine(float dot, float denomA, float denomB)
+{
+    return static_cast<float>(double(dot) / sqrt(double(denomA) * double(denomB)));
+}
+
+#if defined(PILLAR_ARCH_X86)
+PILLAR_TARGET_SSE41 inline float hsum128(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+PILLAR_TARGET_AVX2 inline float hsum256(__m256 v)
+{
+    return hsum128(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+// Only needs SSE2, dispatched with the SSE4.1 level.
+PILLAR_TARGET_SSE41 float cosineSse(const float* A, const float* B, unsigned int len)
+{
+    __m128 dot0 = _mm_setzero_ps(), dot1 = _mm_setzero_ps();
+    __m128 aa0 = _mm_setzero_ps(), aa1 = _mm_setzero_ps();
+    __m128 bb0 = _mm_setzero_ps(), bb1 = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m128 a0 = _mm_loadu_ps(A + i), a1 = _mm_loadu_ps(A + i + 4);
+        const __m128 b0 = _mm_loadu_ps(B + i), b1 = _mm_loadu_ps(B + i + 4);
+        dot0 = _mm_add_ps(dot0, _mm_mul_ps(a0, b0));
+        dot1 = _mm_add_ps(dot1, _mm_mul_ps(a1, b1));
+        aa0 = _mm_add_ps(aa0, _mm_mul_ps(a0, a0));
+        aa1 = _mm_add_ps(aa1, _mm_mul_ps(a1, a1));
+        bb0 = _mm_add_ps(bb0, _mm_mul_ps(b0, b0));
+        bb1 = _mm_add_ps(bb1, _mm_mul_ps(b1, b1));
+    }
+    float dot = hsum128(_mm_add_ps(dot0, dot1));
+    float denomA = hsum128(_mm_add_ps(aa0, aa1));
+    float denomB = hsum128(_mm_add_ps(bb0, bb1));
+    for (; i < len; ++i)
+    {
+        dot += A[i] * B[i];
+        denomA += A[i] * A[i];
+        denomB += B[i] * B[i];
+    }
+    return combine(dot, denomA, denomB);
+}
+
+PILLAR_TARGET_AVX2 float cosineAvx2(const float* A, const float* B, unsigned int len)
+{
+    __m256 dot0 = _mm256_setzero_ps(), dot1 = _mm256_setzero_ps();
+    __m256 aa0 = _mm256_setzero_ps(), aa1 = _mm256_setzero_ps();
+    __m256 bb0 = _mm256_setzero_ps(), bb1 = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m256 a0 = _mm256_loadu_ps(A + i), a1 = _mm256_loadu_ps(A + i + 8);
+        const __m256 b0 = _mm256_loadu_ps(B + i), b1 = _mm256_loadu_ps(B + i + 8);
+        dot0 = _mm256_fmadd_ps(a0, b0, dot0);
+        dot1 = _mm256_fmadd_ps(a1, b1, dot1);
+        aa0 = _mm256_fmadd_ps(a0, a0, aa0);
+        aa1 = _mm256_fmadd_ps(a1, a1, aa1);
+        bb0 = _mm256_fmadd_ps(b0, b0, bb0);
+        bb1 = _mm256_fmadd_ps(b1, b1, bb1);
+    }
+    if (i + 8 <= len)
+    {
+        const __m256 a0 = _mm256_loadu_ps(A + i), b0 = _mm256_loadu_ps(B + i);
+        dot0 = _mm256_fmadd_ps(a0, b0, dot0);
+        aa0 = _mm256_fmadd_ps(a0, a0, aa0);
+        bb0 = _mm256_fmadd_ps(b0, b0, bb0);
+        i += 8;
+    }
+    float dot = hsum256(_mm256_add_ps(dot0, dot1));
+    float denomA = hsum256(_mm256_add_ps(aa0, aa1));
+    float denomB = hsum256(_mm256_add_ps(bb0, bb1));
+    for (; i < len; ++i)
+    {
+        dot += A[i] * B[i];
+        denomA += A[i] * A[i];
+        denomB += B[i] * B[i];
+    }
+    return combine(dot, denomA, denomB);
+}
+
+PILLAR_TARGET_AVX512 float cosineAvx512(const float* A, const float* B, unsigned int len)
+{
+    __m512 dot0 = _mm512_setzero_ps(), dot1 = _mm512_setzero_ps();
+    __m512 aa0 = _mm512_setzero_ps(), aa1 = _mm512_setzero_ps();
+    __m512 bb0 = _mm512_setzero_ps(), bb1 = _mm512_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m512 a0 = _mm512_loadu_ps(A + i), a1 = _mm512_loadu_ps(A + i + 16);
+        const __m512 b0 = _mm512_loadu_ps(B + i), b1 = _mm512_loadu_ps(B + i + 16);
+        dot0 = _mm512_fmadd_ps(a0, b0, dot0);
+        dot1 = _mm512_fmadd_ps(a1, b1, dot1);
+        aa0 = _mm512_fmadd_ps(a0, a0, aa0);
+        aa1 = _mm512_fmadd_ps(a1, a1, aa1);
+        bb0 = _mm512_fmadd_ps(b0, b0, bb0);
+        bb1 = _mm512_fmadd_ps(b1, b1, bb1);
+    }
+    // Up to two masked steps cover the rest.
+    for (; i < len; i += 16)
+    {
+        const unsigned int left = len - i;
+        const __mmask16 mask = left >= 16 ? __mmask16(0xffff) : __mmask16((1u << left) - 1);
+        const __m512 a0 = _mm512_maskz_loadu_ps(mask, A + i), b0 = _mm512_maskz_loadu_ps(mask, B + i);
+        dot0 = _mm512_fmadd_ps(a0, b0, dot0);
+        aa0 = _mm512_fmadd_ps(a0, a0, aa0);
+        bb0 = _mm512_fmadd_ps(b0, b0, bb0);
+    }
+    return combine(_mm512_reduce_add_ps(_mm512_add_ps(dot0, dot1)), _mm512_reduce_add_ps(_mm512_add_ps(aa0, aa1)),
+                   _mm512_reduce_add_ps(_mm512_add_ps(bb0, bb1)));
+}
+
+PILLAR_TARGET_AVX2 float dotAvx2(const float* A, const float* B, unsigned int len)
+{
+    __m256 dot0 = _mm256_setzero_ps(), dot1 = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        dot0 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i), dot0);
+        dot1 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i + 8), _mm256_loadu_ps(B + i + 8), dot1);
+    }
+    if (i + 8 <= len)
+    {
+        dot0 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i), dot0);
+        i += 8;
+    }
+    float dot = hsum256(_mm256_add_ps(dot0, dot1));
+    for (; i < len; ++i)
+        dot += A[i] * B[i];
+    return dot;
+}
+
+PILLAR_TARGET_AVX512 float dotAvx512(const float* A, const float* B, unsigned int len)
+{
+    __m512 dot0 = _mm512_setzero_ps(), dot1 = _mm512_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        dot0 = _mm512_fmadd_ps(_mm512_loadu_ps(A + i), _mm512_loadu_ps(B + i), dot0);
+        dot1 = _mm512_fmadd_ps(_mm512_loadu_ps(A + i + 16), _mm512_loadu_ps(B + i + 16), dot1);
+    }
+    for (; i < len; i += 16)
+    {
+        const unsigned int left = len - i;
+        const __mmask16 mask = left >= 16 ? __mmask16(0xffff) : __mmask16((1u << left) - 1);
+        dot0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, A + i), _mm512_maskz_loadu_ps(mask, B + i), dot0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(dot0, dot1));
+}
+#endif // PILLAR_ARCH_X86
+
+DotKernel selectDotKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return dotAvx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return dotAvx2;
+    }
+#endif
+    (void)level;
+    return dotScalar;
+}
+
+CosineKernel selectKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return cosineAvx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return cosineAvx2;
+    }
+    if (level >= cpu::SimdLevel::kSSE41)
+    {
+        return cosineSse;
+    }
+#endif
+    (void)level;
+    return cosineScalar;
+}
+} // namespace
+
+float cosineSimilarity(const float* A, const float* B, unsigned int len)
+{
+    // Picked once, the CPU does not change under us.
+    static const CosineKernel kernel = selectKernel(cpu::simdLevel());
+    return kernel(A, B, len);
+}
+
+float cosineSimilarity(const float* A, const float* B, unsigned int len, cpu::SimdLevel maxLevel)
+{
+    return selectKernel(std::min(maxLevel, cpu::simdLevel()))(A, B, len);
+}
+
+float dotProduct(const float* A, const float* B, unsigned int len)
+{
+    static const DotKernel kernel = selectDotKernel(cpu::simdLevel());
+    return kernel(A, B, len);
+}
+
+float dotProduct(const float* A, const float* B, unsigned int len, cpu::SimdLevel maxLevel)
+{
+    return selectDotKernel(std::min(maxLevel, cpu::simdLevel()))(A, B, len);
+}
 } // namespace math
-} // namespace yuzu
\ No newline at end of file
+} // namespace yuzu
@@ -0,0 +1,346 @@
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "pillar/utility/ssd_anchors.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace
+{
+float calculateScale(float minScale, float maxScale, size_t index, size_t count)
+{
+    if (count == 1)
+        return (minScale + maxScale) * 0.5f;
+    return minScale + (maxScale - minScale) * float(index) / float(count - 1);
+}
+
+// The decoder options resolved once per call.
+struct Decoder
+{
+    size_t numClasses;
+    size_t numCoords;
+    // Indices of x, y, w and h within an anchor's raw values.
+    int x, y, w, h;
+    float xScale, yScale, wScale, hScale;
+    bool exponential;
+    bool sigmoid;
+    bool flip;
+    float clip;
+    // In logit space with a sigmoid.
+    float threshold;
+
+    float clipped(float raw) const { return std::min(std::max(raw, -clip), clip); }
+
+    // Appends a box from its center and final size.
+    void emit(float xCenter, float yCenter, float width, float height, float score, int32_t label,
+              BoxBatch& boxes) const
+    {
+        if (flip)
+            yCenter = 1.0f - yCenter;
+        if (sigmoid)
+            score = 1.0f / (1.0f + expf(-score));
+        boxes.add(xCenter - width * 0.5f, yCenter - height * 0.5f, xCenter + width * 0.5f, yCenter + height * 0.5f,
+                  score, label);
+    }
+
+    // Decodes anchor `i` whose best class and clipped score are known.
+    void decode(const float* rawBoxes, const AnchorGrid& anchors, size_t i, float score, int32_t label,
+                BoxBatch& boxes) const
+    {
+        const float* raw = rawBoxes + i * numCoords;
+        const float aw = anchors.width()[i], ah = anchors.height()[i];
+        const float xCenter = raw[x] * xScale * aw + anchors.xCenter()[i];
+        const float yCenter = raw[y] * yScale * ah + anchors.yCenter()[i];
+        const float width = exponential ? expf(raw[w] * wScale) * aw : raw[w] * wScale * aw;
+        const float height = exponential ? expf(raw[h] * hScale) * ah : raw[h] * hScale * ah;
+        emit(xCenter, yCenter, width, height, score, label, boxes);
+    }
+
+    // The best class of anchor `i` and its clipped score.
+    float bestScore(const float* rawScores, size_t i, int32_t& label) const
+    {
+        const float* raw = rawScores + i * numClasses;
+        float best = clipped(raw[0]);
+        label = 0;
+        for (size_t c = 1; c < numClasses; ++c)
+        {
+            const float score = clipped(raw[c]);
+            if (score > best)
+                best = score, label = int32_t(c);
+        }
+        return best;
+    }
+};
+
+using DecodeKernel = void (*)(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors,
+                              const Decoder& decoder, BoxBatch& boxes);
+
+// Anchors from `begin` on, one at a time; also the tail of the SIMD kernels.
+void decodeFrom(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors, const Decoder& decoder,
+                size_t begin, BoxBatch& boxes)
+{
+    for (size_t i = begin; i < anchors.size(); ++i)
+    {
+        int32_t label;
+        const float score = decoder.bestScore(rawScores, i, label);
+        if (score >= decoder.threshold)
+            decoder.decode(rawBoxes, anchors, i, score, label, boxes);
+    }
+}
+
+void decodeScalar(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors, const Decoder& decoder,
+                  BoxBatch& boxes)
+{
+    decodeFrom(rawBoxes, rawScores, anchors, decoder, 0, boxes);
+}
+
+#if defined(PILLAR_ARCH_X86)
+// Eight anchors per step: the best class and the threshold test first, then
+// the centers and sizes gathered and decoded for steps with any survivor.
+PILLAR_TARGET_AVX2 void decodeAvx2(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors,
+                                   const Decoder& decoder, BoxBatch& boxes)
+{
+    const __m256 low = _mm256_set1_ps(-decoder.clip), high = _mm256_set1_ps(decoder.clip);
+    const __m256 threshold = _mm256_set1_ps(decoder.threshold);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i classStride = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(int(decoder.numClasses)));
+    const __m256i coordStride = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(int(decoder.numCoords)));
+    alignas(32) float xs[8], ys[8], ws[8], hs[8], scores[8];
+    alignas(32) int32_t labels[8];
+    size_t i = 0;
+    for (; i + 8 <= anchors.size(); i += 8)
+    {
+        const float* scoreBase = rawScores + i * decoder.numClasses;
+        __m256 best = decoder.numClasses == 1 ? _mm256_loadu_ps(scoreBase)
+                                              : _mm256_i32gather_ps(scoreBase, classStride, 4);
+        best = _mm256_min_ps(_mm256_max_ps(best, low), high);
+        __m256i label = _mm256_setzero_si256();
+        for (size_t c = 1; c < decoder.numClasses; ++c)
+        {
+            __m256 score = _mm256_i32gather_ps(scoreBase + c, classStride, 4);
+            score = _mm256_min_ps(_mm256_max_ps(score, low), high);
+            const __m256 better = _mm256_cmp_ps(score, best, _CMP_GT_OQ);
+            best = _mm256_blendv_ps(best, score, better);
+            label = _mm256_blendv_epi8(label, _mm256_set1_epi32(int(c)), _mm256_castps_si256(better));
+        }
+        const unsigned int mask = unsigned(_mm256_movemask_ps(_mm256_cmp_ps(best, threshold, _CMP_GE_OQ)));
+        if (mask == 0)
+            continue;
+
+        const float* boxBase = rawBoxes + i * decoder.numCoords;
+        const __m256 aw = _mm256_loadu_ps(anchors.width() + i), ah = _mm256_loadu_ps(anchors.height() + i);
+        const __m256 rx = _mm256_i32gather_ps(boxBase + decoder.x, coordStride, 4);
+        const __m256 ry = _mm256_i32gather_ps(boxBase + decoder.y, coordStride, 4);
+        __m256 rw = _mm256_mul_ps(_mm256_i32gather_ps(boxBase + decoder.w, coordStride, 4),
+                                  _mm256_set1_ps(decoder.wScale));
+        __m256 rh = _mm256_mul_ps(_mm256_i32gather_ps(boxBase + decoder.h, coordStride, 4),
+                                  _mm256_set1_ps(decoder.hScale));
+        if (!decoder.exponential)
+        {
+            rw = _mm256_mul_ps(rw, aw);
+            rh = _mm256_mul_ps(rh, ah);
+        }
+        _mm256_store_ps(xs, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(rx, _mm256_set1_ps(decoder.xScale)), aw),
+                                          _mm256_loadu_ps(anchors.xCenter() + i)));
+        _mm256_store_ps(ys, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ry, _mm256_set1_ps(decoder.yScale)), ah),
+                                          _mm256_loadu_ps(anchors.yCenter() + i)));
+        _mm256_store_ps(ws, rw);
+        _mm256_store_ps(hs, rh);
+        _mm256_store_ps(scores, best);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(labels), label);
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            if (!(mask >> lane & 1))
+                continue;
+            float width = ws[lane], height = hs[lane];
+            if (decoder.exponential)
+            {
+                width = expf(width) * anchors.width()[i + lane];
+                height = expf(height) * anchors.height()[i + lane];
+            }
+            decoder.emit(xs[lane], ys[lane], width, height, scores[lane], labels[lane], boxes);
+        }
+    }
+    decodeFrom(rawBoxes, rawScores, anchors, decoder, i, boxes);
+}
+#endif // PILLAR_ARCH_X86
+
+DecodeKernel selectKernel(cpu::SimdLevel level)
+{
+#if defined(PILLAR_ARCH_X86)
+    // Sixteen-lane gathers measured no faster than eight, AVX-512 machines
+    // run the AVX2 kernel too.
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return decodeAvx2;
+    }
+#endif
+    (void)level;
+    return decodeScalar;
+}
+} // namespace
+
+bool SsdAnchorOptions::operator==(const SsdAnchorOptions& other) const
+{
+    return inputWidth == other.inputWidth && inputHeight == other.inputHeight && minScale == other.minScale &&
+           maxScale == other.maxScale && anchorOffsetX == other.anchorOffsetX &&
+           anchorOffsetY == other.anchorOffsetY && strides == other.strides && aspectRatios == other.aspectRatios &&
+           interpolatedScaleAspectRatio == other.interpolatedScaleAspectRatio &&
+           reduceBoxesInLowestLayer == other.reduceBoxesInLowestLayer && fixedAnchorSize == other.fixedAnchorSize;
+}
+
+Status AnchorGrid::generate(const SsdAnchorOptions& options, AnchorGrid& grid)
+{
+    if (options.inputWidth <= 0 || options.inputHeight <= 0 || options.strides.empty())
+        return Status(StatusCode::kInvalidArgument, "anchors need an input size and strides");
+    for (int stride : options.strides)
+    {
+        if (stride <= 0)
+            return Status(StatusCode::kInvalidArgument, "anchor strides must be positive");
+    }
+
+    grid.mXCenter.clear();
+    grid.mYCenter.clear();
+    grid.mWidth.clear();
+    grid.mHeight.clear();
+    const size_t layers = options.strides.size();
+    size_t layer = 0;
+    while (layer < layers)
+    {
+        // Layers of the same stride stack their anchors on one grid.
+        std::vector<float> ratios, scales;
+        size_t last = layer;
+        for (; last < layers && options.strides[last] == options.strides[layer]; ++last)
+        {
+            const float scale = calculateScale(options.minScale, options.maxScale, last, layers);
+            if (last == 0 && options.reduceBoxesInLowestLayer)
+            {
+                ratios.insert(ratios.end(), {1.0f, 2.0f, 0.5f});
+                scales.insert(scales.end(), {0.1f, scale, scale});
+                continue;
+            }
+            for (float ratio : options.aspectRatios)
+            {
+                ratios.push_back(ratio);
+                scales.push_back(scale);
+            }
+            if (options.interpolatedScaleAspectRatio > 0.0f)
+            {
+                const float next =
+                    last == layers - 1 ? 1.0f : calculateScale(options.minScale, options.maxScale, last + 1, layers);
+                scales.push_back(sqrtf(scale * next));
+                ratios.push_back(options.interpolatedScaleAspectRatio);
+            }
+        }
+
+        const int stride = options.strides[layer];
+        const int rows = (options.inputHeight + stride - 1) / stride;
+        const int cols = (options.inputWidth + stride - 1) / stride;
+        for (int y = 0; y < rows; ++y)
+        {
+            for (int x = 0; x < cols; ++x)
+            {
+                for (size_t a = 0; a < ratios.size(); ++a)
+                {
+                    const float ratio = sqrtf(ratios[a]);
+                    grid.mXCenter.push_back((x + options.anchorOffsetX) / cols);
+                    grid.mYCenter.push_back((y + options.anchorOffsetY) / rows);
+                    grid.mWidth.push_back(options.fixedAnchorSize ? 1.0f : scales[a] * ratio);
+                    grid.mHeight.push_back(options.fixedAnchorSize ? 1.0f : scales[a] / ratio);
+                }
+            }
+        }
+        layer = last;
+    }
+    return okStatus();
+}
+
+Status AnchorGrid::get(const SsdAnchorOptions& options, std::shared_ptr<const AnchorGrid>& grid)
+{
+    // A handful of layouts per process at most, a list is enough.
+    static std::mutex mutex;
+    static std::vector<std::pair<SsdAnchorOptions, std::shared_ptr<const AnchorGrid>>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : cache)
+    {
+        if (entry.first == options)
+        {
+            grid = entry.second;
+            return okStatus();
+        }
+    }
+    std::shared_ptr<AnchorGrid> generated(new AnchorGrid());
+    Status status = generate(options, *generated);
+    if (!status.ok())
+        return status;
+    cache.emplace_back(options, generated);
+    grid = std::move(generated);
+    return okStatus();
+}
+
+Anchor AnchorGrid::anchor(size_t i) const
+{
+    Anchor anchor;
+    anchor.setXCenter(mXCenter[i]);
+    anchor.setYCenter(mYCenter[i]);
+    anchor.setWidth(mWidth[i]);
+    anchor.setHeight(mHeight[i]);
+    return anchor;
+}
+
+Status decodeSsdBoxes(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors,
+                      const SsdDecoderOptions& options, BoxBatch& boxes)
+{
+    return decodeSsdBoxes(rawBoxes, rawScores, anchors, options, boxes, cpu::simdLevel());
+}
+
+Status decodeSsdBoxes(const float* rawBoxes, const float* rawScores, const AnchorGrid& anchors,
+                      const SsdDecoderOptions& options, BoxBatch& boxes, cpu::SimdLevel maxLevel)
+{
+    boxes.clear();
+    if (options.numClasses <= 0 || options.boxCoordOffset < 0 || options.numCoords < options.boxCoordOffset + 4)
+        return Status(StatusCode::kInvalidArgument, "raw boxes need four coordinates and scores a class");
+    if (options.xScale == 0.0f || options.yScale == 0.0f || options.wScale == 0.0f || options.hScale == 0.0f)
+        return Status(StatusCode::kInvalidArgument, "box scales must not be zero");
+
+    Decoder decoder;
+    decoder.numClasses = size_t(options.numClasses);
+    decoder.numCoords = size_t(options.numCoords);
+    const int offset = options.boxCoordOffset;
+    decoder.x = offset + (options.reverseOutputOrder ? 0 : 1);
+    decoder.y = offset + (options.reverseOutputOrder ? 1 : 0);
+    decoder.w = offset + (options.reverseOutputOrder ? 2 : 3);
+    decoder.h = offset + (options.reverseOutputOrder ? 3 : 2);
+    decoder.xScale = 1.0f / options.xScale;
+    decoder.yScale = 1.0f / options.yScale;
+    decoder.wScale = 1.0f / options.wScale;
+    decoder.hScale = 1.0f / options.hScale;
+    decoder.exponential = options.applyExponentialOnBoxSize;
+    decoder.sigmoid = options.sigmoidScore;
+    decoder.flip = options.flipVertically;
+    decoder.clip = options.sigmoidScore && options.scoreClippingThreshold > 0.0f
+                       ? options.scoreClippingThreshold
+                       : std::numeric_limits<float>::infinity();
+    // sigmoid(s) >= t exactly when s >= log(t / (1 - t)).
+    const float t = options.minScoreThreshold;
+    if (!options.sigmoidScore)
+        decoder.threshold = t;
+    else if (t <= 0.0f)
+        decoder.threshold = -std::numeric_limits<float>::infinity();
+    else
+        decoder.threshold = t >= 1.0f ? std::numeric_limits<float>::infinity() : logf(t / (1.0f - t));
+
+    const DecodeKernel kernel = selectKernel(std::min(maxLevel, cpu::simdLevel()));
+    kernel(rawBoxes, rawScores, anchors, decoder, boxes);
+    return okStatus();
+}
+} // namespace yuzu
@@ -0,0 +1,313 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "pillar/utility/vector_batch.h"
+
+#if defined(PILLAR_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace yuzu
+{
+namespace math
+{
+namespace
+{
+using Normalize2Kernel = void (*)(float* x, float* y, size_t count);
+using Normalize3Kernel = void (*)(float* x, float* y, float* z, size_t count);
+using Transform2Kernel = void (*)(const float* m, const float* x, const float* y, float* outX, float* outY,
+                                  size_t count);
+using Transform3Kernel = void (*)(const float* m, const float* x, const float* y, const float* z, float* outX,
+                                  float* outY, float* outZ, size_t count);
+
+struct Kernels
+{
+    Normalize2Kernel normalize2;
+    Normalize3Kernel normalize3;
+    Transform2Kernel transform2;
+    Transform3Kernel transform3;
+};
+
+// One over the norm, zero for a zero vector, as Vector::normalize.
+inline float inverseNorm(float norm2)
+{
+    const float n = sqrtf(norm2);
+    return n != 0.0f ? 1.0f / n : 0.0f;
+}
+
+void normalize2Scalar(float* x, float* y, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float k = inverseNorm(x[i] * x[i] + y[i] * y[i]);
+        x[i] *= k;
+        y[i] *= k;
+    }
+}
+
+void normalize3Scalar(float* x, float* y, float* z, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float k = inverseNorm(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        x[i] *= k;
+        y[i] *= k;
+        z[i] *= k;
+    }
+}
+
+void transform2Scalar(const float* m, const float* x, const float* y, float* outX, float* outY, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float px = x[i], py = y[i];
+        outX[i] = m[0] * px + m[1] * py + m[2];
+        outY[i] = m[3] * px + m[4] * py + m[5];
+    }
+}
+
+void transform3Scalar(const float* m, const float* x, const float* y, const float* z, float* outX, float* outY,
+                      float* outZ, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float px = x[i], py = y[i], pz = z[i];
+        outX[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+        outY[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+        outZ[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+    }
+}
+
+#if defined(PILLAR_ARCH_X86)
+// Sums of products may be fused, so results can differ from the scalar loop
+// in the last bit.
+PILLAR_TARGET_AVX2 inline __m256 inverseNorm256(__m256 norm2)
+{
+    const __m256 k = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(norm2));
+    return _mm256_and_ps(k, _mm256_cmp_ps(norm2, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+}
+
+PILLAR_TARGET_AVX2 void normalize2Avx2(float* x, float* y, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i);
+        const __m256 k = inverseNorm256(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(vx, k));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(vy, k));
+    }
+    normalize2Scalar(x + i, y + i, count - i);
+}
+
+PILLAR_TARGET_AVX2 void normalize3Avx2(float* x, float* y, float* z, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+        const __m256 n2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)),
+                                        _mm256_mul_ps(vz, vz));
+        const __m256 k = inverseNorm256(n2);
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(vx, k));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(vy, k));
+        _mm256_storeu_ps(z + i, _mm256_mul_ps(vz, k));
+    }
+    normalize3Scalar(x + i, y + i, z + i, count - i);
+}
+
+PILLAR_TARGET_AVX2 void transform2Avx2(const float* m, const float* x, const float* y, float* outX, float* outY,
+                                       size_t count)
+{
+    const __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+    const __m256 m3 = _mm256_set1_ps(m[3]), m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+        _mm256_storeu_ps(outX + i, _mm256_fmadd_ps(m0, px, _mm256_fmadd_ps(m1, py, m2)));
+        _mm256_storeu_ps(outY + i, _mm256_fmadd_ps(m3, px, _mm256_fmadd_ps(m4, py, m5)));
+    }
+    transform2Scalar(m, x + i, y + i, outX + i, outY + i, count - i);
+}
+
+PILLAR_TARGET_AVX2 void transform3Avx2(const float* m, const float* x, const float* y, const float* z, float* outX,
+                                       float* outY, float* outZ, size_t count)
+{
+    __m256 r[12];
+    for (int j = 0; j < 12; ++j)
+        r[j] = _mm256_set1_ps(m[j]);
+    float* out[3] = {outX, outY, outZ};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        __m256 rows[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            const __m256* row = r + 4 * j;
+            rows[j] = _mm256_fmadd_ps(row[0], px, _mm256_fmadd_ps(row[1], py, _mm256_fmadd_ps(row[2], pz, row[3])));
+        }
+        for (int j = 0; j < 3; ++j)
+            _mm256_storeu_ps(out[j] + i, rows[j]);
+    }
+    transform3Scalar(m, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+}
+
+PILLAR_TARGET_AVX512 inline __mmask16 tailMask(size_t left)
+{
+    return left >= 16 ? __mmask16(0xffff) : __mmask16((1u << left) - 1);
+}
+
+PILLAR_TARGET_AVX512 inline __m512 inverseNorm512(__m512 norm2)
+{
+    const __m512 k = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(norm2));
+    return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(norm2, _mm512_setzero_ps(), _CMP_NEQ_UQ), k);
+}
+
+// One masked step covers the tail.
+PILLAR_TARGET_AVX512 void normalize2Avx512(float* x, float* y, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = tailMask(count - i);
+        const __m512 vx = _mm512_maskz_loadu_ps(mask, x + i), vy = _mm512_maskz_loadu_ps(mask, y + i);
+        const __m512 k = inverseNorm512(_mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)));
+        _mm512_mask_storeu_ps(x + i, mask, _mm512_mul_ps(vx, k));
+        _mm512_mask_storeu_ps(y + i, mask, _mm512_mul_ps(vy, k));
+    }
+}
+
+PILLAR_TARGET_AVX512 void normalize3Avx512(float* x, float* y, float* z, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = tailMask(count - i);
+        const __m512 vx = _mm512_maskz_loadu_ps(mask, x + i), vy = _mm512_maskz_loadu_ps(mask, y + i);
+        const __m512 vz = _mm512_maskz_loadu_ps(mask, z + i);
+        const __m512 n2 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)),
+                                        _mm512_mul_ps(vz, vz));
+        const __m512 k = inverseNorm512(n2);
+        _mm512_mask_storeu_ps(x + i, mask, _mm512_mul_ps(vx, k));
+        _mm512_mask_storeu_ps(y + i, mask, _mm512_mul_ps(vy, k));
+        _mm512_mask_storeu_ps(z + i, mask, _mm512_mul_ps(vz, k));
+    }
+}
+
+PILLAR_TARGET_AVX512 void transform2Avx512(const float* m, const float* x, const float* y, float* outX, float* outY,
+                                           size_t count)
+{
+    const __m512 m0 = _mm512_set1_ps(m[0]), m1 = _mm512_set1_ps(m[1]), m2 = _mm512_set1_ps(m[2]);
+    const __m512 m3 = _mm512_set1_ps(m[3]), m4 = _mm512_set1_ps(m[4]), m5 = _mm512_set1_ps(m[5]);
+    for (size_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = tailMask(count - i);
+        const __m512 px = _mm512_maskz_loadu_ps(mask, x + i), py = _mm512_maskz_loadu_ps(mask, y + i);
+        _mm512_mask_storeu_ps(outX + i, mask, _mm512_fmadd_ps(m0, px, _mm512_fmadd_ps(m1, py, m2)));
+        _mm512_mask_storeu_ps(outY + i, mask, _mm512_fmadd_ps(m3, px, _mm512_fmadd_ps(m4, py, m5)));
+    }
+}
+
+PILLAR_TARGET_AVX512 void transform3Avx512(const float* m, const float* x, const float* y, const float* z,
+                                           float* outX, float* outY, float* outZ, size_t count)
+{
+    __m512 r[12];
+    for (int j = 0; j < 12; ++j)
+        r[j] = _mm512_set1_ps(m[j]);
+    float* out[3] = {outX, outY, outZ};
+    for (size_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = tailMask(count - i);
+        const __m512 px = _mm512_maskz_loadu_ps(mask, x + i), py = _mm512_maskz_loadu_ps(mask, y + i);
+        const __m512 pz = _mm512_maskz_loadu_ps(mask, z + i);
+        __m512 rows[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            const __m512* row = r + 4 * j;
+            rows[j] = _mm512_fmadd_ps(row[0], px, _mm512_fmadd_ps(row[1], py, _mm512_fmadd_ps(row[2], pz, row[3])));
+        }
+        for (int j = 0; j < 3; ++j)
+            _mm512_mask_storeu_ps(out[j] + i, mask, rows[j]);
+    }
+}
+#endif // PILLAR_ARCH_X86
+
+// Each point is a handful of flops, SSE would gain little over what the
+// compiler makes of the scalar loops.
+const Kernels& selectKernels(cpu::SimdLevel level)
+{
+    static const Kernels scalar = {normalize2Scalar, normalize3Scalar, transform2Scalar, transform3Scalar};
+#if defined(PILLAR_ARCH_X86)
+    static const Kernels avx2 = {normalize2Avx2, normalize3Avx2, transform2Avx2, transform3Avx2};
+    static const Kernels avx512 = {normalize2Avx512, normalize3Avx512, transform2Avx512, transform3Avx512};
+    if (level >= cpu::SimdLevel::kAVX512)
+    {
+        return avx512;
+    }
+    if (level >= cpu::SimdLevel::kAVX2)
+    {
+        return avx2;
+    }
+#endif
+    (void)level;
+    return scalar;
+}
+
+const Kernels& defaultKernels()
+{
+    // Picked once, the CPU does not change under us.
+    static const Kernels& kernels = selectKernels(cpu::simdLevel());
+    return kernels;
+}
+
+const Kernels& cappedKernels(cpu::SimdLevel maxLevel)
+{
+    return selectKernels(std::min(maxLevel, cpu::simdLevel()));
+}
+} // namespace
+
+void normalizeVectors(float* x, float* y, size_t count)
+{
+    defaultKernels().normalize2(x, y, count);
+}
+
+void normalizeVectors(float* x, float* y, size_t count, cpu::SimdLevel maxLevel)
+{
+    cappedKernels(maxLevel).normalize2(x, y, count);
+}
+
+void normalizeVectors(float* x, float* y, float* z, size_t count)
+{
+    defaultKernels().normalize3(x, y, z, count);
+}
+
+void normalizeVectors(float* x, float* y, float* z, size_t count, cpu::SimdLevel maxLevel)
+{
+    cappedKernels(maxLevel).normalize3(x, y, z, count);
+}
+
+void transformPoints(const float* m, const float* x, const float* y, float* outX, float* outY, size_t count)
+{
+    defaultKernels().transform2(m, x, y, outX, outY, count);
+}
+
+void transformPoints(const float* m, const float* x, const float* y, float* outX, float* outY, size_t count,
+                     cpu::SimdLevel maxLevel)
+{
+    cappedKernels(maxLevel).transform2(m, x, y, outX, outY, count);
+}
+
+void transformPoints(const float* m, const float* x, const float* y, const float* z, float* outX, float* outY,
+                     float* outZ, size_t count)
+{
+    defaultKernels().transform3(m, x, y, z, outX, outY, outZ, count);
+}
+
+void transformPoints(const float* m, const float* x, const float* y, const float* z, float* outX, float* outY,
+                     float* outZ, size_t count, cpu::SimdLevel maxLevel)
+{
+    cappedKernels(maxLevel).transform3(m, x, y, z, outX, outY, outZ, count);
+}
+} // namespace math
+} // namespace yuzu
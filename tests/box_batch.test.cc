@@ -0,0 +1,198 @@
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/utility/box_batch.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// Pairwise suppression over Rectangle objects, the reference.
+static std::vector<size_t> rectangleNms(const std::vector<Rectangle<float>>& boxes, const std::vector<float>& scores,
+                                        float iouThreshold)
+{
+    std::vector<size_t> order(boxes.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); });
+    std::vector<bool> suppressed(boxes.size(), false);
+    std::vector<size_t> kept;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        if (suppressed[order[i]])
+            continue;
+        const Rectangle<float>& a = boxes[order[i]];
+        kept.push_back(order[i]);
+        for (size_t j = i + 1; j < order.size(); ++j)
+        {
+            const Rectangle<float>& b = boxes[order[j]];
+            const Rectangle<float> inter = a.intersect(b);
+            const float interArea = inter.isEmpty() ? 0.0f : inter.area();
+            if (interArea / (a.area() + b.area() - interArea) > iouThreshold)
+                suppressed[order[j]] = true;
+        }
+    }
+    return kept;
+}
+
+static std::vector<size_t> indices(const std::vector<KeptBox>& kept)
+{
+    std::vector<size_t> out;
+    for (const KeptBox& box : kept)
+        out.push_back(box.index);
+    return out;
+}
+
+int main()
+{
+    int failures = 0;
+    const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2, cpu::SimdLevel::kAVX512};
+    const char* names[] = {"scalar", "avx2", "avx512"};
+
+    // Detector-like candidates: jittered boxes around a few dozen objects.
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> position(0.0f, 600.0f), size(20.0f, 200.0f), jitter(-12.0f, 12.0f);
+    std::uniform_real_distribution<float> score(0.05f, 1.0f);
+    const size_t objects = 50, perObject = 100;
+    std::vector<Rectangle<float>> rectangles;
+    std::vector<float> scores;
+    BoxBatch boxes;
+    boxes.reserve(objects * perObject);
+    for (size_t o = 0; o < objects; ++o)
+    {
+        const float x = position(rng), y = position(rng), w = size(rng), h = size(rng);
+        for (size_t i = 0; i < perObject; ++i)
+        {
+            const Rectangle<float> box(x + jitter(rng), y + jitter(rng), w + jitter(rng), h + jitter(rng));
+            rectangles.push_back(box);
+            scores.push_back(score(rng));
+            boxes.add(box, scores.back(), int32_t(o % 3));
+        }
+    }
+
+    {
+        std::vector<float> expected(boxes.size()), ious(boxes.size());
+        intersectionOverUnion(boxes, rectangles[7], expected.data(), cpu::SimdLevel::kScalar);
+        bool same = std::fabs(expected[7] - 1.0f) < 1e-6f;
+        for (size_t l = 1; l < 3; ++l)
+        {
+            intersectionOverUnion(boxes, rectangles[7], ious.data(), levels[l]);
+            for (size_t i = 0; i < boxes.size(); ++i)
+                same &= std::fabs(ious[i] - expected[i]) < 1e-6f;
+        }
+        failures += expect(same, "iou kernels agree");
+    }
+
+    NmsOptions options;
+    options.iouThreshold = 0.5f;
+    std::vector<size_t> reference;
+    {
+        Timer timer("Rectangle pairwise nms: ");
+        reference = rectangleNms(rectangles, scores, options.iouThreshold);
+    }
+    std::cout << reference.size() << " of " << boxes.size() << " boxes kept" << std::endl;
+    for (size_t l = 0; l < 3; ++l)
+    {
+        std::vector<KeptBox> kept;
+        {
+            const std::string label = std::string(names[l]) + " nms x20: ";
+            Timer timer(label);
+            for (int r = 0; r < 20; ++r)
+                nonMaxSuppression(boxes, options, kept, levels[l]);
+        }
+        failures += expect(indices(kept) == reference, "BoxBatch nms matches the Rectangle reference");
+    }
+
+    {
+        // Class-aware: every label alone gives the same boxes as the merged run.
+        NmsOptions aware = options;
+        aware.classAware = true;
+        std::vector<KeptBox> kept;
+        nonMaxSuppression(boxes, aware, kept);
+        std::vector<size_t> expected;
+        for (int32_t label = 0; label < 3; ++label)
+        {
+            std::vector<Rectangle<float>> subset;
+            std::vector<float> subsetScores;
+            std::vector<size_t> original;
+            for (size_t i = 0; i < boxes.size(); ++i)
+            {
+                if (boxes.labels()[i] != label)
+                    continue;
+                subset.push_back(rectangles[i]);
+                subsetScores.push_back(scores[i]);
+                original.push_back(i);
+            }
+            for (size_t i : rectangleNms(subset, subsetScores, options.iouThreshold))
+                expected.push_back(original[i]);
+        }
+        std::sort(expected.begin(), expected.end(),
+                  [&](size_t a, size_t b) { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); });
+        failures += expect(indices(kept) == expected && kept.size() > reference.size(), "class-aware nms");
+
+        aware.maxDetections = 10;
+        aware.scoreThreshold = 0.5f;
+        nonMaxSuppression(boxes, aware, kept);
+        bool limited = kept.size() == 10;
+        for (size_t i = 0; i < kept.size(); ++i)
+            limited &= kept[i].index == expected[i] && kept[i].score >= 0.5f;
+        failures += expect(limited, "score threshold and detection limit");
+
+        const std::vector<Rectangle<float>> out = boxes.rectangles(kept);
+        bool converted = out.size() == kept.size();
+        for (size_t i = 0; converted && i < out.size(); ++i)
+            converted = out[i] == rectangles[kept[i].index];
+        failures += expect(converted, "kept boxes convert back to rectangles");
+    }
+
+    {
+        // Soft-NMS keeps more boxes at lower scores, in decaying score order,
+        // and agrees across kernels.
+        SoftNmsOptions soft;
+        std::vector<KeptBox> expected, kept;
+        {
+            Timer timer("scalar soft nms: ");
+            softNonMaxSuppression(boxes, soft, expected, cpu::SimdLevel::kScalar);
+        }
+        bool ordered = expected.size() > reference.size();
+        for (size_t i = 1; i < expected.size(); ++i)
+            ordered &= expected[i - 1].score >= expected[i].score && expected[i].score >= soft.scoreThreshold;
+        failures += expect(ordered, "soft nms order");
+        for (size_t l = 1; l < 3; ++l)
+        {
+            {
+                const std::string label = std::string(names[l]) + " soft nms: ";
+                Timer timer(label);
+                softNonMaxSuppression(boxes, soft, kept, levels[l]);
+            }
+            bool same = kept.size() == expected.size();
+            for (size_t i = 0; same && i < kept.size(); ++i)
+                same = kept[i].index == expected[i].index && std::fabs(kept[i].score - expected[i].score) < 1e-5f;
+            failures += expect(same, "soft nms kernels agree");
+        }
+
+        // Two boxes overlapping by a third: the weaker one is decayed, not removed.
+        BoxBatch pair;
+        pair.add(0.0f, 0.0f, 10.0f, 10.0f, 0.9f);
+        pair.add(5.0f, 0.0f, 15.0f, 10.0f, 0.8f);
+        softNonMaxSuppression(pair, soft, kept);
+        const float decayed = 0.8f * expf(-(1.0f / 9.0f) / soft.sigma);
+        bool gaussian = kept.size() == 2 && kept[0].index == 0 && std::fabs(kept[1].score - decayed) < 1e-6f;
+        soft.method = SoftNmsMethod::kLinear;
+        soft.iouThreshold = 0.5f;
+        softNonMaxSuppression(pair, soft, kept);
+        gaussian &= kept.size() == 2 && std::fabs(kept[1].score - 0.8f) < 1e-6f;
+        soft.iouThreshold = 0.2f;
+        softNonMaxSuppression(pair, soft, kept);
+        gaussian &= kept.size() == 2 && std::fabs(kept[1].score - 0.8f * (2.0f / 3.0f)) < 1e-6f;
+        failures += expect(gaussian, "soft nms decay");
+    }
+    return failures == 0 ? 0 : 1;
+}
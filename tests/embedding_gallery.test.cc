@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "pillar/utility/embedding_gallery.h"
+#include "pillar/utility/similarity.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(11);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2, cpu::SimdLevel::kAVX512};
+    std::cout << "simd level: " << cpu::simdLevel() << std::endl;
+
+    {
+        // Odd sizes leave partial query groups, row tiles and blocks.
+        double worst = 0.0;
+        for (unsigned int dim : {1u, 7u, 16u, 37u, 128u, 300u})
+        {
+            const size_t rows = 1037, queries = 7;
+            std::vector<float> data(rows * dim), query(queries * dim);
+            for (float& x : data)
+                x = dist(rng);
+            for (float& x : query)
+                x = dist(rng);
+            for (unsigned int i = 0; i < dim; ++i)
+                data[i] = 0.0f;
+            data[0] = 1.0f;
+
+            EmbeddingGallery gallery(dim);
+            if (!gallery.addBatch(data.data(), rows).ok() || gallery.size() != rows)
+                failures += expect(false, "addBatch");
+            for (cpu::SimdLevel level : levels)
+            {
+                std::vector<float> scores(queries * rows, -2.0f);
+                gallery.match(query.data(), queries, scores.data(), level);
+                for (size_t q = 0; q < queries; ++q)
+                    for (size_t r = 0; r < rows; ++r)
+                    {
+                        const float expected =
+                            math::cosineSimilarity(query.data() + q * dim, data.data() + r * dim, dim);
+                        worst = std::max(worst, double(std::abs(scores[q * rows + r] - expected)));
+                    }
+            }
+        }
+        std::cout << "max error against cosineSimilarity: " << worst << std::endl;
+        failures += expect(worst < 1e-5, "batched matching agrees with cosineSimilarity");
+    }
+
+    {
+        EmbeddingGallery gallery(4);
+        const float zero[4] = {0, 0, 0, 0}, unit[4] = {3, 0, 4, 0};
+        const bool rejected = gallery.add(zero).statusCode() == StatusCode::kInvalidArgument && gallery.empty();
+        gallery.add(unit);
+        float score = 0.0f;
+        const bool matched = gallery.match(unit, &score).ok() && std::abs(score - 1.0f) < 1e-6f;
+        const bool aligned = reinterpret_cast<uintptr_t>(gallery.row(0)) % 64 == 0 && gallery.stride() == 16 &&
+                             std::abs(gallery.row(0)[0] - 0.6f) < 1e-6f && gallery.row(0)[15] == 0.0f;
+        failures += expect(rejected && matched && aligned, "rows are normalized, padded and aligned");
+        failures += expect(gallery.match(zero, &score).statusCode() == StatusCode::kInvalidArgument,
+                           "zero queries are rejected");
+
+        // A zero dimension has no rows to hold, owned or viewed.
+        EmbeddingGallery none(0);
+        const EmbeddingGallery view(0, DataType::kFLOAT, gallery.rowData(0), 1);
+        std::vector<GalleryMatch> top;
+        failures += expect(none.add(unit).statusCode() == StatusCode::kInvalidArgument && none.empty() &&
+                               view.empty() && view.match(unit, &score).ok() && view.topK(unit, 1, -1.0f, top).ok() &&
+                               top.empty(),
+                           "zero dimension is rejected");
+    }
+
+    {
+        // Fused selection against a full score vector sorted afterwards.
+        const unsigned int dim = 64;
+        const size_t rows = 5000, queries = 5;
+        std::vector<float> data(rows * dim), query(queries * dim);
+        for (float& x : data)
+            x = dist(rng);
+        for (float& x : query)
+            x = dist(rng);
+        // Duplicates tie and must come back in index order.
+        std::copy(data.begin(), data.begin() + dim, data.begin() + 100 * dim);
+        std::copy(query.begin(), query.begin() + dim, data.begin());
+        std::copy(query.begin(), query.begin() + dim, data.begin() + 100 * dim);
+        EmbeddingGallery gallery(dim);
+        gallery.addBatch(data.data(), rows);
+        std::vector<float> scores(queries * rows);
+        gallery.match(query.data(), queries, scores.data());
+
+        bool same = true, thresholded = true;
+        std::vector<std::vector<GalleryMatch>> top;
+        for (size_t k : {size_t(1), size_t(10), size_t(257), rows + 3})
+        {
+            gallery.topK(query.data(), queries, k, -1.0f, top);
+            for (size_t q = 0; q < queries; ++q)
+            {
+                std::vector<size_t> order(rows);
+                for (size_t r = 0; r < rows; ++r)
+                    order[r] = r;
+                const float* s = scores.data() + q * rows;
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return s[a] > s[b]; });
+                same &= top[q].size() == std::min(k, rows);
+                for (size_t i = 0; same && i < top[q].size(); ++i)
+                    same &= top[q][i].index == order[i] && top[q][i].score == s[order[i]];
+            }
+        }
+        same &= top[0][0].index == 0 && top[0][1].index == 100;
+
+        std::vector<GalleryMatch> passing;
+        gallery.topK(query.data(), 0, 0.2f, passing);
+        size_t expected = 0;
+        for (size_t r = 0; r < rows; ++r)
+            expected += scores[r] >= 0.2f;
+        thresholded = passing.size() == expected;
+        for (size_t i = 0; i < passing.size(); ++i)
+            thresholded &= passing[i].score >= 0.2f && (i == 0 || passing[i - 1].score >= passing[i].score);
+        gallery.topK(query.data(), 3, 0.2f, passing);
+        thresholded &= passing.size() == std::min<size_t>(3, expected);
+        failures += expect(same, "topK matches a full sort");
+        failures += expect(thresholded, "threshold-only mode keeps every row above it");
+    }
+
+    {
+        // Recall of the quantized galleries against float, queries are noisy
+        // copies of gallery rows like repeated captures of one identity.
+        const unsigned int dim = 512;
+        const size_t rows = 50000, queries = 64, k = 10;
+        std::vector<float> data(rows * dim), query(queries * dim);
+        for (float& x : data)
+            x = dist(rng);
+        for (size_t q = 0; q < queries; ++q)
+            for (unsigned int i = 0; i < dim; ++i)
+                query[q * dim + i] = data[(q * 701) % rows * dim + i] + 1.5f * dist(rng);
+
+        std::vector<std::vector<GalleryMatch>> truth;
+        EmbeddingGallery reference(dim);
+        reference.addBatch(data.data(), rows);
+        reference.topK(query.data(), queries, k, -1.0f, truth);
+        std::vector<float> expectedScores(queries * rows);
+        reference.match(query.data(), queries, expectedScores.data());
+        std::cout << "precision   MB   recall@" << k << "   max score error" << std::endl;
+        for (DataType storage : {DataType::kFLOAT, DataType::kHALF, DataType::kINT8})
+        {
+            EmbeddingGallery gallery(dim, storage);
+            gallery.addBatch(data.data(), rows);
+            std::vector<std::vector<GalleryMatch>> found;
+            {
+                Timer timer(storage == DataType::kFLOAT  ? "float topK, 64 queries: "
+                            : storage == DataType::kHALF ? "half topK, 64 queries: "
+                                                         : "int8 topK, 64 queries: ");
+                gallery.topK(query.data(), queries, k, -1.0f, found);
+            }
+            size_t hits = 0;
+            for (size_t q = 0; q < queries; ++q)
+                for (const GalleryMatch& t : truth[q])
+                    for (const GalleryMatch& f : found[q])
+                        hits += t.index == f.index;
+            std::vector<float> scores(queries * rows);
+            gallery.match(query.data(), queries, scores.data());
+            double worst = 0.0;
+            for (size_t i = 0; i < scores.size(); ++i)
+                worst = std::max(worst, double(std::abs(scores[i] - expectedScores[i])));
+            const double recall = double(hits) / double(queries * k);
+            const char* name = storage == DataType::kFLOAT ? "float" : storage == DataType::kHALF ? "half " : "int8 ";
+            std::cout << name << "   " << gallery.memoryBytes() / (1024.0 * 1024.0) << "   " << recall << "   "
+                      << worst << std::endl;
+            if (storage == DataType::kHALF)
+                failures += expect(worst < 1e-3 && recall > 0.95, "half gallery keeps recall");
+            if (storage == DataType::kINT8)
+                failures += expect(worst < 2e-2 && recall > 0.8, "int8 gallery keeps recall");
+        }
+
+        EmbeddingGallery half(dim, DataType::kHALF), int8(dim, DataType::kINT8);
+        half.add(data.data());
+        int8.add(data.data());
+        std::vector<float> a(dim), b(dim);
+        half.dequantizeRow(0, a.data());
+        int8.dequantizeRow(0, b.data());
+        double dot = 0.0;
+        for (unsigned int i = 0; i < dim; ++i)
+            dot += double(a[i]) * reference.row(0)[i] + double(b[i]) * reference.row(0)[i];
+        failures += expect(std::abs(dot - 2.0) < 1e-3 && half.stride() == 512 && int8.memoryBytes() == 512 + 4,
+                           "quantized rows dequantize to the normalized row");
+
+        // Copies and moves own their rows, the source can go away.
+        int8.add(data.data() + dim);
+        std::vector<float> before(2), after(2), moved(2);
+        int8.match(data.data() + dim, before.data());
+        EmbeddingGallery copy = int8;
+        int8.clear();
+        copy.match(data.data() + dim, after.data());
+        EmbeddingGallery target(std::move(copy));
+        copy = EmbeddingGallery(dim, DataType::kINT8);
+        target.match(data.data() + dim, moved.data());
+        failures += expect(after == before && moved == before && target.size() == 2 && copy.empty(),
+                           "copied and moved galleries");
+    }
+
+    {
+        const unsigned int dim = 512;
+        const size_t rows = 100000, queries = 32;
+        std::vector<float> data(rows * dim), query(queries * dim);
+        for (float& x : data)
+            x = dist(rng);
+        for (float& x : query)
+            x = dist(rng);
+        EmbeddingGallery gallery(dim);
+        gallery.addBatch(data.data(), rows);
+        std::vector<std::vector<float>> matrix(rows);
+        for (size_t r = 0; r < rows; ++r)
+            matrix[r].assign(data.begin() + r * dim, data.begin() + (r + 1) * dim);
+        std::vector<float> first(query.begin(), query.begin() + dim);
+        std::vector<float> scores(queries * rows);
+
+        volatile float sink = 0.0f;
+        std::cout << "over " << rows << " x " << dim << ":" << std::endl;
+        {
+            Timer timer("vector of vectors, 1 query: ");
+            sink = math::cosineSimilarity(first, matrix)[0];
+        }
+        {
+            Timer timer("gallery, 1 query: ");
+            gallery.match(query.data(), scores.data());
+        }
+        {
+            Timer timer("gallery batched, 32 queries: ");
+            gallery.match(query.data(), queries, scores.data());
+        }
+        {
+            Timer timer("top-10 by match and partial_sort, 1 query: ");
+            gallery.match(query.data(), scores.data());
+            std::vector<float> copy(scores.begin(), scores.begin() + rows);
+            std::partial_sort(copy.begin(), copy.begin() + 10, copy.end(), std::greater<float>());
+        }
+        std::vector<GalleryMatch> top;
+        {
+            Timer timer("top-10 by topK, 1 query: ");
+            gallery.topK(query.data(), 10, -1.0f, top);
+        }
+        std::vector<std::vector<GalleryMatch>> tops;
+        {
+            Timer timer("top-10 by topK batched, 32 queries: ");
+            gallery.topK(query.data(), queries, 10, -1.0f, tops);
+        }
+        sink = sink + scores[0] + top[0].score + tops[0][0].score;
+    }
+    return failures == 0 ? 0 : 1;
+}
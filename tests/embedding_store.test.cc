@@ -0,0 +1,277 @@
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pillar/utility/embedding_gallery.h"
+#include "pillar/utility/embedding_store.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static void removeStore(const std::string& path)
+{
+    std::remove(path.c_str());
+    std::remove((path + ".wal").c_str());
+}
+
+static bool sameEmbedding(const float* a, const float* b, unsigned int dim, float tolerance)
+{
+    double norm = 0.0;
+    for (unsigned int i = 0; i < dim; ++i)
+        norm += double(b[i]) * b[i];
+    const float scale = float(1.0 / std::sqrt(norm));
+    for (unsigned int i = 0; i < dim; ++i)
+    {
+        if (std::fabs(a[i] - b[i] * scale) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(5);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    const unsigned int dim = 128;
+    const size_t rows = 5000;
+    std::vector<float> data(rows * dim), query(dim);
+    for (float& x : data)
+        x = dist(rng);
+    for (float& x : query)
+        x = dist(rng);
+    const std::string path = "embedding_store.test.bin";
+    removeStore(path);
+
+    EmbeddingStoreOptions options;
+    options.compactLogBytes = 0;
+    {
+        EmbeddingStore store;
+        failures += expect(store.open(path, dim, options).ok() && store.isOpen() && store.size() == 0, "create");
+        for (size_t r = 0; r < rows; ++r)
+            store.put(r, data.data() + r * dim);
+        std::vector<float> out(dim);
+        bool stored = store.size() == rows;
+        for (size_t r = 0; stored && r < rows; r += 97)
+            stored = store.get(r, out.data()).ok() && sameEmbedding(out.data(), data.data() + r * dim, dim, 1e-6f);
+        failures += expect(stored, "put and get");
+
+        const bool statuses = store.remove(rows).statusCode() == StatusCode::kNotFound &&
+                              store.get(rows, out.data()).statusCode() == StatusCode::kNotFound &&
+                              store.open(path, dim, options).statusCode() == StatusCode::kFailedPrecondition;
+        store.remove(3);
+        store.put(4, data.data());
+        const bool replaced = store.get(4, out.data()).ok() && sameEmbedding(out.data(), data.data(), dim, 1e-6f);
+        failures += expect(statuses && replaced && !store.contains(3) && store.size() == rows - 1,
+                           "remove and replace");
+    }
+
+    // The same rows in a gallery are the reference ranking.
+    EmbeddingGallery gallery(dim);
+    std::vector<uint64_t> galleryIds;
+    for (size_t r = 0; r < rows; ++r)
+    {
+        if (r == 3)
+            continue;
+        gallery.add(data.data() + (r == 4 ? 0 : r) * dim);
+        galleryIds.push_back(r);
+    }
+    auto sameRanking = [&](const EmbeddingStore& store)
+    {
+        std::vector<GalleryMatch> expected;
+        std::vector<StoreMatch> matches;
+        gallery.topK(query.data(), 10, -1.0f, expected);
+        if (!store.topK(query.data(), 10, -1.0f, matches).ok() || matches.size() != expected.size())
+            return false;
+        for (size_t i = 0; i < matches.size(); ++i)
+        {
+            if (matches[i].id != galleryIds[expected[i].index] ||
+                std::fabs(matches[i].score - expected[i].score) > 1e-5f)
+                return false;
+        }
+        return true;
+    };
+
+    {
+        // Everything so far lives in the log and is replayed on open.
+        EmbeddingStore store;
+        Status status;
+        {
+            Timer timer("open replaying the log: ");
+            status = store.open(path, dim, options);
+        }
+        failures += expect(status.ok() && store.size() == rows - 1 && sameRanking(store), "log replay");
+
+        const size_t logBytes = store.logBytes();
+        failures += expect(store.compact().ok() && store.logBytes() < logBytes && store.size() == rows - 1 &&
+                               sameRanking(store),
+                           "compaction");
+        store.remove(10);
+        store.put(rows + 1, query.data());
+    }
+
+    {
+        // The compacted base is mapped, not read: only the log tail is replayed.
+        EmbeddingStore store;
+        Status status;
+        {
+            Timer timer("open mapping 5000 rows: ");
+            status = store.open(path, dim, options);
+        }
+        std::vector<StoreMatch> matches;
+        store.topK(query.data(), 1, -1.0f, matches);
+        failures += expect(status.ok() && store.size() == rows - 1 && !store.contains(10) && matches.size() == 1 &&
+                               matches[0].id == rows + 1,
+                           "reopen after compaction");
+        failures += expect(store.open(path, dim + 1, options).statusCode() == StatusCode::kFailedPrecondition,
+                           "second open");
+    }
+
+    {
+        // A record cut short by a crash is dropped, the ones before it kept.
+        EmbeddingStore store;
+        store.open(path, dim, options);
+        store.put(rows + 2, data.data() + 7 * dim);
+        const size_t logBytes = store.logBytes();
+        store.close();
+        failures += expect(::truncate((path + ".wal").c_str(), off_t(logBytes - 5)) == 0, "truncate the log");
+        const Status status = store.open(path, dim, options);
+        failures += expect(status.ok() && !store.contains(rows + 2) && store.contains(rows + 1) &&
+                               store.size() == rows - 1,
+                           "torn log tail");
+        EmbeddingStore other;
+        failures += expect(other.open(path, dim + 1, options).statusCode() == StatusCode::kInvalidArgument,
+                           "dimension mismatch");
+    }
+
+    {
+        // A compaction that cannot replace the log leaves the store on the
+        // old base and log, still writable.
+        EmbeddingStore store;
+        store.open(path, dim, options);
+        store.put(rows + 3, data.data() + 8 * dim);
+        const std::string blocker = path + ".wal.tmp";
+        ::mkdir(blocker.c_str(), 0755);
+        const bool refused = store.compact().statusCode() == StatusCode::kDataLoss;
+        ::rmdir(blocker.c_str());
+        const bool writable = store.put(rows + 4, data.data() + 9 * dim).ok();
+        store.close();
+        failures += expect(refused && writable && store.open(path, dim, options).ok() && store.contains(rows + 3) &&
+                               store.contains(rows + 4) && store.size() == rows + 1,
+                           "failed compaction keeps the log");
+    }
+
+    {
+        // Background compaction keeps the log small under a stream of writes
+        // while readers search.
+        removeStore(path);
+        EmbeddingStoreOptions background;
+        background.compactLogBytes = 256 << 10;
+        EmbeddingStore store;
+        store.open(path, dim, background);
+        std::thread reader(
+            [&]
+            {
+                std::vector<StoreMatch> matches;
+                for (int i = 0; i < 200; ++i)
+                    store.topK(query.data(), 5, -1.0f, matches);
+            });
+        for (size_t r = 0; r < rows; ++r)
+            store.put(r % 1000, data.data() + r * dim);
+        reader.join();
+        // The last compaction request may still be pending.
+        {
+            Timer timer("waiting for the last compaction: ");
+            while (store.logBytes() >= background.compactLogBytes && timer.Elapsed() < 5000)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        store.close();
+        failures += expect(store.open(path, dim, background).ok() && store.size() == 1000 &&
+                               store.logBytes() < background.compactLogBytes,
+                           "background compaction");
+        std::vector<float> out(dim);
+        bool latest = true;
+        for (size_t r = rows - 1000; latest && r < rows; r += 13)
+        {
+            latest = store.get(r % 1000, out.data()).ok() &&
+                     sameEmbedding(out.data(), data.data() + r * dim, dim, 1e-6f);
+        }
+        failures += expect(latest, "latest puts survive compaction");
+    }
+
+    {
+        // Half storage halves the mapped rows.
+        removeStore(path);
+        EmbeddingStoreOptions half = options;
+        half.storage = DataType::kHALF;
+        EmbeddingStore store;
+        bool ok = store.open(path, dim, half).ok();
+        for (size_t r = 0; r < 100; ++r)
+            store.put(r, data.data() + r * dim);
+        ok = ok && store.compact().ok();
+        std::vector<float> out(dim);
+        std::vector<StoreMatch> matches;
+        ok = ok && store.get(42, out.data()).ok() && sameEmbedding(out.data(), data.data() + 42 * dim, dim, 1e-3f);
+        ok = ok && store.topK(data.data() + 42 * dim, 1, -1.0f, matches).ok() && matches.size() == 1 &&
+             matches[0].id == 42;
+        store.close();
+        EmbeddingStore other;
+        failures += expect(ok && other.open(path, dim, options).statusCode() == StatusCode::kInvalidArgument,
+                           "half storage");
+        failures += expect(other.open(path, dim, {DataType::kINT8}).statusCode() == StatusCode::kInvalidArgument,
+                           "int8 storage is rejected");
+    }
+
+    {
+        // A damaged base file is refused before anything is read from it.
+        removeStore(path);
+        EmbeddingStore store;
+        store.open(path, dim, options);
+        for (size_t r = 0; r < 100; ++r)
+            store.put(r, data.data() + r * dim);
+        store.compact();
+        store.close();
+        std::vector<uint8_t> bytes;
+        if (std::FILE* file = std::fopen(path.c_str(), "rb"))
+        {
+            std::fseek(file, 0, SEEK_END);
+            bytes.resize(size_t(std::ftell(file)));
+            std::fseek(file, 0, SEEK_SET);
+            bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+            std::fclose(file);
+        }
+        embedding_store::FileHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        auto refused = [&](size_t offset, uint64_t value)
+        {
+            std::vector<uint8_t> damaged = bytes;
+            std::memcpy(damaged.data() + offset, &value, sizeof(value));
+            std::FILE* file = std::fopen(path.c_str(), "wb");
+            std::fwrite(damaged.data(), 1, damaged.size(), file);
+            std::fclose(file);
+            EmbeddingStore victim;
+            return victim.open(path, dim, options).statusCode() == StatusCode::kDataLoss;
+        };
+        bool safe = refused(offsetof(embedding_store::FileHeader, count), uint64_t(1) << 62);
+        safe &= refused(offsetof(embedding_store::FileHeader, rowsOffset), header.rowsOffset + 8);
+        safe &= refused(offsetof(embedding_store::FileHeader, rowsOffset), ~uint64_t(0) - 63);
+        safe &= refused(offsetof(embedding_store::FileHeader, idsOffset), bytes.size());
+        safe &= refused(offsetof(embedding_store::FileHeader, indexOffset), ~uint64_t(0) - 7);
+        safe &= refused(size_t(header.indexOffset) + offsetof(embedding_store::IndexEntry, row), header.count);
+        failures += expect(safe, "corrupt store files are refused");
+    }
+    removeStore(path);
+    return failures == 0 ? 0 : 1;
+}
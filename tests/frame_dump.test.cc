@@ -0,0 +1,182 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/framework/formats/frame_dump.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static void fillPattern(ImageFrame& frame, int seed)
+{
+    for (int y = 0; y < frame.height(); ++y)
+        for (int x = 0; x < frame.width() * frame.channels() * frame.byteDepth(); ++x)
+            frame.pixelData()[y * frame.step() + x] = static_cast<uint8_t>(x * 7 + y * 3 + seed);
+}
+
+static bool samePixels(const ConstImageFrameView& a, const ConstImageFrameView& b)
+{
+    if (a.format() != b.format() || a.width() != b.width() || a.height() != b.height())
+        return false;
+    for (int y = 0; y < a.height(); ++y)
+        if (std::memcmp(a.row(y), b.row(y), a.width() * a.channels() * a.byteDepth()) != 0)
+            return false;
+    return true;
+}
+
+int main()
+{
+    const std::string path = "frame_dump.test.bin";
+    const ImageFormat::Format formats[] = {ImageFormat::SRGB, ImageFormat::GRAY8, ImageFormat::SBGRA,
+                                           ImageFormat::VEC32F1};
+    std::vector<ImageFrame> expected;
+    for (int i = 0; i < 8; ++i)
+    {
+        ImageFrame frame(formats[i % 4], 97 + i * 13, 31 + i);
+        fillPattern(frame, i);
+        expected.push_back(std::move(frame));
+    }
+
+    FrameDumpWriter writer;
+    writer.open(path);
+    for (int i = 0; i < 8; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            // Copied into a staging buffer by the writer.
+            writer.write(ConstImageFrameView(expected[i]), 1000 + i);
+        }
+        else
+        {
+            ImageFrame copy;
+            copy.copyFrom(expected[i], ImageFrame::kDefaultAlignmentBoundary);
+            writer.write(std::move(copy), 1000 + i);
+        }
+    }
+    Status status = writer.close();
+    std::cout << "writer: " << status << ", frames " << writer.stats().framesWritten << ", bytes "
+              << writer.stats().bytesWritten << std::endl;
+
+    int failures = expect(status.ok() && writer.stats().framesWritten == expected.size(), "write and close");
+    auto verify = [&](const std::string& name)
+    {
+        FrameDumpReader reader;
+        Status s = reader.open(path);
+        bool ok = s.ok() && reader.size() == expected.size();
+        for (size_t i = 0; ok && i < reader.size(); ++i)
+        {
+            ImageFrame frame;
+            reader.frame(i, frame);
+            ok = samePixels(ConstImageFrameView(frame), ConstImageFrameView(expected[i])) &&
+                 reader.timestamp(i) == int64_t(1000 + i) &&
+                 reinterpret_cast<uintptr_t>(frame.pixelData()) % frame_dump::kDataAlignment == 0;
+        }
+        std::cout << name << ": " << s << ", frames " << reader.size() << std::endl;
+        failures += expect(ok, name);
+    };
+    verify("indexed read");
+
+    // Without the index, as if the recorder had crashed, the frames are found
+    // by walking their headers.
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        frame_dump::FileHeader header;
+        std::fread(&header, sizeof(header), 1, file);
+        header.indexOffset = 0;
+        std::fseek(file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+    }
+    verify("scanned read");
+
+    // A frame header whose rows do not fit in its data ends the frames found.
+    {
+        const long alignment = long(frame_dump::kDataAlignment);
+        const long headerSize = long(sizeof(frame_dump::FrameHeader));
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        frame_dump::FrameHeader header;
+        std::fseek(file, alignment - headerSize, SEEK_SET);
+        std::fread(&header, sizeof(header), 1, file);
+        const long firstEnd = alignment + long(header.dataSize);
+        const long secondHeader = (firstEnd + headerSize + alignment - 1) / alignment * alignment - headerSize;
+        std::fseek(file, secondHeader, SEEK_SET);
+        std::fread(&header, sizeof(header), 1, file);
+        header.step *= 64;
+        std::fseek(file, secondHeader, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+
+        FrameDumpReader reader;
+        failures += expect(reader.open(path).ok() && reader.size() == 1, "corrupt frame header");
+    }
+
+    {
+        FrameDumpWriter missing;
+        failures += expect(missing.open("no-such-directory/frame_dump.bin").statusCode() == StatusCode::kNotFound,
+                           "open in a missing directory");
+    }
+
+    // Writes racing close() are either written or rejected, never stranded
+    // behind the stop record where flush() would wait for them forever.
+    {
+        ImageFrame small(ImageFormat::GRAY8, 64, 64);
+        fillPattern(small, 1);
+        bool ok = true;
+        for (int round = 0; round < 50 && ok; ++round)
+        {
+            FrameDumpWriter racing;
+            racing.open(path);
+            std::thread producer(
+                [&]
+                {
+                    for (int i = 0; i < 200; ++i)
+                        racing.write(ConstImageFrameView(small), i);
+                });
+            std::this_thread::sleep_for(std::chrono::microseconds(round * 20));
+            racing.close();
+            producer.join();
+            racing.flush();
+            ok = racing.write(ConstImageFrameView(small), 0).statusCode() == StatusCode::kFailedPrecondition;
+        }
+        failures += expect(ok, "write racing close");
+    }
+
+    // Recording: the calling thread only pays for staging the copy. The 32
+    // frames fit under the default pending cap, so none is dropped however
+    // slow the disk.
+    ImageFrame frame(ImageFormat::SRGB, 1920, 1080);
+    fillPattern(frame, 0);
+    {
+        FrameDumpWriter recorder;
+        recorder.open(path);
+        {
+            Timer timer("stage 32 1080p frames: ");
+            for (int i = 0; i < 32; ++i)
+                recorder.write(ConstImageFrameView(frame), i);
+        }
+        recorder.close();
+        failures += expect(recorder.stats().framesWritten == 32 && recorder.stats().framesDropped == 0,
+                           "staged frames are all written");
+    }
+    {
+        FrameDumpReader reader;
+        reader.open(path);
+        uint64_t checksum = 0;
+        Timer timer("replay 32 1080p frames (touch one byte per page): ");
+        for (size_t i = 0; i < reader.size(); ++i)
+        {
+            ConstImageFrameView view = reader.view(i);
+            for (int offset = 0; offset < view.height() * view.step(); offset += 4096)
+                checksum += view.pixelData()[offset];
+        }
+        std::cout << "checksum " << checksum << std::endl;
+    }
+    std::remove(path.c_str());
+    return failures == 0 ? 0 : 1;
+}
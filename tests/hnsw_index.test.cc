@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "pillar/utility/hnsw_index.h"
+#include "pillar/utility/similarity.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(3);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    const unsigned int dim = 64;
+    const size_t rows = 20000, queries = 200, k = 10;
+    std::vector<float> data(rows * dim), query(queries * dim);
+    for (float& x : data)
+        x = dist(rng);
+    for (float& x : query)
+        x = dist(rng);
+
+    HnswOptions options;
+    options.M = 16;
+    options.efConstruction = 100;
+    HnswIndex index(dim, rows, options);
+    {
+        Timer timer("build 20000 x 64: ");
+        for (size_t r = 0; r < rows; ++r)
+            index.add(r, data.data() + r * dim);
+    }
+
+    // Exact baseline: every row scored with cosineSimilarity.
+    std::vector<std::vector<size_t>> truth(queries);
+    {
+        Timer timer("exact scan, 200 queries: ");
+        for (size_t q = 0; q < queries; ++q)
+        {
+            std::vector<std::pair<float, size_t>> scored(rows);
+            for (size_t r = 0; r < rows; ++r)
+                scored[r] = {math::cosineSimilarity(query.data() + q * dim, data.data() + r * dim, dim), r};
+            std::partial_sort(scored.begin(), scored.begin() + k, scored.end(),
+                              std::greater<std::pair<float, size_t>>());
+            for (size_t i = 0; i < k; ++i)
+                truth[q].push_back(scored[i].second);
+        }
+    }
+
+    for (unsigned int ef : {16u, 32u, 64u, 128u, 256u})
+    {
+        size_t hits1 = 0, hits10 = 0;
+        std::vector<IndexMatch> matches;
+        {
+            Timer timer("200 searches: ");
+            for (size_t q = 0; q < queries; ++q)
+            {
+                index.search(query.data() + q * dim, k, ef, matches);
+                hits1 += !matches.empty() && matches[0].label == truth[q][0];
+                for (const IndexMatch& m : matches)
+                    hits10 += std::count(truth[q].begin(), truth[q].end(), m.label);
+            }
+        }
+        const double recallAt10 = double(hits10) / double(queries * k);
+        std::cout << "ef " << ef << ": recall@1 " << double(hits1) / queries << ", recall@10 " << recallAt10
+                  << std::endl;
+        // Random gaussian vectors are the hard case, real embeddings cluster.
+        if (ef == 256)
+            failures += expect(recallAt10 > 0.95, "recall@10 above 0.95 at ef 256");
+    }
+
+    {
+        // Tombstoned labels never come back, and can be added again.
+        bool hidden = true;
+        for (size_t r = 0; r < 100; ++r)
+            index.remove(r);
+        std::vector<IndexMatch> matches;
+        for (size_t r = 0; r < 100; ++r)
+        {
+            index.search(data.data() + r * dim, k, matches);
+            for (const IndexMatch& m : matches)
+                hidden &= m.label >= 100;
+        }
+        failures += expect(hidden && index.deletedCount() == 100, "removed labels are not returned");
+        HnswIndex small(dim, 101, options);
+        for (size_t r = 0; r < 100; ++r)
+            small.add(r, data.data() + r * dim);
+        const bool statuses = small.add(5, data.data()).statusCode() == StatusCode::kAlreadyExists &&
+                              small.remove(1000).statusCode() == StatusCode::kNotFound && small.remove(5).ok() &&
+                              small.add(5, data.data() + 5 * dim).ok() &&
+                              small.add(6000, data.data()).statusCode() == StatusCode::kResourceExhausted;
+        small.search(data.data() + 5 * dim, 1, matches);
+        failures += expect(statuses && matches.size() == 1 && matches[0].label == 5, "labels, duplicates and capacity");
+    }
+
+    {
+        // The file round trip keeps the graph as it is.
+        const std::string path = "hnsw_index.test.bin";
+        const Status saved = index.save(path);
+        HnswIndex loaded(1, 0);
+        const Status status = loaded.load(path, rows + 10);
+        bool same = saved.ok() && status.ok() && loaded.size() == rows && loaded.dim() == dim &&
+                    loaded.deletedCount() == 100 && loaded.capacity() == rows + 10;
+        std::vector<IndexMatch> a, b;
+        for (size_t q = 0; same && q < queries; ++q)
+        {
+            index.search(query.data() + q * dim, k, a);
+            loaded.search(query.data() + q * dim, k, b);
+            same &= a.size() == b.size();
+            for (size_t i = 0; same && i < a.size(); ++i)
+                same &= a[i].label == b[i].label && a[i].score == b[i].score;
+        }
+        same &= loaded.add(rows + 1, query.data()).ok();
+        same &= loaded.add(rows + 1, query.data()).statusCode() == StatusCode::kAlreadyExists;
+        failures += expect(same, "save and load round trip");
+
+        // Damaged files are refused before they can send a search astray.
+        std::vector<uint8_t> bytes;
+        if (std::FILE* file = std::fopen(path.c_str(), "rb"))
+        {
+            std::fseek(file, 0, SEEK_END);
+            bytes.resize(size_t(std::ftell(file)));
+            std::fseek(file, 0, SEEK_SET);
+            bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+            std::fclose(file);
+        }
+        hnsw::FileHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        auto refused = [&](size_t offset, const void* value, size_t size, size_t length)
+        {
+            std::vector<uint8_t> damaged(bytes.begin(), bytes.begin() + length);
+            if (offset + size <= damaged.size())
+                std::memcpy(damaged.data() + offset, value, size);
+            std::FILE* file = std::fopen(path.c_str(), "wb");
+            std::fwrite(damaged.data(), 1, damaged.size(), file);
+            std::fclose(file);
+            // The victim holds a node, so a refused file must clear it.
+            HnswIndex victim(dim, 1);
+            victim.add(0, query.data());
+            return victim.load(path).statusCode() == StatusCode::kDataLoss && victim.size() == 0 &&
+                   victim.add(0, query.data()).ok();
+        };
+        auto patched = [&](size_t offset, auto value)
+        { return refused(offset, &value, sizeof(value), bytes.size()); };
+        const uint32_t badLevel = uint32_t(header.maxLevel + 1);
+        bool safe = patched(0, uint64_t(0));
+        safe &= patched(offsetof(hnsw::FileHeader, entryPoint), int64_t(header.count));
+        safe &= patched(offsetof(hnsw::FileHeader, count), uint64_t(1) << 40);
+        safe &= patched(offsetof(hnsw::FileHeader, stride), uint64_t(1) << 60);
+        safe &= patched(size_t(header.levelsOffset), badLevel);
+        safe &= patched(size_t(header.linksOffset), uint32_t(2 * options.M + 1));
+        safe &= patched(size_t(header.linksOffset) + 4, uint32_t(header.count));
+        safe &= refused(0, nullptr, 0, bytes.size() - 1);
+        std::remove(path.c_str());
+        failures += expect(safe, "corrupt index files are refused");
+    }
+
+    {
+        // Writers and readers at once; afterwards every row finds itself.
+        const size_t perThread = 1500, writers = 4;
+        HnswIndex shared(dim, perThread * writers, options);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < writers; ++t)
+            threads.emplace_back(
+                [&, t]
+                {
+                    for (size_t i = 0; i < perThread; ++i)
+                    {
+                        const size_t r = t * perThread + i;
+                        shared.add(r, data.data() + r * dim);
+                    }
+                });
+        for (size_t t = 0; t < 2; ++t)
+            threads.emplace_back(
+                [&]
+                {
+                    std::vector<IndexMatch> matches;
+                    for (size_t q = 0; q < 300; ++q)
+                        shared.search(query.data() + (q % queries) * dim, k, matches);
+                });
+        for (std::thread& t : threads)
+            t.join();
+        size_t found = 0;
+        std::vector<IndexMatch> matches;
+        for (size_t r = 0; r < perThread * writers; ++r)
+        {
+            shared.search(data.data() + r * dim, 1, matches);
+            found += !matches.empty() && matches[0].label == r;
+        }
+        std::cout << "self recall after concurrent build: " << double(found) / (perThread * writers) << std::endl;
+        failures += expect(shared.size() == perThread * writers && found >= perThread * writers * 99 / 100,
+                           "concurrent inserts and searches");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/framework/formats/image_format_conversion.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static const char* name(ImageFormat::Format format)
+{
+    switch (format)
+    {
+        case ImageFormat::SRGB:
+            return "SRGB";
+        case ImageFormat::SRGBA:
+            return "SRGBA";
+        case ImageFormat::SBGRA:
+            return "SBGRA";
+        case ImageFormat::GRAY8:
+            return "GRAY8";
+        case ImageFormat::GRAY16:
+            return "GRAY16";
+        case ImageFormat::SRGB48:
+            return "SRGB48";
+        case ImageFormat::VEC32F1:
+            return "VEC32F1";
+        default:
+            return "?";
+    }
+}
+
+static void fillRandom(ImageFrame& frame)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> bytes(0, 255);
+    std::uniform_real_distribution<float> values(-0.1f, 1.1f);
+    for (int y = 0; y < frame.height(); ++y)
+    {
+        uint8_t* row = frame.pixelData() + y * frame.step();
+        if (frame.format() == ImageFormat::VEC32F1)
+        {
+            float* f = reinterpret_cast<float*>(row);
+            for (int x = 0; x < frame.width(); ++x)
+                f[x] = values(gen);
+        }
+        else
+        {
+            for (int x = 0; x < frame.width() * frame.channels() * frame.byteDepth(); ++x)
+                row[x] = static_cast<uint8_t>(bytes(gen));
+        }
+    }
+}
+
+static bool samePixels(const ImageFrame& a, const ImageFrame& b)
+{
+    const int rowBytes = a.width() * a.channels() * a.byteDepth();
+    for (int y = 0; y < a.height(); ++y)
+    {
+        if (std::memcmp(a.pixelData() + y * a.step(), b.pixelData() + y * b.step(), rowBytes) != 0)
+            return false;
+    }
+    return true;
+}
+
+static void timeConversion(const std::string& label, const ImageFrame& src, ImageFrame& dst, cpu::SimdLevel level)
+{
+    Timer timer(label);
+    for (int i = 0; i < 20; ++i)
+    {
+        convertFormat(ConstImageFrameView(src), ImageFrameView(dst), level);
+    }
+}
+
+int main()
+{
+    const std::pair<ImageFormat::Format, ImageFormat::Format> pairs[] = {
+        {ImageFormat::SRGB, ImageFormat::SBGRA},    {ImageFormat::SBGRA, ImageFormat::SRGB},
+        {ImageFormat::SRGB, ImageFormat::SRGBA},    {ImageFormat::SRGBA, ImageFormat::SRGB},
+        {ImageFormat::SRGBA, ImageFormat::SBGRA},   {ImageFormat::SRGB, ImageFormat::GRAY8},
+        {ImageFormat::SRGBA, ImageFormat::GRAY8},   {ImageFormat::SBGRA, ImageFormat::GRAY8},
+        {ImageFormat::GRAY8, ImageFormat::SRGB},    {ImageFormat::GRAY8, ImageFormat::SBGRA},
+        {ImageFormat::GRAY8, ImageFormat::GRAY16},  {ImageFormat::GRAY16, ImageFormat::GRAY8},
+        {ImageFormat::SRGB, ImageFormat::SRGB48},   {ImageFormat::SRGB48, ImageFormat::SRGB},
+        {ImageFormat::GRAY8, ImageFormat::VEC32F1}, {ImageFormat::GRAY16, ImageFormat::VEC32F1},
+        {ImageFormat::VEC32F1, ImageFormat::GRAY8},
+    };
+
+    std::cout << "simd level: " << cpu::simdLevel() << std::endl;
+    int failures = 0;
+    // An odd width exercises the scalar tails of the SIMD kernels.
+    for (auto [from, to] : pairs)
+    {
+        ImageFrame src(from, 1917, 1080);
+        fillRandom(src);
+
+        ImageFrame reference(to, src.width(), src.height());
+        ImageFrame simd(to, src.width(), src.height());
+        convertFormat(ConstImageFrameView(src), ImageFrameView(reference), cpu::SimdLevel::kScalar);
+        Status status = convertFormat(src, to, simd);
+        const std::string conversion = std::string(name(from)) + " -> " + name(to);
+        failures += expect(status.ok() && samePixels(reference, simd), conversion);
+
+        timeConversion("  scalar x20: ", src, reference, cpu::SimdLevel::kScalar);
+        timeConversion("  sse41 x20: ", src, simd, cpu::SimdLevel::kSSE41);
+        timeConversion("  avx2 x20: ", src, simd, cpu::SimdLevel::kAVX2);
+    }
+
+    ImageFrame lab(ImageFormat::LAB8, 4, 4);
+    ImageFrame out;
+    failures += expect(convertFormat(lab, ImageFormat::SRGB, out).statusCode() == StatusCode::kUnimplemented,
+                       "unsupported conversions are refused");
+    return failures == 0 ? 0 : 1;
+}
@@ -1,10 +1,15 @@
 #include <iostream>
 
 #include "pillar/framework/formats/image_frame.h"
+#include "pillar/framework/formats/image_frame_view.h"
+#include "pillar/utility/test.h"
 
 using namespace yuzu;
+using test::expect;
+
 int main()
 {
+    int failures = 0;
     yuzu::ImageFrame img1(ImageFormat::SRGB, 112, 112);
     std::cout << "image(1): " << img1 << std::endl;
     std::cout << "image(1) contiguous: " << img1.isContiguous() << std::endl;
@@ -14,5 +19,31 @@ int main()
     std::cout << "image(2): " << img2 << std::endl;
     std::cout << "image(2) contiguous: " << img2.isContiguous() << std::endl;
     std::cout << "image(2) step: " << img2.step() << "|" << 111 % sizeof(void*) << std::endl;
-    return 0;
+
+    yuzu::ImageFrameView face(img2, yuzu::Rectangle<int>(10, 20, 32, 48));
+    face.setToZero();
+    std::cout << "view: [" << face.width() << ", " << face.height() << ", " << face.channels() << "]" << std::endl;
+    std::cout << "view contiguous: " << face.isContiguous() << " step: " << face.step() << std::endl;
+
+    yuzu::ConstImageFrameView clipped = yuzu::ConstImageFrameView(img2).crop(yuzu::Rectangle<int>(100, 100, 32, 32));
+    std::cout << "clipped view: [" << clipped.width() << ", " << clipped.height() << "]" << std::endl;
+
+    yuzu::ImageFrame crop;
+    crop.copyFrom(face, 1);
+    std::cout << "crop: " << crop << " contiguous: " << crop.isContiguous() << std::endl;
+
+    {
+        // A frame can take over a crop of itself.
+        ImageFrame frame(ImageFormat::GRAY8, 64, 48);
+        for (int y = 0; y < frame.height(); ++y)
+            for (int x = 0; x < frame.width(); ++x)
+                frame.pixelData()[y * frame.step() + x] = uint8_t(x + 3 * y);
+        frame.copyFrom(ConstImageFrameView(frame).crop(Rectangle<int>(10, 5, 20, 30)), 1);
+        bool same = frame.width() == 20 && frame.height() == 30;
+        for (int y = 0; same && y < frame.height(); ++y)
+            for (int x = 0; x < frame.width(); ++x)
+                same &= frame.pixelData()[y * frame.step() + x] == uint8_t(x + 10 + 3 * (y + 5));
+        failures += expect(same, "copy from a crop of the same frame");
+    }
+    return failures == 0 ? 0 : 1;
 }
\ No newline at end of file
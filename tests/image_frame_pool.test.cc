@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "pillar/framework/formats/image_frame_pool.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static bool sameStats(const ImageFramePool& pool, size_t hits, size_t misses, size_t bytesRetained,
+                      size_t highWaterMark)
+{
+    const ImageFramePool::Stats stats = pool.stats();
+    std::cout << "  hits: " << stats.hits << ", misses: " << stats.misses << ", retained: " << stats.bytesRetained
+              << ", high water mark: " << stats.highWaterMark << std::endl;
+    return stats.hits == hits && stats.misses == misses && stats.bytesRetained == bytesRetained &&
+           stats.highWaterMark == highWaterMark;
+}
+
+int main()
+{
+    int failures = 0;
+    // 1920 * 3 bytes is already a multiple of the 16 byte alignment.
+    const size_t frameBytes = size_t(1920) * 3 * 1080;
+    const size_t grayBytes = size_t(640) * 480;
+
+    ImageFramePool pool;
+    {
+        ImageFrame img1 = pool.acquire(ImageFormat::SRGB, 1920, 1080);
+        failures += expect(!img1.isEmpty() && img1.isAligned(16) && img1.step() == 1920 * 3,
+                           "acquire has the ImageFrame layout");
+    }
+    failures += expect(sameStats(pool, 0, 1, frameBytes, frameBytes), "release keeps the buffer");
+
+    {
+        ImageFrame img2 = pool.acquire(ImageFormat::SRGB, 1920, 1080);
+        for (int i = 0; i < img2.pixelDataSize(); ++i)
+            img2.pixelData()[i] = uint8_t(i * 7);
+        ImageFrame img3 = pool.acquireCopy(img2);
+        failures += expect(img3.pixelData() != img2.pixelData() &&
+                               std::memcmp(img3.pixelData(), img2.pixelData(), frameBytes) == 0,
+                           "acquireCopy copies the pixels");
+        failures += expect(sameStats(pool, 1, 2, 0, 2 * frameBytes), "reuse, then a second buffer");
+    }
+    failures += expect(sameStats(pool, 1, 2, 2 * frameBytes, 2 * frameBytes), "both buffers return");
+
+    pool.reserve(ImageFormat::GRAY8, 640, 480, 1, 4);
+    failures += expect(sameStats(pool, 1, 2, 2 * frameBytes + 4 * grayBytes, 2 * frameBytes + 4 * grayBytes),
+                       "reserve fills the pool");
+
+    ImageFrame outlive = pool.acquire(ImageFormat::GRAY8, 640, 480, 1);
+    failures += expect(outlive.isContiguous() &&
+                           sameStats(pool, 2, 2, 2 * frameBytes + 3 * grayBytes, 2 * frameBytes + 4 * grayBytes),
+                       "reserved buffers are hits");
+    pool.clear();
+    failures += expect(sameStats(pool, 2, 2, 0, 2 * frameBytes + 4 * grayBytes), "clear frees what is retained");
+
+    std::fill(outlive.pixelData(), outlive.pixelData() + outlive.pixelDataSize(), uint8_t(9));
+    const bool intact = std::all_of(outlive.pixelData(), outlive.pixelData() + outlive.pixelDataSize(),
+                                    [](uint8_t v) { return v == 9; });
+    outlive = ImageFrame();
+    failures += expect(intact && sameStats(pool, 2, 2, grayBytes, 2 * frameBytes + 4 * grayBytes),
+                       "a frame handed out survives clear and returns");
+
+    {
+        Timer timer("pooled 1000 x 1080p: ");
+        for (int i = 0; i < 1000; ++i)
+        {
+            ImageFrame frame = pool.acquire(ImageFormat::SRGB, 1920, 1080);
+            frame.setToZero();
+        }
+    }
+    {
+        Timer timer("unpooled 1000 x 1080p: ");
+        for (int i = 0; i < 1000; ++i)
+        {
+            ImageFrame frame(ImageFormat::SRGB, 1920, 1080);
+            frame.setToZero();
+        }
+    }
+    failures += expect(sameStats(pool, 1001, 3, grayBytes + frameBytes, 2 * frameBytes + 4 * grayBytes),
+                       "a steady stream allocates once");
+    return failures == 0 ? 0 : 1;
+}
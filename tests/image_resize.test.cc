@@ -0,0 +1,85 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "pillar/framework/formats/image_resize.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// Every 2x2 block of `src` averaged, which both modes must reproduce for an
+// exact 2x downscale.
+static int checkHalving(ImageFormat::Format format, InterpolationMode mode)
+{
+    ImageFrame src(format, 64, 48);
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> values(0, 255);
+    const int channels = src.channels();
+    for (int y = 0; y < src.height(); ++y)
+        for (int i = 0; i < src.width() * channels; ++i)
+        {
+            uint8_t* row = src.pixelData() + y * src.step();
+            if (src.byteDepth() == 1)
+                row[i] = static_cast<uint8_t>(values(gen));
+            else
+                reinterpret_cast<float*>(row)[i] = values(gen) / 255.0f;
+        }
+
+    ImageFrame dst;
+    resize(src, 32, 24, dst, mode);
+    double maxError = 0.0;
+    for (int y = 0; y < dst.height(); ++y)
+        for (int i = 0; i < dst.width() * channels; ++i)
+        {
+            const int x = i / channels, c = i % channels;
+            auto at = [&](int sy, int sx)
+            {
+                const uint8_t* row = src.pixelData() + sy * src.step();
+                const int j = sx * channels + c;
+                return src.byteDepth() == 1 ? double(row[j]) : double(reinterpret_cast<const float*>(row)[j]);
+            };
+            const double expected = (at(2 * y, 2 * x) + at(2 * y, 2 * x + 1) + at(2 * y + 1, 2 * x) +
+                                     at(2 * y + 1, 2 * x + 1)) / 4.0;
+            const uint8_t* row = dst.pixelData() + y * dst.step();
+            const double value =
+                dst.byteDepth() == 1 ? double(row[i]) : double(reinterpret_cast<const float*>(row)[i]);
+            maxError = std::max(maxError, std::fabs(value - expected));
+        }
+
+    const double tolerance = src.byteDepth() == 1 ? 0.5 + 1e-3 : 1e-5;
+    return expect(maxError <= tolerance, "format " + std::to_string(format) + " mode " + std::to_string(int(mode)) +
+                                             " halving max error " + std::to_string(maxError));
+}
+
+int main()
+{
+    int failures = 0;
+    for (auto format : {ImageFormat::GRAY8, ImageFormat::SRGB, ImageFormat::SRGBA, ImageFormat::VEC32F1})
+        for (auto mode : {InterpolationMode::kBilinear, InterpolationMode::kArea})
+            failures += checkHalving(format, mode);
+
+    ImageFrame frame(ImageFormat::SRGB, 1920, 1080);
+    frame.setToZero();
+    ImageFrame boxed(ImageFormat::SRGB, 640, 640);
+    Rectangle<float> mapping;
+    Status status = letterbox(ConstImageFrameView(frame), ImageFrameView(boxed), mapping,
+                              InterpolationMode::kBilinear, 114.0f);
+    std::cout << "letterbox mapping " << mapping << std::endl;
+    failures += expect(status.ok() && boxed.pixelData()[0] == 114, "letterbox pads with the border value");
+
+    ImageFrame small;
+    {
+        Timer timer("bilinear 1080p -> 640x360 x100: ");
+        for (int i = 0; i < 100; ++i)
+            resize(frame, 640, 360, small, InterpolationMode::kBilinear);
+    }
+    {
+        Timer timer("area 1080p -> 640x360 x100: ");
+        for (int i = 0; i < 100; ++i)
+            resize(frame, 640, 360, small, InterpolationMode::kArea);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/framework/formats/image_to_tensor.h"
+#include "pillar/utility/half.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static void fillRandom(ImageFrame& frame)
+{
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> bytes(0, 255);
+    for (int i = 0; i < frame.pixelDataSize(); ++i)
+        frame.pixelData()[i] = static_cast<uint8_t>(bytes(gen));
+}
+
+// Straightforward per-element reference.
+static float expected(const ImageFrame& frame, const TensorConversionOptions& options, int c, int y, int x)
+{
+    const uint8_t* px = frame.pixelData() + y * frame.step() + x * frame.channels();
+    int index = 0;
+    if (frame.format() != ImageFormat::GRAY8)
+    {
+        const int rgbChannel = options.channelOrder == ChannelOrder::kRGB ? c : 2 - c;
+        index = frame.format() == ImageFormat::SBGRA ? 2 - rgbChannel : rgbChannel;
+    }
+    return (px[index] - options.mean[c]) * options.scale[c];
+}
+
+static int check(ImageFormat::Format format, TensorLayout layout, ChannelOrder order, DataType type)
+{
+    ImageFrame frame(format, 301, 37);
+    fillRandom(frame);
+    const int channels = format == ImageFormat::GRAY8 ? 1 : 3;
+
+    TensorConversionOptions options;
+    options.layout = layout;
+    options.channelOrder = order;
+    options.dataType = type;
+    options.batchIndex = 1;
+    for (int c = 0; c < 3; ++c)
+    {
+        options.mean[c] = 100.0f + 10.0f * c;
+        options.scale[c] = 1.0f / (50.0f + 5.0f * c);
+    }
+
+    const int h = frame.height(), w = frame.width();
+    Dims dims = layout == TensorLayout::kNCHW ? Dims{{2, channels, h, w}, 4} : Dims{{2, h, w, channels}, 4};
+    std::vector<float> f32(2 * channels * h * w);
+    std::vector<uint16_t> f16(f32.size());
+    void* buffer = type == DataType::kFLOAT ? static_cast<void*>(f32.data()) : static_cast<void*>(f16.data());
+    const std::string what = "format " + std::to_string(format) + ", layout " + std::to_string(int(layout)) +
+                             ", order " + std::to_string(int(order)) + ", type " + std::to_string(int(type));
+    Status status = toTensor(ConstImageFrameView(frame), options, buffer, dims);
+    if (!status.ok())
+    {
+        std::cout << status << std::endl;
+        return expect(false, what);
+    }
+
+    const size_t base = size_t(channels) * h * w;
+    float maxError = 0.0f;
+    for (int c = 0; c < channels; ++c)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+            {
+                const size_t i = base + (layout == TensorLayout::kNCHW ? (size_t(c) * h + y) * w + x
+                                                                       : (size_t(y) * w + x) * channels + c);
+                const float value = type == DataType::kFLOAT ? f32[i] : halfToFloat(f16[i]);
+                maxError = std::max(maxError, std::fabs(value - expected(frame, options, c, y, x)));
+            }
+
+    const float tolerance = type == DataType::kFLOAT ? 1e-5f : 4e-3f;
+    return expect(maxError <= tolerance, what + ", max error " + std::to_string(maxError));
+}
+
+int main()
+{
+    int failures = 0;
+    for (ImageFormat::Format format : {ImageFormat::SRGB, ImageFormat::SBGRA, ImageFormat::GRAY8})
+        for (TensorLayout layout : {TensorLayout::kNCHW, TensorLayout::kNHWC})
+            for (ChannelOrder order : {ChannelOrder::kRGB, ChannelOrder::kBGR})
+                for (DataType type : {DataType::kFLOAT, DataType::kHALF})
+                    failures += check(format, layout, order, type);
+
+    // One fused pass against copy + normalize + transpose.
+    ImageFrame frame(ImageFormat::SRGB, 640, 640);
+    fillRandom(frame);
+    std::vector<float> tensor(3 * 640 * 640);
+    std::vector<uint8_t> packed(3 * 640 * 640);
+    std::vector<float> normalized(3 * 640 * 640);
+    TensorConversionOptions options;
+    const float mean[3] = {123.675f, 116.28f, 103.53f};
+    const float scale[3] = {1 / 58.395f, 1 / 57.12f, 1 / 57.375f};
+    std::copy(mean, mean + 3, options.mean);
+    std::copy(scale, scale + 3, options.scale);
+    Dims dims{{1, 3, 640, 640}, 4};
+    {
+        Timer timer("fused toTensor x100: ");
+        for (int i = 0; i < 100; ++i)
+            toTensor(ConstImageFrameView(frame), options, tensor.data(), dims);
+    }
+    {
+        Timer timer("three passes x100: ");
+        for (int i = 0; i < 100; ++i)
+        {
+            frame.copyToBuffer(packed.data(), int(packed.size()));
+            for (size_t j = 0; j < packed.size(); ++j)
+                normalized[j] = (packed[j] - mean[j % 3]) * scale[j % 3];
+            for (int c = 0; c < 3; ++c)
+                for (int p = 0; p < 640 * 640; ++p)
+                    tensor[c * 640 * 640 + p] = normalized[p * 3 + c];
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/framework/formats/image_warp.h"
+#include "pillar/utility/point_transform.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static bool near(const Point2<float>& a, const Point2<float>& b, float tolerance = 1e-3f)
+{
+    return std::fabs(a.x() - b.x()) <= tolerance && std::fabs(a.y() - b.y()) <= tolerance;
+}
+
+template <class M>
+static bool near(const M& a, const M& b, int size, float tolerance = 1e-4f)
+{
+    for (int i = 0; i < size; ++i)
+    {
+        if (std::fabs(a.data()[i] - b.data()[i]) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+static double value(const ImageFrame& frame, int x, int y, int c)
+{
+    const uint8_t* row = frame.pixelData() + y * frame.step();
+    const int i = x * frame.channels() + c;
+    switch (frame.byteDepth())
+    {
+        case 1:
+            return row[i];
+        case 2:
+            return reinterpret_cast<const uint16_t*>(row)[i];
+        default:
+            return reinterpret_cast<const float*>(row)[i];
+    }
+}
+
+static void fillRandom(ImageFrame& frame, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    const double range = frame.byteDepth() == 1 ? 255.0 : frame.byteDepth() == 2 ? 65535.0 : 1.0;
+    for (int y = 0; y < frame.height(); ++y)
+    {
+        uint8_t* row = frame.pixelData() + y * frame.step();
+        for (int i = 0; i < frame.width() * frame.channels(); ++i)
+        {
+            const double v = dist(rng) * range;
+            if (frame.byteDepth() == 1)
+                row[i] = uint8_t(v);
+            else if (frame.byteDepth() == 2)
+                reinterpret_cast<uint16_t*>(row)[i] = uint16_t(v);
+            else
+                reinterpret_cast<float*>(row)[i] = float(v);
+        }
+    }
+}
+
+// Bilinear in double, tap by tap.
+static double reference(const ImageFrame& src, const Matrix2x3<double>& inverse, int x, int y, int c, double border)
+{
+    const Point2<double> s = inverse * Point2<double>(x, y);
+    const double fx0 = std::floor(s.x()), fy0 = std::floor(s.y());
+    const double fx = s.x() - fx0, fy = s.y() - fy0;
+    auto at = [&](double tx, double ty)
+    {
+        if (tx < 0 || ty < 0 || tx >= src.width() || ty >= src.height())
+            return border;
+        return value(src, int(tx), int(ty), c);
+    };
+    return (1 - fx) * (1 - fy) * at(fx0, fy0) + fx * (1 - fy) * at(fx0 + 1, fy0) + (1 - fx) * fy * at(fx0, fy0 + 1) +
+           fx * fy * at(fx0 + 1, fy0 + 1);
+}
+
+// Both kernels against the reference, under rotation, scaling and borders.
+static bool checkWarp(ImageFormat::Format format, std::mt19937& rng)
+{
+    ImageFrame src(format, 61, 47), dst(format, 40, 52);
+    fillRandom(src, rng);
+    const Matrix2x3<float> transform = Matrix2x3<float>::similarity(0.8f, 0.4f, -3.0f, 8.0f);
+    Matrix2x3<float> inverse;
+    transform.invert(inverse);
+    Matrix2x3<double> inverseD;
+    for (int i = 0; i < 6; ++i)
+        inverseD.data()[i] = inverse.data()[i];
+    const double tolerance = src.byteDepth() == 4 ? 1e-4 : 1.0;
+    const float border = src.byteDepth() == 4 ? 0.25f : 7.0f;
+
+    for (cpu::SimdLevel level : {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2})
+    {
+        if (!warpAffine(ConstImageFrameView(src), ImageFrameView(dst), transform, border, level).ok())
+            return false;
+        for (int y = 0; y < dst.height(); ++y)
+            for (int x = 0; x < dst.width(); ++x)
+                for (int c = 0; c < dst.channels(); ++c)
+                {
+                    const double expected = reference(src, inverseD, x, y, c, border);
+                    const double rounded = src.byteDepth() == 4 ? expected : std::round(expected);
+                    if (std::fabs(value(dst, x, y, c) - rounded) > tolerance)
+                        return false;
+                }
+    }
+    return true;
+}
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(25);
+
+    {
+        const Matrix2x3<float> a = Matrix2x3<float>::similarity(1.5f, 0.3f, 4.0f, -2.0f);
+        const Matrix2x3<float> b = Matrix2x3<float>::translation(3.0f, 5.0f) * Matrix2x3<float>::scaling(2.0f, 0.5f);
+        Matrix2x3<float> inverse;
+        bool ok = a.invert(inverse) && near(a * inverse, Matrix2x3<float>(), 6) &&
+                  near(inverse * a, Matrix2x3<float>(), 6);
+        const Point2<float> p(7.0f, -1.0f);
+        ok &= near((a * b) * p, a * (b * p)) && near(b * p, Point2<float>(17.0f, 4.5f));
+        const deps::Vector2<float> h = a * deps::Vector3<float>(p.x(), p.y(), 1.0f);
+        ok &= near(Point2<float>(h.x(), h.y()), a * p);
+        ok &= !Matrix2x3<float>::scaling(0.0f, 1.0f).invert(inverse);
+
+        const Matrix3x3<float> homography(1.1f, 0.2f, 5.0f, -0.1f, 0.9f, 3.0f, 0.001f, 0.002f, 1.0f);
+        Matrix3x3<float> homographyInverse;
+        ok &= homography.invert(homographyInverse) && near(homography * homographyInverse, Matrix3x3<float>(), 9);
+        ok &= near(homographyInverse * (homography * p), p) && near(Matrix3x3<float>(a) * p, a * p);
+        ok &= Matrix3x3<float>(a).isAffine() && Matrix3x3<float>(a).affine() == a && !homography.isAffine();
+        ok &= std::fabs(homography.determinant() - homography.transpose().determinant()) < 1e-5f;
+        failures += expect(ok, "matrix algebra");
+    }
+
+    {
+        // The ArcFace five-point template and landmarks that are a known
+        // similarity of it.
+        const std::vector<Point2<float>> reference = {{38.2946f, 51.6963f}, {73.5318f, 51.5014f}, {56.0252f, 71.7366f},
+                                                      {41.5493f, 92.3655f}, {70.7299f, 92.2041f}};
+        const Matrix2x3<float> truth = Matrix2x3<float>::similarity(2.7f, -0.35f, 410.0f, 220.0f);
+        Matrix2x3<float> truthInverse;
+        truth.invert(truthInverse);
+        std::vector<Point2<float>> landmarks;
+        for (const auto& p : reference)
+            landmarks.push_back(truthInverse * p);
+        Matrix2x3<float> estimate;
+        bool ok = math::estimateSimilarity(landmarks.data(), reference.data(), 5, estimate).ok();
+        ok &= near(estimate, truth, 6, 1e-2f);
+        ok &= math::estimateSimilarity(reference.data(), landmarks.data(), 5, estimate).ok() &&
+              near(estimate, truthInverse, 6, 1e-3f);
+
+        // A reflection of the template is fitted by the best rotation, not mirrored.
+        std::vector<Point2<float>> mirrored;
+        for (const auto& p : reference)
+            mirrored.push_back(Point2<float>(-p.x(), p.y()));
+        ok &= math::estimateSimilarity(reference.data(), mirrored.data(), 5, estimate).ok() &&
+              estimate.determinant() >= 0.0f;
+        const std::vector<Point2<float>> same(3, Point2<float>(1.0f, 1.0f));
+        ok &= math::estimateSimilarity(same.data(), reference.data(), 3, estimate).statusCode() ==
+              StatusCode::kInvalidArgument;
+        ok &= math::estimateSimilarity(reference.data(), reference.data(), 1, estimate).statusCode() ==
+              StatusCode::kInvalidArgument;
+        failures += expect(ok, "similarity estimation");
+    }
+
+    {
+        std::uniform_real_distribution<float> coord(-500.0f, 500.0f);
+        const Matrix2x3<float> affine = Matrix2x3<float>::similarity(1.2f, 0.7f, 30.0f, -12.0f);
+        const Matrix3x3<float> homography(1.1f, 0.2f, 5.0f, -0.1f, 0.9f, 3.0f, 0.0001f, 0.0002f, 1.0f);
+        bool ok = true;
+        for (size_t n : {size_t(0), size_t(1), size_t(5), size_t(8), size_t(13), size_t(468)})
+        {
+            std::vector<Point2<float>> points(n);
+            for (auto& p : points)
+                p = Point2<float>(coord(rng), coord(rng));
+            for (cpu::SimdLevel level : {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2, cpu::SimdLevel::kAVX512})
+            {
+                std::vector<Point2<float>> a = points, h = points;
+                math::transformPoints(affine, a.data(), a.data(), n, level);
+                math::transformPoints(homography, h.data(), h.data(), n, level);
+                for (size_t i = 0; i < n; ++i)
+                    ok &= near(a[i], affine * points[i], 1e-3f) && near(h[i], homography * points[i], 1e-3f);
+            }
+        }
+        failures += expect(ok, "batched point transforms");
+    }
+
+    {
+        bool ok = true;
+        for (auto format : {ImageFormat::GRAY8, ImageFormat::SRGB, ImageFormat::SRGBA, ImageFormat::SRGB48,
+                            ImageFormat::VEC32F1, ImageFormat::VEC32F2})
+            ok &= checkWarp(format, rng);
+        failures += expect(ok, "warps match the reference");
+
+        // An integer translation copies pixels exactly.
+        ImageFrame src(ImageFormat::SRGB, 32, 24), dst(ImageFormat::SRGB, 32, 24);
+        fillRandom(src, rng);
+        warpAffine(ConstImageFrameView(src), ImageFrameView(dst), Matrix2x3<float>::translation(2.0f, 3.0f), 9.0f);
+        bool shifted = value(dst, 0, 0, 0) == 9.0 && value(dst, 1, 5, 2) == 9.0;
+        for (int y = 3; y < 24; ++y)
+            for (int x = 2; x < 32; ++x)
+                for (int c = 0; c < 3; ++c)
+                    shifted &= value(dst, x, y, c) == value(src, x - 2, y - 3, c);
+        failures += expect(shifted, "translation");
+
+        ImageFrame gray(ImageFormat::GRAY8, 32, 24);
+        ok = warpAffine(ConstImageFrameView(src), ImageFrameView(gray), Matrix2x3<float>()).statusCode() ==
+             StatusCode::kInvalidArgument;
+        ok &= warpAffine(ConstImageFrameView(src), ImageFrameView(dst), Matrix2x3<float>::scaling(0.0f, 1.0f))
+                  .statusCode() == StatusCode::kInvalidArgument;
+        failures += expect(ok, "formats must match and the transform must be invertible");
+
+        // Crops of one frame may be warped into each other only if their rows
+        // do not share memory.
+        const Matrix2x3<float> shift = Matrix2x3<float>::translation(1.0f, 1.0f);
+        ok = warpAffine(ConstImageFrameView(src).crop(Rectangle<int>(0, 0, 16, 12)),
+                        ImageFrameView(src, Rectangle<int>(8, 6, 16, 12)), shift)
+                 .statusCode() == StatusCode::kInvalidArgument;
+        ok &= warpAffine(ConstImageFrameView(src).crop(Rectangle<int>(0, 0, 16, 12)),
+                         ImageFrameView(src, Rectangle<int>(8, 12, 16, 12)), shift)
+                  .ok();
+        failures += expect(ok, "overlapping crops are refused");
+    }
+
+    {
+        // Face alignment: 50 crops of 112 x 112 from a 720p frame.
+        ImageFrame frame(ImageFormat::SRGB, 1280, 720);
+        fillRandom(frame, rng);
+        std::vector<ImageFrame> crops;
+        std::vector<Matrix2x3<float>> transforms;
+        std::uniform_real_distribution<float> x(100.0f, 1180.0f), y(100.0f, 620.0f), angle(-0.5f, 0.5f);
+        for (int f = 0; f < 50; ++f)
+        {
+            crops.emplace_back(ImageFormat::SRGB, 112, 112);
+            transforms.push_back(Matrix2x3<float>::translation(56.0f, 56.0f) *
+                                 Matrix2x3<float>::similarity(0.7f, angle(rng), 0.0f, 0.0f) *
+                                 Matrix2x3<float>::translation(-x(rng), -y(rng)));
+        }
+        const int repeats = 20;
+        const char* names[] = {"scalar", "avx2"};
+        const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2};
+        for (int l = 0; l < 2; ++l)
+        {
+            const std::string label = std::string(names[l]) + " 50 aligned faces x20: ";
+            Timer timer(label);
+            for (int r = 0; r < repeats; ++r)
+                for (int f = 0; f < 50; ++f)
+                    warpAffine(ConstImageFrameView(frame), ImageFrameView(crops[f]), transforms[f], 0.0f, levels[l]);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
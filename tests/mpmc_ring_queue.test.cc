@@ -0,0 +1,138 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/thread_pool/mpmc_ring_queue.h"
+#include "pillar/thread_pool/threadsafe_queue.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// Counts heap allocations to check the steady state of the ring.
+static std::atomic<size_t> gAllocations{0};
+
+void* operator new(size_t size)
+{
+    ++gAllocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// `producers` threads push `perProducer` items each, `consumers` threads pop
+// them all. Prints the time under `label`, returns the sum of popped items.
+template <class Queue>
+static long transfer(const std::string& label, Queue& queue, int producers, int consumers, long perProducer)
+{
+    std::atomic<long> total{0};
+    std::vector<std::thread> threads;
+    const long items = perProducer * producers;
+    std::atomic<long> popped{0};
+    Timer timer(label);
+    for (int p = 0; p < producers; ++p)
+        threads.emplace_back(
+            [&]
+            {
+                for (long i = 1; i <= perProducer; ++i)
+                    queue.push(i);
+            });
+    for (int c = 0; c < consumers; ++c)
+        threads.emplace_back(
+            [&]
+            {
+                long local = 0;
+                while (popped.fetch_add(1, std::memory_order_relaxed) < items)
+                {
+                    long value = 0;
+                    queue.waitAndPop(value);
+                    local += value;
+                }
+                total.fetch_add(local);
+            });
+    for (std::thread& t : threads)
+        t.join();
+    return total.load();
+}
+
+int main()
+{
+    int failures = 0;
+
+    {
+        MpmcRingQueue<int> queue(5);
+        int pushed = 0;
+        while (queue.tryPush(pushed))
+            ++pushed;
+        failures += expect(pushed == 8 && queue.capacity() == 8 && queue.size() == 8, "tryPush fails once full");
+
+        int value = -1;
+        bool fifo = true;
+        for (int i = 0; i < 8; ++i)
+            fifo &= queue.tryPop(value) && value == i;
+        failures += expect(fifo && !queue.tryPop(value) && queue.empty(), "items come out in order");
+    }
+
+    {
+        // Items still queued are destroyed with the queue.
+        auto tracked = std::make_shared<int>(1);
+        {
+            MpmcRingQueue<std::shared_ptr<int>> queue(4);
+            queue.push(tracked);
+            queue.push(tracked);
+        }
+        failures += expect(tracked.use_count() == 1, "queued items are destroyed");
+    }
+
+    {
+        MpmcRingQueue<std::unique_ptr<int>> queue(2);
+        auto item = std::make_unique<int>(3);
+        queue.push(std::make_unique<int>(1));
+        queue.push(std::make_unique<int>(2));
+        failures += expect(!queue.tryPush(std::move(item)) && item && *item == 3, "failed tryPush keeps the value");
+    }
+
+    {
+        // Blocking push waits for a consumer, blocking pop for a producer.
+        MpmcRingQueue<long> queue(4);
+        const long sum = transfer("4/4 through 4 slots: ", queue, 4, 4, 20000);
+        failures += expect(sum == 4 * (20000L * 20001 / 2), "blocking push and pop hand over every item");
+    }
+
+    {
+        MpmcRingQueue<long> queue(64);
+        const size_t before = gAllocations.load();
+        long value = 0;
+        for (long i = 0; i < 100000; ++i)
+        {
+            queue.push(i);
+            queue.waitAndPop(value);
+        }
+        failures += expect(gAllocations.load() == before, "steady state does not allocate");
+    }
+
+    // 200000 items through each queue, producers/consumers threads each.
+    for (int threads : {1, 2, 4})
+    {
+        const long perProducer = 200000 / threads;
+        const long expected = threads * (perProducer * (perProducer + 1) / 2);
+        const std::string pair = std::to_string(threads) + "/" + std::to_string(threads);
+        ThreadsafeQueue<long> coarse;
+        FineGrainedThreadsafeQueue<long> fine;
+        MpmcRingQueue<long> ring(1024);
+        const long a = transfer(pair + " ThreadsafeQueue: ", coarse, threads, threads, perProducer);
+        const long b = transfer(pair + " FineGrainedThreadsafeQueue: ", fine, threads, threads, perProducer);
+        const long c = transfer(pair + " MpmcRingQueue: ", ring, threads, threads, perProducer);
+        failures +=
+            expect(a == expected && b == expected && c == expected, pair + " every queue hands over every item");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+template <class T>
+static std::vector<size_t> nearestBruteForce(const std::vector<Rectangle<T>>& rects, T x, T y, size_t k)
+{
+    std::vector<std::pair<double, size_t>> scored;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        if (rects[i].isEmpty())
+            continue;
+        const double dx = (double(rects[i].xmin()) + double(rects[i].xmax())) * 0.5 - double(x);
+        const double dy = (double(rects[i].ymin()) + double(rects[i].ymax())) * 0.5 - double(y);
+        scored.push_back({dx * dx + dy * dy, i});
+    }
+    std::sort(scored.begin(), scored.end());
+    std::vector<size_t> out;
+    for (size_t i = 0; i < std::min(k, scored.size()); ++i)
+        out.push_back(scored[i].second);
+    return out;
+}
+
+// Every query against a loop over all rectangles.
+template <class T, class Draw>
+static bool matchesBruteForce(const std::vector<Rectangle<T>>& rects, const PackedRTree<T>& tree, Draw draw)
+{
+    std::vector<size_t> found, expected;
+    for (int q = 0; q < 200; ++q)
+    {
+        const Rectangle<T> query = draw();
+        tree.queryIntersecting(query, found);
+        expected.clear();
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            if (rects[i].intersects(query))
+                expected.push_back(i);
+        }
+        if (found != expected)
+            return false;
+
+        tree.queryContaining(query.xmin(), query.ymax(), found);
+        expected.clear();
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            if (rects[i].contains(query.xmin(), query.ymax()))
+                expected.push_back(i);
+        }
+        if (found != expected)
+            return false;
+
+        tree.nearestCentres(query.xmin(), query.ymin(), 5, found);
+        if (found != nearestBruteForce(rects, query.xmin(), query.ymin(), 5))
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(21);
+
+    {
+        // Tracker-sized frames: a few hundred boxes in a 1920 x 1080 image.
+        std::uniform_real_distribution<float> x(0.0f, 1920.0f), y(0.0f, 1080.0f), size(10.0f, 250.0f);
+        auto draw = [&] { return Rectangle<float>(x(rng), y(rng), size(rng), size(rng)); };
+        std::vector<Rectangle<float>> tracks(500), detections(500);
+        for (auto& r : tracks)
+            r = draw();
+        for (auto& r : detections)
+            r = draw();
+        tracks[3] = Rectangle<float>();
+
+        PackedRTree<float> tree;
+        const int repeats = 100;
+        {
+            Timer timer("build over 500 boxes x100: ");
+            for (int r = 0; r < repeats; ++r)
+                tree.build(tracks);
+        }
+        failures += expect(tree.size() == tracks.size() - 1, "empty rectangles are left out");
+        failures += expect(matchesBruteForce(tracks, tree, draw), "float queries match the brute force");
+
+        size_t pairs = 0, brutePairs = 0;
+        std::vector<size_t> found;
+        {
+            Timer timer("index matching x100: ");
+            for (int r = 0; r < repeats; ++r)
+            {
+                for (const auto& d : detections)
+                {
+                    tree.queryIntersecting(d, found);
+                    pairs += found.size();
+                }
+            }
+        }
+        {
+            Timer timer("double loop matching x100: ");
+            for (int r = 0; r < repeats; ++r)
+            {
+                for (const auto& d : detections)
+                    for (const auto& t : tracks)
+                        brutePairs += t.intersects(d);
+            }
+        }
+        failures += expect(pairs == brutePairs, "same overlapping pairs");
+    }
+
+    {
+        // Integer boxes on a coarse grid: shared edges, duplicates and ties.
+        std::uniform_int_distribution<int32_t> coord(0, 40), size(0, 8);
+        auto draw = [&] { return Rectangle<int32_t>(coord(rng), coord(rng), size(rng), size(rng)); };
+        std::vector<Rectangle<int32_t>> rects(1000);
+        for (auto& r : rects)
+            r = draw();
+        rects[10] = rects[11];
+        PackedRTree<int32_t> tree(rects);
+        failures += expect(matchesBruteForce(rects, tree, draw), "integer queries match the brute force");
+
+        std::vector<size_t> found;
+        PackedRTree<int32_t> small(std::vector<Rectangle<int32_t>>{Rectangle<int32_t>(0, 0, 2, 2)});
+        small.nearestCentres(5, 5, 3, found);
+        bool tiny = found == std::vector<size_t>{0};
+        small.queryContaining(Point2<int32_t>(2, 2), found);
+        tiny &= found == std::vector<size_t>{0};
+        PackedRTree<int32_t> none;
+        none.queryIntersecting(Rectangle<int32_t>(0, 0, 2, 2), found);
+        tiny &= found.empty() && none.bounds().isEmpty();
+        failures += expect(tiny, "one and no rectangles");
+    }
+
+    {
+        // The members the index leans on.
+        Rectangle<float> a(0.0f, 0.0f, 4.0f, 4.0f), b(1.0f, 1.0f, 2.0f, 2.0f);
+        Rectangle<float> grown = b;
+        grown.expand(Rectangle<float>(5.0f, 5.0f, 1.0f, 1.0f));
+        failures += expect(a.contains(b) && !b.contains(a) && grown == Rectangle<float>(1.0f, 1.0f, 5.0f, 5.0f),
+                           "rectangle containment and expansion");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/thread_pool/pipeline.h"
+#include "pillar/utility/test.h"
+
+using namespace yuzu;
+using test::expect;
+using namespace std::chrono_literals;
+
+static void printMetrics(const std::vector<StageMetrics>& metrics)
+{
+    for (const StageMetrics& m : metrics)
+    {
+        std::cout << "  " << m.name << ": workers " << m.workers << ", processed " << m.processed << ", failed "
+                  << m.failed << ", mean " << m.meanLatencyUs << " us, max " << m.maxLatencyUs << " us, max depth "
+                  << m.maxQueueDepth << std::endl;
+    }
+}
+
+int main()
+{
+    int failures = 0;
+
+    {
+        auto pipeline = PipelineBuilder<int>()
+                            .stage<std::string>("format", 2,
+                                                [](int&& x, std::string& out)
+                                                {
+                                                    out = std::to_string(x);
+                                                    return okStatus();
+                                                })
+                            .stage<size_t>("measure", 3,
+                                           [](std::string&& s, size_t& out)
+                                           {
+                                               out = s.size();
+                                               return okStatus();
+                                           })
+                            .build();
+        std::thread producer(
+            [&]
+            {
+                for (int i = 0; i < 1000; ++i)
+                    pipeline->push(i);
+                pipeline->close();
+            });
+        size_t digits = 0, count = 0, value = 0;
+        while (pipeline->pop(value))
+        {
+            digits += value;
+            ++count;
+        }
+        producer.join();
+        const Status status = pipeline->finish();
+        const auto metrics = pipeline->metrics();
+        printMetrics(metrics);
+        failures += expect(status.ok() && count == 1000 && digits == 10 + 90 * 2 + 900 * 3, "every item flows through");
+        failures += expect(metrics.size() == 2 && metrics[0].processed == 1000 && metrics[1].processed == 1000 &&
+                               metrics[1].workers == 3,
+                           "metrics count every item");
+    }
+
+    {
+        // Later items finish first, the output still comes out in order.
+        PipelineOptions options;
+        options.ordered = true;
+        options.queueCapacity = 8;
+        auto pipeline = PipelineBuilder<int>(options)
+                            .stage<int>("jitter", 4,
+                                        [](int&& x, int& out)
+                                        {
+                                            std::this_thread::sleep_for(std::chrono::microseconds((x * 7919) % 500));
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .build();
+        std::thread producer(
+            [&]
+            {
+                for (int i = 0; i < 200; ++i)
+                    pipeline->push(i);
+                pipeline->close();
+            });
+        int expected = 0, value = 0;
+        bool inOrder = true;
+        while (pipeline->pop(value))
+            inOrder &= value == expected++;
+        producer.join();
+        failures += expect(pipeline->finish().ok() && inOrder && expected == 200, "ordered output keeps input order");
+    }
+
+    {
+        // The first item is the slowest by far: the results overtaking it fill
+        // the reorder buffer, never the queue of the stage the first item still
+        // has to pass through.
+        PipelineOptions options;
+        options.ordered = true;
+        options.queueCapacity = 4;
+        auto pipeline = PipelineBuilder<int>(options)
+                            .stage<int>("jitter", 4,
+                                        [](int&& x, int& out)
+                                        {
+                                            if (x == 0)
+                                                std::this_thread::sleep_for(200ms);
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .stage<int>("pass", 1,
+                                        [](int&& x, int& out)
+                                        {
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .build();
+        std::thread producer(
+            [&]
+            {
+                for (int i = 0; i < 100; ++i)
+                    pipeline->push(i);
+                pipeline->close();
+            });
+        int expected = 0, value = 0;
+        bool inOrder = true;
+        while (pipeline->pop(value))
+            inOrder &= value == expected++;
+        producer.join();
+        failures += expect(pipeline->finish().ok() && inOrder && expected == 100,
+                           "ordered output across stages with a straggler");
+    }
+
+    {
+        // A slow stage throttles the producer through its bounded queue.
+        PipelineOptions options;
+        options.queueCapacity = 2;
+        auto pipeline = PipelineBuilder<int>(options)
+                            .stage<int>("slow", 1,
+                                        [](int&& x, int& out)
+                                        {
+                                            std::this_thread::sleep_for(200us);
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .build();
+        std::thread consumer(
+            [&]
+            {
+                int value;
+                while (pipeline->pop(value))
+                {
+                }
+            });
+        for (int i = 0; i < 100; ++i)
+            pipeline->push(i);
+        const Status status = pipeline->finish();
+        consumer.join();
+        const auto metrics = pipeline->metrics();
+        printMetrics(metrics);
+        failures += expect(status.ok() && metrics[0].maxQueueDepth <= 2, "bounded queue limits the depth");
+    }
+
+    {
+        // A failing stage cancels everything and its status comes back.
+        auto pipeline = PipelineBuilder<int>()
+                            .stage<int>("check", 2,
+                                        [](int&& x, int& out)
+                                        {
+                                            if (x == 50)
+                                                return Status(StatusCode::kInvalidArgument, "bad item");
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .stage<int>("pass", 1,
+                                        [](int&& x, int& out)
+                                        {
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .build();
+        Status pushStatus = okStatus();
+        std::thread producer(
+            [&]
+            {
+                // Keeps pushing until the pipeline refuses.
+                for (int i = 0; pushStatus.ok(); ++i)
+                    pushStatus = pipeline->push(i);
+            });
+        int value;
+        while (pipeline->pop(value))
+        {
+        }
+        producer.join();
+        const Status status = pipeline->finish();
+        failures += expect(status.statusCode() == StatusCode::kInvalidArgument && status.message() == "bad item" &&
+                               pushStatus.statusCode() == StatusCode::kCancelled,
+                           "a failing stage cancels the pipeline");
+    }
+
+    {
+        // Cancelling wakes a producer blocked on backpressure.
+        PipelineOptions options;
+        options.queueCapacity = 1;
+        auto pipeline = PipelineBuilder<int>(options)
+                            .stage<int>("stuck", 1,
+                                        [](int&& x, int& out)
+                                        {
+                                            out = x;
+                                            return okStatus();
+                                        })
+                            .build();
+        Status pushStatus = okStatus();
+        std::thread producer(
+            [&]
+            {
+                for (int i = 0; pushStatus.ok(); ++i)
+                    pushStatus = pipeline->push(i);
+            });
+        std::this_thread::sleep_for(20ms);
+        pipeline->cancel();
+        producer.join();
+        failures += expect(pushStatus.statusCode() == StatusCode::kCancelled &&
+                               pipeline->finish().statusCode() == StatusCode::kCancelled,
+                           "cancel wakes a blocked producer");
+    }
+    return failures == 0 ? 0 : 1;
+}
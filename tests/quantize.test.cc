@@ -0,0 +1,90 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "pillar/utility/half.h"
+#include "pillar/utility/quantize.h"
+#include "pillar/utility/test.h"
+
+using namespace yuzu;
+using test::expect;
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(5);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kSSE41, cpu::SimdLevel::kAVX2,
+                                     cpu::SimdLevel::kAVX512};
+    std::cout << "simd level: " << cpu::simdLevel() << ", avx512 vnni " << cpu::features().avx512vnni
+              << ", avx vnni " << cpu::features().avxvnni << std::endl;
+
+    {
+        std::vector<float> src(300), back(300);
+        std::vector<int8_t> q(300);
+        for (float& x : src)
+            x = dist(rng);
+        const float scale = math::quantizeInt8(src.data(), 300, q.data());
+        math::dequantizeInt8(q.data(), 300, scale, back.data());
+        bool inRange = true;
+        float worst = 0.0f;
+        for (int i = 0; i < 300; ++i)
+        {
+            inRange &= q[i] >= -127;
+            worst = std::max(worst, std::abs(back[i] - src[i]));
+        }
+        const float zero[3] = {0, 0, 0};
+        int8_t zq[3] = {1, 1, 1};
+        const bool zeroes = math::quantizeInt8(zero, 3, zq) == 0.0f && zq[0] == 0 && zq[2] == 0;
+        failures += expect(inRange && worst <= 0.5f * scale * 1.0001f && zeroes, "int8 round trip within half a step");
+
+        std::vector<uint16_t> h(300);
+        math::quantizeHalf(src.data(), 300, h.data());
+        math::dequantizeHalf(h.data(), 300, back.data());
+        bool same = true;
+        for (int i = 0; i < 300; ++i)
+            same &= h[i] == floatToHalf(src[i]) && back[i] == halfToFloat(h[i]);
+        failures += expect(same, "half round trip matches the scalar conversion");
+    }
+
+    {
+        // Every length up to 300 covers the vector bodies and the tails.
+        bool exact = true;
+        double worst = 0.0;
+        for (unsigned int len = 1; len <= 300; ++len)
+        {
+            std::vector<float> a(len), b(len);
+            std::vector<int8_t> qa(len), qb(len);
+            std::vector<uint16_t> hb(len);
+            for (unsigned int i = 0; i < len; ++i)
+            {
+                a[i] = dist(rng);
+                b[i] = dist(rng);
+            }
+            math::quantizeInt8(a.data(), len, qa.data());
+            math::quantizeInt8(b.data(), len, qb.data());
+            // The extremes stress the pmaddubsw saturation bound.
+            qa[0] = -127;
+            qb[0] = -127;
+            math::quantizeHalf(b.data(), len, hb.data());
+            int32_t expectedInt = 0;
+            double expectedHalf = 0.0;
+            for (unsigned int i = 0; i < len; ++i)
+            {
+                expectedInt += int32_t(qa[i]) * qb[i];
+                expectedHalf += double(a[i]) * halfToFloat(hb[i]);
+            }
+            for (cpu::SimdLevel level : levels)
+            {
+                exact &= math::dotProduct(qa.data(), qb.data(), len, level) == expectedInt;
+                worst = std::max(worst, std::abs(math::dotProduct(a.data(), hb.data(), len, level) - expectedHalf));
+            }
+            exact &= math::dotProduct(qa.data(), qb.data(), len) == expectedInt;
+        }
+        std::cout << "max half dot error: " << worst << std::endl;
+        failures += expect(exact, "int8 kernels are exact");
+        failures += expect(worst < 1e-3, "half kernels match the double reference");
+    }
+    return failures == 0 ? 0 : 1;
+}
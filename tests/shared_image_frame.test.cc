@@ -0,0 +1,87 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "pillar/framework/formats/shared_image_frame.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+int main()
+{
+    int failures = 0;
+
+    ImageFramePool pool;
+    const size_t frameBytes = ImageFrame(ImageFormat::SRGB, 640, 480).pixelDataSize();
+    {
+        ImageFrame frame = pool.acquire(ImageFormat::SRGB, 640, 480);
+        frame.setToZero();
+        SharedImageFrame original(std::move(frame), pool.allocator());
+        const uint8_t* pixels = original.view().pixelData();
+
+        // Fan-out: every consumer reads the same buffer.
+        std::vector<SharedImageFrame> consumers(3, original);
+        failures += expect(original.useCount() == 4, "four handles share one frame");
+        std::vector<std::thread> threads;
+        std::vector<int> sums(3, 0);
+        for (int i = 0; i < 3; ++i)
+        {
+            threads.emplace_back(
+                [&, i]
+                {
+                    const SharedImageFrame& handle = consumers[i];
+                    sums[i] = handle.pixelData() == pixels ? 1 : 0;
+                });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        failures += expect(sums[0] + sums[1] + sums[2] == 3, "readers see the original pixels");
+
+        // A writer gets its own copy, drawn from the pool.
+        consumers[0].pixelData()[0] = 42;
+        failures += expect(consumers[0].view().pixelData() != pixels && original.view().pixelData()[0] == 0 &&
+                               consumers[0].view().pixelData()[0] == 42,
+                           "write copies a shared frame");
+        failures += expect(pool.stats().misses == 2, "copy comes from the pool");
+
+        // The last handle writes in place.
+        consumers[1].reset();
+        consumers[2].reset();
+        original.setToZero();
+        failures += expect(original.view().pixelData() == pixels, "unique frame is written in place");
+    }
+    failures += expect(pool.stats().bytesRetained == 2 * frameBytes, "last release returns buffers to the pool");
+
+    {
+        SharedImageFrame a(ImageFrame(ImageFormat::GRAY8, 8, 8));
+        SharedImageFrame b = a;
+        ImageFrame released = a.release();
+        failures += expect(a.isEmpty() && released.pixelData() != b.view().pixelData(), "release copies when shared");
+        released = b.release();
+        failures += expect(b.isEmpty() && !released.isEmpty(), "release moves when unique");
+    }
+
+    // One 1080p frame fed to three consumers.
+    ImageFrame frame(ImageFormat::SRGB, 1920, 1080);
+    frame.setToZero();
+    {
+        Timer timer("fan-out by copyFrom x100: ");
+        for (int i = 0; i < 100; ++i)
+        {
+            ImageFrame copies[2];
+            copies[0].copyFrom(frame, ImageFrame::kDefaultAlignmentBoundary);
+            copies[1].copyFrom(frame, ImageFrame::kDefaultAlignmentBoundary);
+        }
+    }
+    SharedImageFrame shared(std::move(frame));
+    {
+        Timer timer("fan-out by SharedImageFrame x100: ");
+        for (int i = 0; i < 100; ++i)
+        {
+            SharedImageFrame handles[2] = {shared, shared};
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
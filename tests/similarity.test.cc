@@ -0,0 +1,105 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/utility/similarity.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static double reference(const float* a, const float* b, unsigned int len)
+{
+    double dot = 0.0, na = 0.0, nb = 0.0;
+    for (unsigned int i = 0; i < len; ++i)
+    {
+        dot += double(a[i]) * b[i];
+        na += double(a[i]) * a[i];
+        nb += double(b[i]) * b[i];
+    }
+    return dot / std::sqrt(na * nb);
+}
+
+// Ten passes of `query` over every gallery row, timed under `label`.
+static void benchmark(const std::string& label, const std::vector<float>& query, const std::vector<float>& gallery,
+                      unsigned int dim, cpu::SimdLevel level)
+{
+    const size_t rows = gallery.size() / dim;
+    volatile float sink = 0.0f;
+    Timer timer(label);
+    for (int repeat = 0; repeat < 10; ++repeat)
+        for (size_t r = 0; r < rows; ++r)
+            sink = sink + math::cosineSimilarity(query.data(), gallery.data() + r * dim, dim, level);
+}
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(7);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kSSE41, cpu::SimdLevel::kAVX2,
+                                     cpu::SimdLevel::kAVX512};
+    std::cout << "simd level: " << cpu::simdLevel() << std::endl;
+
+    {
+        // Every length from 1 to 300 exercises every tail path.
+        double worst = 0.0, worstDot = 0.0;
+        for (unsigned int len = 1; len <= 300; ++len)
+        {
+            std::vector<float> a(len), b(len);
+            for (unsigned int i = 0; i < len; ++i)
+            {
+                a[i] = dist(rng);
+                b[i] = 0.5f * a[i] + dist(rng);
+            }
+            const double expected = reference(a.data(), b.data(), len);
+            double dot = 0.0, norms = 0.0;
+            for (unsigned int i = 0; i < len; ++i)
+            {
+                dot += double(a[i]) * b[i];
+                norms += std::abs(double(a[i]) * b[i]);
+            }
+            for (cpu::SimdLevel level : levels)
+            {
+                worst = std::max(worst, std::abs(math::cosineSimilarity(a.data(), b.data(), len, level) - expected));
+                worstDot = std::max(worstDot, std::abs(math::dotProduct(a.data(), b.data(), len, level) - dot) / norms);
+            }
+            worst = std::max(worst, std::abs(math::cosineSimilarity(a.data(), b.data(), len) - expected));
+        }
+        std::cout << "max error against the double reference: " << worst << std::endl;
+        failures += expect(worst < 1e-5, "every kernel matches the double reference");
+        failures += expect(worstDot < 1e-5, "every dot product kernel matches the double reference");
+    }
+
+    {
+        std::vector<float> a(512);
+        for (float& x : a)
+            x = dist(rng);
+        std::vector<float> negated(a);
+        for (float& x : negated)
+            x = -x;
+        bool exact = true;
+        for (cpu::SimdLevel level : levels)
+            exact &= std::abs(math::cosineSimilarity(a.data(), a.data(), 512, level) - 1.0f) < 1e-6f &&
+                     std::abs(math::cosineSimilarity(a.data(), negated.data(), 512, level) + 1.0f) < 1e-6f;
+        failures += expect(exact, "parallel and opposite vectors");
+    }
+
+    // 40960 comparisons per line.
+    const char* names[] = {"scalar", "sse41", "avx2", "avx512"};
+    for (unsigned int dim : {128u, 256u, 512u, 1024u})
+    {
+        const size_t rows = 4096;
+        std::vector<float> query(dim), gallery(rows * dim);
+        for (float& x : query)
+            x = dist(rng);
+        for (float& x : gallery)
+            x = dist(rng);
+        for (int l = 0; l < 4; ++l)
+            benchmark("dim " + std::to_string(dim) + ", " + names[l] + " x40960: ", query, gallery, dim, levels[l]);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "pillar/thread_pool/spsc_ring_queue.h"
+#include "pillar/thread_pool/threadsafe_queue.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// One producer hands `items` increasing values to one consumer, timed under
+// `label`. Tells whether every value arrived in order.
+template <class Queue>
+static bool handOff(const char* label, Queue& queue, long items)
+{
+    Timer timer(label);
+    std::thread producer(
+        [&]
+        {
+            for (long i = 0; i < items; ++i)
+                queue.push(i);
+        });
+    bool inOrder = true;
+    for (long i = 0; i < items; ++i)
+    {
+        long value = -1;
+        queue.waitAndPop(value);
+        inOrder &= value == i;
+    }
+    producer.join();
+    return inOrder;
+}
+
+int main()
+{
+    int failures = 0;
+
+    {
+        SpscRingQueue<int> queue(3);
+        int pushed = 0;
+        while (queue.tryPush(pushed))
+            ++pushed;
+        int value = -1;
+        bool fifo = true;
+        for (int i = 0; i < 4; ++i)
+            fifo &= queue.tryPop(value) && value == i;
+        failures += expect(pushed == 4 && fifo && !queue.tryPop(value), "kReject ring fails once full");
+    }
+
+    {
+        SpscRingQueue<int> queue(8);
+        std::vector<int> in = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        const size_t pushed = queue.pushN(in.begin(), in.size());
+        std::vector<int> out;
+        const size_t popped = queue.popN(std::back_inserter(out), 5);
+        const size_t rest = queue.popN(std::back_inserter(out), 16);
+        const bool same = out == std::vector<int>(in.begin(), in.begin() + 8);
+        failures += expect(pushed == 8 && popped == 5 && rest == 3 && same, "pushN and popN stop at the ring bounds");
+    }
+
+    {
+        using Queue = SpscRingQueue<std::unique_ptr<int>>;
+        Queue queue(4, Queue::FullPolicy::kOverwriteOldest);
+        for (int i = 0; i < 10; ++i)
+            queue.push(std::make_unique<int>(i));
+        std::vector<std::unique_ptr<int>> out;
+        queue.popN(std::back_inserter(out), 10);
+        failures += expect(queue.dropped() == 6 && out.size() == 4 && *out.front() == 6 && *out.back() == 9,
+                           "kOverwriteOldest keeps the latest items");
+    }
+
+    {
+        auto tracked = std::make_shared<int>(1);
+        {
+            using Queue = SpscRingQueue<std::shared_ptr<int>>;
+            Queue queue(4, Queue::FullPolicy::kOverwriteOldest);
+            for (int i = 0; i < 7; ++i)
+                queue.push(tracked);
+        }
+        failures += expect(tracked.use_count() == 1, "dropped and queued items are destroyed");
+    }
+
+    {
+        // A live consumer sees a strictly increasing subsequence.
+        using Queue = SpscRingQueue<long>;
+        Queue queue(4, Queue::FullPolicy::kOverwriteOldest);
+        constexpr long kItems = 200000;
+        std::thread producer(
+            [&]
+            {
+                for (long i = 0; i <= kItems; ++i)
+                    queue.push(i);
+            });
+        long last = -1, received = 0;
+        bool increasing = true;
+        while (last != kItems)
+        {
+            long value;
+            queue.waitAndPop(value);
+            increasing &= value > last;
+            last = value;
+            ++received;
+        }
+        producer.join();
+        failures += expect(increasing && received + static_cast<long>(queue.dropped()) == kItems + 1,
+                           "kOverwriteOldest under concurrency drops but never reorders");
+    }
+
+    {
+        SpscRingQueue<long> ring(256);
+        ThreadsafeQueue<long> locked;
+        constexpr long kItems = 500000;
+        const bool ringInOrder = handOff("hand-off of 500000 items, SpscRingQueue: ", ring, kItems);
+        const bool lockedInOrder = handOff("hand-off of 500000 items, ThreadsafeQueue: ", locked, kItems);
+        failures += expect(ringInOrder && lockedInOrder, "blocking hand-off keeps order");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/utility/ssd_anchors.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// The per-consumer loop the decoder replaces, over Anchor objects.
+static BoxBatch referenceDecode(const float* rawBoxes, const float* rawScores, const AnchorGrid& grid,
+                                const SsdDecoderOptions& options)
+{
+    BoxBatch boxes;
+    for (size_t i = 0; i < grid.size(); ++i)
+    {
+        const Anchor anchor = grid.anchor(i);
+        float best = -1e30f;
+        int32_t label = 0;
+        for (int c = 0; c < options.numClasses; ++c)
+        {
+            float score = rawScores[i * options.numClasses + c];
+            if (options.sigmoidScore)
+            {
+                score = std::min(std::max(score, -options.scoreClippingThreshold), options.scoreClippingThreshold);
+                score = 1.0f / (1.0f + expf(-score));
+            }
+            if (score > best)
+                best = score, label = c;
+        }
+        if (best < options.minScoreThreshold)
+            continue;
+        const float* raw = rawBoxes + i * options.numCoords + options.boxCoordOffset;
+        float x = raw[0], y = raw[1], w = raw[2], h = raw[3];
+        if (!options.reverseOutputOrder)
+            x = raw[1], y = raw[0], w = raw[3], h = raw[2];
+        const float xCenter = x / options.xScale * anchor.width() + anchor.xCenter();
+        float yCenter = y / options.yScale * anchor.height() + anchor.yCenter();
+        if (options.applyExponentialOnBoxSize)
+            w = expf(w / options.wScale) * anchor.width(), h = expf(h / options.hScale) * anchor.height();
+        else
+            w = w / options.wScale * anchor.width(), h = h / options.hScale * anchor.height();
+        if (options.flipVertically)
+            yCenter = 1.0f - yCenter;
+        boxes.add(xCenter - w / 2, yCenter - h / 2, xCenter + w / 2, yCenter + h / 2, best, label);
+    }
+    return boxes;
+}
+
+static bool sameBoxes(const BoxBatch& a, const BoxBatch& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        const float d = std::fabs(a.xmin()[i] - b.xmin()[i]) + std::fabs(a.ymin()[i] - b.ymin()[i]) +
+                        std::fabs(a.xmax()[i] - b.xmax()[i]) + std::fabs(a.ymax()[i] - b.ymax()[i]) +
+                        std::fabs(a.scores()[i] - b.scores()[i]);
+        if (d > 1e-4f || a.labels()[i] != b.labels()[i])
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    int failures = 0;
+    const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2};
+    const char* names[] = {"scalar", "avx2"};
+
+    {
+        // BlazeFace: 16 x 16 cells of 2 anchors, then 8 x 8 cells of 6.
+        std::shared_ptr<const AnchorGrid> grid;
+        const Status status = AnchorGrid::get(SsdAnchorOptions(), grid);
+        bool layout = status.ok() && grid->size() == 896;
+        layout = layout && grid->xCenter()[0] == 0.5f / 16 && grid->yCenter()[1] == 0.5f / 16 &&
+                 grid->xCenter()[2] == 1.5f / 16 && grid->width()[0] == 1.0f;
+        layout = layout && grid->xCenter()[512] == 0.5f / 8 && grid->xCenter()[518] == 1.5f / 8 &&
+                 grid->yCenter()[895] == 7.5f / 8;
+        failures += expect(layout, "blazeface anchors");
+
+        // One grid per layout, whichever thread asks first.
+        std::vector<std::shared_ptr<const AnchorGrid>> grids(4);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < grids.size(); ++t)
+            threads.emplace_back([&grids, t] { AnchorGrid::get(SsdAnchorOptions(), grids[t]); });
+        for (std::thread& t : threads)
+            t.join();
+        bool shared = true;
+        for (const auto& g : grids)
+            shared &= g == grid;
+        SsdAnchorOptions other;
+        other.inputWidth = 256;
+        std::shared_ptr<const AnchorGrid> otherGrid;
+        AnchorGrid::get(other, otherGrid);
+        failures += expect(shared && otherGrid != grid && otherGrid->size() > grid->size(), "anchors are shared");
+
+        SsdAnchorOptions bad;
+        bad.strides.clear();
+        failures += expect(AnchorGrid::get(bad, otherGrid).statusCode() == StatusCode::kInvalidArgument,
+                           "strides are required");
+    }
+
+    {
+        // Sized anchors: aspect ratios stretch width against height.
+        SsdAnchorOptions options;
+        options.inputWidth = options.inputHeight = 300;
+        options.minScale = 0.2f;
+        options.maxScale = 0.95f;
+        options.strides = {16, 32, 64, 128, 256, 512};
+        options.aspectRatios = {1.0f, 2.0f, 0.5f, 3.0f, 0.3333f};
+        options.reduceBoxesInLowestLayer = true;
+        options.fixedAnchorSize = false;
+        AnchorGrid grid;
+        bool sized = AnchorGrid::generate(options, grid).ok() && grid.size() == 1917;
+        sized = sized && std::fabs(grid.width()[0] - 0.1f) < 1e-6f &&
+                std::fabs(grid.width()[1] * grid.height()[1] / (0.2f * 0.2f) - 1.0f) < 1e-5f &&
+                std::fabs(grid.width()[1] / grid.height()[1] - 2.0f) < 1e-5f;
+        failures += expect(sized, "ssd mobilenet anchors");
+    }
+
+    {
+        std::shared_ptr<const AnchorGrid> grid;
+        SsdAnchorOptions full;
+        full.inputWidth = full.inputHeight = 192;
+        full.strides = {4};
+        full.interpolatedScaleAspectRatio = 0.0f;
+        AnchorGrid::get(full, grid);
+        std::mt19937 rng(9);
+        std::normal_distribution<float> dist(0.0f, 4.0f);
+        const int numClasses = 3;
+        std::vector<float> rawBoxes(grid->size() * 16), rawScores(grid->size() * numClasses);
+        for (float& x : rawBoxes)
+            x = dist(rng);
+        for (float& x : rawScores)
+            x = dist(rng) - 6.0f;
+
+        SsdDecoderOptions options;
+        options.numClasses = numClasses;
+        options.boxCoordOffset = 2;
+        options.minScoreThreshold = 0.6f;
+        for (int variant = 0; variant < 3; ++variant)
+        {
+            options.applyExponentialOnBoxSize = variant == 1;
+            options.reverseOutputOrder = variant != 2;
+            options.flipVertically = variant == 2;
+            options.xScale = options.yScale = options.wScale = options.hScale = variant == 1 ? 10.0f : 192.0f;
+            const BoxBatch expected = referenceDecode(rawBoxes.data(), rawScores.data(), *grid, options);
+            bool same = expected.size() > 0 && expected.size() < grid->size() / 4;
+            for (size_t l = 0; l < 2; ++l)
+            {
+                BoxBatch boxes;
+                same &= decodeSsdBoxes(rawBoxes.data(), rawScores.data(), *grid, options, boxes, levels[l]).ok() &&
+                        sameBoxes(boxes, expected);
+            }
+            failures += expect(same, "decoders match the reference");
+        }
+
+        options = SsdDecoderOptions();
+        options.numClasses = 1;
+        const size_t above = referenceDecode(rawBoxes.data(), rawScores.data(), *grid, options).size();
+        std::cout << grid->size() << " anchors, " << above << " above the threshold" << std::endl;
+        {
+            Timer timer("Anchor loop x200: ");
+            for (int r = 0; r < 200; ++r)
+                referenceDecode(rawBoxes.data(), rawScores.data(), *grid, options);
+        }
+        BoxBatch boxes;
+        for (size_t l = 0; l < 2; ++l)
+        {
+            const std::string label = std::string(names[l]) + " decode x200: ";
+            Timer timer(label);
+            for (int r = 0; r < 200; ++r)
+                decodeSsdBoxes(rawBoxes.data(), rawScores.data(), *grid, options, boxes, levels[l]);
+        }
+
+        options.numCoords = 3;
+        failures += expect(decodeSsdBoxes(rawBoxes.data(), rawScores.data(), *grid, options, boxes).statusCode() ==
+                               StatusCode::kInvalidArgument,
+                           "raw boxes need four coordinates");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/thread_pool/parallel_for.h"
+#include "pillar/thread_pool/thread_pool.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// Counts heap allocations to check that small tasks are stored in place.
+static std::atomic<size_t> gAllocations{0};
+
+void* operator new(size_t size)
+{
+    ++gAllocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+int main()
+{
+    int failures = 0;
+
+    {
+        int a = 1, b = 2, c = 3;
+        const size_t before = gAllocations.load();
+        Task small([a, b, c]() mutable { a += b + c; });
+        Task moved(std::move(small));
+        failures += expect(moved.isInline() && !small && gAllocations.load() == before, "small task does not allocate");
+
+        auto owned = std::make_unique<int>(7);
+        std::array<char, 64> pad{};
+        Task big([owned = std::move(owned), pad] { (void)pad; });
+        failures += expect(big && !big.isInline(), "large task goes to the heap");
+    }
+
+    {
+        ThreadPool pool(4);
+        auto sum = pool.submit([](int x, int y) { return x + y; }, 20, 22);
+        failures += expect(sum.get() == 42, "submit returns the result");
+
+        auto thrower = pool.submit([] { throw std::runtime_error("boom"); });
+        bool caught = false;
+        try
+        {
+            thrower.get();
+        }
+        catch (const std::runtime_error& e)
+        {
+            caught = std::string(e.what()) == "boom";
+        }
+        failures += expect(caught, "exception propagates through the future");
+
+        auto unique = pool.submit([](std::unique_ptr<int> p) { return *p; }, std::make_unique<int>(5));
+        failures += expect(unique.get() == 5, "move-only arguments");
+
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 10000; ++i)
+            pool.post([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+        pool.waitIdle();
+        failures += expect(counter.load() == 10000 && pool.pending() == 0, "waitIdle waits for every task");
+
+        // Graceful shutdown runs what is queued, later tasks are refused.
+        for (int i = 0; i < 1000; ++i)
+            pool.post(
+                [&counter]
+                {
+                    std::this_thread::yield();
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                });
+        pool.shutdown();
+        failures += expect(counter.load() == 11000, "shutdown drains the queue");
+
+        auto refused = pool.submit([] { return 1; });
+        bool broken = false;
+        try
+        {
+            refused.get();
+        }
+        catch (const std::future_error& e)
+        {
+            broken = e.code() == std::future_errc::broken_promise;
+        }
+        failures += expect(broken, "tasks after shutdown report broken_promise");
+    }
+
+    {
+        // Nested parallelFor from pool workers must not deadlock.
+        std::atomic<long> total{0};
+        parallelFor(0, 64, 1,
+                    [&](int b0, int b1)
+                    {
+                        for (int i = b0; i < b1; ++i)
+                            parallelFor(0, 1000, 10,
+                                        [&](int c0, int c1) { total.fetch_add(c1 - c0, std::memory_order_relaxed); });
+                    });
+        failures += expect(total.load() == 64000, "nested parallelFor");
+    }
+
+    // Dispatch cost: small tasks through the pool against a thread per task.
+    {
+        ThreadPool pool;
+        std::atomic<int> counter{0};
+        {
+            Timer timer("100000 tasks through the pool: ");
+            for (int i = 0; i < 100000; ++i)
+                pool.post([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+            pool.waitIdle();
+        }
+        {
+            Timer timer("1000 tasks on their own thread: ");
+            for (int i = 0; i < 1000; ++i)
+                std::thread([&counter] { counter.fetch_add(1, std::memory_order_relaxed); }).join();
+        }
+        const size_t before = gAllocations.load();
+        for (int i = 0; i < 10000; ++i)
+            pool.post([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+        pool.waitIdle();
+        std::cout << "allocations per posted task: " << double(gAllocations.load() - before) / 10000 << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/thread_pool/threadsafe_queue.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+using namespace std::chrono_literals;
+
+template <class Queue>
+static int check(const std::string& name)
+{
+    int failures = 0;
+
+    {
+        Queue queue;
+        int value = -1;
+        Timer timer("waitAndPopFor(20ms) waited ");
+        const bool timedOut = !queue.waitAndPopFor(value, 20ms);
+        failures += expect(timedOut && timer.Elapsed() >= 19, name + " waitAndPopFor times out");
+
+        queue.push(5);
+        const bool got = queue.waitAndPopUntil(value, std::chrono::steady_clock::now() + 1s);
+        failures += expect(got && value == 5, name + " waitAndPopUntil returns a queued item");
+    }
+
+    {
+        Queue queue;
+        for (int i = 0; i < 10; ++i)
+            queue.push(i);
+        std::vector<int> batch;
+        const size_t n = queue.waitAndPopBatch(batch, 4, 1s);
+        failures += expect(n == 4 && batch == std::vector<int>({0, 1, 2, 3}) && queue.size() == 6,
+                           name + " full batch returns at once");
+
+        // Fewer items than asked for: whatever arrived by the deadline.
+        Queue partial;
+        partial.push(7);
+        std::thread late(
+            [&]
+            {
+                std::this_thread::sleep_for(5ms);
+                partial.push(8);
+            });
+        batch.clear();
+        Timer timer("partial waitAndPopBatch(60ms) waited ");
+        const size_t m = partial.waitAndPopBatch(batch, 16, 60ms);
+        late.join();
+        failures += expect(m == 2 && batch == std::vector<int>({7, 8}) && timer.Elapsed() >= 59,
+                           name + " partial batch after the timeout");
+
+        // A batch waiter fills up as items arrive.
+        Queue filling;
+        std::thread producer(
+            [&]
+            {
+                for (int i = 0; i < 8; ++i)
+                    filling.push(i);
+            });
+        batch.clear();
+        const size_t k = filling.waitAndPopBatch(batch, 8, 10s);
+        producer.join();
+        failures += expect(k == 8 && batch.size() == 8, name + " batch waits for maxItems");
+    }
+
+    {
+        Queue queue;
+        std::vector<std::thread> waiters;
+        std::vector<int> results(4, 1);
+        for (int i = 0; i < 4; ++i)
+            waiters.emplace_back(
+                [&, i]
+                {
+                    int value;
+                    results[i] = queue.waitAndPop(value) ? 1 : 0;
+                });
+        std::thread batchWaiter(
+            [&]
+            {
+                std::vector<int> batch;
+                queue.waitAndPopBatch(batch, 100, 1h);
+            });
+        std::this_thread::sleep_for(10ms);
+        Timer timer("close woke every waiter in ");
+        queue.close();
+        for (std::thread& t : waiters)
+            t.join();
+        batchWaiter.join();
+        bool allFailed = true;
+        for (int r : results)
+            allFailed &= r == 0;
+        failures += expect(allFailed && timer.Elapsed() < 1000, name + " close wakes every waiter");
+        failures += expect(!queue.push(1) && queue.isClosed(), name + " push fails after close");
+    }
+
+    {
+        Queue queue;
+        queue.push(1);
+        queue.push(2);
+        queue.close();
+        int a = 0, b = 0, c = 0;
+        const bool drained = queue.waitAndPop(a) && queue.waitAndPop(b) && !queue.waitAndPop(c);
+        failures += expect(drained && a == 1 && b == 2 && !queue.waitAndPop(), name + " closed queue drains first");
+    }
+    return failures;
+}
+
+int main()
+{
+    int failures = 0;
+    failures += check<ThreadsafeQueue<int>>("ThreadsafeQueue");
+    failures += check<FineGrainedThreadsafeQueue<int>>("FineGrainedThreadsafeQueue");
+    return failures == 0 ? 0 : 1;
+}
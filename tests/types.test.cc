@@ -22,5 +22,13 @@ int main()
     yuzu::Rectangle<int> rect{1, 2, 3, 4};
     std::cout << "rect: " << rect << " size of " << sizeof(yuzu::Rectangle<int>) << std::endl;
 
+    // ==================================
+    // matrix
+    // ==================================
+    yuzu::Matrix2x3<float> affine = yuzu::Matrix2x3<float>::similarity(2.0f, 0.5f, 10.0f, 20.0f);
+    std::cout << "affine: " << affine << " size of " << sizeof(yuzu::Matrix2x3<float>) << std::endl;
+    yuzu::Matrix3x3<float> homography(affine);
+    std::cout << "homography: " << homography << " size of " << sizeof(yuzu::Matrix3x3<float>) << std::endl;
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/framework/coretypes.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+#include "pillar/utility/vector_batch.h"
+
+using namespace yuzu;
+using test::expect;
+
+template <class T>
+using Vector3 = deps::Vector3<T>;
+template <class T>
+using Vector4 = deps::Vector4<T>;
+template <size_t N>
+using Generic = deps::internal::GenericVectorOps<float, N>;
+
+static bool near(float a, float b, float tolerance = 1e-5f)
+{
+    return std::fabs(a - b) <= tolerance * std::max(1.0f, std::fabs(b));
+}
+
+template <class V>
+static bool near(const V& a, const V& b)
+{
+    for (int i = 0; i < V::SIZE; ++i)
+    {
+        if (!near(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+// Vector3::normalize with the generic component loops.
+static Vector3<float> genericNormalize(Vector3<float> v)
+{
+    float n = sqrtf(Generic<3>::dot(v.data(), v.data()));
+    if (n != 0.0f)
+        n = 1.0f / n;
+    Generic<3>::mulEq(v.data(), n);
+    return v;
+}
+
+int main()
+{
+    int failures = 0;
+    std::mt19937 rng(24);
+    std::normal_distribution<float> dist(0.0f, 3.0f);
+
+    {
+        // The float specializations against the generic loops and against
+        // integer vectors, which keep the generic path.
+        bool same = true;
+        for (int r = 0; r < 1000; ++r)
+        {
+            const Vector4<float> a(dist(rng), dist(rng), dist(rng), dist(rng));
+            const Vector4<float> b(dist(rng), dist(rng), dist(rng), dist(rng));
+            Vector4<float> sum = a, diff = a, scaled = a, lo = a, hi = a;
+            Generic<4>::plusEq(sum.data(), b.data());
+            Generic<4>::minusEq(diff.data(), b.data());
+            Generic<4>::divEq(scaled.data(), 3.0f);
+            Generic<4>::minEq(lo.data(), b.data());
+            Generic<4>::maxEq(hi.data(), b.data());
+            same &= a + b == sum && a - b == diff && a / 3.0f == scaled && min(a, b) == lo && max(a, b) == hi;
+            same &= near(a.dotProd(b), Generic<4>::dot(a.data(), b.data()));
+
+            const Vector3<float> c(a.x(), a.y(), a.z()), d(b.x(), b.y(), b.z());
+            Vector3<float> cross;
+            Generic<3>::cross(cross.data(), c.data(), d.data());
+            same &= c.crossProd(d) == cross && (c * 2.0f).x() == c.x() * 2.0f;
+            same &= near(c.normalize(), genericNormalize(c)) && near(c.dotProd(d), Generic<3>::dot(c.data(), d.data()));
+        }
+        const Vector3<int> i(1, 2, 3), j(4, 5, 6);
+        same &= i.crossProd(j) == Vector3<int>(-3, 6, -3) && i.dotProd(j) == 32 && i.norm2() == 14;
+        same &= Vector3<float>().normalize() == Vector3<float>() && Vector3<float>(0, 3, 4).norm() == 5.0f;
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        same &= std::isnan(max(Vector4<float>(nan, 0, 0, 0), Vector4<float>(1, 0, 0, 0)).x()) &&
+                max(Vector4<float>(1, 0, 0, 0), Vector4<float>(nan, 0, 0, 0)).x() == 1.0f;
+        failures += expect(same, "simd vectors match the generic template");
+    }
+
+    const size_t count = 4096;
+    const int repeats = 200;
+    {
+        // Per-vector operations over a landmark-sized array.
+        std::vector<Vector4<float>> a(count), b(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            a[i] = Vector4<float>(dist(rng), dist(rng), dist(rng), dist(rng));
+            b[i] = Vector4<float>(dist(rng), dist(rng), dist(rng), dist(rng));
+        }
+        volatile float sink = 0.0f;
+        {
+            Timer timer("generic Vector4 add, scale, dot x200: ");
+            for (int r = 0; r < repeats; ++r)
+            {
+                float total = 0.0f;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    Vector4<float> v = a[i];
+                    Generic<4>::plusEq(v.data(), b[i].data());
+                    Generic<4>::mulEq(v.data(), 0.5f);
+                    total += Generic<4>::dot(v.data(), b[i].data());
+                }
+                sink = sink + total;
+            }
+        }
+        {
+            Timer timer("simd Vector4 add, scale, dot x200: ");
+            for (int r = 0; r < repeats; ++r)
+            {
+                float total = 0.0f;
+                for (size_t i = 0; i < count; ++i)
+                    total += ((a[i] + b[i]) * 0.5f).dotProd(b[i]);
+                sink = sink + total;
+            }
+        }
+
+        std::vector<Vector3<float>> c(count), normalized(count);
+        for (size_t i = 0; i < count; ++i)
+            c[i] = Vector3<float>(a[i].x(), a[i].y(), a[i].z());
+        {
+            Timer timer("generic Vector3 normalize x200: ");
+            for (int r = 0; r < repeats; ++r)
+            {
+                for (size_t i = 0; i < count; ++i)
+                    normalized[i] = genericNormalize(c[i]);
+            }
+        }
+        {
+            Timer timer("simd Vector3 normalize x200: ");
+            for (int r = 0; r < repeats; ++r)
+            {
+                for (size_t i = 0; i < count; ++i)
+                    normalized[i] = c[i].normalize();
+            }
+        }
+
+        // The same landmarks as columns.
+        std::vector<float> x(count), y(count), z(count);
+        const cpu::SimdLevel levels[] = {cpu::SimdLevel::kScalar, cpu::SimdLevel::kAVX2, cpu::SimdLevel::kAVX512};
+        const char* names[] = {"scalar", "avx2", "avx512"};
+        for (int l = 0; l < 3; ++l)
+        {
+            {
+                const std::string label = std::string(names[l]) + " batch normalize (with the copy) x200: ";
+                Timer timer(label);
+                for (int r = 0; r < repeats; ++r)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                        x[i] = c[i].x(), y[i] = c[i].y(), z[i] = c[i].z();
+                    math::normalizeVectors(x.data(), y.data(), z.data(), count, levels[l]);
+                }
+            }
+            bool same = true;
+            for (size_t i = 0; i < count; ++i)
+                same &= near(Vector3<float>(x[i], y[i], z[i]), normalized[i]);
+            failures += expect(same, "batch normalize matches Vector3");
+        }
+    }
+
+    {
+        // Every kernel, with tails and zero vectors, against the scalar one.
+        const cpu::SimdLevel levels[] = {cpu::SimdLevel::kAVX2, cpu::SimdLevel::kAVX512};
+        const float m2[6] = {0.8f, -0.6f, 12.0f, 0.6f, 0.8f, -4.0f};
+        const float m3[12] = {0.5f, 0.1f, -0.2f, 1.0f, 0.3f, 0.9f, 0.0f, -2.0f, 0.2f, -0.4f, 1.1f, 3.0f};
+        bool same = true;
+        for (size_t n : {size_t(0), size_t(1), size_t(7), size_t(8), size_t(17), size_t(100)})
+        {
+            std::vector<float> x(n), y(n), z(n);
+            for (size_t i = 0; i < n; ++i)
+                x[i] = dist(rng), y[i] = dist(rng), z[i] = dist(rng);
+            if (n > 3)
+                x[3] = y[3] = z[3] = 0.0f;
+            std::vector<float> ex = x, ey = y, ez = z, fx = x, fy = y;
+            math::normalizeVectors(ex.data(), ey.data(), ez.data(), n, cpu::SimdLevel::kScalar);
+            math::normalizeVectors(fx.data(), fy.data(), n, cpu::SimdLevel::kScalar);
+            std::vector<float> tx(n), ty(n), tz(n), sx(n), sy(n);
+            math::transformPoints(m3, x.data(), y.data(), z.data(), tx.data(), ty.data(), tz.data(), n,
+                                  cpu::SimdLevel::kScalar);
+            math::transformPoints(m2, x.data(), y.data(), sx.data(), sy.data(), n, cpu::SimdLevel::kScalar);
+            for (cpu::SimdLevel level : levels)
+            {
+                std::vector<float> ax = x, ay = y, az = z, bx = x, by = y;
+                math::normalizeVectors(ax.data(), ay.data(), az.data(), n, level);
+                math::normalizeVectors(bx.data(), by.data(), n, level);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    same &= near(ax[i], ex[i]) && near(ay[i], ey[i]) && near(az[i], ez[i]);
+                    same &= near(bx[i], fx[i]) && near(by[i], fy[i]) && (i != 3 || ax[i] == 0.0f);
+                }
+                // In place.
+                ax = x, ay = y, az = z, bx = x, by = y;
+                math::transformPoints(m3, ax.data(), ay.data(), az.data(), ax.data(), ay.data(), az.data(), n, level);
+                math::transformPoints(m2, bx.data(), by.data(), bx.data(), by.data(), n, level);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    same &= near(ax[i], tx[i], 1e-4f) && near(ay[i], ty[i], 1e-4f) && near(az[i], tz[i], 1e-4f);
+                    same &= near(bx[i], sx[i], 1e-4f) && near(by[i], sy[i], 1e-4f);
+                }
+            }
+            if (n > 3)
+                same &= ex[3] == 0.0f && fx[3] == 0.0f && near(ex[0] * ex[0] + ey[0] * ey[0] + ez[0] * ez[0], 1.0f);
+            if (n > 0)
+                same &= sx[0] == 0.8f * x[0] - 0.6f * y[0] + 12.0f;
+        }
+        failures += expect(same, "batch kernels agree");
+    }
+    return failures == 0 ? 0 : 1;
+}
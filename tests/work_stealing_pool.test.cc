@@ -0,0 +1,231 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pillar/thread_pool/threadsafe_queue.h"
+#include "pillar/thread_pool/work_stealing_pool.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+// Counts heap allocations to check that task slots are reused.
+static std::atomic<size_t> gAllocations{0};
+
+void* operator new(size_t size)
+{
+    ++gAllocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Baseline for the benchmark: workers sharing one queue.
+template <class Queue>
+class QueuePool
+{
+public:
+    explicit QueuePool(size_t threads)
+    {
+        for (size_t i = 0; i < threads; ++i)
+            mWorkers.emplace_back(
+                [this]
+                {
+                    for (;;)
+                    {
+                        Task task;
+                        mQueue.waitAndPop(task);
+                        if (!task)
+                            return;
+                        task();
+                        mPending.fetch_sub(1, std::memory_order_acq_rel);
+                    }
+                });
+    }
+    ~QueuePool()
+    {
+        for (size_t i = 0; i < mWorkers.size(); ++i)
+            mQueue.push(Task());
+        for (std::thread& worker : mWorkers)
+            worker.join();
+    }
+    void post(Task task)
+    {
+        mPending.fetch_add(1, std::memory_order_relaxed);
+        mQueue.push(std::move(task));
+    }
+    void waitIdle()
+    {
+        while (mPending.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+    }
+
+private:
+    Queue mQueue;
+    std::vector<std::thread> mWorkers;
+    std::atomic<size_t> mPending{0};
+};
+
+// A tree of fine-grained tasks: every inner task spawns `fanout` children,
+// leaves do a little arithmetic.
+template <class Pool>
+static void spawnTree(Pool& pool, int depth, int fanout, std::atomic<long>& leaves)
+{
+    if (depth == 0)
+    {
+        volatile int x = 0;
+        for (int i = 0; i < 64; ++i)
+            x = x + i;
+        leaves.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    for (int i = 0; i < fanout; ++i)
+        pool.post([&pool, depth, fanout, &leaves] { spawnTree(pool, depth - 1, fanout, leaves); });
+}
+
+// Times the tree under `label`, returns the leaves that ran.
+template <class Pool>
+static long benchmark(const std::string& label, size_t threads)
+{
+    Pool pool(threads);
+    std::atomic<long> leaves{0};
+    Timer timer(label);
+    pool.post([&] { spawnTree(pool, 4, 12, leaves); });
+    pool.waitIdle();
+    return leaves.load();
+}
+
+int main()
+{
+    int failures = 0;
+
+    {
+        WorkStealingDeque<int> deque(2);
+        for (int i = 0; i < 10; ++i)
+            deque.push(i);
+        int a = -1, b = -1;
+        deque.pop(a);
+        deque.steal(b);
+        failures += expect(a == 9 && b == 0 && deque.size() == 8, "owner pops LIFO, thieves steal FIFO");
+    }
+
+    {
+        // Every item is taken exactly once while thieves race the owner.
+        constexpr int kItems = 200000;
+        WorkStealingDeque<int> deque(64);
+        std::vector<std::atomic<int>> seen(kItems);
+        std::atomic<bool> done{false};
+        std::vector<std::thread> thieves;
+        for (int t = 0; t < 3; ++t)
+            thieves.emplace_back(
+                [&]
+                {
+                    int item;
+                    while (!done.load(std::memory_order_acquire) || !deque.empty())
+                        if (deque.steal(item))
+                            seen[item].fetch_add(1, std::memory_order_relaxed);
+                });
+        int item;
+        for (int i = 0; i < kItems; ++i)
+        {
+            deque.push(i);
+            if (i % 3 == 0 && deque.pop(item))
+                seen[item].fetch_add(1, std::memory_order_relaxed);
+        }
+        while (deque.pop(item))
+            seen[item].fetch_add(1, std::memory_order_relaxed);
+        done.store(true, std::memory_order_release);
+        for (std::thread& thief : thieves)
+            thief.join();
+        bool once = true;
+        for (auto& count : seen)
+            once &= count.load() == 1;
+        failures += expect(once, "concurrent steal takes every item once");
+    }
+
+    {
+        WorkStealingPool pool(4);
+        auto answer = pool.submit([](int x) { return x * 2; }, 21);
+        failures += expect(answer.get() == 42, "submit returns the result");
+
+        auto thrower = pool.submit([] { throw 7; });
+        bool caught = false;
+        try
+        {
+            thrower.get();
+        }
+        catch (int e)
+        {
+            caught = e == 7;
+        }
+        failures += expect(caught, "exception propagates through the future");
+
+        std::atomic<long> leaves{0};
+        pool.post([&] { spawnTree(pool, 3, 10, leaves); });
+        pool.waitIdle();
+        failures += expect(leaves.load() == 1000, "nested spawns all run");
+
+        // Once the slots and deques have grown, spawning allocates nothing
+        // but the odd batch of fresh slots.
+        leaves = 0;
+        const size_t before = gAllocations.load();
+        pool.post([&] { spawnTree(pool, 3, 10, leaves); });
+        pool.waitIdle();
+        const size_t allocations = gAllocations.load() - before;
+        std::cout << "allocations for 1111 tasks after warm-up: " << allocations << std::endl;
+        failures += expect(leaves.load() == 1000 && allocations < 111, "task slots are reused");
+
+        // Shutdown also runs what the last tasks spawn.
+        leaves = 0;
+        pool.post([&] { spawnTree(pool, 3, 10, leaves); });
+        pool.shutdown();
+        failures += expect(leaves.load() == 1000, "shutdown drains nested spawns");
+        failures += expect(pool.size() == 0, "no workers after shutdown");
+    }
+
+    {
+        // Posts racing shutdown either run or are dropped, none is stranded
+        // in the injection queue where waitIdle() would wait for it.
+        bool ok = true;
+        for (int round = 0; round < 50 && ok; ++round)
+        {
+            WorkStealingPool pool(2);
+            std::atomic<long> ran{0};
+            std::vector<std::thread> posters;
+            for (int t = 0; t < 3; ++t)
+                posters.emplace_back(
+                    [&]
+                    {
+                        for (int i = 0; i < 2000; ++i)
+                            pool.post([&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+                    });
+            std::this_thread::sleep_for(std::chrono::microseconds(round * 10));
+            pool.shutdown();
+            for (std::thread& poster : posters)
+                poster.join();
+            pool.waitIdle();
+            ok = pool.pending() == 0 && ran.load() <= 6000;
+        }
+        failures += expect(ok, "posts racing shutdown are run or dropped");
+    }
+
+    // 12^4 = 20736 leaf tasks, spawned from inside tasks.
+    for (size_t threads : {1, 2, 4, 8, 16, 32, 64})
+    {
+        const std::string count = std::to_string(threads) + " threads";
+        const long a = benchmark<QueuePool<ThreadsafeQueue<Task>>>(count + ", ThreadsafeQueue: ", threads);
+        const long b = benchmark<QueuePool<FineGrainedThreadsafeQueue<Task>>>(
+            count + ", FineGrainedThreadsafeQueue: ", threads);
+        const long c = benchmark<WorkStealingPool>(count + ", WorkStealingPool: ", threads);
+        failures += expect(a == 20736 && b == 20736 && c == 20736, count + ", every leaf runs");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pillar/framework/formats/image_resize.h"
+#include "pillar/framework/formats/yuv_conversion.h"
+#include "pillar/utility/test.h"
+#include "pillar/utility/timeit.h"
+
+using namespace yuzu;
+using test::expect;
+
+static void fillRandom(YUVImage& image)
+{
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> bytes(0, 255);
+    const int chromaBytes = image.layout() == YUVImage::Layout::kNV12 ? 2 * image.chromaWidth() : image.chromaWidth();
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.row(0, y)[x] = static_cast<uint8_t>(bytes(gen));
+    for (int plane = 1; plane < image.numPlanes(); ++plane)
+        for (int y = 0; y < image.chromaHeight(); ++y)
+            for (int x = 0; x < chromaBytes; ++x)
+                image.row(plane, y)[x] = static_cast<uint8_t>(bytes(gen));
+}
+
+// Floating point BT.601 / BT.709 reference.
+static void expected(const YUVImage& image, int x, int y, float rgb[3])
+{
+    const bool nv12 = image.layout() == YUVImage::Layout::kNV12;
+    const float luma = image.row(0, y)[x];
+    const float cb = nv12 ? image.row(1, y / 2)[x / 2 * 2] : image.row(1, y / 2)[x / 2];
+    const float cr = nv12 ? image.row(1, y / 2)[x / 2 * 2 + 1] : image.row(2, y / 2)[x / 2];
+    const bool bt709 = image.colorMatrix() == YUVImage::ColorMatrix::kBT709;
+    const float kr = bt709 ? 0.2126f : 0.299f, kb = bt709 ? 0.0722f : 0.114f, kg = 1.0f - kr - kb;
+    const float yy = image.fullRange() ? luma : (luma - 16.0f) * 255.0f / 219.0f;
+    const float u = image.fullRange() ? cb - 128.0f : (cb - 128.0f) * 255.0f / 224.0f;
+    const float v = image.fullRange() ? cr - 128.0f : (cr - 128.0f) * 255.0f / 224.0f;
+    rgb[0] = yy + 2.0f * (1.0f - kr) * v;
+    rgb[1] = yy - 2.0f * (1.0f - kb) * kb / kg * u - 2.0f * (1.0f - kr) * kr / kg * v;
+    rgb[2] = yy + 2.0f * (1.0f - kb) * u;
+    for (int c = 0; c < 3; ++c)
+        rgb[c] = std::min(std::max(rgb[c], 0.0f), 255.0f);
+}
+
+static int check(YUVImage::Layout layout, ImageFormat::Format format, bool fullRange, YUVImage::ColorMatrix matrix)
+{
+    YUVImage image(layout, 301, 37);
+    image.setFullRange(fullRange);
+    image.setColorMatrix(matrix);
+    fillRandom(image);
+
+    ImageFrame scalar(format, image.width(), image.height());
+    ImageFrame simd(format, image.width(), image.height());
+    convertYUVToRGB(image, ImageFrameView(scalar), cpu::SimdLevel::kScalar);
+    Status status = convertYUVToRGB(image, ImageFrameView(simd), cpu::SimdLevel::kAVX512);
+    if (!status.ok())
+    {
+        std::cout << status << std::endl;
+        return 1;
+    }
+
+    const int channels = scalar.channels();
+    float maxError = 0.0f;
+    bool identical = true;
+    for (int y = 0; y < image.height(); ++y)
+    {
+        identical &= std::memcmp(scalar.pixelData() + y * scalar.step(), simd.pixelData() + y * simd.step(),
+                                 image.width() * channels) == 0;
+        for (int x = 0; x < image.width(); ++x)
+        {
+            float rgb[3];
+            expected(image, x, y, rgb);
+            const uint8_t* px = simd.pixelData() + y * simd.step() + x * channels;
+            for (int c = 0; c < 3; ++c)
+            {
+                const int index = format == ImageFormat::SBGRA ? 2 - c : c;
+                maxError = std::max(maxError, std::fabs(px[index] - rgb[c]));
+            }
+        }
+    }
+
+    return expect(identical && maxError <= 1.0f,
+                  "layout " + std::to_string(int(layout)) + ", format " + std::to_string(format) + ", full range " +
+                      std::to_string(fullRange) + ", matrix " + std::to_string(int(matrix)) + ", max error " +
+                      std::to_string(maxError) + (identical ? "" : ", simd differs"));
+}
+
+int main()
+{
+    int failures = 0;
+    for (auto layout : {YUVImage::Layout::kI420, YUVImage::Layout::kNV12})
+        for (auto format : {ImageFormat::SRGB, ImageFormat::SBGRA})
+            for (bool fullRange : {false, true})
+                for (auto matrix : {YUVImage::ColorMatrix::kBT601, YUVImage::ColorMatrix::kBT709})
+                    failures += check(layout, format, fullRange, matrix);
+
+    // Adopting decoder planes, the deleter runs once with the luma pointer.
+    {
+        std::vector<uint8_t> y(64 * 32, 128), uv(64 * 16, 128);
+        int deleted = 0;
+        {
+            YUVImage image;
+            image.adoptPlanes(YUVImage::Layout::kNV12, 60, 30, y.data(), 64, uv.data(), 64, nullptr, 0,
+                              [&](uint8_t* p) { deleted += p == y.data(); });
+            ImageFrame rgb;
+            failures += expect(convertYUVToRGB(image, ImageFormat::SRGB, 60, 30, rgb).ok() && rgb.width() == 60,
+                               "adopted NV12 -> SRGB");
+        }
+        failures += expect(deleted == 1, "the deleter runs once with the luma plane");
+    }
+
+    // Fused convert + resize against convert then resize.
+    YUVImage image(YUVImage::Layout::kNV12, 1920, 1080);
+    fillRandom(image);
+    ImageFrame full, resized, fused;
+    convertYUVToRGB(image, ImageFormat::SRGB, 1920, 1080, full);
+    resize(full, 640, 360, resized);
+    convertYUVToRGB(image, ImageFormat::SRGB, 640, 360, fused);
+    int maxDiff = 0;
+    for (int y = 0; y < 360; ++y)
+        for (int x = 0; x < 640 * 3; ++x)
+            maxDiff = std::max(maxDiff, std::abs(resized.pixelData()[y * resized.step() + x] -
+                                                 fused.pixelData()[y * fused.step() + x]));
+    failures += expect(maxDiff <= 1, "fused resize max diff " + std::to_string(maxDiff));
+
+    ImageFrame rgb(ImageFormat::SRGB, 1920, 1080);
+    {
+        Timer timer("NV12 -> SRGB 1080p scalar x100: ");
+        for (int i = 0; i < 100; ++i)
+            convertYUVToRGB(image, ImageFrameView(rgb), cpu::SimdLevel::kScalar);
+    }
+    {
+        Timer timer("NV12 -> SRGB 1080p simd x100: ");
+        for (int i = 0; i < 100; ++i)
+            convertYUVToRGB(image, ImageFrameView(rgb), cpu::SimdLevel::kAVX512);
+    }
+    {
+        Timer timer("NV12 -> SRGB 640x360 convert then resize x100: ");
+        for (int i = 0; i < 100; ++i)
+        {
+            convertYUVToRGB(image, ImageFrameView(rgb));
+            resize(rgb, 640, 360, resized);
+        }
+    }
+    {
+        Timer timer("NV12 -> SRGB 640x360 fused x100: ");
+        for (int i = 0; i < 100; ++i)
+            convertYUVToRGB(image, ImageFormat::SRGB, 640, 360, fused);
+    }
+    return failures == 0 ? 0 : 1;
+}